@@ -0,0 +1,111 @@
+#include <kernel/arch/x86_64/acpi.h>
+#include <kernel/memory/vmm.h>
+#include <kernel/console.h>
+
+namespace Core {
+namespace ACPI {
+
+#define BIOS_AREA_START 0xE0000
+#define BIOS_AREA_END   0x100000
+#define MAX_TABLES      32
+
+struct Rsdp {
+    char signature[8];
+    uint8_t checksum;
+    char oem_id[6];
+    uint8_t revision;
+    uint32_t rsdt_address;
+    uint32_t length;
+    uint64_t xsdt_address;
+    uint8_t extended_checksum;
+    uint8_t reserved[3];
+} PACKED;
+
+// Tables are mapped once at boot and never released.
+static const AcpiHeader* tables[MAX_TABLES];
+static uint32_t table_count = 0;
+
+static bool checksum_ok(const void* data, size_t length) {
+    uint8_t sum = 0;
+    for (size_t i = 0; i < length; i++) {
+        sum += ((const uint8_t*)data)[i];
+    }
+    return sum == 0;
+}
+
+static bool signature_is(const char* a, const char* b, size_t length) {
+    for (size_t i = 0; i < length; i++) {
+        if (a[i] != b[i]) return false;
+    }
+    return true;
+}
+
+static const AcpiHeader* map_table(uint64_t phys) {
+    const AcpiHeader* header = (const AcpiHeader*)VMM::map_mmio(phys, sizeof(AcpiHeader));
+    if (!header) {
+        return nullptr;
+    }
+
+    uint32_t length = header->length;
+    if (length > sizeof(AcpiHeader)) {
+        header = (const AcpiHeader*)VMM::map_mmio(phys, length);
+    }
+
+    if (!header || !checksum_ok(header, length)) {
+        return nullptr;
+    }
+    return header;
+}
+
+static const Rsdp* scan_bios_area() {
+    for (uint64_t addr = BIOS_AREA_START; addr < BIOS_AREA_END; addr += 16) {
+        const Rsdp* rsdp = (const Rsdp*)(addr + KERNEL_VIRTUAL_BASE);
+        if (signature_is(rsdp->signature, "RSD PTR ", 8) && checksum_ok(rsdp, 20)) {
+            return rsdp;
+        }
+    }
+    return nullptr;
+}
+
+void initialize(const void* boot_rsdp) {
+    const Rsdp* rsdp = boot_rsdp ? (const Rsdp*)boot_rsdp : scan_bios_area();
+    if (!rsdp) {
+        return;
+    }
+
+    bool use_xsdt = rsdp->revision >= 2 && rsdp->xsdt_address;
+    const AcpiHeader* root = map_table(use_xsdt ? rsdp->xsdt_address : rsdp->rsdt_address);
+    if (!root) {
+        Console::printf("[ACPI] Bad root table checksum\n");
+        return;
+    }
+
+    size_t entry_size = use_xsdt ? 8 : 4;
+    size_t entries = (root->length - sizeof(AcpiHeader)) / entry_size;
+    const uint8_t* pointers = (const uint8_t*)(root + 1);
+
+    for (size_t i = 0; i < entries && table_count < MAX_TABLES; i++) {
+        uint64_t phys = use_xsdt ? *(const uint64_t*)(pointers + i * 8)
+                                 : *(const uint32_t*)(pointers + i * 4);
+        const AcpiHeader* table = map_table(phys);
+        if (table) {
+            tables[table_count++] = table;
+        }
+    }
+}
+
+bool is_present() {
+    return table_count > 0;
+}
+
+const AcpiHeader* find_table(const char* signature) {
+    for (uint32_t i = 0; i < table_count; i++) {
+        if (signature_is(tables[i]->signature, signature, 4)) {
+            return tables[i];
+        }
+    }
+    return nullptr;
+}
+
+}
+}
\ No newline at end of file
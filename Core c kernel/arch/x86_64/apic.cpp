@@ -1,10 +1,20 @@
 #include <kernel/arch/x86_64/apic.h>
+#include <kernel/arch/x86_64/cpu.h>
+#include <kernel/memory/vmm.h>
 
 namespace Core {
 namespace APIC {
 
 #define IA32_APIC_BASE_MSR 0x1B
 
+#define LAPIC_ID       0x20
+#define LAPIC_EOI      0xB0
+#define LAPIC_SVR      0xF0
+#define LAPIC_ICR_LOW  0x300
+#define LAPIC_ICR_HIGH 0x310
+
+#define SVR_ENABLE     BIT(8)
+
 static uint64_t lapic_base = 0;
 
 static uint32_t read_lapic(uint32_t reg) {
@@ -16,21 +26,26 @@ static void write_lapic(uint32_t reg, uint32_t value) {
 }
 
 void initialize() {
-    uint32_t eax, edx;
-    __asm__ volatile("rdmsr" : "=a"(eax), "=d"(edx) : "c"(IA32_APIC_BASE_MSR));
-    lapic_base = ((uint64_t)edx << 32) | (eax & 0xFFFFF000);
-    lapic_base += 0xFFFFFFFF80000000;
+    // The LAPIC sits at 0xFEE00000, far above the boot mapping.
+    uint64_t phys = CPU::read_msr(IA32_APIC_BASE_MSR) & 0xFFFFFF000ULL;
+    lapic_base = (uint64_t)VMM::map_mmio(phys, PAGE_SIZE);
+
+    CPU::local()->apic_id = get_id();
     
-    write_lapic(0xF0, read_lapic(0xF0) | 0x1FF);
+    write_lapic(LAPIC_SVR, read_lapic(LAPIC_SVR) | SVR_ENABLE | 0xFF);
+}
+
+uint32_t get_id() {
+    return read_lapic(LAPIC_ID) >> 24;
 }
 
 void send_eoi() {
-    write_lapic(0xB0, 0);
+    write_lapic(LAPIC_EOI, 0);
 }
 
 void send_ipi(uint32_t cpu, uint8_t vector) {
-    write_lapic(0x310, (cpu << 24));
-    write_lapic(0x300, vector);
+    write_lapic(LAPIC_ICR_HIGH, CPU::get(cpu)->apic_id << 24);
+    write_lapic(LAPIC_ICR_LOW, vector);
 }
 
 }
@@ -0,0 +1,24 @@
+section .text
+bits 64
+
+; void context_switch(uint64_t* old_rsp, uint64_t new_rsp)
+global context_switch
+context_switch:
+    push rbx
+    push rbp
+    push r12
+    push r13
+    push r14
+    push r15
+
+    mov [rdi], rsp
+    mov rsp, rsi
+
+    pop r15
+    pop r14
+    pop r13
+    pop r12
+    pop rbp
+    pop rbx
+
+    ret
\ No newline at end of file
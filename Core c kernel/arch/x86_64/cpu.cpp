@@ -0,0 +1,38 @@
+#include <kernel/arch/x86_64/cpu.h>
+
+namespace Core {
+namespace CPU {
+
+static Local cpu_locals[MAX_CPUS];
+static uint32_t cpus_online = 0;
+
+void initialize() {
+    uint32_t cpu = cpus_online++;
+    Local* local = &cpu_locals[cpu];
+
+    local->self = local;
+    local->id = cpu;
+    local->current_thread = nullptr;
+    local->idle_thread = nullptr;
+    local->preempt_count = 0;
+    local->fpu_owner = nullptr;
+    local->irq_nesting = 0;
+    local->softirq_pending = 0;
+    local->need_resched = false;
+    local->apic_id = 0;
+    local->kernel_rsp = 0;
+    local->user_rsp = 0;
+
+    write_msr(IA32_GS_BASE_MSR, (uint64_t)local);
+}
+
+Local* get(uint32_t cpu) {
+    return &cpu_locals[cpu];
+}
+
+uint32_t online_count() {
+    return cpus_online;
+}
+
+}
+}
\ No newline at end of file
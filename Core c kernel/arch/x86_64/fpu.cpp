@@ -0,0 +1,221 @@
+#include <kernel/arch/x86_64/fpu.h>
+#include <kernel/arch/x86_64/cpu.h>
+#include <kernel/arch/x86_64/idt.h>
+#include <kernel/process/process.h>
+#include <kernel/memory/slab.h>
+
+extern "C" void isr7();
+
+namespace Core {
+namespace FPU {
+
+#define CR0_MP        BIT(1)
+#define CR0_EM        BIT(2)
+#define CR0_TS        BIT(3)
+#define CR4_OSFXSR    BIT(9)
+#define CR4_OSXMMEXCPT BIT(10)
+#define CR4_OSXSAVE   BIT(18)
+
+#define XFEATURE_X87     BIT(0)
+#define XFEATURE_SSE     BIT(1)
+#define XFEATURE_AVX     BIT(2)
+#define XFEATURE_AVX512  (BIT(5) | BIT(6) | BIT(7))
+
+#define FXSAVE_SIZE      512
+#define DEFAULT_FCW      0x037F
+#define DEFAULT_MXCSR    0x1F80
+
+static bool xsave_supported = false;
+static bool xsaveopt_supported = false;
+static bool avx2_supported = false;
+static uint64_t xfeatures = 0;
+static size_t state_size = FXSAVE_SIZE;
+
+// Sized once the enabled features are known. Every object is a multiple of
+// 64 bytes, which keeps XSAVE areas aligned as the instructions require.
+static ObjectCache state_cache("fpu_state", FXSAVE_SIZE);
+
+static inline uint64_t read_cr0() {
+    uint64_t value;
+    __asm__ volatile("mov %%cr0, %0" : "=r"(value));
+    return value;
+}
+
+static inline void write_cr0(uint64_t value) {
+    __asm__ volatile("mov %0, %%cr0" : : "r"(value) : "memory");
+}
+
+static inline uint64_t read_cr4() {
+    uint64_t value;
+    __asm__ volatile("mov %%cr4, %0" : "=r"(value));
+    return value;
+}
+
+static inline void write_cr4(uint64_t value) {
+    __asm__ volatile("mov %0, %%cr4" : : "r"(value) : "memory");
+}
+
+static inline void clts() {
+    __asm__ volatile("clts" : : : "memory");
+}
+
+static inline void stts() {
+    write_cr0(read_cr0() | CR0_TS);
+}
+
+static void save(void* area) {
+    uint32_t lo = (uint32_t)xfeatures;
+    uint32_t hi = (uint32_t)(xfeatures >> 32);
+
+    if (xsaveopt_supported) {
+        __asm__ volatile("xsaveopt64 (%0)" : : "r"(area), "a"(lo), "d"(hi) : "memory");
+    } else if (xsave_supported) {
+        __asm__ volatile("xsave64 (%0)" : : "r"(area), "a"(lo), "d"(hi) : "memory");
+    } else {
+        __asm__ volatile("fxsave64 (%0)" : : "r"(area) : "memory");
+    }
+}
+
+static void restore(void* area) {
+    uint32_t lo = (uint32_t)xfeatures;
+    uint32_t hi = (uint32_t)(xfeatures >> 32);
+
+    if (xsave_supported) {
+        __asm__ volatile("xrstor64 (%0)" : : "r"(area), "a"(lo), "d"(hi) : "memory");
+    } else {
+        __asm__ volatile("fxrstor64 (%0)" : : "r"(area) : "memory");
+    }
+}
+
+static void* alloc_state() {
+    uint8_t* area = (uint8_t*)state_cache.zalloc();
+    if (!area) return nullptr;
+
+    *(uint16_t*)(area + 0) = DEFAULT_FCW;
+    *(uint32_t*)(area + 24) = DEFAULT_MXCSR;
+
+    return area;
+}
+
+static void free_state(void* area) {
+    state_cache.free(area);
+}
+
+void initialize() {
+    uint32_t eax, ebx, ecx, edx;
+
+    CPU::cpuid(1, 0, &eax, &ebx, &ecx, &edx);
+    xsave_supported = ecx & BIT(26);
+
+    uint64_t cr4 = read_cr4() | CR4_OSFXSR | CR4_OSXMMEXCPT;
+    if (xsave_supported) {
+        cr4 |= CR4_OSXSAVE;
+    }
+    write_cr4(cr4);
+    write_cr0((read_cr0() & ~CR0_EM) | CR0_MP);
+
+    if (xsave_supported) {
+        CPU::cpuid(0xD, 0, &eax, &ebx, &ecx, &edx);
+        uint64_t supported = ((uint64_t)edx << 32) | eax;
+        xfeatures = supported & (XFEATURE_X87 | XFEATURE_SSE | XFEATURE_AVX | XFEATURE_AVX512);
+
+        __asm__ volatile("xsetbv" : : "c"(0), "a"((uint32_t)xfeatures), "d"((uint32_t)(xfeatures >> 32)));
+
+        // EBX reflects the size required by the features just enabled in XCR0.
+        CPU::cpuid(0xD, 0, &eax, &ebx, &ecx, &edx);
+        state_size = ebx;
+        state_cache.set_object_size(ALIGN_UP(state_size, 64));
+
+        CPU::cpuid(0xD, 1, &eax, &ebx, &ecx, &edx);
+        xsaveopt_supported = eax & BIT(0);
+
+        CPU::cpuid(7, 0, &eax, &ebx, &ecx, &edx);
+        avx2_supported = (xfeatures & XFEATURE_AVX) && (ebx & BIT(5));
+    }
+
+    __asm__ volatile("fninit");
+    IDT::set_gate(7, (uint64_t)isr7, 0);
+    stts();
+}
+
+size_t get_state_size() {
+    return state_size;
+}
+
+bool has_xsave() {
+    return xsave_supported;
+}
+
+bool has_avx2() {
+    return avx2_supported;
+}
+
+void switch_to(Thread* next) {
+    if (CPU::local()->fpu_owner == next) {
+        clts();
+    } else {
+        stts();
+    }
+}
+
+bool handle_device_not_available() {
+    CPU::Local* local = CPU::local();
+    Thread* current = local->current_thread;
+    Thread* owner = local->fpu_owner;
+
+    clts();
+
+    if (owner == current) {
+        return true;
+    }
+
+    if (!current->fpu_state) {
+        current->fpu_state = alloc_state();
+        if (!current->fpu_state) {
+            return false;
+        }
+    }
+
+    if (owner) {
+        save(owner->fpu_state);
+    }
+
+    restore(current->fpu_state);
+    local->fpu_owner = current;
+
+    return true;
+}
+
+void release(Thread* thread) {
+    uint64_t flags = CPU::irq_save();
+    CPU::Local* local = CPU::get(thread->cpu);
+
+    if (local->fpu_owner == thread) {
+        local->fpu_owner = nullptr;
+    }
+    CPU::irq_restore(flags);
+
+    free_state(thread->fpu_state);
+    thread->fpu_state = nullptr;
+}
+
+}
+
+void kernel_fpu_begin() {
+    CPU::preempt_disable();
+
+    CPU::Local* local = CPU::local();
+    FPU::clts();
+
+    if (local->fpu_owner) {
+        FPU::save(local->fpu_owner->fpu_state);
+        local->fpu_owner = nullptr;
+    }
+}
+
+void kernel_fpu_end() {
+    FPU::stts();
+    CPU::preempt_enable();
+}
+
+}
\ No newline at end of file
@@ -1,4 +1,5 @@
 #include <kernel/arch/x86_64/gdt.h>
+#include <kernel/arch/x86_64/cpu.h>
 #include <kernel/console.h>
 
 namespace Core {
@@ -41,14 +42,18 @@ struct TSS {
     uint16_t iomap_base;
 } PACKED;
 
-static GDTEntry gdt[7];
-static TSSEntry* tss_entry;
-static TSS tss;
-static GDTPointer gdt_ptr;
+// Each CPU has its own TSS, and so its own GDT to hold the descriptor.
+static GDTEntry gdts[CPU::MAX_CPUS][7];
+static TSS tsses[CPU::MAX_CPUS];
+static GDTPointer gdt_ptrs[CPU::MAX_CPUS];
 
 extern "C" void gdt_flush(uint64_t);
+extern "C" void tss_flush(uint16_t);
+
+void initialize(uint32_t cpu) {
+    GDTEntry* gdt = gdts[cpu];
+    TSS& tss = tsses[cpu];
 
-void initialize() {
     gdt[0] = {0, 0, 0, 0, 0, 0};
     
     gdt[1].limit_low = 0xFFFF;
@@ -68,18 +73,18 @@ void initialize() {
     gdt[3].limit_low = 0xFFFF;
     gdt[3].base_low = 0;
     gdt[3].base_middle = 0;
-    gdt[3].access = 0xFA;
-    gdt[3].granularity = 0xAF;
+    gdt[3].access = 0xF2;
+    gdt[3].granularity = 0xCF;
     gdt[3].base_high = 0;
     
     gdt[4].limit_low = 0xFFFF;
     gdt[4].base_low = 0;
     gdt[4].base_middle = 0;
-    gdt[4].access = 0xF2;
-    gdt[4].granularity = 0xCF;
+    gdt[4].access = 0xFA;
+    gdt[4].granularity = 0xAF;
     gdt[4].base_high = 0;
     
-    tss_entry = (TSSEntry*)&gdt[5];
+    TSSEntry* tss_entry = (TSSEntry*)&gdt[5];
     uint64_t tss_base = (uint64_t)&tss;
     uint32_t tss_limit = sizeof(TSS) - 1;
     
@@ -97,13 +102,20 @@ void initialize() {
     }
     tss.iomap_base = sizeof(TSS);
     
-    gdt_ptr.limit = sizeof(gdt) - 1;
-    gdt_ptr.base = (uint64_t)&gdt;
-    gdt_flush((uint64_t)&gdt_ptr);
+    gdt_ptrs[cpu].limit = sizeof(gdts[cpu]) - 1;
+    gdt_ptrs[cpu].base = (uint64_t)gdt;
+    gdt_flush((uint64_t)&gdt_ptrs[cpu]);
+    tss_flush(TSS_SELECTOR);
 }
 
 void install_tss(uint64_t rsp0) {
-    tss.rsp0 = rsp0;
+    tsses[CPU::id()].rsp0 = rsp0;
+}
+
+void set_ist(uint8_t ist, uint64_t rsp) {
+    if (ist >= 1 && ist <= 7) {
+        tsses[CPU::id()].ist[ist - 1] = rsp;
+    }
 }
 
 }
@@ -1,6 +1,8 @@
 #include <kernel/arch/x86_64/idt.h>
 #include <kernel/console.h>
 
+extern "C" uint64_t isr_stub_table[256];
+
 namespace Core {
 namespace IDT {
 
@@ -34,7 +36,7 @@ void set_gate(uint8_t num, uint64_t handler, uint8_t ist) {
 
 void initialize() {
     for (int i = 0; i < 256; i++) {
-        idt[i] = {0, 0, 0, 0, 0, 0, 0};
+        set_gate(i, isr_stub_table[i], 0);
     }
     
     idt_ptr.limit = sizeof(idt) - 1;
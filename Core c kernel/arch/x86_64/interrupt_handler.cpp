@@ -1,6 +1,11 @@
 #include <kernel/types.h>
 #include <kernel/console.h>
 #include <kernel/arch/x86_64/apic.h>
+#include <kernel/arch/x86_64/cpu.h>
+#include <kernel/arch/x86_64/fpu.h>
+#include <kernel/process/scheduler.h>
+#include <kernel/memory/kstack.h>
+#include <kernel/irq/irq.h>
 
 namespace Core {
 
@@ -11,6 +16,13 @@ struct InterruptFrame {
     uint64_t rip, cs, rflags, rsp, ss;
 };
 
+// Device vectors only save caller-saved registers (see interrupts.asm).
+struct IrqFrame {
+    uint64_t r11, r10, r9, r8, rdi, rsi, rdx, rcx, rax;
+    uint64_t vector, error_code;
+    uint64_t rip, cs, rflags, rsp, ss;
+};
+
 static const char* exception_messages[] = {
     "Division By Zero", "Debug", "NMI", "Breakpoint",
     "Overflow", "Bound Range", "Invalid Opcode", "Device Not Available",
@@ -20,29 +32,50 @@ static const char* exception_messages[] = {
 };
 
 extern "C" void interrupt_handler(InterruptFrame* frame) {
-    if (frame->int_num < 32) {
-        Console::printf("\n[EXCEPTION] %s (#%llu)\n", 
-                       exception_messages[frame->int_num], frame->int_num);
-        Console::printf("Error Code: 0x%llx\n", frame->error_code);
-        Console::printf("RIP: 0x%llx\n", frame->rip);
-        
-        if (frame->int_num == 14) {
-            uint64_t cr2;
-            __asm__ volatile("mov %%cr2, %0" : "=r"(cr2));
-            Console::printf("Page Fault Address: 0x%llx\n", cr2);
-        }
-        
-        while (true) {
-            __asm__ volatile("cli; hlt");
-        }
-    } else if (frame->int_num >= 32 && frame->int_num < 48) {
-        if (frame->int_num == 32) {
-            extern void pit_tick();
-            pit_tick();
+    if (frame->int_num == 7 && FPU::handle_device_not_available()) {
+        return;
+    }
+
+    if (frame->int_num == 14) {
+        uint64_t cr2;
+        __asm__ volatile("mov %%cr2, %0" : "=r"(cr2));
+        if (KernelStack::handle_fault(cr2, frame->rsp)) {
+            return;
         }
-        
+    }
+
+    const char* message = frame->int_num < ARRAY_SIZE(exception_messages)
+                              ? exception_messages[frame->int_num] : "Reserved";
+    Console::printf("\n[EXCEPTION] %s (#%llu)\n", message, frame->int_num);
+    Console::printf("Error Code: 0x%llx\n", frame->error_code);
+    Console::printf("RIP: 0x%llx\n", frame->rip);
+    
+    if (frame->int_num == 14) {
+        uint64_t cr2;
+        __asm__ volatile("mov %%cr2, %0" : "=r"(cr2));
+        Console::printf("Page Fault Address: 0x%llx\n", cr2);
+    }
+    
+    while (true) {
+        __asm__ volatile("cli; hlt");
+    }
+}
+
+extern "C" void irq_handler(IrqFrame* frame) {
+    uint64_t start = CPU::rdtsc();
+    IRQ::enter();
+
+    IRQ::dispatch(frame->vector);
+
+    // The LAPIC doesn't expect an EOI for its spurious vector.
+    if (frame->vector != IRQ::SPURIOUS_VECTOR) {
         APIC::send_eoi();
     }
+    IRQ::exit(start);
+
+    if (CPU::local()->need_resched && CPU::local()->preempt_count == 0) {
+        Scheduler::schedule();
+    }
 }
 
 }
\ No newline at end of file
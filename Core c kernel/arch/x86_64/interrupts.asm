@@ -2,9 +2,23 @@ section .text
 bits 64
 
 extern interrupt_handler
-global common_interrupt_handler
+extern irq_handler
+global isr_stub_table
 
-common_interrupt_handler:
+; Interrupts taken from ring 3 arrive with the user GS base loaded. %1 is
+; the offset of the saved CS on the stack.
+%macro SWAPGS_IF_USER 2
+    test qword [rsp + %1], 3
+    jz %2
+    swapgs
+%2:
+%endmacro
+
+; Exceptions save the full register frame for the fault handlers and for
+; diagnostics.
+exception_common:
+    SWAPGS_IF_USER 24, .kernel_entry
+    cld
     push rax
     push rbx
     push rcx
@@ -40,6 +54,41 @@ common_interrupt_handler:
     pop rbx
     pop rax
     
+    add rsp, 16
+    SWAPGS_IF_USER 8, .kernel_exit
+    iretq
+
+; Device and IPI vectors only save what the C ABI lets irq_handler clobber;
+; callee-saved registers are preserved by the compiler and by
+; context_switch if the interrupt ends in a reschedule.
+irq_common:
+    SWAPGS_IF_USER 24, .kernel_entry
+    cld
+    push rax
+    push rcx
+    push rdx
+    push rsi
+    push rdi
+    push r8
+    push r9
+    push r10
+    push r11
+
+    mov rdi, rsp
+    call irq_handler
+
+    pop r11
+    pop r10
+    pop r9
+    pop r8
+    pop rdi
+    pop rsi
+    pop rdx
+    pop rcx
+    pop rax
+
+    add rsp, 16
+    SWAPGS_IF_USER 8, .kernel_exit
     iretq
 
 %macro ISR_NOERRCODE 1
@@ -47,14 +96,22 @@ global isr%1
 isr%1:
     push qword 0
     push qword %1
-    jmp common_interrupt_handler
+    jmp exception_common
 %endmacro
 
 %macro ISR_ERRCODE 1
 global isr%1
 isr%1:
     push qword %1
-    jmp common_interrupt_handler
+    jmp exception_common
+%endmacro
+
+%macro IRQ_STUB 1
+global isr%1
+isr%1:
+    push qword 0
+    push qword %1
+    jmp irq_common
 %endmacro
 
 ISR_NOERRCODE 0
@@ -78,9 +135,33 @@ ISR_ERRCODE 17
 ISR_NOERRCODE 18
 ISR_NOERRCODE 19
 ISR_NOERRCODE 20
+ISR_ERRCODE 21
+ISR_NOERRCODE 22
+ISR_NOERRCODE 23
+ISR_NOERRCODE 24
+ISR_NOERRCODE 25
+ISR_NOERRCODE 26
+ISR_NOERRCODE 27
+ISR_NOERRCODE 28
+ISR_ERRCODE 29
+ISR_ERRCODE 30
+ISR_NOERRCODE 31
 
 %assign i 32
-%rep 16
-    ISR_NOERRCODE i
+%rep 224
+    IRQ_STUB i
+    %assign i i+1
+%endrep
+
+%macro STUB_ENTRY 1
+    dq isr%1
+%endmacro
+
+section .rodata
+align 8
+isr_stub_table:
+%assign i 0
+%rep 256
+    STUB_ENTRY i
     %assign i i+1
 %endrep
\ No newline at end of file
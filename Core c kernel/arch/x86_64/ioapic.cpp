@@ -0,0 +1,274 @@
+#include <kernel/arch/x86_64/ioapic.h>
+#include <kernel/arch/x86_64/acpi.h>
+#include <kernel/arch/x86_64/cpu.h>
+#include <kernel/arch/x86_64/io.h>
+#include <kernel/irq/irq.h>
+#include <kernel/memory/vmm.h>
+#include <kernel/sync/spinlock.h>
+#include <kernel/console.h>
+
+namespace Core {
+namespace IOAPIC {
+
+#define MAX_IOAPICS     8
+#define ISA_IRQS        16
+#define ISA_CASCADE_IRQ 2
+
+#define IOAPIC_REGSEL   0x00
+#define IOAPIC_WINDOW   0x10
+#define IOAPIC_VERSION  0x01
+#define IOAPIC_REDTBL   0x10
+
+#define REDIR_ACTIVE_LOW BIT(13)
+#define REDIR_LEVEL      BIT(15)
+#define REDIR_MASKED     BIT(16)
+
+// MADT interrupt source override flags.
+#define ISO_POLARITY_MASK 0x3
+#define ISO_ACTIVE_LOW    0x3
+#define ISO_TRIGGER_MASK  0xC
+#define ISO_LEVEL         0xC
+
+#define PIC1_COMMAND 0x20
+#define PIC1_DATA    0x21
+#define PIC2_COMMAND 0xA0
+#define PIC2_DATA    0xA1
+
+struct IoApic {
+    uint64_t base;
+    uint32_t gsi_base;
+    uint32_t pins;
+};
+
+struct IsaRoute {
+    uint32_t gsi;
+    uint16_t flags;
+};
+
+static IoApic ioapics[MAX_IOAPICS];
+static uint32_t ioapic_count = 0;
+static IsaRoute isa_routes[ISA_IRQS];
+static Spinlock ioapic_lock("ioapic");
+
+static uint32_t read_reg(IoApic* io, uint32_t reg) {
+    *(volatile uint32_t*)(io->base + IOAPIC_REGSEL) = reg;
+    return *(volatile uint32_t*)(io->base + IOAPIC_WINDOW);
+}
+
+static void write_reg(IoApic* io, uint32_t reg, uint32_t value) {
+    *(volatile uint32_t*)(io->base + IOAPIC_REGSEL) = reg;
+    *(volatile uint32_t*)(io->base + IOAPIC_WINDOW) = value;
+}
+
+static IoApic* find_ioapic(uint32_t gsi) {
+    for (uint32_t i = 0; i < ioapic_count; i++) {
+        if (gsi >= ioapics[i].gsi_base && gsi < ioapics[i].gsi_base + ioapics[i].pins) {
+            return &ioapics[i];
+        }
+    }
+    return nullptr;
+}
+
+static void update_entry(uint32_t gsi, uint32_t clear, uint32_t set) {
+    IoApic* io = find_ioapic(gsi);
+    if (!io) return;
+
+    uint32_t reg = IOAPIC_REDTBL + (gsi - io->gsi_base) * 2;
+
+    uint64_t flags = ioapic_lock.lock_irqsave();
+    write_reg(io, reg, (read_reg(io, reg) & ~clear) | set);
+    ioapic_lock.unlock_irqrestore(flags);
+}
+
+static void mask_pin(uint32_t gsi) {
+    update_entry(gsi, 0, REDIR_MASKED);
+}
+
+static void unmask_pin(uint32_t gsi) {
+    update_entry(gsi, REDIR_MASKED, 0);
+}
+
+static error_t set_pin_affinity(uint32_t gsi, uint8_t, uint32_t cpu) {
+    IoApic* io = find_ioapic(gsi);
+    if (!io) return E_INVAL;
+
+    uint32_t reg = IOAPIC_REDTBL + (gsi - io->gsi_base) * 2 + 1;
+
+    uint64_t flags = ioapic_lock.lock_irqsave();
+    write_reg(io, reg, CPU::get(cpu)->apic_id << 24);
+    ioapic_lock.unlock_irqrestore(flags);
+
+    return E_OK;
+}
+
+static const IrqChip ioapic_chip = {
+    "ioapic",
+    mask_pin,
+    unmask_pin,
+    set_pin_affinity,
+};
+
+static error_t program_pin(uint32_t gsi, uint8_t vector, bool level_triggered, bool active_low) {
+    IoApic* io = find_ioapic(gsi);
+    if (!io) return E_INVAL;
+
+    uint32_t reg = IOAPIC_REDTBL + (gsi - io->gsi_base) * 2;
+    uint32_t low = vector | REDIR_MASKED;
+    if (level_triggered) low |= REDIR_LEVEL;
+    if (active_low) low |= REDIR_ACTIVE_LOW;
+
+    uint64_t flags = ioapic_lock.lock_irqsave();
+    write_reg(io, reg, REDIR_MASKED);
+    write_reg(io, reg + 1, CPU::local()->apic_id << 24);
+    write_reg(io, reg, low);
+    ioapic_lock.unlock_irqrestore(flags);
+
+    IRQ::set_chip(vector, &ioapic_chip, gsi);
+    return E_OK;
+}
+
+#define PIC_ICW4_8086    0x01
+#define PIC_ICW4_AUTO_EOI 0x02
+
+// Remap the 8259s away from the exception vectors and mask every line, so a
+// stray interrupt latched during the switch can't look like a fault.
+static void remap_pic(uint8_t icw4) {
+    IO::outb(PIC1_COMMAND, 0x11);
+    IO::outb(PIC2_COMMAND, 0x11);
+    IO::outb(PIC1_DATA, IRQ::ISA_VECTOR_BASE);
+    IO::outb(PIC2_DATA, IRQ::ISA_VECTOR_BASE + 8);
+    IO::outb(PIC1_DATA, 4);
+    IO::outb(PIC2_DATA, 2);
+    IO::outb(PIC1_DATA, icw4);
+    IO::outb(PIC2_DATA, icw4);
+
+    IO::outb(PIC1_DATA, 0xFF);
+    IO::outb(PIC2_DATA, 0xFF);
+}
+
+static void update_pic_line(uint32_t irq, bool masked) {
+    uint16_t port = irq < 8 ? PIC1_DATA : PIC2_DATA;
+    uint8_t bit = BIT(irq & 7);
+
+    uint64_t flags = ioapic_lock.lock_irqsave();
+    uint8_t mask = IO::inb(port);
+    IO::outb(port, masked ? mask | bit : mask & ~bit);
+    if (!masked && irq >= 8) {
+        IO::outb(PIC1_DATA, IO::inb(PIC1_DATA) & ~BIT(ISA_CASCADE_IRQ));
+    }
+    ioapic_lock.unlock_irqrestore(flags);
+}
+
+static void pic_mask(uint32_t irq) {
+    update_pic_line(irq, true);
+}
+
+static void pic_unmask(uint32_t irq) {
+    update_pic_line(irq, false);
+}
+
+// The 8259s can't steer, so these vectors are never balanced.
+static const IrqChip pic_chip = {
+    "8259",
+    pic_mask,
+    pic_unmask,
+    nullptr,
+};
+
+// Without an IOAPIC the 8259s keep the ISA IRQs, reaching the CPU through
+// LINT0 in virtual-wire mode. They run in auto-EOI mode, since irq_handler()
+// only acknowledges the LAPIC.
+static void use_pic() {
+    remap_pic(PIC_ICW4_8086 | PIC_ICW4_AUTO_EOI);
+    for (uint32_t irq = 0; irq < ISA_IRQS; irq++) {
+        if (irq == ISA_CASCADE_IRQ) continue;
+        IRQ::set_chip(IRQ::ISA_VECTOR_BASE + irq, &pic_chip, irq);
+    }
+}
+
+static void parse_madt(const MadtHeader* madt) {
+    const uint8_t* ptr = (const uint8_t*)(madt + 1);
+    const uint8_t* end = (const uint8_t*)madt + madt->header.length;
+
+    while (ptr + sizeof(MadtEntry) <= end) {
+        const MadtEntry* entry = (const MadtEntry*)ptr;
+        if (entry->length < sizeof(MadtEntry)) break;
+
+        if (entry->type == MADT_IOAPIC && ioapic_count < MAX_IOAPICS) {
+            const MadtIoApic* info = (const MadtIoApic*)entry;
+            IoApic* io = &ioapics[ioapic_count++];
+            io->base = (uint64_t)VMM::map_mmio(info->address, PAGE_SIZE);
+            io->gsi_base = info->gsi_base;
+            io->pins = ((read_reg(io, IOAPIC_VERSION) >> 16) & 0xFF) + 1;
+        } else if (entry->type == MADT_ISO) {
+            const MadtIso* iso = (const MadtIso*)entry;
+            if (iso->bus == 0 && iso->source < ISA_IRQS) {
+                isa_routes[iso->source].gsi = iso->gsi;
+                isa_routes[iso->source].flags = iso->flags;
+            }
+        }
+
+        ptr += entry->length;
+    }
+}
+
+void initialize() {
+    for (uint32_t irq = 0; irq < ISA_IRQS; irq++) {
+        isa_routes[irq].gsi = irq;
+        isa_routes[irq].flags = 0;
+    }
+
+    const MadtHeader* madt = (const MadtHeader*)ACPI::find_table("APIC");
+    if (madt) {
+        parse_madt(madt);
+    }
+
+    if (ioapic_count == 0) {
+        use_pic();
+        Console::printf("[IOAPIC] No IOAPIC found, ISA IRQs stay on the 8259 PIC\n");
+        return;
+    }
+
+    remap_pic(PIC_ICW4_8086);
+
+    for (uint32_t i = 0; i < ioapic_count; i++) {
+        for (uint32_t pin = 0; pin < ioapics[i].pins; pin++) {
+            write_reg(&ioapics[i], IOAPIC_REDTBL + pin * 2, REDIR_MASKED);
+        }
+    }
+
+    // ISA interrupts default to edge-triggered, active high.
+    for (uint32_t irq = 0; irq < ISA_IRQS; irq++) {
+        if (irq == ISA_CASCADE_IRQ) continue;
+
+        uint16_t flags = isa_routes[irq].flags;
+        program_pin(isa_routes[irq].gsi, IRQ::ISA_VECTOR_BASE + irq,
+                    (flags & ISO_TRIGGER_MASK) == ISO_LEVEL,
+                    (flags & ISO_POLARITY_MASK) == ISO_ACTIVE_LOW);
+    }
+}
+
+uint32_t get_pin_count() {
+    uint32_t pins = 0;
+    for (uint32_t i = 0; i < ioapic_count; i++) {
+        pins += ioapics[i].pins;
+    }
+    return pins;
+}
+
+int map_gsi(uint32_t gsi, bool level_triggered, bool active_low) {
+    if (!find_ioapic(gsi)) {
+        return E_INVAL;
+    }
+
+    int vector = IRQ::alloc_vector();
+    if (vector < 0) {
+        return vector;
+    }
+
+    program_pin(gsi, vector, level_triggered, active_low);
+    return vector;
+}
+
+}
+}
\ No newline at end of file
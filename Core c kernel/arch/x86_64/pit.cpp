@@ -1,12 +1,34 @@
 #include <kernel/arch/x86_64/pit.h>
 #include <kernel/arch/x86_64/io.h>
+#include <kernel/process/scheduler.h>
+#include <kernel/irq/softirq.h>
+#include <kernel/irq/irq.h>
+#include <kernel/time/clock.h>
+#include <kernel/time/timer.h>
 
 namespace Core {
 namespace PIT {
 
+#define PIT_VECTOR 32
+
 static volatile uint64_t ticks = 0;
 
+static bool timer_interrupt(uint8_t, void*) {
+    ticks++;
+    Softirq::raise(SOFTIRQ_TIMER);
+    return true;
+}
+
+static void timer_softirq() {
+    Clock::tick();
+    Timer::run_expired();
+    Scheduler::tick();
+}
+
 void initialize(uint32_t frequency) {
+    Softirq::register_handler(SOFTIRQ_TIMER, timer_softirq);
+    request_irq(PIT_VECTOR, timer_interrupt, nullptr, "pit");
+
     uint32_t divisor = 1193182 / frequency;
     
     IO::outb(0x43, 0x36);
@@ -20,14 +42,16 @@ uint64_t get_ticks() {
 
 void sleep(uint32_t ms) {
     uint64_t end_tick = ticks + ms;
+
+    if (Scheduler::can_block()) {
+        Scheduler::sleep_until(end_tick);
+        return;
+    }
+
     while (ticks < end_tick) {
         __asm__ volatile("hlt");
     }
 }
 
-extern "C" void pit_tick() {
-    ticks++;
-}
-
 }
 }
\ No newline at end of file
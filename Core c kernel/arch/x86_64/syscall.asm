@@ -0,0 +1,99 @@
+section .text
+bits 64
+
+extern syscall_table
+extern syscall_resched
+
+; Must match the CPU_LOCAL_* offsets in cpu.h.
+%define CPU_NEED_RESCHED 48
+%define CPU_KERNEL_RSP   56
+%define CPU_USER_RSP     64
+
+%define NR_SYSCALLS      24
+%define E_NOSYS          -7
+
+; Return to ring 3 with the user RSP already loaded.
+%macro SYSRET_TO_USER 0
+    swapgs
+    o64 sysret
+%endmacro
+
+; Entered with interrupts masked (FMASK), RCX = user RIP, R11 = user RFLAGS.
+global syscall_entry
+syscall_entry:
+    swapgs
+    mov [gs:CPU_USER_RSP], rsp
+    mov rsp, [gs:CPU_KERNEL_RSP]
+
+    ; Build the SyscallFrame (syscall.h). The argument registers are
+    ; reloaded from it on return, so handlers can pass results back through
+    ; them and nothing the kernel left in them reaches user mode.
+    push qword [gs:CPU_USER_RSP]
+    push r11
+    push rcx
+    push rdi
+    push rsi
+    push rdx
+    push r10
+    push r8
+    push r9
+    sub rsp, 8
+    sti
+
+    cmp rax, NR_SYSCALLS
+    jae .bad_syscall
+
+    mov rcx, r10
+    call [syscall_table + rax * 8]
+
+.return:
+    cli
+    cmp byte [gs:CPU_NEED_RESCHED], 0
+    jne .resched
+
+    add rsp, 8
+    pop r9
+    pop r8
+    pop r10
+    pop rdx
+    pop rsi
+    pop rdi
+    pop rcx
+    pop r11
+    pop rsp
+    SYSRET_TO_USER
+
+.bad_syscall:
+    mov rax, E_NOSYS
+    jmp .return
+
+.resched:
+    push rax
+    sub rsp, 8
+    call syscall_resched
+    add rsp, 8
+    pop rax
+    jmp .return
+
+; void syscall_enter_user(uint64_t rip, uint64_t rsp, uint64_t arg)
+global syscall_enter_user
+syscall_enter_user:
+    cli
+    mov rcx, rdi
+    mov rsp, rsi
+    mov rdi, rdx
+    mov r11, 0x202
+    xor eax, eax
+    xor ebx, ebx
+    xor edx, edx
+    xor esi, esi
+    xor ebp, ebp
+    xor r8d, r8d
+    xor r9d, r9d
+    xor r10d, r10d
+    xor r12d, r12d
+    xor r13d, r13d
+    xor r14d, r14d
+    xor r15d, r15d
+    swapgs
+    o64 sysret
\ No newline at end of file
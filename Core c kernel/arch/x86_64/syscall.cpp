@@ -0,0 +1,37 @@
+#include <kernel/syscall.h>
+#include <kernel/arch/x86_64/cpu.h>
+#include <kernel/arch/x86_64/gdt.h>
+
+extern "C" void syscall_entry();
+extern "C" [[noreturn]] void syscall_enter_user(uint64_t rip, uint64_t rsp, uint64_t arg);
+
+namespace Core {
+namespace Syscall {
+
+#define EFER_SCE BIT(0)
+
+#define RFLAGS_TF BIT(8)
+#define RFLAGS_IF BIT(9)
+#define RFLAGS_DF BIT(10)
+#define RFLAGS_NT BIT(14)
+#define RFLAGS_AC BIT(18)
+
+void initialize() {
+    CPU::write_msr(IA32_EFER_MSR, CPU::read_msr(IA32_EFER_MSR) | EFER_SCE);
+
+    // SYSCALL loads CS/SS from STAR[47:32]; SYSRET loads SS from
+    // STAR[63:48] + 8 and CS from STAR[63:48] + 16, both with RPL 3.
+    uint64_t star = ((uint64_t)(KERNEL_DS | 3) << 48) | ((uint64_t)KERNEL_CS << 32);
+    CPU::write_msr(IA32_STAR_MSR, star);
+    CPU::write_msr(IA32_LSTAR_MSR, (uint64_t)syscall_entry);
+
+    // The entry path runs with interrupts off until it is on the kernel stack.
+    CPU::write_msr(IA32_FMASK_MSR, RFLAGS_TF | RFLAGS_IF | RFLAGS_DF | RFLAGS_NT | RFLAGS_AC);
+}
+
+void enter_user(uint64_t rip, uint64_t rsp, uint64_t arg) {
+    syscall_enter_user(rip, rsp, arg);
+}
+
+}
+}
\ No newline at end of file
@@ -0,0 +1,75 @@
+#include <kernel/arch/x86_64/tlb.h>
+#include <kernel/arch/x86_64/apic.h>
+#include <kernel/arch/x86_64/cpu.h>
+#include <kernel/irq/irq.h>
+#include <kernel/sync/spinlock.h>
+
+namespace Core {
+namespace TLB {
+
+// One shootdown at a time; the initiator publishes the batch and spins
+// until every other online CPU has flushed it.
+static Spinlock shootdown_lock("tlb_shootdown");
+static Batch* shootdown_batch;
+static uint32_t shootdown_pending;
+static uint64_t shootdown_count;
+
+static void flush_local(const Batch* batch) {
+    if (batch->full) {
+        uint64_t cr3;
+        __asm__ volatile("mov %%cr3, %0; mov %0, %%cr3" : "=r"(cr3) : : "memory");
+        return;
+    }
+
+    for (uint32_t i = 0; i < batch->count; i++) {
+        __asm__ volatile("invlpg (%0)" : : "r"(batch->pages[i]) : "memory");
+    }
+}
+
+static bool shootdown_interrupt(uint8_t, void*) {
+    flush_local(__atomic_load_n(&shootdown_batch, __ATOMIC_ACQUIRE));
+    __atomic_sub_fetch(&shootdown_pending, 1, __ATOMIC_RELEASE);
+    return true;
+}
+
+void initialize() {
+    request_irq(IRQ::TLB_SHOOTDOWN_VECTOR, shootdown_interrupt, nullptr, "tlb");
+}
+
+void flush(Batch* batch) {
+    if (!batch->count && !batch->full) {
+        return;
+    }
+
+    uint32_t online = CPU::online_count();
+    if (online == 1) {
+        flush_local(batch);
+    } else {
+        ScopedLock guard(shootdown_lock);
+        uint32_t self = CPU::id();
+
+        __atomic_store_n(&shootdown_batch, batch, __ATOMIC_RELEASE);
+        __atomic_store_n(&shootdown_pending, online - 1, __ATOMIC_RELEASE);
+        for (uint32_t cpu = 0; cpu < online; cpu++) {
+            if (cpu != self) {
+                APIC::send_ipi(cpu, IRQ::TLB_SHOOTDOWN_VECTOR);
+            }
+        }
+
+        flush_local(batch);
+        while (__atomic_load_n(&shootdown_pending, __ATOMIC_ACQUIRE)) {
+            CPU::relax();
+        }
+        shootdown_count++;
+    }
+
+    batch->count = 0;
+    batch->full = false;
+}
+
+uint64_t get_shootdown_count() {
+    return shootdown_count;
+}
+
+}
+}
\ No newline at end of file
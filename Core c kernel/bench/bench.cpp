@@ -0,0 +1,119 @@
+#ifdef CONFIG_BENCH
+
+#include <kernel/bench.h>
+#include <kernel/console.h>
+#include <kernel/process/process.h>
+#include <kernel/sync/completion.h>
+#include <kernel/arch/x86_64/cpu.h>
+#include <kernel/arch/x86_64/pit.h>
+
+namespace Core {
+namespace Bench {
+
+#define CALIBRATE_MS 50
+
+struct ThreadRun {
+    bench_func_t func;
+    void* arg;
+    uint32_t remaining;
+    uint32_t go;
+    Completion done;
+};
+
+struct ThreadSlot {
+    ThreadRun* run;
+    uint32_t index;
+};
+
+static uint64_t tsc_per_us = 0;
+
+static void* bench_thread(void* data) {
+    ThreadSlot* slot = (ThreadSlot*)data;
+    ThreadRun* run = slot->run;
+
+    while (!__atomic_load_n(&run->go, __ATOMIC_ACQUIRE)) {
+        CPU::relax();
+    }
+
+    run->func(slot->index, run->arg);
+
+    if (__atomic_sub_fetch(&run->remaining, 1, __ATOMIC_ACQ_REL) == 0) {
+        run->done.complete();
+    }
+    return nullptr;
+}
+
+void run_threads(bench_func_t func, void* arg, uint32_t count) {
+    ThreadRun run;
+    ThreadSlot slots[MAX_THREADS];
+
+    count = MIN(count, MAX_THREADS);
+    run.func = func;
+    run.arg = arg;
+    run.remaining = count;
+    run.go = 0;
+
+    for (uint32_t i = 0; i < count; i++) {
+        slots[i].run = &run;
+        slots[i].index = i;
+        if (!ProcessManager::create_kernel_thread("bench", bench_thread, &slots[i],
+                                                  i % CPU::online_count())) {
+            Console::printf("[BENCH] Failed to start thread %u\n", i);
+            __atomic_sub_fetch(&run.remaining, 1, __ATOMIC_ACQ_REL);
+        }
+    }
+
+    __atomic_store_n(&run.go, 1, __ATOMIC_RELEASE);
+    if (__atomic_load_n(&run.remaining, __ATOMIC_ACQUIRE) > 0) {
+        run.done.wait();
+    }
+}
+
+void run_on_cpus(bench_func_t func, void* arg) {
+    run_threads(func, arg, CPU::online_count());
+}
+
+uint64_t cycles_per_us() {
+    return tsc_per_us;
+}
+
+static void calibrate() {
+    uint64_t start = CPU::rdtsc();
+    PIT::sleep(CALIBRATE_MS);
+    tsc_per_us = (CPU::rdtsc() - start) / (CALIBRATE_MS * 1000);
+    if (tsc_per_us == 0) {
+        tsc_per_us = 1;
+    }
+}
+
+static void* bench_main(void*) {
+    calibrate();
+    Console::printf("[BENCH] %u CPUs online, TSC %llu MHz\n", CPU::online_count(), tsc_per_us);
+
+    spinlock();
+    rcu();
+    queues();
+    syscalls();
+    clock();
+    ipc();
+    channels();
+    io_rings();
+    memory_objects();
+    vfs();
+    page_cache();
+    tmpfs();
+    virtio_blk();
+    block();
+
+    Console::printf("[BENCH] Done\n");
+    return nullptr;
+}
+
+void start() {
+    ProcessManager::create_kernel_thread("bench", bench_main, nullptr);
+}
+
+}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,162 @@
+#ifdef CONFIG_BENCH
+
+#include <kernel/bench.h>
+#include <kernel/console.h>
+#include <kernel/block/block.h>
+#include <kernel/memory/pmm.h>
+#include <kernel/memory/copy.h>
+#include <kernel/process/scheduler.h>
+#include <kernel/arch/x86_64/cpu.h>
+
+namespace Core {
+namespace Bench {
+
+#define BIO_SIZE      4096
+#define BIO_OPS       16384
+#define MAX_DEPTH     32
+#define SPAN_SECTORS  (64ULL * 1024 * 1024 / Block::SECTOR_SIZE)
+
+// Bios kept in flight through the block layer, recycled the same way as
+// the virtio_blk suite: completions push onto `ready`, the submitter takes
+// the list and resubmits it under one plug.
+struct BlockJob {
+    BlockDevice* dev;
+    Bio bios[MAX_DEPTH];
+    uint64_t pages[MAX_DEPTH];
+    Bio* ready;
+    uint64_t completed;
+    uint64_t errors;
+};
+
+static void bio_done(Bio* bio) {
+    BlockJob* job = (BlockJob*)bio->private_data;
+    if (bio->result != E_OK) {
+        __atomic_fetch_add(&job->errors, 1, __ATOMIC_RELAXED);
+    }
+
+    Bio* head = __atomic_load_n(&job->ready, __ATOMIC_RELAXED);
+    do {
+        bio->next = head;
+    } while (!__atomic_compare_exchange_n(&job->ready, &head, bio, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    __atomic_fetch_add(&job->completed, 1, __ATOMIC_RELEASE);
+}
+
+// 4K reads over the first SPAN_SECTORS of the disk, either ascending or
+// random. Returns elapsed cycles.
+static uint64_t run(BlockJob* job, bool sequential) {
+    uint64_t span = MIN(SPAN_SECTORS, job->dev->capacity) / (BIO_SIZE / Block::SECTOR_SIZE);
+    uint64_t seed = 0x9E3779B97F4A7C15ULL;
+    uint64_t issued = 0;
+
+    job->ready = nullptr;
+    job->completed = 0;
+    job->errors = 0;
+    for (uint32_t i = 0; i < MAX_DEPTH; i++) {
+        Bio* bio = &job->bios[i];
+        bio->op = BlockOp::READ;
+        bio->phys = job->pages[i];
+        bio->len = BIO_SIZE;
+        bio->done = bio_done;
+        bio->private_data = job;
+        bio->next = job->ready;
+        job->ready = bio;
+    }
+
+    uint64_t start = CPU::rdtsc();
+    while (__atomic_load_n(&job->completed, __ATOMIC_ACQUIRE) < BIO_OPS) {
+        Bio* list = __atomic_exchange_n(&job->ready, nullptr, __ATOMIC_ACQUIRE);
+        if (!list || issued >= BIO_OPS) {
+            Scheduler::yield();
+            continue;
+        }
+
+        BlockPlug plug;
+        Block::start_plug(&plug);
+        while (list && issued < BIO_OPS) {
+            Bio* bio = list;
+            list = bio->next;
+
+            uint64_t block = sequential ? issued % span : seed % span;
+            seed ^= seed << 13;
+            seed ^= seed >> 7;
+            seed ^= seed << 17;
+            bio->sector = block * (BIO_SIZE / Block::SECTOR_SIZE);
+            issued++;
+            Block::submit(job->dev, bio);
+        }
+        Block::finish_plug(&plug);
+    }
+    return CPU::rdtsc() - start;
+}
+
+// Sequential reads should reach the driver as a few large requests, random
+// ones one bio per request; "deadline" trades a little latency for sorted
+// dispatch on single-queue devices.
+static void workload(BlockJob* job, const char* sched, bool sequential) {
+    if (Block::set_scheduler(job->dev, sched) != E_OK) {
+        Console::printf("[BENCH] block/%s: scheduler unavailable, skipped\n", sched);
+        return;
+    }
+
+    Block::reset_stats(job->dev);
+    uint64_t us = MAX(run(job, sequential) / cycles_per_us(), 1ULL);
+    BlockStats stats = Block::get_stats(job->dev);
+    uint64_t requests = MAX(stats.requests, 1ULL);
+
+    Console::printf("[BENCH] block/%s/%s: %llu IOPS (%llu MB/s), %llu requests of %llu KB avg, %llu merged, %s\n",
+                    sched, sequential ? "seq" : "rand", (uint64_t)BIO_OPS * 1000000 / us,
+                    (uint64_t)BIO_OPS * BIO_SIZE / us, stats.requests,
+                    stats.read_sectors * Block::SECTOR_SIZE / 1024 / requests, stats.merges,
+                    job->errors ? "FAILED" : "OK");
+    Console::printf("[BENCH]   depth %llu avg, %llu max; latency p50 < %llu us, p99 < %llu us\n",
+                    stats.depth_sum / requests, stats.max_inflight,
+                    Block::latency_percentile(stats, 500), Block::latency_percentile(stats, 990));
+}
+
+void block() {
+    BlockDevice* dev = Block::get_devices();
+    if (!dev) {
+        Console::printf("[BENCH] block: no registered device, skipped\n");
+        return;
+    }
+
+    uint64_t phys = PMM::alloc_page();
+    if (!phys) {
+        Console::printf("[BENCH] block: out of memory\n");
+        return;
+    }
+    BlockJob* job = (BlockJob*)(phys + KERNEL_VIRTUAL_BASE);
+    static_assert(sizeof(BlockJob) <= PAGE_SIZE, "BlockJob must fit in a page");
+    zero_pages(job, 1);
+    job->dev = dev;
+
+    bool ok = true;
+    for (uint32_t i = 0; i < MAX_DEPTH && ok; i++) {
+        job->pages[i] = PMM::alloc_page();
+        ok = job->pages[i] != 0;
+    }
+
+    if (ok) {
+        // Runs only return once every bio has completed, so the device is
+        // idle and the scheduler can be switched.
+        const BlockScheduler* original = dev->sched;
+        static const char* const schedulers[] = {"none", "deadline"};
+        for (const char* sched : schedulers) {
+            workload(job, sched, true);
+            workload(job, sched, false);
+        }
+        Block::set_scheduler(dev, original->name);
+    } else {
+        Console::printf("[BENCH] block: out of memory\n");
+    }
+
+    for (uint32_t i = 0; i < MAX_DEPTH; i++) {
+        if (job->pages[i]) PMM::free_page(job->pages[i]);
+    }
+    PMM::free_page(phys);
+}
+
+}
+}
+
+#endif
\ No newline at end of file
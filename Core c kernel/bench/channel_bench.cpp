@@ -0,0 +1,180 @@
+#ifdef CONFIG_BENCH
+
+#include <kernel/bench.h>
+#include <kernel/console.h>
+#include <kernel/ipc/channel.h>
+#include <kernel/memory/pmm.h>
+#include <kernel/memory/copy.h>
+#include <kernel/process/process.h>
+#include <kernel/sync/completion.h>
+#include <kernel/arch/x86_64/cpu.h>
+
+namespace Core {
+namespace Bench {
+
+#define CHANNEL_SLOTS   256
+#define CHANNEL_ARENA   (2 * 1024 * 1024)
+#define BULK_SIZE       (64 * 1024)
+#define BULK_BYTES      (256ULL * 1024 * 1024)
+#define SMALL_SIZE      64
+#define SMALL_MESSAGES  2000000
+
+// Writer and reader run on different CPUs when there are two. Both check
+// sequence numbers, so a lost, duplicated or torn message counts as an
+// error; the notification count is the number of kernel entries.
+struct Transfer {
+    Channel* channel;
+    uint32_t size;
+    uint64_t messages;
+    uint8_t* src;
+    uint8_t* dst;
+    uint64_t notifies;
+    uint64_t waits;
+    uint64_t errors;
+    Completion done;
+};
+
+static void move(void* dst, const void* src, uint32_t size) {
+    if (size >= PAGE_SIZE) {
+        copy_pages(dst, src, size / PAGE_SIZE);
+    } else {
+        for (uint32_t i = 0; i < size / sizeof(uint64_t); i++) {
+            ((uint64_t*)dst)[i] = ((const uint64_t*)src)[i];
+        }
+    }
+}
+
+static void* writer_thread(void* arg) {
+    Transfer* t = (Transfer*)arg;
+    ChannelWriter writer;
+    writer.attach(t->channel->shared);
+
+    for (uint64_t seq = 0; seq < t->messages; seq++) {
+        void* buf;
+        while (!(buf = writer.reserve(t->size))) {
+            writer.prepare_wait();
+            if ((buf = writer.reserve(t->size))) {
+                break;
+            }
+            __atomic_fetch_add(&t->waits, 1, __ATOMIC_RELAXED);
+            channel_wait(t->channel, ChannelSide::WRITER, writer.wait_token());
+        }
+
+        *(uint64_t*)t->src = seq;
+        move(buf, t->src, t->size);
+
+        if (writer.commit(t->size, 0)) {
+            __atomic_fetch_add(&t->notifies, 1, __ATOMIC_RELAXED);
+            channel_notify(t->channel, ChannelSide::READER);
+        }
+    }
+
+    t->done.complete();
+    return nullptr;
+}
+
+static void* reader_thread(void* arg) {
+    Transfer* t = (Transfer*)arg;
+    ChannelReader reader;
+    reader.attach(t->channel->shared);
+
+    for (uint64_t seq = 0; seq < t->messages; seq++) {
+        void* data;
+        const ChannelDesc* desc;
+        while (!(desc = reader.peek(&data))) {
+            __atomic_fetch_add(&t->waits, 1, __ATOMIC_RELAXED);
+            channel_wait(t->channel, ChannelSide::READER, reader.wait_token());
+        }
+
+        move(t->dst, data, desc->length);
+        if (desc->length != t->size || *(uint64_t*)t->dst != seq) {
+            t->errors++;
+        }
+
+        if (reader.release()) {
+            __atomic_fetch_add(&t->notifies, 1, __ATOMIC_RELAXED);
+            channel_notify(t->channel, ChannelSide::WRITER);
+        }
+    }
+
+    t->done.complete();
+    return nullptr;
+}
+
+static void transfer(const char* name, uint32_t size, uint64_t messages) {
+    uint32_t buf_pages = ALIGN_UP(size, PAGE_SIZE) / PAGE_SIZE;
+    uint64_t src = PMM::alloc_pages(buf_pages);
+    uint64_t dst = PMM::alloc_pages(buf_pages);
+
+    Transfer t;
+    t.channel = channel_create(CHANNEL_SLOTS, CHANNEL_ARENA);
+    t.size = size;
+    t.messages = messages;
+    t.src = (uint8_t*)(src + KERNEL_VIRTUAL_BASE);
+    t.dst = (uint8_t*)(dst + KERNEL_VIRTUAL_BASE);
+    t.notifies = 0;
+    t.waits = 0;
+    t.errors = 0;
+
+    uint32_t reader_cpu = CPU::online_count() > 1 ? 1 : 0;
+    uint64_t start = CPU::rdtsc();
+
+    if (!t.channel || !src || !dst) {
+        Console::printf("[BENCH] channel/%s: out of memory\n", name);
+    } else if (!ProcessManager::create_kernel_thread("chan-reader", reader_thread, &t, reader_cpu)) {
+        Console::printf("[BENCH] channel/%s: failed to start reader\n", name);
+    } else if (!ProcessManager::create_kernel_thread("chan-writer", writer_thread, &t, 0)) {
+        // The reader never finishes; leave everything to it rather than hang.
+        Console::printf("[BENCH] channel/%s: failed to start writer\n", name);
+        return;
+    } else {
+        t.done.wait();
+        t.done.wait();
+
+        uint64_t us = (CPU::rdtsc() - start) / cycles_per_us();
+        uint64_t bytes = (uint64_t)size * messages;
+        Console::printf("[BENCH] channel/%s: %llu MB/s, %llu msgs/ms, %llu notifies, %llu waits, %s\n",
+                        name, us ? bytes / us : 0, us ? messages * 1000 / us : 0,
+                        t.notifies, t.waits, t.errors ? "FAILED" : "OK");
+        if (t.errors) {
+            Console::printf("[BENCH]   %llu errors\n", t.errors);
+        }
+    }
+
+    if (t.channel) channel_put(t.channel);
+    if (src) PMM::free_pages(src, buf_pages);
+    if (dst) PMM::free_pages(dst, buf_pages);
+}
+
+// Single-threaded copy of the same volume, as a ceiling for the bulk run.
+static void copy_baseline() {
+    uint32_t pages = BULK_SIZE / PAGE_SIZE;
+    uint64_t src = PMM::alloc_pages(pages);
+    uint64_t dst = PMM::alloc_pages(pages);
+    if (!src || !dst) {
+        if (src) PMM::free_pages(src, pages);
+        if (dst) PMM::free_pages(dst, pages);
+        return;
+    }
+
+    uint64_t start = CPU::rdtsc();
+    for (uint64_t done = 0; done < BULK_BYTES; done += BULK_SIZE) {
+        copy_pages((void*)(dst + KERNEL_VIRTUAL_BASE), (void*)(src + KERNEL_VIRTUAL_BASE), pages);
+    }
+    uint64_t us = (CPU::rdtsc() - start) / cycles_per_us();
+    Console::printf("[BENCH] channel/memcpy: %llu MB/s\n", us ? BULK_BYTES / us : 0);
+
+    PMM::free_pages(src, pages);
+    PMM::free_pages(dst, pages);
+}
+
+void channels() {
+    copy_baseline();
+    transfer("bulk", BULK_SIZE, BULK_BYTES / BULK_SIZE);
+    transfer("small", SMALL_SIZE, SMALL_MESSAGES);
+}
+
+}
+}
+
+#endif
\ No newline at end of file
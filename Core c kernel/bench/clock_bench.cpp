@@ -0,0 +1,48 @@
+#ifdef CONFIG_BENCH
+
+#include <kernel/bench.h>
+#include <kernel/console.h>
+#include <kernel/time/clock.h>
+#include <kernel/time/vdso.h>
+#include <kernel/arch/x86_64/cpu.h>
+#include <kernel/arch/x86_64/pit.h>
+
+namespace Core {
+namespace Bench {
+
+#define ITERATIONS 100000
+
+typedef uint64_t (*clock_func_t)();
+
+static uint64_t pit_ticks() {
+    return PIT::get_ticks();
+}
+
+static void measure(const char* name, clock_func_t func) {
+    uint64_t sink = 0;
+    uint64_t start = CPU::rdtsc();
+    for (uint32_t i = 0; i < ITERATIONS; i++) {
+        sink += func();
+    }
+    uint64_t cycles = CPU::rdtsc() - start;
+    __asm__ volatile("" : : "r"(sink));
+
+    Console::printf("[BENCH] %-20s %llu cycles/read\n", name, cycles / ITERATIONS);
+}
+
+void clock() {
+    measure("PIT::get_ticks", pit_ticks);
+    measure("Clock::monotonic_ns", Clock::monotonic_ns);
+    // The same page user processes call; nothing in it depends on CPL.
+    measure("vdso monotonic", (clock_func_t)VDSO_CLOCK_MONOTONIC);
+
+    uint64_t a = ((clock_func_t)VDSO_CLOCK_MONOTONIC)();
+    uint64_t b = Clock::monotonic_ns();
+    uint64_t c = ((clock_func_t)VDSO_CLOCK_MONOTONIC)();
+    Console::printf("[BENCH] vdso/kernel clock agreement: %s\n", a <= b && b <= c ? "OK" : "FAILED");
+}
+
+}
+}
+
+#endif
\ No newline at end of file
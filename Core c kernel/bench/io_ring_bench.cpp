@@ -0,0 +1,221 @@
+#ifdef CONFIG_BENCH
+
+#include <kernel/bench.h>
+#include <kernel/console.h>
+#include <kernel/ipc/io_ring.h>
+#include <kernel/ipc/ipc.h>
+#include <kernel/process/process.h>
+#include <kernel/process/scheduler.h>
+#include <kernel/sync/completion.h>
+#include <kernel/arch/x86_64/cpu.h>
+
+namespace Core {
+namespace Bench {
+
+#define RING_ENTRIES   256
+#define NOP_OPS        200000
+#define SEND_OPS       100000
+#define TIMEOUTS       8
+
+static void report(const char* name, uint64_t ops, uint64_t cycles, uint64_t errors) {
+    Console::printf("[BENCH] io_ring/%s: %llu cycles/op, %s\n", name,
+                    ops ? cycles / ops : 0, errors ? "FAILED" : "OK");
+    if (errors) {
+        Console::printf("[BENCH]   %llu errors\n", errors);
+    }
+}
+
+// Reaps every available CQE; wrong results and out-of-order user_data
+// count as errors when `expected` is given.
+static uint64_t reap(IoRingClient& client, uint64_t* errors, uint64_t* expected = nullptr) {
+    uint64_t count = 0;
+    const IoCqe* cqe;
+
+    while ((cqe = client.peek_cqe())) {
+        if (cqe->result != E_OK || (expected && cqe->user_data != (*expected)++)) {
+            (*errors)++;
+        }
+        client.cqe_seen();
+        count++;
+    }
+    return count;
+}
+
+static void nops(const char* name, uint32_t batch) {
+    IoRing* ring = io_ring_create(RING_ENTRIES, 0);
+    if (!ring) {
+        Console::printf("[BENCH] io_ring/%s: out of memory\n", name);
+        return;
+    }
+
+    IoRingClient client;
+    client.attach(ring->shared);
+    uint64_t errors = 0;
+    uint64_t expected = 0;
+
+    uint64_t start = CPU::rdtsc();
+    for (uint64_t done = 0; done < NOP_OPS; done += batch) {
+        for (uint32_t i = 0; i < batch; i++) {
+            IoSqe* sqe = client.get_sqe();
+            sqe->opcode = IO_OP_NOP;
+            sqe->user_data = done + i;
+        }
+        io_ring_enter(ring, client.flush(), batch, IO_ENTER_GETEVENTS);
+        reap(client, &errors, &expected);
+    }
+    report(name, NOP_OPS, CPU::rdtsc() - start, errors + (expected != NOP_OPS));
+
+    io_ring_put(ring);
+}
+
+// No syscalls while the polling thread is awake; the wakeup count is the
+// number of kernel entries needed.
+static void sqpoll() {
+    IoRing* ring = io_ring_create(RING_ENTRIES, IO_RING_SQPOLL);
+    if (!ring) {
+        Console::printf("[BENCH] io_ring/sqpoll: out of memory\n");
+        return;
+    }
+
+    IoRingClient client;
+    client.attach(ring->shared);
+    uint64_t errors = 0;
+    uint64_t expected = 0;
+    uint64_t wakeups = 0;
+    uint64_t submitted = 0;
+
+    uint64_t start = CPU::rdtsc();
+    while (expected < NOP_OPS) {
+        IoSqe* sqe;
+        while (submitted < NOP_OPS && submitted - expected < RING_ENTRIES && (sqe = client.get_sqe())) {
+            sqe->opcode = IO_OP_NOP;
+            sqe->user_data = submitted++;
+        }
+
+        if (client.flush() && client.needs_wakeup()) {
+            io_ring_enter(ring, 0, 0, IO_ENTER_SQ_WAKEUP);
+            wakeups++;
+        }
+
+        if (!reap(client, &errors, &expected)) {
+            Scheduler::yield();
+        }
+    }
+    report("sqpoll", NOP_OPS, CPU::rdtsc() - start, errors);
+    Console::printf("[BENCH]   %llu wakeups\n", wakeups);
+
+    io_ring_put(ring);
+}
+
+struct SendServer {
+    Endpoint* ep;
+    uint64_t received;
+    uint64_t label_sum;
+    Completion done;
+};
+
+static void* send_server(void* arg) {
+    SendServer* server = (SendServer*)arg;
+    IpcMessage msg;
+
+    for (uint64_t i = 0; i < SEND_OPS; i++) {
+        ipc_receive(server->ep, &msg);
+        server->received++;
+        server->label_sum += msg.label;
+    }
+
+    server->done.complete();
+    return nullptr;
+}
+
+// Sends complete inline when the server is already waiting and stay queued
+// on the endpoint otherwise, so completions come back out of order; only
+// totals are checked.
+static void sends() {
+    SendServer server;
+    server.ep = endpoint_create();
+    server.received = 0;
+    server.label_sum = 0;
+
+    IoRing* ring = io_ring_create(RING_ENTRIES, 0);
+    int handle = server.ep ? ProcessManager::get_current()->handles.install(&server.ep->obj) : E_NOMEM;
+
+    if (!ring || handle < 0) {
+        Console::printf("[BENCH] io_ring/ipc_send: out of memory\n");
+    } else if (!ProcessManager::create_kernel_thread("io-server", send_server, &server,
+                                                      CPU::online_count() > 1 ? 1 : 0)) {
+        Console::printf("[BENCH] io_ring/ipc_send: failed to start server\n");
+    } else {
+        IoRingClient client;
+        client.attach(ring->shared);
+        uint64_t errors = 0;
+        uint64_t completed = 0;
+        uint64_t submitted = 0;
+
+        uint64_t start = CPU::rdtsc();
+        while (completed < SEND_OPS) {
+            IoSqe* sqe;
+            while (submitted < SEND_OPS && submitted - completed < RING_ENTRIES && (sqe = client.get_sqe())) {
+                sqe->opcode = IO_OP_IPC_SEND;
+                sqe->handle = handle;
+                sqe->user_data = submitted;
+                sqe->args[0] = submitted++;
+            }
+            io_ring_enter(ring, client.flush(), 1, IO_ENTER_GETEVENTS);
+            completed += reap(client, &errors);
+        }
+        server.done.wait();
+
+        uint64_t label_sum = (uint64_t)SEND_OPS * (SEND_OPS - 1) / 2;
+        report("ipc_send", SEND_OPS, CPU::rdtsc() - start,
+               errors + (server.received != SEND_OPS) + (server.label_sum != label_sum));
+    }
+
+    if (handle >= 0) ProcessManager::get_current()->handles.close(handle);
+    if (server.ep) endpoint_put(server.ep);
+    if (ring) io_ring_put(ring);
+}
+
+// Armed longest first; must complete shortest first.
+static void timeouts() {
+    IoRing* ring = io_ring_create(RING_ENTRIES, 0);
+    if (!ring) {
+        Console::printf("[BENCH] io_ring/timeout: out of memory\n");
+        return;
+    }
+
+    IoRingClient client;
+    client.attach(ring->shared);
+    uint64_t errors = 0;
+    uint64_t expected = 1;
+
+    for (uint32_t ms = TIMEOUTS; ms >= 1; ms--) {
+        IoSqe* sqe = client.get_sqe();
+        sqe->opcode = IO_OP_TIMEOUT;
+        sqe->user_data = ms;
+        sqe->args[0] = ms * 1000000ULL;
+    }
+
+    uint64_t start = CPU::rdtsc();
+    io_ring_enter(ring, client.flush(), TIMEOUTS, IO_ENTER_GETEVENTS);
+    uint64_t us = (CPU::rdtsc() - start) / cycles_per_us();
+    reap(client, &errors, &expected);
+
+    Console::printf("[BENCH] io_ring/timeout: %u timers in %llu us, %s\n", TIMEOUTS, us,
+                    errors || expected != TIMEOUTS + 1 ? "FAILED" : "OK");
+
+    io_ring_put(ring);
+}
+
+void io_rings() {
+    nops("nop_single", 1);
+    nops("nop_batch32", 32);
+    sqpoll();
+    sends();
+    timeouts();
+}
+
+}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,116 @@
+#ifdef CONFIG_BENCH
+
+#include <kernel/bench.h>
+#include <kernel/console.h>
+#include <kernel/ipc/ipc.h>
+#include <kernel/process/process.h>
+#include <kernel/sync/completion.h>
+#include <kernel/arch/x86_64/cpu.h>
+
+namespace Core {
+namespace Bench {
+
+#define ROUND_TRIPS 100000
+#define LABEL_STOP  ~0ULL
+
+// Client and server play ping-pong over one endpoint; the server bumps every
+// word so a reply routed to the wrong caller shows up as an error.
+struct PingPong {
+    Endpoint* ep;
+    uint64_t cycles;
+    uint64_t errors;
+    Completion client_done;
+    Completion server_done;
+};
+
+static void* server_thread(void* arg) {
+    PingPong* pp = (PingPong*)arg;
+    IpcMessage msg;
+
+    ipc_receive(pp->ep, &msg);
+    while (msg.label != LABEL_STOP) {
+        msg.label++;
+        for (uint32_t i = 0; i < IPC_MSG_WORDS; i++) {
+            msg.words[i]++;
+        }
+        ipc_reply_wait(pp->ep, &msg);
+    }
+
+    ipc_reply(&msg);
+    pp->server_done.complete();
+    return nullptr;
+}
+
+static void* client_thread(void* arg) {
+    PingPong* pp = (PingPong*)arg;
+    IpcMessage msg;
+
+    uint64_t start = CPU::rdtsc();
+    for (uint64_t i = 0; i < ROUND_TRIPS; i++) {
+        msg.label = i;
+        for (uint32_t w = 0; w < IPC_MSG_WORDS; w++) {
+            msg.words[w] = i + w;
+        }
+
+        error_t err = ipc_call(pp->ep, &msg);
+        if (err != E_OK || msg.label != i + 1 || msg.words[IPC_MSG_WORDS - 1] != i + IPC_MSG_WORDS) {
+            pp->errors++;
+        }
+    }
+    pp->cycles = CPU::rdtsc() - start;
+
+    msg.label = LABEL_STOP;
+    ipc_call(pp->ep, &msg);
+    pp->client_done.complete();
+    return nullptr;
+}
+
+static void ping_pong(const char* name, uint32_t client_cpu, uint32_t server_cpu, bool direct) {
+    PingPong pp;
+    pp.ep = endpoint_create();
+    pp.cycles = 0;
+    pp.errors = 0;
+    if (!pp.ep) {
+        Console::printf("[BENCH] ipc/%s: out of memory\n", name);
+        return;
+    }
+
+    ipc_set_direct_switch(direct);
+
+    if (!ProcessManager::create_kernel_thread("ipc-server", server_thread, &pp, server_cpu)) {
+        Console::printf("[BENCH] ipc/%s: failed to start server\n", name);
+        endpoint_put(pp.ep);
+        return;
+    }
+    if (!ProcessManager::create_kernel_thread("ipc-client", client_thread, &pp, client_cpu)) {
+        // Nobody else will stop the server; leak it rather than hang.
+        Console::printf("[BENCH] ipc/%s: failed to start client\n", name);
+        return;
+    }
+
+    pp.client_done.wait();
+    pp.server_done.wait();
+
+    Console::printf("[BENCH] ipc/%s: %llu cycles/round trip, %s\n", name,
+                    pp.cycles / ROUND_TRIPS, pp.errors ? "FAILED" : "OK");
+    if (pp.errors) {
+        Console::printf("[BENCH]   %llu errors\n", pp.errors);
+    }
+
+    endpoint_put(pp.ep);
+    ipc_set_direct_switch(true);
+}
+
+void ipc() {
+    ping_pong("direct", 0, 0, true);
+    ping_pong("runqueue", 0, 0, false);
+
+    if (CPU::online_count() > 1) {
+        ping_pong("cross-cpu", 0, 1, true);
+    }
+}
+
+}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,105 @@
+#ifdef CONFIG_BENCH
+
+#include <kernel/bench.h>
+#include <kernel/console.h>
+#include <kernel/ipc/memory_object.h>
+#include <kernel/memory/copy.h>
+#include <kernel/arch/x86_64/cpu.h>
+#include <kernel/arch/x86_64/tlb.h>
+
+namespace Core {
+namespace Bench {
+
+#define MIN_SIZE        (4 * 1024)
+#define MAX_SIZE        (64 * 1024 * 1024)
+#define ROUNDS          8
+
+#define SOURCE_ADDR     (USER_SPACE_START + 0x40000000ULL)
+#define COPY_ADDR       (USER_SPACE_START + 0x80000000ULL)
+#define TRANSFER_ADDR_A (USER_SPACE_START + 0xC0000000ULL)
+#define TRANSFER_ADDR_B (USER_SPACE_START + 0x100000000ULL)
+
+static void stamp(uint64_t addr, size_t pages) {
+    for (size_t i = 0; i < pages; i++) {
+        *(volatile uint64_t*)(addr + i * PAGE_SIZE) = i ^ 0x5A5A5A5A;
+    }
+}
+
+static bool verify(uint64_t addr, size_t pages) {
+    for (size_t i = 0; i < pages; i++) {
+        if (*(volatile uint64_t*)(addr + i * PAGE_SIZE) != (i ^ 0x5A5A5A5A)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Copying `size` bytes between two mapped objects against moving the
+// object's pages to a new address, which ping-pongs between two
+// destinations. Data must survive every transfer.
+static void transfer(size_t size) {
+    size_t pages = size / PAGE_SIZE;
+    MemoryObject* source = memory_object_create(size);
+    MemoryObject* copy = memory_object_create(size);
+    if (!source || !copy) {
+        Console::printf("[BENCH] memory/%lluK: out of memory\n", (uint64_t)size / 1024);
+        if (source) memory_object_put(source);
+        if (copy) memory_object_put(copy);
+        return;
+    }
+
+    // Unmapped explicitly below: the final put tears mappings down from a
+    // workqueue, too late for the next size to reuse the addresses.
+    if (memory_object_map(source, SOURCE_ADDR, true) != E_OK ||
+        memory_object_map(copy, COPY_ADDR, true) != E_OK) {
+        Console::printf("[BENCH] memory/%lluK: map failed\n", (uint64_t)size / 1024);
+        memory_object_unmap(source, SOURCE_ADDR);
+        memory_object_put(source);
+        memory_object_put(copy);
+        return;
+    }
+    stamp(SOURCE_ADDR, pages);
+
+    uint64_t start = CPU::rdtsc();
+    for (uint32_t i = 0; i < ROUNDS; i++) {
+        copy_pages((void*)COPY_ADDR, (const void*)SOURCE_ADDR, pages);
+    }
+    uint64_t copy_cycles = (CPU::rdtsc() - start) / ROUNDS;
+    bool ok = verify(COPY_ADDR, pages);
+    memory_object_unmap(copy, COPY_ADDR);
+    memory_object_put(copy);
+
+    uint64_t shootdowns = TLB::get_shootdown_count();
+    uint64_t addr = SOURCE_ADDR;
+    start = CPU::rdtsc();
+    for (uint32_t i = 0; i < ROUNDS && ok; i++) {
+        uint64_t dest = i % 2 ? TRANSFER_ADDR_B : TRANSFER_ADDR_A;
+        MemoryObject* moved = nullptr;
+        if (memory_object_transfer(source, dest, &moved) != E_OK) {
+            ok = false;
+            break;
+        }
+        memory_object_put(source);
+        source = moved;
+        addr = dest;
+    }
+    uint64_t transfer_cycles = (CPU::rdtsc() - start) / ROUNDS;
+    shootdowns = TLB::get_shootdown_count() - shootdowns;
+    ok = ok && verify(addr, pages);
+    memory_object_unmap(source, addr);
+    memory_object_put(source);
+
+    Console::printf("[BENCH] memory/%lluK: copy %llu cycles, transfer %llu cycles, %llu shootdowns, %s\n",
+                    (uint64_t)size / 1024, copy_cycles, transfer_cycles, shootdowns, ok ? "OK" : "FAILED");
+}
+
+void memory_objects() {
+    for (size_t size = MIN_SIZE; size <= MAX_SIZE; size *= 4) {
+        transfer(size);
+    }
+}
+
+}
+}
+
+#endif
\ No newline at end of file
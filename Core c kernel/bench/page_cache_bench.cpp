@@ -0,0 +1,175 @@
+#ifdef CONFIG_BENCH
+
+#include <kernel/bench.h>
+#include <kernel/console.h>
+#include <kernel/fs/vfs.h>
+#include <kernel/fs/page_cache.h>
+#include <kernel/memory/pmm.h>
+#include <kernel/arch/x86_64/cpu.h>
+
+namespace Core {
+namespace Bench {
+
+#define FILE_SIZE       (16 * 1024 * 1024)
+#define CHUNK_SIZE      (64 * 1024)
+#define RANDOM_READS    2048
+// Stand-in for device latency, so misses cost something.
+#define READPAGE_CYCLES 20000
+
+static uint64_t readpage_calls;
+
+static uint64_t pattern(uint64_t ino, uint64_t word) {
+    return (ino << 40) ^ word ^ 0xA5A5A5A5;
+}
+
+static error_t cachefs_readpage(Inode* inode, uint64_t index, void* page) {
+    __atomic_fetch_add(&readpage_calls, 1, __ATOMIC_RELAXED);
+
+    uint64_t* words = (uint64_t*)page;
+    for (uint32_t i = 0; i < PAGE_SIZE / sizeof(uint64_t); i++) {
+        words[i] = pattern(inode->ino, index * (PAGE_SIZE / sizeof(uint64_t)) + i);
+    }
+
+    uint64_t until = CPU::rdtsc() + READPAGE_CYCLES;
+    while (CPU::rdtsc() < until) {
+        CPU::relax();
+    }
+    return E_OK;
+}
+
+static error_t cachefs_lookup(Inode* dir, const char*, uint32_t, Inode** result);
+
+static const InodeOps cachefs_ops = {
+    .lookup = cachefs_lookup,
+    .create = nullptr,
+    .unlink = nullptr,
+    .read = nullptr,
+    .write = nullptr,
+    .readdir = nullptr,
+    .readpage = cachefs_readpage,
+};
+
+// Every name is a fresh FILE_SIZE file.
+static error_t cachefs_lookup(Inode* dir, const char*, uint32_t, Inode** result) {
+    Inode* inode = VFS::alloc_inode(dir->sb, InodeType::FILE, &cachefs_ops);
+    if (!inode) {
+        return E_NOMEM;
+    }
+    inode->size = FILE_SIZE;
+    *result = inode;
+    return E_OK;
+}
+
+static error_t cachefs_mount(SuperBlock* sb, const void*) {
+    sb->root = VFS::alloc_inode(sb, InodeType::DIRECTORY, &cachefs_ops);
+    return sb->root ? E_OK : E_NOMEM;
+}
+
+static FileSystem cachefs = {
+    .name = "cachefs",
+    .mount = cachefs_mount,
+    .evict = nullptr,
+    .next = nullptr,
+};
+
+static bool check(const Inode* inode, const uint8_t* buffer, uint64_t offset, size_t size) {
+    for (size_t pos = 0; pos < size; pos += sizeof(uint64_t)) {
+        if (*(const uint64_t*)(buffer + pos) != pattern(inode->ino, (offset + pos) / sizeof(uint64_t))) {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void report(const char* name, uint64_t pages, uint64_t cycles, uint64_t calls,
+                   const PageCacheStats& before, bool ok) {
+    PageCacheStats after = PageCache::get_stats();
+    Console::printf("[BENCH] page_cache/%s: %llu cycles/page, %llu readpage, %llu hits, %llu misses, "
+                    "%llu readahead, %s\n", name, pages ? cycles / pages : 0, calls,
+                    after.hits - before.hits, after.misses - before.misses,
+                    after.readahead - before.readahead, ok ? "OK" : "FAILED");
+}
+
+static void sequential(File* file, uint8_t* buffer, const char* name) {
+    PageCacheStats before = PageCache::get_stats();
+    uint64_t calls = __atomic_load_n(&readpage_calls, __ATOMIC_RELAXED);
+    bool ok = true;
+
+    file->offset = 0;
+    uint64_t start = CPU::rdtsc();
+    for (uint64_t offset = 0; offset < FILE_SIZE; offset += CHUNK_SIZE) {
+        if (VFS::read(file, buffer, CHUNK_SIZE) != CHUNK_SIZE) {
+            ok = false;
+            break;
+        }
+        ok = ok && check(file->inode, buffer, offset, CHUNK_SIZE);
+    }
+    uint64_t cycles = CPU::rdtsc() - start;
+
+    report(name, FILE_SIZE / PAGE_SIZE, cycles, __atomic_load_n(&readpage_calls, __ATOMIC_RELAXED) - calls,
+           before, ok);
+}
+
+static void random(File* file, uint8_t* buffer) {
+    PageCacheStats before = PageCache::get_stats();
+    uint64_t calls = __atomic_load_n(&readpage_calls, __ATOMIC_RELAXED);
+    uint64_t seed = 0x2545F4914F6CDD1DULL;
+    bool ok = true;
+
+    uint64_t start = CPU::rdtsc();
+    for (uint32_t i = 0; i < RANDOM_READS; i++) {
+        seed ^= seed << 13;
+        seed ^= seed >> 7;
+        seed ^= seed << 17;
+        file->offset = (seed % (FILE_SIZE / PAGE_SIZE)) * PAGE_SIZE;
+
+        uint64_t offset = file->offset;
+        ok = ok && VFS::read(file, buffer, PAGE_SIZE) == PAGE_SIZE && check(file->inode, buffer, offset, PAGE_SIZE);
+    }
+    uint64_t cycles = CPU::rdtsc() - start;
+
+    report("random", RANDOM_READS, cycles, __atomic_load_n(&readpage_calls, __ATOMIC_RELAXED) - calls,
+           before, ok);
+}
+
+void page_cache() {
+    VFS::register_filesystem(&cachefs);
+    // The chunk is as big as the whole kernel heap.
+    Mount* mnt = VFS::kern_mount("cachefs", nullptr);
+    uint64_t phys = PMM::alloc_pages(CHUNK_SIZE / PAGE_SIZE);
+    if (!mnt || !phys) {
+        Console::printf("[BENCH] page_cache: setup failed\n");
+        if (phys) PMM::free_pages(phys, CHUNK_SIZE / PAGE_SIZE);
+        return;
+    }
+    uint8_t* buffer = (uint8_t*)(phys + KERNEL_VIRTUAL_BASE);
+
+    File seq_file = {};
+    File rand_file = {};
+    if (VFS::lookup_at(mnt, "/seq", &seq_file.inode) != E_OK ||
+        VFS::lookup_at(mnt, "/rand", &rand_file.inode) != E_OK) {
+        Console::printf("[BENCH] page_cache: lookup failed\n");
+        PMM::free_pages(phys, CHUNK_SIZE / PAGE_SIZE);
+        return;
+    }
+
+    sequential(&seq_file, buffer, "seq_cold");
+    sequential(&seq_file, buffer, "seq_warm");
+    random(&rand_file, buffer);
+
+    PageCacheStats before = PageCache::get_stats();
+    size_t freed = PageCache::reclaim(before.pages);
+    Console::printf("[BENCH] page_cache/reclaim: %llu of %llu pages evicted, %llu left\n",
+                    (uint64_t)freed, before.pages, PageCache::get_stats().pages);
+
+    sequential(&seq_file, buffer, "seq_refill");
+
+    VFS::put_inode(seq_file.inode);
+    VFS::put_inode(rand_file.inode);
+    PMM::free_pages(phys, CHUNK_SIZE / PAGE_SIZE);
+}
+
+}
+}
+
+#endif
\ No newline at end of file
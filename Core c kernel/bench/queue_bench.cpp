@@ -0,0 +1,166 @@
+#ifdef CONFIG_BENCH
+
+#include <kernel/bench.h>
+#include <kernel/console.h>
+#include <kernel/sync/spsc_ring.h>
+#include <kernel/sync/mpsc_queue.h>
+#include <kernel/sync/lfstack.h>
+#include <kernel/sync/percpu.h>
+#include <kernel/process/scheduler.h>
+#include <kernel/arch/x86_64/cpu.h>
+
+namespace Core {
+namespace Bench {
+
+// Stress tests double as throughput benchmarks: every run checks the
+// container's invariants and reports FAILED if any were violated.
+
+#define QUEUE_SIZE      256
+#define SPSC_ITEMS      2000000
+#define MPSC_PRODUCERS  3
+#define MPSC_ITEMS      500000
+#define STACK_THREADS   4
+#define STACK_NODES     64
+#define STACK_ROUNDS    500000
+#define COUNTER_THREADS 4
+#define COUNTER_ADDS    1000000
+
+static uint64_t start_tsc;
+
+static void report(const char* name, uint64_t ops, uint64_t errors) {
+    uint64_t us = (CPU::rdtsc() - start_tsc) / cycles_per_us();
+    Console::printf("[BENCH] queues/%s: %llu ops/ms, %s\n", name,
+                    us ? ops * 1000 / us : 0, errors ? "FAILED" : "OK");
+    if (errors) {
+        Console::printf("[BENCH]   %llu errors\n", errors);
+    }
+}
+
+// Threads may share a CPU, so waiting sides yield instead of spinning.
+
+static SpscRing<uint64_t, QUEUE_SIZE> spsc;
+static uint64_t spsc_errors;
+
+static void spsc_thread(uint32_t index, void*) {
+    if (index == 0) {
+        for (uint64_t i = 1; i <= SPSC_ITEMS; i++) {
+            while (!spsc.push(i)) {
+                Scheduler::yield();
+            }
+        }
+        return;
+    }
+
+    uint64_t expected = 1;
+    while (expected <= SPSC_ITEMS) {
+        uint64_t value;
+        if (!spsc.pop(value)) {
+            Scheduler::yield();
+            continue;
+        }
+        if (value != expected) {
+            spsc_errors++;
+        }
+        expected = value + 1;
+    }
+}
+
+static MpscQueue<uint64_t, QUEUE_SIZE> mpsc;
+static uint64_t mpsc_errors;
+
+static void mpsc_thread(uint32_t index, void*) {
+    if (index < MPSC_PRODUCERS) {
+        for (uint64_t i = 0; i < MPSC_ITEMS; i++) {
+            while (!mpsc.enqueue(((uint64_t)index << 32) | i)) {
+                Scheduler::yield();
+            }
+        }
+        return;
+    }
+
+    // Per-producer FIFO order must survive the interleaving.
+    uint64_t next[MPSC_PRODUCERS] = {};
+    uint64_t received = 0;
+    while (received < MPSC_PRODUCERS * MPSC_ITEMS) {
+        uint64_t value;
+        if (!mpsc.dequeue(value)) {
+            Scheduler::yield();
+            continue;
+        }
+        uint32_t producer = value >> 32;
+        if (producer >= MPSC_PRODUCERS || (value & 0xFFFFFFFF) != next[producer]) {
+            mpsc_errors++;
+        } else {
+            next[producer]++;
+        }
+        received++;
+    }
+}
+
+struct StackItem {
+    LfStackNode node;
+    uint32_t owned;
+};
+
+static LfStack stack;
+static StackItem stack_items[STACK_NODES];
+static uint64_t stack_errors;
+
+// Each popped node must have exactly one owner; ABA would hand one out twice.
+static void stack_thread(uint32_t, void*) {
+    for (uint32_t round = 0; round < STACK_ROUNDS; round++) {
+        StackItem* item = (StackItem*)stack.pop();
+        if (!item) {
+            continue;
+        }
+        if (__atomic_exchange_n(&item->owned, 1, __ATOMIC_ACQ_REL)) {
+            __atomic_fetch_add(&stack_errors, 1, __ATOMIC_RELAXED);
+        }
+        __atomic_store_n(&item->owned, 0, __ATOMIC_RELEASE);
+        stack.push(&item->node);
+    }
+}
+
+static PerCpuCounter counter;
+
+static void counter_thread(uint32_t, void*) {
+    for (uint32_t i = 0; i < COUNTER_ADDS; i++) {
+        counter.inc();
+    }
+}
+
+void queues() {
+    spsc_errors = 0;
+    start_tsc = CPU::rdtsc();
+    run_threads(spsc_thread, nullptr, 2);
+    report("spsc", SPSC_ITEMS, spsc_errors + !spsc.is_empty());
+
+    mpsc_errors = 0;
+    start_tsc = CPU::rdtsc();
+    run_threads(mpsc_thread, nullptr, MPSC_PRODUCERS + 1);
+    report("mpsc", MPSC_PRODUCERS * MPSC_ITEMS, mpsc_errors);
+
+    stack_errors = 0;
+    for (uint32_t i = 0; i < STACK_NODES; i++) {
+        stack_items[i].owned = 0;
+        stack.push(&stack_items[i].node);
+    }
+    start_tsc = CPU::rdtsc();
+    run_threads(stack_thread, nullptr, STACK_THREADS);
+    uint32_t remaining = 0;
+    for (LfStackNode* node = stack.pop_all(); node; node = node->next) {
+        remaining++;
+    }
+    report("lfstack", STACK_THREADS * STACK_ROUNDS * 2, stack_errors + (remaining != STACK_NODES));
+
+    counter.reset();
+    start_tsc = CPU::rdtsc();
+    run_threads(counter_thread, nullptr, COUNTER_THREADS);
+    report("percpu_counter", COUNTER_THREADS * COUNTER_ADDS,
+           counter.sum() != (int64_t)COUNTER_THREADS * COUNTER_ADDS);
+}
+
+}
+}
+
+#endif
\ No newline at end of file
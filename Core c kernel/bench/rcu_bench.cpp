@@ -0,0 +1,96 @@
+#ifdef CONFIG_BENCH
+
+#include <kernel/bench.h>
+#include <kernel/console.h>
+#include <kernel/lib/radix_tree.h>
+#include <kernel/sync/spinlock.h>
+#include <kernel/sync/rwlock.h>
+#include <kernel/sync/rcu.h>
+#include <kernel/arch/x86_64/cpu.h>
+
+namespace Core {
+namespace Bench {
+
+#define WINDOW_MS      200
+#define TABLE_SIZE     1024
+#define CHECK_INTERVAL 64
+
+// Read-side scaling of a radix tree lookup under each kind of protection.
+enum class ReadSide { SPINLOCK, RWLOCK, RCU };
+
+struct LookupRun {
+    RadixTree tree;
+    Spinlock spinlock;
+    RWLock rwlock;
+    uint64_t deadline;
+    uint64_t lookups[CPU::MAX_CPUS];
+};
+
+static LookupRun run;
+
+template <ReadSide mode>
+static void lookup_loop(uint32_t cpu, void*) {
+    uint64_t count = 0;
+    uint64_t index = cpu;
+
+    while (true) {
+        for (uint32_t i = 0; i < CHECK_INTERVAL; i++) {
+            index = (index + 7) % TABLE_SIZE;
+            if (mode == ReadSide::SPINLOCK) {
+                ScopedLock guard(run.spinlock);
+                run.tree.lookup(index);
+            } else if (mode == ReadSide::RWLOCK) {
+                ScopedReadLock guard(run.rwlock);
+                run.tree.lookup(index);
+            } else {
+                rcu_read_lock();
+                run.tree.lookup(index);
+                rcu_read_unlock();
+            }
+        }
+        count += CHECK_INTERVAL;
+
+        if (CPU::rdtsc() >= run.deadline) {
+            break;
+        }
+    }
+
+    run.lookups[cpu] = count;
+}
+
+template <ReadSide mode>
+static void measure(const char* name) {
+    for (uint32_t cpu = 0; cpu < CPU::MAX_CPUS; cpu++) {
+        run.lookups[cpu] = 0;
+    }
+    run.deadline = CPU::rdtsc() + WINDOW_MS * 1000 * cycles_per_us();
+    run_on_cpus(lookup_loop<mode>, nullptr);
+
+    uint64_t total = 0;
+    for (uint32_t cpu = 0; cpu < CPU::online_count(); cpu++) {
+        total += run.lookups[cpu];
+    }
+
+    Console::printf("[BENCH] rcu/%s: %llu lookups/ms total, %llu per CPU\n",
+                    name, total / WINDOW_MS, total / WINDOW_MS / CPU::online_count());
+}
+
+void rcu() {
+    run.tree.initialize();
+    for (uint64_t i = 0; i < TABLE_SIZE; i++) {
+        run.tree.insert(i, (void*)(i + 1));
+    }
+
+    measure<ReadSide::SPINLOCK>("spinlock");
+    measure<ReadSide::RWLOCK>("rwlock");
+    measure<ReadSide::RCU>("rcu");
+
+    for (uint64_t i = 0; i < TABLE_SIZE; i++) {
+        run.tree.remove(i);
+    }
+}
+
+}
+}
+
+#endif
\ No newline at end of file
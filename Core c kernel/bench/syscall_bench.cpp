@@ -0,0 +1,113 @@
+#ifdef CONFIG_BENCH
+
+#include <kernel/bench.h>
+#include <kernel/console.h>
+#include <kernel/syscall.h>
+#include <kernel/memory/pmm.h>
+#include <kernel/memory/vmm.h>
+#include <kernel/process/process.h>
+#include <kernel/sync/rcu.h>
+#include <kernel/arch/x86_64/pit.h>
+
+namespace Core {
+namespace Bench {
+
+#define ITERATIONS  100000
+#define TIMEOUT_MS  5000
+
+#define CODE_PAGE   (USER_SPACE_START)
+#define DATA_PAGE   (USER_SPACE_START + PAGE_SIZE)
+#define STACK_PAGE  (USER_SPACE_START + 2 * PAGE_SIZE)
+
+struct UserParams {
+    uint64_t iterations;
+    uint64_t cycles;
+};
+
+// Ring 3 loop; RDI points at UserParams.
+//
+//   mov r14, rdi; mov r12, [rdi]; rdtsc; shl rdx, 32; or rax, rdx; mov r13, rax
+//   1: xor eax, eax; syscall; dec r12; jnz 1b
+//   rdtsc; shl rdx, 32; or rax, rdx; sub rax, r13; mov [r14 + 8], rax
+//   mov eax, SYS_EXIT; xor edi, edi; syscall
+static const uint8_t null_syscall_loop[] = {
+    0x49, 0x89, 0xFE, 0x4C, 0x8B, 0x27, 0x0F, 0x31, 0x48, 0xC1, 0xE2, 0x20,
+    0x48, 0x09, 0xD0, 0x49, 0x89, 0xC5,
+    0x31, 0xC0, 0x0F, 0x05, 0x49, 0xFF, 0xCC, 0x75, 0xF7,
+    0x0F, 0x31, 0x48, 0xC1, 0xE2, 0x20, 0x48, 0x09, 0xD0, 0x4C, 0x29, 0xE8,
+    0x49, 0x89, 0x46, 0x08,
+    0xB8, SYS_EXIT, 0x00, 0x00, 0x00, 0x31, 0xFF, 0x0F, 0x05,
+    0xEB, 0xFE,
+};
+
+static void* user_thread(void*) {
+    Syscall::enter_user(CODE_PAGE, STACK_PAGE + PAGE_SIZE, DATA_PAGE);
+}
+
+static bool thread_alive(int tid) {
+    rcu_read_lock();
+    bool alive = ProcessManager::find_thread(tid) != nullptr;
+    rcu_read_unlock();
+    return alive;
+}
+
+void syscalls() {
+    uint64_t pages[3];
+    for (int i = 0; i < 3; i++) {
+        pages[i] = PMM::alloc_page();
+        if (!pages[i]) {
+            Console::printf("[BENCH] syscall: out of memory\n");
+            while (--i >= 0) PMM::free_page(pages[i]);
+            return;
+        }
+    }
+
+    uint8_t* code = (uint8_t*)(pages[0] + KERNEL_VIRTUAL_BASE);
+    for (size_t i = 0; i < sizeof(null_syscall_loop); i++) {
+        code[i] = null_syscall_loop[i];
+    }
+
+    VMM::map_page(CODE_PAGE, pages[0], VMM::PRESENT | VMM::USER);
+    VMM::map_page(DATA_PAGE, pages[1], VMM::PRESENT | VMM::WRITABLE | VMM::USER);
+    VMM::map_page(STACK_PAGE, pages[2], VMM::PRESENT | VMM::WRITABLE | VMM::USER);
+
+    volatile UserParams* params = (volatile UserParams*)DATA_PAGE;
+    params->iterations = ITERATIONS;
+    params->cycles = 0;
+
+    // Read the tid before the thread can possibly exit and be freed.
+    rcu_read_lock();
+    Thread* thread = ProcessManager::create_kernel_thread("syscall-bench", user_thread, nullptr);
+    int tid = thread ? thread->get_tid() : -1;
+    rcu_read_unlock();
+
+    if (tid < 0) {
+        Console::printf("[BENCH] syscall: failed to start user thread\n");
+    } else {
+        // The pages can only go once the thread has been reaped.
+        for (uint32_t waited = 0; thread_alive(tid) && waited < TIMEOUT_MS; waited += 10) {
+            PIT::sleep(10);
+        }
+
+        if (params->cycles) {
+            Console::printf("[BENCH] null syscall round trip: %llu cycles/call (%u calls)\n",
+                            params->cycles / ITERATIONS, ITERATIONS);
+        } else {
+            Console::printf("[BENCH] null syscall round trip: FAILED\n");
+        }
+
+        if (thread_alive(tid)) {
+            return;
+        }
+    }
+
+    for (int i = 0; i < 3; i++) {
+        VMM::unmap_page(USER_SPACE_START + i * PAGE_SIZE);
+        PMM::free_page(pages[i]);
+    }
+}
+
+}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,141 @@
+#ifdef CONFIG_BENCH
+
+#include <kernel/bench.h>
+#include <kernel/console.h>
+#include <kernel/fs/vfs.h>
+#include <kernel/fs/page_cache.h>
+#include <kernel/memory/pmm.h>
+#include <kernel/arch/x86_64/cpu.h>
+
+namespace Core {
+namespace Bench {
+
+#define MAX_FILES    10000
+#define DATA_SIZE    (4 * 1024 * 1024)
+#define CHUNK_SIZE   (64 * 1024)
+#define SPARSE_AT    (1024ULL * 1024 * 1024)
+
+static void file_name(char* buffer, const char* prefix, uint32_t n) {
+    char* p = buffer;
+    while (*prefix) *p++ = *prefix++;
+    for (uint32_t div = 10000; div; div /= 10) {
+        *p++ = '0' + (n / div) % 10;
+    }
+    *p = '\0';
+}
+
+// Per-file create cost should stay flat as the directory grows.
+static void creates(Mount* mnt) {
+    char name[32];
+    uint32_t from = 0;
+    bool ok = VFS::create_at(mnt, "/dir", InodeType::DIRECTORY) == E_OK;
+
+    for (uint32_t to = 100; to <= MAX_FILES && ok; to *= 10) {
+        uint64_t start = CPU::rdtsc();
+        for (uint32_t i = from; i < to && ok; i++) {
+            file_name(name, "/dir/f", i);
+            ok = VFS::create_at(mnt, name, InodeType::FILE) == E_OK;
+        }
+        uint64_t cycles = CPU::rdtsc() - start;
+
+        Console::printf("[BENCH] tmpfs/create_%u: %llu cycles/file, %s\n", to,
+                        cycles / (to - from), ok ? "OK" : "FAILED");
+        from = to;
+    }
+
+    uint64_t start = CPU::rdtsc();
+    for (uint32_t i = 0; i < from && ok; i++) {
+        file_name(name, "/dir/f", i);
+        ok = VFS::unlink_at(mnt, name) == E_OK;
+    }
+    uint64_t cycles = CPU::rdtsc() - start;
+    Console::printf("[BENCH] tmpfs/unlink: %llu cycles/file, %s\n", from ? cycles / from : 0, ok ? "OK" : "FAILED");
+}
+
+static void data(Mount* mnt, uint64_t* buffer) {
+    File* file;
+    if (VFS::create_at(mnt, "/data", InodeType::FILE) != E_OK || VFS::open_at(mnt, "/data", &file) != E_OK) {
+        Console::printf("[BENCH] tmpfs/data: create failed\n");
+        return;
+    }
+
+    bool ok = true;
+    uint64_t start = CPU::rdtsc();
+    for (uint64_t offset = 0; offset < DATA_SIZE && ok; offset += CHUNK_SIZE) {
+        for (uint32_t i = 0; i < CHUNK_SIZE / sizeof(uint64_t); i++) {
+            buffer[i] = offset + i;
+        }
+        ok = VFS::write(file, buffer, CHUNK_SIZE) == CHUNK_SIZE;
+    }
+    uint64_t write_cycles = CPU::rdtsc() - start;
+
+    file->offset = 0;
+    start = CPU::rdtsc();
+    for (uint64_t offset = 0; offset < DATA_SIZE && ok; offset += CHUNK_SIZE) {
+        ok = VFS::read(file, buffer, CHUNK_SIZE) == CHUNK_SIZE;
+        for (uint32_t i = 0; i < CHUNK_SIZE / sizeof(uint64_t) && ok; i++) {
+            ok = buffer[i] == offset + i;
+        }
+    }
+    uint64_t read_cycles = CPU::rdtsc() - start;
+
+    Console::printf("[BENCH] tmpfs/data: write %llu, read %llu cycles/page, %s\n",
+                    write_cycles / (DATA_SIZE / PAGE_SIZE), read_cycles / (DATA_SIZE / PAGE_SIZE),
+                    ok ? "OK" : "FAILED");
+    VFS::close(file);
+    VFS::unlink_at(mnt, "/data");
+}
+
+// One page written far into the file: only that page is allocated, and
+// the hole reads back as zeros.
+static void sparse(Mount* mnt, uint64_t* buffer) {
+    File* file;
+    if (VFS::create_at(mnt, "/sparse", InodeType::FILE) != E_OK || VFS::open_at(mnt, "/sparse", &file) != E_OK) {
+        Console::printf("[BENCH] tmpfs/sparse: create failed\n");
+        return;
+    }
+
+    uint64_t pinned = PageCache::get_stats().pinned;
+    buffer[0] = 0x5A5A5A5A;
+    file->offset = SPARSE_AT;
+    bool ok = VFS::write(file, buffer, PAGE_SIZE) == PAGE_SIZE;
+    ok = ok && file->inode->size == SPARSE_AT + PAGE_SIZE;
+    ok = ok && PageCache::get_stats().pinned == pinned + 1;
+
+    file->offset = SPARSE_AT / 2;
+    ok = ok && VFS::read(file, buffer, CHUNK_SIZE) == CHUNK_SIZE;
+    for (uint32_t i = 0; i < CHUNK_SIZE / sizeof(uint64_t) && ok; i++) {
+        ok = buffer[i] == 0;
+    }
+
+    file->offset = SPARSE_AT;
+    ok = ok && VFS::read(file, buffer, PAGE_SIZE) == PAGE_SIZE && buffer[0] == 0x5A5A5A5A;
+
+    Console::printf("[BENCH] tmpfs/sparse: %llu MB file in %llu pages, %s\n",
+                    file->inode->size / (1024 * 1024), file->inode->cached_pages, ok ? "OK" : "FAILED");
+    VFS::close(file);
+    VFS::unlink_at(mnt, "/sparse");
+}
+
+void tmpfs() {
+    // The chunk is as big as the whole kernel heap.
+    Mount* mnt = VFS::kern_mount("tmpfs", nullptr);
+    uint64_t phys = PMM::alloc_pages(CHUNK_SIZE / PAGE_SIZE);
+    if (!mnt || !phys) {
+        Console::printf("[BENCH] tmpfs: setup failed\n");
+        if (phys) PMM::free_pages(phys, CHUNK_SIZE / PAGE_SIZE);
+        return;
+    }
+    uint64_t* buffer = (uint64_t*)(phys + KERNEL_VIRTUAL_BASE);
+
+    creates(mnt);
+    data(mnt, buffer);
+    sparse(mnt, buffer);
+
+    PMM::free_pages(phys, CHUNK_SIZE / PAGE_SIZE);
+}
+
+}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,223 @@
+#ifdef CONFIG_BENCH
+
+#include <kernel/bench.h>
+#include <kernel/console.h>
+#include <kernel/drivers/virtio_blk.h>
+#include <kernel/memory/pmm.h>
+#include <kernel/memory/copy.h>
+#include <kernel/process/scheduler.h>
+#include <kernel/arch/x86_64/cpu.h>
+
+namespace Core {
+namespace Bench {
+
+#define IO_SIZE       4096
+#define IO_OPS        20000
+#define MAX_DEPTH     32
+#define SPAN_SECTORS  (64ULL * 1024 * 1024 / VirtioBlk::SECTOR_SIZE)
+
+// A fixed set of requests kept in flight. Completions push themselves onto
+// `ready` from the block softirq; the submitting thread takes the whole
+// list and resubmits it as one batch.
+struct Job {
+    VirtioBlkDevice* dev;
+    uint32_t depth;
+    uint64_t ops;
+    VirtioBlkRequest requests[MAX_DEPTH];
+    uint64_t pages[MAX_DEPTH];
+    uint64_t issued_at[MAX_DEPTH];
+    VirtioBlkRequest* ready;
+    uint64_t completed;
+    uint64_t errors;
+    uint64_t latency_sum;
+    uint64_t latency_max;
+    uint64_t cycles;
+};
+
+static uint64_t next_random(uint64_t* state) {
+    *state ^= *state << 13;
+    *state ^= *state >> 7;
+    *state ^= *state << 17;
+    return *state;
+}
+
+static void io_done(VirtioBlkRequest* req) {
+    Job* job = (Job*)req->private_data;
+    uint64_t latency = CPU::rdtsc() - job->issued_at[req - job->requests];
+
+    // Only the owning CPU's softirq completes these, but the submitting
+    // thread reads the totals concurrently.
+    __atomic_fetch_add(&job->latency_sum, latency, __ATOMIC_RELAXED);
+    if (latency > job->latency_max) {
+        __atomic_store_n(&job->latency_max, latency, __ATOMIC_RELAXED);
+    }
+    if (req->result != E_OK) {
+        __atomic_fetch_add(&job->errors, 1, __ATOMIC_RELAXED);
+    }
+
+    VirtioBlkRequest* head = __atomic_load_n(&job->ready, __ATOMIC_RELAXED);
+    do {
+        req->next = head;
+    } while (!__atomic_compare_exchange_n(&job->ready, &head, req, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+    __atomic_fetch_add(&job->completed, 1, __ATOMIC_RELEASE);
+}
+
+// Random 4K reads over the first SPAN_SECTORS of the disk, `depth` at a time.
+static void run_job(Job* job, uint32_t cpu) {
+    uint64_t seed = 0x9E3779B97F4A7C15ULL ^ (cpu + 1);
+    uint64_t span = MIN(SPAN_SECTORS, job->dev->capacity) / (IO_SIZE / VirtioBlk::SECTOR_SIZE);
+    uint32_t queue = VirtioBlk::queue_for_cpu(job->dev, cpu);
+    uint64_t issued = 0;
+
+    job->ready = nullptr;
+    for (uint32_t i = 0; i < job->depth; i++) {
+        VirtioBlkRequest* req = &job->requests[i];
+        req->type = VIRTIO_BLK_T_IN;
+        req->segment_count = 1;
+        req->segments[0] = {job->pages[i], IO_SIZE};
+        req->done = io_done;
+        req->private_data = job;
+        req->next = job->ready;
+        job->ready = req;
+    }
+
+    uint64_t start = CPU::rdtsc();
+    while (__atomic_load_n(&job->completed, __ATOMIC_ACQUIRE) < job->ops) {
+        VirtioBlkRequest* list = __atomic_exchange_n(&job->ready, nullptr, __ATOMIC_ACQUIRE);
+        if (!list || issued >= job->ops) {
+            Scheduler::yield();
+            continue;
+        }
+
+        VirtioBlkRequest* batch = nullptr;
+        while (list && issued < job->ops) {
+            VirtioBlkRequest* req = list;
+            list = req->next;
+            req->sector = (next_random(&seed) % span) * (IO_SIZE / VirtioBlk::SECTOR_SIZE);
+            job->issued_at[req - job->requests] = CPU::rdtsc();
+            req->next = batch;
+            batch = req;
+            issued++;
+        }
+
+        // The ring has room for every request in flight.
+        VirtioBlk::submit(job->dev, queue, &batch);
+    }
+    job->cycles = CPU::rdtsc() - start;
+}
+
+static size_t job_pages(uint32_t count) {
+    return ALIGN_UP(count * sizeof(Job), PAGE_SIZE) / PAGE_SIZE;
+}
+
+static void free_jobs(Job* jobs, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        for (uint32_t j = 0; j < MAX_DEPTH; j++) {
+            if (jobs[i].pages[j]) PMM::free_page(jobs[i].pages[j]);
+        }
+    }
+    PMM::free_pages((uint64_t)jobs - KERNEL_VIRTUAL_BASE, job_pages(count));
+}
+
+static Job* alloc_jobs(VirtioBlkDevice* dev, uint32_t count) {
+    uint64_t phys = PMM::alloc_pages(job_pages(count));
+    if (!phys) {
+        return nullptr;
+    }
+
+    Job* jobs = (Job*)(phys + KERNEL_VIRTUAL_BASE);
+    zero_pages(jobs, job_pages(count));
+    for (uint32_t i = 0; i < count; i++) {
+        jobs[i].dev = dev;
+        for (uint32_t j = 0; j < MAX_DEPTH; j++) {
+            jobs[i].pages[j] = PMM::alloc_page();
+            if (!jobs[i].pages[j]) {
+                free_jobs(jobs, count);
+                return nullptr;
+            }
+        }
+    }
+    return jobs;
+}
+
+static void reset(Job* job, uint32_t depth, uint64_t ops) {
+    job->depth = depth;
+    job->ops = ops;
+    job->completed = 0;
+    job->errors = 0;
+    job->latency_sum = 0;
+    job->latency_max = 0;
+}
+
+static void job_thread(uint32_t cpu, void* arg) {
+    run_job(&((Job*)arg)[cpu], cpu);
+}
+
+// One thread at increasing queue depths: IOPS should rise with depth while
+// doorbells and interrupts per request fall, from batching and EVENT_IDX.
+static void depths(VirtioBlkDevice* dev, Job* job) {
+    static const uint32_t levels[] = {1, 4, 16, MAX_DEPTH};
+
+    for (uint32_t depth : levels) {
+        if (depth > dev->queue_depth) break;
+
+        VirtioBlkStats before = VirtioBlk::get_stats(dev);
+        reset(job, depth, IO_OPS);
+        run_job(job, CPU::id());
+        VirtioBlkStats after = VirtioBlk::get_stats(dev);
+
+        uint64_t us = MAX(job->cycles / cycles_per_us(), 1ULL);
+        uint64_t ops = after.submitted - before.submitted;
+        Console::printf("[BENCH] virtio_blk/qd%u: %llu IOPS, latency avg %llu us max %llu us, %s\n", depth,
+                        job->ops * 1000000 / us, job->latency_sum / job->ops / cycles_per_us(),
+                        job->latency_max / cycles_per_us(), job->errors ? "FAILED" : "OK");
+        Console::printf("[BENCH]   %llu kicks, %llu interrupts per 100 requests\n",
+                        (after.kicks - before.kicks) * 100 / MAX(ops, 1ULL),
+                        (after.interrupts - before.interrupts) * 100 / MAX(ops, 1ULL));
+    }
+}
+
+// Every CPU at full depth on its own queue.
+static void all_cpus(VirtioBlkDevice* dev, Job* jobs) {
+    uint32_t cpus = MIN(CPU::online_count(), MAX_THREADS);
+    uint32_t depth = MIN((uint32_t)MAX_DEPTH, dev->queue_depth);
+    for (uint32_t i = 0; i < cpus; i++) {
+        reset(&jobs[i], depth, IO_OPS / 2);
+    }
+
+    uint64_t start = CPU::rdtsc();
+    run_threads(job_thread, jobs, cpus);
+    uint64_t us = MAX((CPU::rdtsc() - start) / cycles_per_us(), 1ULL);
+
+    uint64_t errors = 0;
+    for (uint32_t i = 0; i < cpus; i++) {
+        errors += jobs[i].errors;
+    }
+    Console::printf("[BENCH] virtio_blk/%u_cpus_qd%u: %llu IOPS over %u queues, %s\n", cpus, depth,
+                    (uint64_t)cpus * (IO_OPS / 2) * 1000000 / us, dev->queue_count, errors ? "FAILED" : "OK");
+}
+
+void virtio_blk() {
+    VirtioBlkDevice* dev = VirtioBlk::get_devices();
+    if (!dev) {
+        Console::printf("[BENCH] virtio_blk: no device, skipped\n");
+        return;
+    }
+
+    uint32_t count = MIN(CPU::online_count(), MAX_THREADS);
+    Job* jobs = alloc_jobs(dev, count);
+    if (!jobs) {
+        Console::printf("[BENCH] virtio_blk: out of memory\n");
+        return;
+    }
+
+    // Runs only return once every request has completed.
+    depths(dev, &jobs[0]);
+    all_cpus(dev, jobs);
+    free_jobs(jobs, count);
+}
+
+}
+}
+
+#endif
\ No newline at end of file
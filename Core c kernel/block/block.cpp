@@ -0,0 +1,727 @@
+#include <kernel/block/block.h>
+#include <kernel/memory/pmm.h>
+#include <kernel/memory/copy.h>
+#include <kernel/process/process.h>
+#include <kernel/sync/spinlock.h>
+#include <kernel/sync/rwlock.h>
+#include <kernel/sync/percpu.h>
+#include <kernel/sync/waitqueue.h>
+#include <kernel/sync/completion.h>
+#include <kernel/time/clock.h>
+#include <kernel/time/timer.h>
+#include <kernel/arch/x86_64/cpu.h>
+#include <kernel/arch/x86_64/pit.h>
+#include <kernel/console.h>
+
+namespace Core {
+
+// Requests staged on one CPU; only the "none" scheduler uses them, others
+// take requests straight into their own structures.
+struct SoftQueue {
+    Spinlock lock;
+    BlockRequest* head;
+    BlockRequest* tail;
+} ALIGNED(64);
+
+// One per hardware queue. `running` lets a single CPU dispatch at a time;
+// anyone arriving meanwhile sets `rerun` instead of waiting.
+struct HwQueue {
+    Spinlock lock;
+    BlockDevice* dev;
+    uint32_t index;
+    uint32_t inflight;
+    bool running;
+    bool rerun;
+    BlockRequest* requeue;      // refused by the driver, retried first
+    Timer retry;
+    BlockStats stats;
+} ALIGNED(64);
+
+struct BlockQueue {
+    Spinlock pool_lock;
+    BlockRequest* free_list;
+    uint32_t free_count;
+    uint32_t request_count;
+    uint8_t* pool;
+    WaitQueue pool_wait;
+    SoftQueue* soft_queues;
+    uint32_t soft_queue_count;
+    HwQueue* hw_queues;
+    PerCpuCounter bios;
+    PerCpuCounter merges;
+};
+
+// Devices and schedulers register once, at boot; lookups by name far
+// outnumber them.
+static RWLock registry_lock;
+static BlockDevice* devices = nullptr;
+static BlockScheduler* schedulers = nullptr;
+
+static uint64_t cycles_to_us(uint64_t cycles) {
+    return cycles / MAX(Clock::get_tsc_hz() / 1000000, 1ULL);
+}
+
+static bool name_equals(const char* a, const char* b) {
+    while (*a && *a == *b) {
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+static error_t check_bio(BlockDevice* dev, Bio* bio) {
+    if (bio->op == BlockOp::FLUSH) {
+        return bio->len == 0 ? E_OK : E_INVAL;
+    }
+    if (bio->op != BlockOp::READ && bio->op != BlockOp::WRITE) {
+        return E_INVAL;
+    }
+
+    uint64_t sectors = bio->len / Block::SECTOR_SIZE;
+    if (bio->len == 0 || bio->len % Block::SECTOR_SIZE || sectors > dev->max_sectors ||
+        bio->sector > dev->capacity || sectors > dev->capacity - bio->sector) {
+        return E_INVAL;
+    }
+    return E_OK;
+}
+
+static void flush_plug(BlockPlug* plug);
+
+static BlockRequest* alloc_request(BlockDevice* dev) {
+    BlockQueue* q = dev->queue;
+
+    while (true) {
+        uint64_t flags = q->pool_lock.lock_irqsave();
+        BlockRequest* req = q->free_list;
+        if (req) {
+            q->free_list = req->next;
+            q->free_count--;
+            q->pool_lock.unlock_irqrestore(flags);
+            return req;
+        }
+        q->pool_lock.unlock_irqrestore(flags);
+
+        // Requests sitting in our own plug may be what frees the pool.
+        Thread* thread = ProcessManager::get_current_thread();
+        if (thread && thread->plug) {
+            flush_plug(thread->plug);
+        }
+        q->pool_wait.wait_event([q] { return __atomic_load_n(&q->free_list, __ATOMIC_ACQUIRE) != nullptr; });
+    }
+}
+
+static void free_request(BlockDevice* dev, BlockRequest* req) {
+    BlockQueue* q = dev->queue;
+
+    uint64_t flags = q->pool_lock.lock_irqsave();
+    req->next = q->free_list;
+    q->free_list = req;
+    q->free_count++;
+    q->pool_lock.unlock_irqrestore(flags);
+
+    // The unlock is a plain store; without the fence the is_empty() load
+    // can pass it and miss a waiter that just found free_list empty.
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (!q->pool_wait.is_empty()) {
+        q->pool_wait.wake_one();
+    }
+}
+
+static void init_request(BlockDevice* dev, BlockRequest* req, Bio* bio) {
+    req->dev = dev;
+    req->op = bio->op;
+    req->sector = bio->sector;
+    req->sectors = bio->len / Block::SECTOR_SIZE;
+    req->segment_count = bio->op == BlockOp::FLUSH ? 0 : 1;
+    req->segments[0] = {bio->phys, bio->len};
+    req->bios = req->bio_tail = bio;
+    req->bio_count = 1;
+    req->start_tsc = CPU::rdtsc();
+    req->deadline = 0;
+    req->next = req->sort_prev = req->sort_next = nullptr;
+    req->fifo_prev = req->fifo_next = req->hash_next = nullptr;
+    bio->next = nullptr;
+}
+
+bool Block::merge_bio(BlockRequest* req, Bio* bio) {
+    BlockDevice* dev = req->dev;
+    if (req->op != bio->op || bio->op == BlockOp::FLUSH) {
+        return false;
+    }
+
+    uint32_t sectors = bio->len / SECTOR_SIZE;
+    if (req->sectors + sectors > dev->max_sectors) {
+        return false;
+    }
+
+    if (bio->sector == req->sector + req->sectors) {
+        BlockSegment* last = &req->segments[req->segment_count - 1];
+        if (last->phys + last->len == bio->phys) {
+            last->len += bio->len;
+        } else if (req->segment_count < dev->max_segments) {
+            req->segments[req->segment_count++] = {bio->phys, bio->len};
+        } else {
+            return false;
+        }
+
+        bio->next = nullptr;
+        req->bio_tail->next = bio;
+        req->bio_tail = bio;
+    } else if (bio->sector + sectors == req->sector) {
+        BlockSegment* first = &req->segments[0];
+        if (bio->phys + bio->len == first->phys) {
+            first->phys = bio->phys;
+            first->len += bio->len;
+        } else if (req->segment_count < dev->max_segments) {
+            for (uint32_t i = req->segment_count; i > 0; i--) {
+                req->segments[i] = req->segments[i - 1];
+            }
+            req->segments[0] = {bio->phys, bio->len};
+            req->segment_count++;
+        } else {
+            return false;
+        }
+
+        bio->next = req->bios;
+        req->bios = bio;
+        req->sector = bio->sector;
+    } else {
+        return false;
+    }
+
+    req->sectors += sectors;
+    req->bio_count++;
+    return true;
+}
+
+static void retry_hw_queue(Timer* timer);
+
+// Feeds the driver from the requeue list, then the scheduler, while the
+// hardware queue has room. Room is reserved before the lock is dropped so
+// completions racing with the driver call never see inflight underflow.
+static void run_hw_queue(HwQueue* hq) {
+    BlockDevice* dev = hq->dev;
+
+    uint64_t flags = hq->lock.lock_irqsave();
+    if (hq->running) {
+        hq->rerun = true;
+        hq->lock.unlock_irqrestore(flags);
+        return;
+    }
+    hq->running = true;
+
+    do {
+        hq->rerun = false;
+        while (hq->inflight < dev->hw_queue_depth) {
+            uint32_t room = dev->hw_queue_depth - hq->inflight;
+            BlockRequest* list = nullptr;
+            BlockRequest** tail = &list;
+            uint32_t count = 0;
+
+            while (hq->requeue && count < room) {
+                *tail = hq->requeue;
+                tail = &hq->requeue->next;
+                hq->requeue = hq->requeue->next;
+                count++;
+            }
+            *tail = nullptr;
+            hq->inflight += room;
+            hq->lock.unlock_irqrestore(flags);
+
+            if (count < room) {
+                *tail = dev->sched->dispatch(dev, hq->index, room - count);
+            }
+
+            uint64_t now = CPU::rdtsc();
+            count = 0;
+            for (BlockRequest* req = list; req; req = req->next) {
+                req->hw_queue = hq->index;
+                req->dispatch_tsc = now;
+                count++;
+            }
+
+            uint32_t taken = count ? dev->ops->queue_requests(dev, hq->index, &list) : 0;
+
+            flags = hq->lock.lock_irqsave();
+            hq->inflight -= room - taken;
+            hq->stats.requests += taken;
+            hq->stats.depth_sum += (uint64_t)taken * hq->inflight;
+            hq->stats.max_inflight = MAX(hq->stats.max_inflight, (uint64_t)hq->inflight);
+
+            if (list) {
+                // Refused requests go back in front, in order. With nothing
+                // in flight no completion will rerun the queue, so poll.
+                BlockRequest* last = list;
+                while (last->next) last = last->next;
+                last->next = hq->requeue;
+                hq->requeue = list;
+                if (hq->inflight == 0 && !hq->retry.pending) {
+                    Timer::add(&hq->retry, PIT::get_ticks() + 1);
+                }
+                break;
+            }
+            if (count < room) {
+                break;
+            }
+        }
+    } while (hq->rerun);
+
+    hq->running = false;
+    hq->lock.unlock_irqrestore(flags);
+}
+
+static void retry_hw_queue(Timer* timer) {
+    run_hw_queue((HwQueue*)((uint8_t*)timer - offsetof(HwQueue, retry)));
+}
+
+static void insert_and_run(BlockDevice* dev, uint32_t cpu, BlockRequest* list) {
+    dev->sched->insert(dev, cpu, list);
+    run_hw_queue(&dev->queue->hw_queues[Block::hw_queue_for_cpu(dev, cpu)]);
+}
+
+// Hands each device its share of the plug, in submission order.
+static void flush_plug(BlockPlug* plug) {
+    BlockRequest* list = plug->head;
+    plug->head = plug->tail = nullptr;
+    plug->count = 0;
+
+    uint32_t cpu = CPU::id();
+    while (list) {
+        BlockDevice* dev = list->dev;
+        BlockRequest* mine = nullptr;
+        BlockRequest** mine_tail = &mine;
+        BlockRequest* rest = nullptr;
+        BlockRequest** rest_tail = &rest;
+
+        for (BlockRequest* req = list; req; req = req->next) {
+            if (req->dev == dev) {
+                *mine_tail = req;
+                mine_tail = &req->next;
+            } else {
+                *rest_tail = req;
+                rest_tail = &req->next;
+            }
+        }
+        *mine_tail = nullptr;
+        *rest_tail = nullptr;
+
+        insert_and_run(dev, cpu, mine);
+        list = rest;
+    }
+}
+
+// The newest request is the likeliest to extend.
+static bool plug_merge(BlockPlug* plug, BlockDevice* dev, Bio* bio) {
+    if (plug->tail && plug->tail->dev == dev && Block::merge_bio(plug->tail, bio)) {
+        return true;
+    }
+    for (BlockRequest* req = plug->head; req && req != plug->tail; req = req->next) {
+        if (req->dev == dev && Block::merge_bio(req, bio)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Block::submit(BlockDevice* dev, Bio* bio) {
+    error_t err = check_bio(dev, bio);
+    if (err != E_OK) {
+        bio->result = err;
+        bio->done(bio);
+        return;
+    }
+
+    BlockQueue* q = dev->queue;
+    q->bios.inc();
+
+    Thread* thread = ProcessManager::get_current_thread();
+    BlockPlug* plug = thread ? thread->plug : nullptr;
+    if ((plug && plug_merge(plug, dev, bio)) || dev->sched->merge(dev, bio)) {
+        q->merges.inc();
+        return;
+    }
+
+    BlockRequest* req = alloc_request(dev);
+    init_request(dev, req, bio);
+
+    if (plug) {
+        if (plug->tail) {
+            plug->tail->next = req;
+        } else {
+            plug->head = req;
+        }
+        plug->tail = req;
+        if (++plug->count >= PLUG_MAX) {
+            flush_plug(plug);
+        }
+        return;
+    }
+
+    insert_and_run(dev, CPU::id(), req);
+}
+
+static void wait_done(Bio* bio) {
+    ((Completion*)bio->private_data)->complete();
+}
+
+error_t Block::submit_wait(BlockDevice* dev, Bio* bio) {
+    Completion done;
+    bio->done = wait_done;
+    bio->private_data = &done;
+    submit(dev, bio);
+
+    // Plugged I/O only moves once the plug is flushed.
+    Thread* thread = ProcessManager::get_current_thread();
+    if (thread && thread->plug) {
+        flush_plug(thread->plug);
+    }
+
+    done.wait();
+    return bio->result;
+}
+
+void Block::start_plug(BlockPlug* plug) {
+    plug->head = plug->tail = nullptr;
+    plug->count = 0;
+    plug->active = false;
+
+    Thread* thread = ProcessManager::get_current_thread();
+    if (thread && !thread->plug) {
+        thread->plug = plug;
+        plug->active = true;
+    }
+}
+
+void Block::finish_plug(BlockPlug* plug) {
+    if (!plug->active) {
+        return;
+    }
+
+    flush_plug(plug);
+    ProcessManager::get_current_thread()->plug = nullptr;
+    plug->active = false;
+}
+
+void Block::complete(BlockRequest* req, error_t result) {
+    BlockDevice* dev = req->dev;
+    HwQueue* hq = &dev->queue->hw_queues[req->hw_queue];
+    uint64_t now = CPU::rdtsc();
+    uint64_t latency = cycles_to_us(now - req->start_tsc);
+    uint32_t bucket = latency ? MIN((uint32_t)(64 - __builtin_clzll(latency)), BLOCK_LATENCY_BUCKETS - 1) : 0;
+
+    uint64_t flags = hq->lock.lock_irqsave();
+    hq->inflight--;
+    hq->stats.completed++;
+    if (result != E_OK) {
+        hq->stats.errors++;
+    } else if (req->op == BlockOp::READ) {
+        hq->stats.read_sectors += req->sectors;
+    } else if (req->op == BlockOp::WRITE) {
+        hq->stats.write_sectors += req->sectors;
+    }
+    hq->stats.latency_us_sum += latency;
+    hq->stats.device_us_sum += cycles_to_us(now - req->dispatch_tsc);
+    hq->stats.latency[bucket]++;
+    hq->lock.unlock_irqrestore(flags);
+
+    // The request goes back first, so once its last bio is done the device
+    // counts as idle again.
+    Bio* bio = req->bios;
+    free_request(dev, req);
+    run_hw_queue(hq);
+
+    while (bio) {
+        Bio* next = bio->next;
+        bio->result = result;
+        bio->done(bio);
+        bio = next;
+    }
+}
+
+// Default for multiqueue devices: no reordering. Requests wait in the
+// submitting CPU's staging queue, where the last few can still absorb
+// adjacent bios, and each hardware queue drains the CPUs mapped to it.
+static error_t none_init(BlockDevice*) {
+    return E_OK;
+}
+
+static void none_exit(BlockDevice*) {}
+
+static bool none_merge(BlockDevice* dev, Bio* bio) {
+    SoftQueue* sq = &dev->queue->soft_queues[CPU::id() % dev->queue->soft_queue_count];
+    bool merged = false;
+
+    uint64_t flags = sq->lock.lock_irqsave();
+    BlockRequest* req = sq->tail;
+    for (uint32_t i = 0; req && i < Block::MERGE_SCAN && !merged; i++, req = req->fifo_prev) {
+        merged = Block::merge_bio(req, bio);
+    }
+    sq->lock.unlock_irqrestore(flags);
+    return merged;
+}
+
+static void none_insert(BlockDevice* dev, uint32_t cpu, BlockRequest* list) {
+    SoftQueue* sq = &dev->queue->soft_queues[cpu % dev->queue->soft_queue_count];
+
+    uint64_t flags = sq->lock.lock_irqsave();
+    while (list) {
+        BlockRequest* req = list;
+        list = req->next;
+        req->fifo_next = nullptr;
+        req->fifo_prev = sq->tail;
+        if (sq->tail) {
+            sq->tail->fifo_next = req;
+        } else {
+            sq->head = req;
+        }
+        sq->tail = req;
+    }
+    sq->lock.unlock_irqrestore(flags);
+}
+
+static BlockRequest* none_dispatch(BlockDevice* dev, uint32_t hw_queue, uint32_t max) {
+    BlockQueue* q = dev->queue;
+    BlockRequest* list = nullptr;
+    BlockRequest** tail = &list;
+    uint32_t count = 0;
+
+    for (uint32_t cpu = hw_queue; cpu < q->soft_queue_count && count < max; cpu += dev->hw_queue_count) {
+        SoftQueue* sq = &q->soft_queues[cpu];
+        if (!__atomic_load_n(&sq->head, __ATOMIC_RELAXED)) {
+            continue;
+        }
+
+        uint64_t flags = sq->lock.lock_irqsave();
+        while (sq->head && count < max) {
+            BlockRequest* req = sq->head;
+            sq->head = req->fifo_next;
+            if (sq->head) {
+                sq->head->fifo_prev = nullptr;
+            } else {
+                sq->tail = nullptr;
+            }
+            *tail = req;
+            tail = &req->next;
+            count++;
+        }
+        sq->lock.unlock_irqrestore(flags);
+    }
+
+    *tail = nullptr;
+    return list;
+}
+
+static BlockScheduler none_scheduler = {
+    "none",
+    none_init,
+    none_exit,
+    none_merge,
+    none_insert,
+    none_dispatch,
+    nullptr,
+};
+
+void Block::initialize() {
+    register_scheduler(&none_scheduler);
+}
+
+void Block::register_scheduler(BlockScheduler* sched) {
+    ScopedWriteLock guard(registry_lock);
+    sched->next = schedulers;
+    schedulers = sched;
+}
+
+static BlockScheduler* find_scheduler(const char* name) {
+    ScopedReadLock guard(registry_lock);
+    for (BlockScheduler* sched = schedulers; sched; sched = sched->next) {
+        if (name_equals(sched->name, name)) {
+            return sched;
+        }
+    }
+    return nullptr;
+}
+
+error_t Block::set_scheduler(BlockDevice* dev, const char* name) {
+    BlockScheduler* sched = find_scheduler(name);
+    if (!sched) {
+        return E_NOENT;
+    }
+
+    BlockQueue* q = dev->queue;
+    if (__atomic_load_n(&q->free_count, __ATOMIC_ACQUIRE) != q->request_count) {
+        return E_BUSY;
+    }
+    if (sched == dev->sched) {
+        return E_OK;
+    }
+
+    dev->sched->exit(dev);
+    dev->sched_data = nullptr;
+    error_t err = sched->init(dev);
+    if (err != E_OK) {
+        // "none" keeps no state of its own, so it cannot fail.
+        dev->sched = &none_scheduler;
+        return err;
+    }
+    dev->sched = sched;
+    return E_OK;
+}
+
+error_t Block::register_device(BlockDevice* dev) {
+    if (!dev->ops || !dev->hw_queue_count || !dev->hw_queue_depth || !dev->max_segments || !dev->max_sectors) {
+        return E_INVAL;
+    }
+    dev->max_segments = MIN(dev->max_segments, BLOCK_MAX_SEGMENTS);
+
+    // The queue, its per-CPU and per-hardware-queue state and the request
+    // pool share one zeroed run of pages; the pool alone is hundreds of KB
+    // with a driver's command attached to each request.
+    uint32_t soft_queue_count = CPU::online_count();
+    uint32_t request_count = MIN(MAX_REQUESTS, 2 * dev->hw_queue_count * dev->hw_queue_depth);
+    size_t driver_offset = ALIGN_UP(sizeof(BlockRequest), 16);
+    size_t request_size = ALIGN_UP(driver_offset + dev->cmd_size, 16);
+    size_t soft_offset = ALIGN_UP(sizeof(BlockQueue), 64);
+    size_t hw_offset = soft_offset + ALIGN_UP(soft_queue_count * sizeof(SoftQueue), 64);
+    size_t pool_offset = hw_offset + ALIGN_UP(dev->hw_queue_count * sizeof(HwQueue), 64);
+    size_t pages = ALIGN_UP(pool_offset + request_count * request_size, PAGE_SIZE) / PAGE_SIZE;
+
+    uint64_t phys = PMM::alloc_pages(pages);
+    if (!phys) {
+        Console::printf("[BLOCK] %s: no memory for %u requests (%llu KB), not registered\n",
+                        dev->name, request_count, (uint64_t)pages * PAGE_SIZE / 1024);
+        return E_NOMEM;
+    }
+
+    uint8_t* base = (uint8_t*)(phys + KERNEL_VIRTUAL_BASE);
+    zero_pages(base, pages);
+    BlockQueue* q = (BlockQueue*)base;
+    q->request_count = request_count;
+    q->soft_queue_count = soft_queue_count;
+    q->soft_queues = (SoftQueue*)(base + soft_offset);
+    q->hw_queues = (HwQueue*)(base + hw_offset);
+    q->pool = base + pool_offset;
+
+    q->pool_lock.set_name("block_pool");
+    for (uint32_t i = 0; i < q->request_count; i++) {
+        BlockRequest* req = (BlockRequest*)(q->pool + i * request_size);
+        req->driver_data = (uint8_t*)req + driver_offset;
+        req->next = q->free_list;
+        q->free_list = req;
+    }
+    q->free_count = q->request_count;
+
+    for (uint32_t i = 0; i < q->soft_queue_count; i++) {
+        q->soft_queues[i].lock.set_name("block_soft_queue");
+    }
+    for (uint32_t i = 0; i < dev->hw_queue_count; i++) {
+        q->hw_queues[i].lock.set_name("block_hw_queue");
+        q->hw_queues[i].dev = dev;
+        q->hw_queues[i].index = i;
+        q->hw_queues[i].retry.func = retry_hw_queue;
+    }
+    dev->queue = q;
+
+    BlockScheduler* sched = dev->hw_queue_count > 1 ? nullptr : find_scheduler("deadline");
+    if (!sched) {
+        sched = &none_scheduler;
+    }
+    dev->sched_data = nullptr;
+    if (sched->init(dev) != E_OK) {
+        sched = &none_scheduler;
+    }
+    dev->sched = sched;
+
+    ScopedWriteLock guard(registry_lock);
+    BlockDevice** tail = &devices;
+    while (*tail) tail = &(*tail)->next;
+    dev->next = nullptr;
+    *tail = dev;
+    return E_OK;
+}
+
+BlockDevice* Block::find(const char* name) {
+    ScopedReadLock guard(registry_lock);
+    for (BlockDevice* dev = devices; dev; dev = dev->next) {
+        if (name_equals(dev->name, name)) {
+            return dev;
+        }
+    }
+    return nullptr;
+}
+
+BlockDevice* Block::get_devices() {
+    return devices;
+}
+
+BlockStats Block::get_stats(BlockDevice* dev) {
+    BlockStats total = {};
+    BlockQueue* q = dev->queue;
+
+    for (uint32_t i = 0; i < dev->hw_queue_count; i++) {
+        HwQueue* hq = &q->hw_queues[i];
+        uint64_t flags = hq->lock.lock_irqsave();
+        total.requests += hq->stats.requests;
+        total.completed += hq->stats.completed;
+        total.errors += hq->stats.errors;
+        total.read_sectors += hq->stats.read_sectors;
+        total.write_sectors += hq->stats.write_sectors;
+        total.inflight += hq->inflight;
+        total.max_inflight += hq->stats.max_inflight;
+        total.depth_sum += hq->stats.depth_sum;
+        total.latency_us_sum += hq->stats.latency_us_sum;
+        total.device_us_sum += hq->stats.device_us_sum;
+        for (uint32_t b = 0; b < BLOCK_LATENCY_BUCKETS; b++) {
+            total.latency[b] += hq->stats.latency[b];
+        }
+        hq->lock.unlock_irqrestore(flags);
+    }
+
+    total.bios = q->bios.sum();
+    total.merges = q->merges.sum();
+    return total;
+}
+
+void Block::reset_stats(BlockDevice* dev) {
+    BlockQueue* q = dev->queue;
+
+    for (uint32_t i = 0; i < dev->hw_queue_count; i++) {
+        HwQueue* hq = &q->hw_queues[i];
+        uint64_t flags = hq->lock.lock_irqsave();
+        hq->stats = {};
+        hq->lock.unlock_irqrestore(flags);
+    }
+
+    q->bios.reset();
+    q->merges.reset();
+}
+
+uint64_t Block::latency_percentile(const BlockStats& stats, uint32_t permille) {
+    uint64_t target = (stats.completed * permille + 999) / 1000;
+    uint64_t seen = 0;
+    for (uint32_t b = 0; b < BLOCK_LATENCY_BUCKETS; b++) {
+        seen += stats.latency[b];
+        if (seen >= target) {
+            return 1ULL << b;
+        }
+    }
+    return 1ULL << (BLOCK_LATENCY_BUCKETS - 1);
+}
+
+void Block::dump_stats() {
+    for (BlockDevice* dev = devices; dev; dev = dev->next) {
+        BlockStats stats = get_stats(dev);
+        uint64_t requests = MAX(stats.requests, 1ULL);
+        uint64_t completed = MAX(stats.completed, 1ULL);
+
+        Console::printf("[BLOCK] %s (%s): %llu bios, %llu merged, %llu requests of %llu KB avg, %llu errors\n",
+                        dev->name, dev->sched->name, stats.bios, stats.merges, stats.requests,
+                        (stats.read_sectors + stats.write_sectors) * SECTOR_SIZE / 1024 / completed, stats.errors);
+        Console::printf("[BLOCK]   depth %llu now, %llu avg, %llu max; latency %llu us avg (device %llu), "
+                        "p50 < %llu us, p99 < %llu us\n",
+                        stats.inflight, stats.depth_sum / requests, stats.max_inflight,
+                        stats.latency_us_sum / completed, stats.device_us_sum / completed,
+                        latency_percentile(stats, 500), latency_percentile(stats, 990));
+    }
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,242 @@
+#include <kernel/block/deadline.h>
+#include <kernel/block/block.h>
+#include <kernel/memory/heap.h>
+#include <kernel/sync/spinlock.h>
+#include <kernel/arch/x86_64/pit.h>
+
+namespace Core {
+
+enum Direction : uint32_t {
+    DIR_READ = 0,
+    DIR_WRITE = 1,
+};
+
+// Each queued request is on its direction's sorted list and FIFO, and in
+// the hash by end sector, which finds back-merge candidates without a
+// walk. Flushes bypass the ordering.
+struct DeadlineData {
+    Spinlock lock;
+    BlockRequest* sort_head[2];
+    BlockRequest* sort_tail[2];
+    BlockRequest* fifo_head[2];
+    BlockRequest* fifo_tail[2];
+    BlockRequest* next_rq[2];
+    BlockRequest* flush_head;
+    BlockRequest* flush_tail;
+    BlockRequest* hash[Deadline::HASH_BUCKETS];
+    uint32_t batching;
+    uint32_t starved;
+    uint32_t last_dir;
+};
+
+static DeadlineData* data_of(BlockDevice* dev) {
+    return (DeadlineData*)dev->sched_data;
+}
+
+static uint32_t direction(BlockRequest* req) {
+    return req->op == BlockOp::WRITE ? DIR_WRITE : DIR_READ;
+}
+
+static BlockRequest** bucket(DeadlineData* dd, uint64_t end_sector) {
+    return &dd->hash[(end_sector * 0x9E3779B97F4A7C15ULL) >> 58];
+}
+
+static_assert(Deadline::HASH_BUCKETS == 64, "bucket() takes the top 6 bits");
+
+static void hash_add(DeadlineData* dd, BlockRequest* req) {
+    BlockRequest** head = bucket(dd, req->sector + req->sectors);
+    req->hash_next = *head;
+    *head = req;
+}
+
+static void hash_remove(DeadlineData* dd, BlockRequest* req) {
+    for (BlockRequest** link = bucket(dd, req->sector + req->sectors); *link; link = &(*link)->hash_next) {
+        if (*link == req) {
+            *link = req->hash_next;
+            return;
+        }
+    }
+}
+
+// Walks back from the tail, so a sequential stream inserts in O(1).
+static void sort_insert(DeadlineData* dd, uint32_t dir, BlockRequest* req) {
+    BlockRequest* prev = dd->sort_tail[dir];
+    while (prev && prev->sector > req->sector) {
+        prev = prev->sort_prev;
+    }
+
+    req->sort_prev = prev;
+    req->sort_next = prev ? prev->sort_next : dd->sort_head[dir];
+    if (req->sort_next) {
+        req->sort_next->sort_prev = req;
+    } else {
+        dd->sort_tail[dir] = req;
+    }
+    if (prev) {
+        prev->sort_next = req;
+    } else {
+        dd->sort_head[dir] = req;
+    }
+}
+
+static void remove(DeadlineData* dd, BlockRequest* req) {
+    uint32_t dir = direction(req);
+
+    if (req->sort_prev) req->sort_prev->sort_next = req->sort_next;
+    else dd->sort_head[dir] = req->sort_next;
+    if (req->sort_next) req->sort_next->sort_prev = req->sort_prev;
+    else dd->sort_tail[dir] = req->sort_prev;
+
+    if (req->fifo_prev) req->fifo_prev->fifo_next = req->fifo_next;
+    else dd->fifo_head[dir] = req->fifo_next;
+    if (req->fifo_next) req->fifo_next->fifo_prev = req->fifo_prev;
+    else dd->fifo_tail[dir] = req->fifo_prev;
+
+    hash_remove(dd, req);
+}
+
+static error_t deadline_init(BlockDevice* dev) {
+    DeadlineData* dd = (DeadlineData*)Heap::calloc(1, sizeof(DeadlineData));
+    if (!dd) {
+        return E_NOMEM;
+    }
+
+    dd->lock.set_name("deadline");
+    dev->sched_data = dd;
+    return E_OK;
+}
+
+static void deadline_exit(BlockDevice* dev) {
+    Heap::free(dev->sched_data);
+    dev->sched_data = nullptr;
+}
+
+// Only back merges: a request grows at its end, which is what sequential
+// streams produce. Front merges are left to the plug.
+static bool deadline_merge(BlockDevice* dev, Bio* bio) {
+    DeadlineData* dd = data_of(dev);
+    bool merged = false;
+
+    uint64_t flags = dd->lock.lock_irqsave();
+    for (BlockRequest* req = *bucket(dd, bio->sector); req; req = req->hash_next) {
+        if (req->sector + req->sectors == bio->sector) {
+            // Unhash under the old end before merge_bio() moves it.
+            hash_remove(dd, req);
+            merged = Block::merge_bio(req, bio);
+            hash_add(dd, req);
+            break;
+        }
+    }
+    dd->lock.unlock_irqrestore(flags);
+    return merged;
+}
+
+static void deadline_insert(BlockDevice* dev, uint32_t, BlockRequest* list) {
+    DeadlineData* dd = data_of(dev);
+    uint64_t now = PIT::get_ticks();
+
+    uint64_t flags = dd->lock.lock_irqsave();
+    while (list) {
+        BlockRequest* req = list;
+        list = req->next;
+        req->next = nullptr;
+
+        if (req->op == BlockOp::FLUSH) {
+            if (dd->flush_tail) {
+                dd->flush_tail->next = req;
+            } else {
+                dd->flush_head = req;
+            }
+            dd->flush_tail = req;
+            continue;
+        }
+
+        uint32_t dir = direction(req);
+        req->deadline = now + (dir == DIR_WRITE ? Deadline::WRITE_EXPIRE_MS : Deadline::READ_EXPIRE_MS);
+        req->fifo_next = nullptr;
+        req->fifo_prev = dd->fifo_tail[dir];
+        if (dd->fifo_tail[dir]) {
+            dd->fifo_tail[dir]->fifo_next = req;
+        } else {
+            dd->fifo_head[dir] = req;
+        }
+        dd->fifo_tail[dir] = req;
+
+        sort_insert(dd, dir, req);
+        hash_add(dd, req);
+    }
+    dd->lock.unlock_irqrestore(flags);
+}
+
+static BlockRequest* pick(DeadlineData* dd, uint64_t now) {
+    if (dd->flush_head) {
+        BlockRequest* req = dd->flush_head;
+        dd->flush_head = req->next;
+        if (!dd->flush_head) dd->flush_tail = nullptr;
+        return req;
+    }
+
+    uint32_t dir = dd->last_dir;
+    BlockRequest* req = dd->next_rq[dir];
+    if (!req || dd->batching >= Deadline::FIFO_BATCH) {
+        bool reads = dd->fifo_head[DIR_READ];
+        bool writes = dd->fifo_head[DIR_WRITE];
+        if (reads && !(writes && dd->starved++ >= Deadline::WRITES_STARVED)) {
+            dir = DIR_READ;
+        } else if (writes) {
+            dir = DIR_WRITE;
+            dd->starved = 0;
+        } else {
+            return nullptr;
+        }
+
+        // An expired request, or running off the end of the sorted list,
+        // restarts the sweep from the oldest request.
+        req = dd->next_rq[dir];
+        if (!req || dd->fifo_head[dir]->deadline <= now) {
+            req = dd->fifo_head[dir];
+        }
+        dd->last_dir = dir;
+        dd->batching = 0;
+    }
+
+    dd->batching++;
+    dd->next_rq[dir] = req->sort_next;
+    remove(dd, req);
+    req->next = nullptr;
+    return req;
+}
+
+static BlockRequest* deadline_dispatch(BlockDevice* dev, uint32_t, uint32_t max) {
+    DeadlineData* dd = data_of(dev);
+    BlockRequest* list = nullptr;
+    BlockRequest** tail = &list;
+    uint64_t now = PIT::get_ticks();
+
+    uint64_t flags = dd->lock.lock_irqsave();
+    for (uint32_t count = 0; count < max; count++) {
+        BlockRequest* req = pick(dd, now);
+        if (!req) break;
+        *tail = req;
+        tail = &req->next;
+    }
+    dd->lock.unlock_irqrestore(flags);
+
+    return list;
+}
+
+static BlockScheduler deadline_scheduler = {
+    "deadline",
+    deadline_init,
+    deadline_exit,
+    deadline_merge,
+    deadline_insert,
+    deadline_dispatch,
+    nullptr,
+};
+
+void Deadline::initialize() {
+    Block::register_scheduler(&deadline_scheduler);
+}
+
+}
\ No newline at end of file
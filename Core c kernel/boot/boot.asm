@@ -17,6 +17,12 @@ multiboot_header_start:
     dd 768
     dd 32
 
+    ; Module alignment tag: load modules on page boundaries
+    align 8
+    dw 6
+    dw 0
+    dd 8
+
     ; End tag
     align 8
     dw 0
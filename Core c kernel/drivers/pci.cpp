@@ -1,5 +1,10 @@
 #include <kernel/drivers/pci.h>
 #include <kernel/arch/x86_64/io.h>
+#include <kernel/arch/x86_64/cpu.h>
+#include <kernel/irq/irq.h>
+#include <kernel/memory/heap.h>
+#include <kernel/memory/vmm.h>
+#include <kernel/sync/spinlock.h>
 #include <kernel/console.h>
 
 namespace Core {
@@ -7,31 +12,423 @@ namespace Core {
 #define PCI_CONFIG_ADDRESS 0xCF8
 #define PCI_CONFIG_DATA    0xCFC
 
+#define PCI_VENDOR_ID      0x00
+#define PCI_COMMAND        0x04
+#define PCI_STATUS         0x06
+#define PCI_CLASS_REVISION 0x08
+#define PCI_HEADER_TYPE    0x0E
+#define PCI_BAR0           0x10
+#define PCI_CAP_POINTER    0x34
+#define PCI_INTERRUPT_LINE 0x3C
+#define PCI_INTERRUPT_PIN  0x3D
+
+#define ISA_IRQ_LINES      16
+
+#define PCI_COMMAND_MASTER       BIT(2)
+#define PCI_COMMAND_INTX_DISABLE BIT(10)
+#define PCI_STATUS_CAP_LIST      BIT(4)
+
+#define MSI_CONTROL        0x02
+#define MSI_ADDRESS_LO     0x04
+#define MSI_ADDRESS_HI     0x08
+#define MSI_CONTROL_ENABLE BIT(0)
+#define MSI_CONTROL_64BIT  BIT(7)
+
+#define MSIX_CONTROL       0x02
+#define MSIX_TABLE         0x04
+#define MSIX_CONTROL_MASK  BIT(14)
+#define MSIX_CONTROL_ENABLE BIT(15)
+#define MSIX_ENTRY_SIZE    16
+#define MSIX_VECTOR_MASKED BIT(0)
+
+#define MSI_ADDRESS_BASE   0xFEE00000
+
+// Which device entry raised each vector, so the IrqChip callbacks (which
+// only get a number) can find the message to rewrite.
+struct MsiDesc {
+    PciDevice* dev;
+    uint16_t entry;
+};
+
+static PciDevice* devices = nullptr;
+static Spinlock config_lock("pci_config");
+static MsiDesc msi_descs[IRQ::NR_VECTORS];
+
+static uint32_t config_address(uint8_t bus, uint8_t slot, uint8_t func, uint8_t offset) {
+    return (uint32_t)((bus << 16) | (slot << 11) | (func << 8) | (offset & 0xFC) | 0x80000000);
+}
+
 static uint32_t pci_read(uint8_t bus, uint8_t slot, uint8_t func, uint8_t offset) {
-    uint32_t address = (uint32_t)((bus << 16) | (slot << 11) | 
-                      (func << 8) | (offset & 0xFC) | 0x80000000);
-    
-    IO::outl(PCI_CONFIG_ADDRESS, address);
-    return IO::inl(PCI_CONFIG_DATA);
+    uint64_t flags = config_lock.lock_irqsave();
+    IO::outl(PCI_CONFIG_ADDRESS, config_address(bus, slot, func, offset));
+    uint32_t value = IO::inl(PCI_CONFIG_DATA);
+    config_lock.unlock_irqrestore(flags);
+    return value;
+}
+
+uint32_t PCI::read32(PciDevice* dev, uint8_t offset) {
+    return pci_read(dev->bus, dev->slot, dev->func, offset);
+}
+
+uint16_t PCI::read16(PciDevice* dev, uint8_t offset) {
+    return read32(dev, offset) >> ((offset & 2) * 8);
+}
+
+uint8_t PCI::read8(PciDevice* dev, uint8_t offset) {
+    return read32(dev, offset) >> ((offset & 3) * 8);
+}
+
+void PCI::write32(PciDevice* dev, uint8_t offset, uint32_t value) {
+    uint64_t flags = config_lock.lock_irqsave();
+    IO::outl(PCI_CONFIG_ADDRESS, config_address(dev->bus, dev->slot, dev->func, offset));
+    IO::outl(PCI_CONFIG_DATA, value);
+    config_lock.unlock_irqrestore(flags);
+}
+
+void PCI::write16(PciDevice* dev, uint8_t offset, uint16_t value) {
+    uint64_t flags = config_lock.lock_irqsave();
+    IO::outl(PCI_CONFIG_ADDRESS, config_address(dev->bus, dev->slot, dev->func, offset));
+    IO::outw(PCI_CONFIG_DATA + (offset & 2), value);
+    config_lock.unlock_irqrestore(flags);
+}
+
+uint8_t PCI::find_capability(PciDevice* dev, uint8_t cap_id, uint8_t from) {
+    if (!(read16(dev, PCI_STATUS) & PCI_STATUS_CAP_LIST)) {
+        return 0;
+    }
+
+    // Bound the walk in case a broken device links the list into a loop.
+    uint8_t offset = (from ? read8(dev, from + 1) : read8(dev, PCI_CAP_POINTER)) & 0xFC;
+    for (int i = 0; offset && i < 48; i++) {
+        uint16_t header = read16(dev, offset);
+        if ((header & 0xFF) == cap_id) {
+            return offset;
+        }
+        offset = (header >> 8) & 0xFC;
+    }
+    return 0;
+}
+
+uint64_t PCI::get_bar(PciDevice* dev, uint32_t index) {
+    uint32_t bar = read32(dev, PCI_BAR0 + index * 4);
+    if (bar & 1) {
+        return bar & ~0x3ULL;
+    }
+
+    uint64_t address = bar & ~0xFULL;
+    if (((bar >> 1) & 3) == 2 && index < 5) {
+        address |= (uint64_t)read32(dev, PCI_BAR0 + (index + 1) * 4) << 32;
+    }
+    return address;
+}
+
+void PCI::enable_bus_master(PciDevice* dev) {
+    write16(dev, PCI_COMMAND, read16(dev, PCI_COMMAND) | PCI_COMMAND_MASTER);
+}
+
+static uint32_t msi_address(uint32_t cpu) {
+    return MSI_ADDRESS_BASE | (CPU::get(cpu)->apic_id << 12);
+}
+
+static volatile uint32_t* msix_entry(PciDevice* dev, uint16_t entry) {
+    return dev->msix_table + entry * (MSIX_ENTRY_SIZE / 4);
+}
+
+static void msix_mask(uint32_t vector) {
+    MsiDesc* desc = &msi_descs[vector];
+    msix_entry(desc->dev, desc->entry)[3] |= MSIX_VECTOR_MASKED;
+}
+
+static void msix_unmask(uint32_t vector) {
+    MsiDesc* desc = &msi_descs[vector];
+    msix_entry(desc->dev, desc->entry)[3] &= ~MSIX_VECTOR_MASKED;
+}
+
+// Entries are masked while the address changes so the device never sees a
+// half-written message.
+static error_t msix_set_affinity(uint32_t vector, uint8_t, uint32_t cpu) {
+    MsiDesc* desc = &msi_descs[vector];
+    volatile uint32_t* entry = msix_entry(desc->dev, desc->entry);
+
+    uint32_t control = entry[3];
+    entry[3] = control | MSIX_VECTOR_MASKED;
+    entry[0] = msi_address(cpu);
+    entry[1] = 0;
+    entry[3] = control;
+
+    return E_OK;
+}
+
+static const IrqChip msix_chip = {
+    "msix",
+    msix_mask,
+    msix_unmask,
+    msix_set_affinity,
+};
+
+// Plain MSI is only used with a single message, enabled at allocation, so
+// the enable bit doubles as the mask.
+static void msi_mask(uint32_t vector) {
+    PciDevice* dev = msi_descs[vector].dev;
+    uint8_t control = dev->msi_cap + MSI_CONTROL;
+    PCI::write16(dev, control, PCI::read16(dev, control) & ~MSI_CONTROL_ENABLE);
+}
+
+static void msi_unmask(uint32_t vector) {
+    PciDevice* dev = msi_descs[vector].dev;
+    uint8_t control = dev->msi_cap + MSI_CONTROL;
+    PCI::write16(dev, control, PCI::read16(dev, control) | MSI_CONTROL_ENABLE);
+}
+
+static error_t msi_set_affinity(uint32_t vector, uint8_t, uint32_t cpu) {
+    PciDevice* dev = msi_descs[vector].dev;
+    PCI::write32(dev, dev->msi_cap + MSI_ADDRESS_LO, msi_address(cpu));
+    return E_OK;
+}
+
+static const IrqChip msi_chip = {
+    "msi",
+    msi_mask,
+    msi_unmask,
+    msi_set_affinity,
+};
+
+static void release_vectors(PciDevice* dev, uint32_t count) {
+    for (uint32_t i = 0; i < count; i++) {
+        msi_descs[dev->vectors[i]].dev = nullptr;
+        IRQ::free_vector(dev->vectors[i]);
+    }
+}
+
+static int setup_msix(PciDevice* dev, uint32_t min_vecs, uint32_t max_vecs) {
+    uint32_t count = MIN(max_vecs, (uint32_t)dev->msix_table_size);
+    if (count < min_vecs) {
+        return E_INVAL;
+    }
+
+    if (!dev->msix_table) {
+        uint32_t table = PCI::read32(dev, dev->msix_cap + MSIX_TABLE);
+        uint64_t bar = PCI::get_bar(dev, table & 0x7);
+        dev->msix_table = (volatile uint32_t*)VMM::map_mmio(bar + (table & ~0x7U),
+                                                            dev->msix_table_size * MSIX_ENTRY_SIZE);
+        if (!dev->msix_table) {
+            return E_NOMEM;
+        }
+    }
+
+    for (uint32_t i = 0; i < count; i++) {
+        int vector = IRQ::alloc_vector();
+        if (vector < 0) {
+            if (i < min_vecs) {
+                release_vectors(dev, i);
+                return vector;
+            }
+            count = i;
+            break;
+        }
+
+        uint32_t cpu = i % CPU::online_count();
+        volatile uint32_t* entry = msix_entry(dev, i);
+        entry[3] = MSIX_VECTOR_MASKED;
+        entry[0] = msi_address(cpu);
+        entry[1] = 0;
+        entry[2] = vector;
+
+        dev->vectors[i] = vector;
+        msi_descs[vector] = {dev, (uint16_t)i};
+        IRQ::set_chip(vector, &msix_chip, vector);
+        if (cpu != 0) {
+            irq_set_affinity(vector, cpu);
+        }
+    }
+
+    uint8_t control = dev->msix_cap + MSIX_CONTROL;
+    PCI::write16(dev, control, (PCI::read16(dev, control) | MSIX_CONTROL_ENABLE) & ~MSIX_CONTROL_MASK);
+    return count;
+}
+
+static int setup_msi(PciDevice* dev) {
+    int vector = IRQ::alloc_vector();
+    if (vector < 0) {
+        return vector;
+    }
+
+    uint8_t cap = dev->msi_cap;
+    uint16_t control = PCI::read16(dev, cap + MSI_CONTROL);
+    uint8_t data = (control & MSI_CONTROL_64BIT) ? cap + 12 : cap + 8;
+
+    PCI::write32(dev, cap + MSI_ADDRESS_LO, msi_address(0));
+    if (control & MSI_CONTROL_64BIT) {
+        PCI::write32(dev, cap + MSI_ADDRESS_HI, 0);
+    }
+    PCI::write16(dev, data, vector);
+
+    // One message only: clear Multiple Message Enable, leave MSI disabled
+    // until request_irq() unmasks it.
+    PCI::write16(dev, cap + MSI_CONTROL, control & ~(MSI_CONTROL_ENABLE | (0x7 << 4)));
+
+    dev->vectors[0] = vector;
+    msi_descs[vector] = {dev, 0};
+    IRQ::set_chip(vector, &msi_chip, vector);
+    return 1;
+}
+
+int PCI::alloc_irq_vectors(PciDevice* dev, uint32_t min_vecs, uint32_t max_vecs, uint32_t types) {
+    if (!dev || min_vecs == 0 || min_vecs > max_vecs || dev->irq_mode) {
+        return E_INVAL;
+    }
+
+    dev->vectors = (uint8_t*)Heap::calloc(max_vecs, sizeof(uint8_t));
+    if (!dev->vectors) {
+        return E_NOMEM;
+    }
+
+    int count = E_INVAL;
+    if ((types & PCI_IRQ_MSIX) && dev->msix_cap) {
+        count = setup_msix(dev, min_vecs, max_vecs);
+        if (count > 0) dev->irq_mode = PCI_IRQ_MSIX;
+    }
+    if (count <= 0 && (types & PCI_IRQ_MSI) && dev->msi_cap && min_vecs == 1) {
+        count = setup_msi(dev);
+        if (count > 0) dev->irq_mode = PCI_IRQ_MSI;
+    }
+
+    if (count > 0) {
+        write16(dev, PCI_COMMAND, read16(dev, PCI_COMMAND) | PCI_COMMAND_INTX_DISABLE);
+    } else if ((types & PCI_IRQ_LEGACY) && dev->irq_pin && dev->irq_line < ISA_IRQ_LINES && min_vecs == 1) {
+        // Without an AML interpreter there is no _PRT, so trust the line the
+        // firmware wrote; it is already wired to its ISA vector. 0xFF means
+        // the firmware left it unrouted, and like any other line past the
+        // ISA range it has no vector. The line may be shared, so handlers
+        // must use IRQF_SHARED.
+        dev->vectors[0] = IRQ::ISA_VECTOR_BASE + dev->irq_line;
+        dev->irq_mode = PCI_IRQ_LEGACY;
+        count = 1;
+    }
+
+    if (count <= 0) {
+        Heap::free(dev->vectors);
+        dev->vectors = nullptr;
+        return count;
+    }
+
+    dev->vector_count = count;
+    return count;
+}
+
+void PCI::free_irq_vectors(PciDevice* dev) {
+    if (!dev->irq_mode) {
+        return;
+    }
+
+    if (dev->irq_mode == PCI_IRQ_MSIX) {
+        uint8_t control = dev->msix_cap + MSIX_CONTROL;
+        write16(dev, control, read16(dev, control) & ~MSIX_CONTROL_ENABLE);
+    } else if (dev->irq_mode == PCI_IRQ_MSI) {
+        msi_mask(dev->vectors[0]);
+    }
+
+    if (dev->irq_mode != PCI_IRQ_LEGACY) {
+        release_vectors(dev, dev->vector_count);
+        write16(dev, PCI_COMMAND, read16(dev, PCI_COMMAND) & ~PCI_COMMAND_INTX_DISABLE);
+    }
+
+    Heap::free(dev->vectors);
+    dev->vectors = nullptr;
+    dev->vector_count = 0;
+    dev->irq_mode = 0;
+}
+
+int PCI::irq_vector(PciDevice* dev, uint32_t index) {
+    if (index >= dev->vector_count) {
+        return E_INVAL;
+    }
+    return dev->vectors[index];
+}
+
+static PciDevice* probe(uint8_t bus, uint8_t slot, uint8_t func) {
+    uint32_t id = pci_read(bus, slot, func, PCI_VENDOR_ID);
+    if ((id & 0xFFFF) == 0xFFFF) {
+        return nullptr;
+    }
+
+    PciDevice* dev = (PciDevice*)Heap::calloc(1, sizeof(PciDevice));
+    if (!dev) {
+        return nullptr;
+    }
+
+    dev->bus = bus;
+    dev->slot = slot;
+    dev->func = func;
+    dev->vendor_id = id & 0xFFFF;
+    dev->device_id = id >> 16;
+
+    uint32_t class_rev = PCI::read32(dev, PCI_CLASS_REVISION);
+    dev->class_code = class_rev >> 24;
+    dev->subclass = class_rev >> 16;
+    dev->prog_if = class_rev >> 8;
+    dev->irq_line = PCI::read8(dev, PCI_INTERRUPT_LINE);
+    dev->irq_pin = PCI::read8(dev, PCI_INTERRUPT_PIN);
+
+    dev->msi_cap = PCI::find_capability(dev, PCI_CAP_MSI);
+    dev->msix_cap = PCI::find_capability(dev, PCI_CAP_MSIX);
+    if (dev->msix_cap) {
+        dev->msix_table_size = (PCI::read16(dev, dev->msix_cap + MSIX_CONTROL) & 0x7FF) + 1;
+    }
+
+    return dev;
 }
 
 void PCI::initialize() {
     int device_count = 0;
+    int msix_count = 0;
+    PciDevice** tail = &devices;
     
     for (int bus = 0; bus < 256; bus++) {
         for (int slot = 0; slot < 32; slot++) {
             for (int func = 0; func < 8; func++) {
-                uint32_t vendor_device = pci_read(bus, slot, func, 0);
-                uint16_t vendor = vendor_device & 0xFFFF;
-                
-                if (vendor != 0xFFFF) {
-                    device_count++;
+                PciDevice* dev = probe(bus, slot, func);
+                if (!dev) {
+                    if (func == 0) break;
+                    continue;
+                }
+
+                *tail = dev;
+                tail = &dev->next;
+                device_count++;
+                if (dev->msix_cap) msix_count++;
+
+                // Single-function devices may decode all eight functions.
+                if (func == 0 && !(read8(dev, PCI_HEADER_TYPE) & 0x80)) {
+                    break;
                 }
             }
         }
     }
     
-    Console::printf("[PCI] Found %d devices\n", device_count);
+    Console::printf("[PCI] Found %d devices (%d with MSI-X)\n", device_count, msix_count);
+}
+
+PciDevice* PCI::get_devices() {
+    return devices;
+}
+
+PciDevice* PCI::find(uint16_t vendor_id, uint16_t device_id, PciDevice* from) {
+    for (PciDevice* dev = from ? from->next : devices; dev; dev = dev->next) {
+        if (dev->vendor_id == vendor_id && dev->device_id == device_id) {
+            return dev;
+        }
+    }
+    return nullptr;
+}
+
+PciDevice* PCI::find_class(uint8_t class_code, uint8_t subclass, PciDevice* from) {
+    for (PciDevice* dev = from ? from->next : devices; dev; dev = dev->next) {
+        if (dev->class_code == class_code && dev->subclass == subclass) {
+            return dev;
+        }
+    }
+    return nullptr;
 }
 
 }
\ No newline at end of file
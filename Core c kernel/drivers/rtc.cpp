@@ -0,0 +1,93 @@
+#include <kernel/drivers/rtc.h>
+#include <kernel/arch/x86_64/io.h>
+
+namespace Core {
+
+#define CMOS_ADDRESS 0x70
+#define CMOS_DATA    0x71
+
+#define RTC_SECONDS  0x00
+#define RTC_MINUTES  0x02
+#define RTC_HOURS    0x04
+#define RTC_DAY      0x07
+#define RTC_MONTH    0x08
+#define RTC_YEAR     0x09
+#define RTC_STATUS_A 0x0A
+#define RTC_STATUS_B 0x0B
+
+#define STATUS_A_UPDATING BIT(7)
+#define STATUS_B_24HOUR   BIT(1)
+#define STATUS_B_BINARY   BIT(2)
+#define HOURS_PM          0x80
+
+struct RtcTime {
+    uint8_t second, minute, hour, day, month, year;
+};
+
+static uint8_t read_cmos(uint8_t reg) {
+    IO::outb(CMOS_ADDRESS, reg);
+    return IO::inb(CMOS_DATA);
+}
+
+static void read_raw(RtcTime* time) {
+    while (read_cmos(RTC_STATUS_A) & STATUS_A_UPDATING) {
+    }
+
+    time->second = read_cmos(RTC_SECONDS);
+    time->minute = read_cmos(RTC_MINUTES);
+    time->hour = read_cmos(RTC_HOURS);
+    time->day = read_cmos(RTC_DAY);
+    time->month = read_cmos(RTC_MONTH);
+    time->year = read_cmos(RTC_YEAR);
+}
+
+static uint8_t from_bcd(uint8_t value) {
+    return (value & 0x0F) + (value >> 4) * 10;
+}
+
+// Days from 1970-01-01 to the given civil date (proleptic Gregorian).
+static int64_t days_from_civil(int64_t year, uint32_t month, uint32_t day) {
+    year -= month <= 2;
+    int64_t era = (year >= 0 ? year : year - 399) / 400;
+    uint32_t year_of_era = (uint32_t)(year - era * 400);
+    uint32_t day_of_year = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + day - 1;
+    uint32_t day_of_era = year_of_era * 365 + year_of_era / 4 - year_of_era / 100 + day_of_year;
+    return era * 146097 + (int64_t)day_of_era - 719468;
+}
+
+uint64_t RTC::read_unix_time() {
+    RtcTime time, check;
+
+    // Read until two consecutive snapshots agree, so an update that lands
+    // mid-read can't produce a torn time.
+    read_raw(&time);
+    do {
+        check = time;
+        read_raw(&time);
+    } while (time.second != check.second || time.minute != check.minute ||
+             time.hour != check.hour || time.day != check.day ||
+             time.month != check.month || time.year != check.year);
+
+    uint8_t status = read_cmos(RTC_STATUS_B);
+    bool pm = time.hour & HOURS_PM;
+    time.hour &= ~HOURS_PM;
+
+    if (!(status & STATUS_B_BINARY)) {
+        time.second = from_bcd(time.second);
+        time.minute = from_bcd(time.minute);
+        time.hour = from_bcd(time.hour);
+        time.day = from_bcd(time.day);
+        time.month = from_bcd(time.month);
+        time.year = from_bcd(time.year);
+    }
+
+    if (!(status & STATUS_B_24HOUR)) {
+        time.hour %= 12;
+        if (pm) time.hour += 12;
+    }
+
+    int64_t days = days_from_civil(2000 + time.year, time.month, time.day);
+    return (uint64_t)days * 86400 + time.hour * 3600 + time.minute * 60 + time.second;
+}
+
+}
\ No newline at end of file
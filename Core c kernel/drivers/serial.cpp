@@ -0,0 +1,78 @@
+#include <kernel/drivers/serial.h>
+#include <kernel/arch/x86_64/io.h>
+#include <kernel/console.h>
+#include <stdarg.h>
+
+namespace Core {
+
+#define COM1_PORT      0x3F8
+
+#define UART_DATA      0
+#define UART_IER       1
+#define UART_FCR       2
+#define UART_LCR       3
+#define UART_MCR       4
+#define UART_LSR       5
+
+#define LCR_DLAB       0x80
+#define LCR_8N1        0x03
+#define LSR_DATA_READY 0x01
+#define LSR_THR_EMPTY  0x20
+#define MCR_LOOPBACK   0x10
+
+static bool present = false;
+
+void Serial::initialize() {
+    IO::outb(COM1_PORT + UART_IER, 0x00);
+    IO::outb(COM1_PORT + UART_LCR, LCR_DLAB);
+    IO::outb(COM1_PORT + UART_DATA, 0x01);  // 115200 baud
+    IO::outb(COM1_PORT + UART_IER, 0x00);
+    IO::outb(COM1_PORT + UART_LCR, LCR_8N1);
+    IO::outb(COM1_PORT + UART_FCR, 0xC7);   // enable and clear FIFOs
+
+    // Loopback self-test: a missing UART reads back 0xFF.
+    IO::outb(COM1_PORT + UART_MCR, MCR_LOOPBACK | 0x0F);
+    IO::outb(COM1_PORT + UART_DATA, 0xAE);
+    present = IO::inb(COM1_PORT + UART_DATA) == 0xAE;
+
+    IO::outb(COM1_PORT + UART_MCR, 0x0F);
+}
+
+bool Serial::is_present() {
+    return present;
+}
+
+void Serial::putchar(char c) {
+    if (!present) return;
+
+    if (c == '\n') {
+        putchar('\r');
+    }
+
+    while (!(IO::inb(COM1_PORT + UART_LSR) & LSR_THR_EMPTY)) {
+        __asm__ volatile("pause");
+    }
+    IO::outb(COM1_PORT + UART_DATA, c);
+}
+
+void Serial::write(const char* str) {
+    while (*str) {
+        putchar(*str++);
+    }
+}
+
+void Serial::printf(const char* format, ...) {
+    va_list args;
+    va_start(args, format);
+    Console::vprintf(putchar, format, args);
+    va_end(args);
+}
+
+int Serial::read_char() {
+    if (!present || !(IO::inb(COM1_PORT + UART_LSR) & LSR_DATA_READY)) {
+        return -1;
+    }
+    return IO::inb(COM1_PORT + UART_DATA);
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,308 @@
+#include <kernel/drivers/virtio.h>
+#include <kernel/memory/pmm.h>
+#include <kernel/memory/vmm.h>
+#include <kernel/memory/copy.h>
+#include <kernel/arch/x86_64/cpu.h>
+
+namespace Core {
+
+// struct virtio_pci_cap
+#define VIRTIO_CAP_CFG_TYPE  3
+#define VIRTIO_CAP_BAR       4
+#define VIRTIO_CAP_OFFSET    8
+#define VIRTIO_CAP_LENGTH    12
+#define VIRTIO_CAP_NOTIFY_MULTIPLIER 16
+
+#define VIRTIO_PCI_CAP_COMMON_CFG 1
+#define VIRTIO_PCI_CAP_NOTIFY_CFG 2
+#define VIRTIO_PCI_CAP_ISR_CFG    3
+#define VIRTIO_PCI_CAP_DEVICE_CFG 4
+
+// struct virtio_pci_common_cfg
+#define COMMON_DEVICE_FEATURE_SELECT 0x00
+#define COMMON_DEVICE_FEATURE        0x04
+#define COMMON_DRIVER_FEATURE_SELECT 0x08
+#define COMMON_DRIVER_FEATURE        0x0C
+#define COMMON_MSIX_CONFIG           0x10
+#define COMMON_NUM_QUEUES            0x12
+#define COMMON_DEVICE_STATUS         0x14
+#define COMMON_CONFIG_GENERATION     0x15
+#define COMMON_QUEUE_SELECT          0x16
+#define COMMON_QUEUE_SIZE            0x18
+#define COMMON_QUEUE_MSIX_VECTOR     0x1A
+#define COMMON_QUEUE_ENABLE          0x1C
+#define COMMON_QUEUE_NOTIFY_OFF      0x1E
+#define COMMON_QUEUE_DESC            0x20
+#define COMMON_QUEUE_DRIVER          0x28
+#define COMMON_QUEUE_DEVICE          0x30
+
+#define PCI_BAR0 0x10
+
+static inline uint8_t read8(volatile uint8_t* base, uint32_t offset) {
+    return *(volatile uint8_t*)(base + offset);
+}
+
+static inline uint16_t read16(volatile uint8_t* base, uint32_t offset) {
+    return *(volatile uint16_t*)(base + offset);
+}
+
+static inline uint32_t read32(volatile uint8_t* base, uint32_t offset) {
+    return *(volatile uint32_t*)(base + offset);
+}
+
+static inline void write8(volatile uint8_t* base, uint32_t offset, uint8_t value) {
+    *(volatile uint8_t*)(base + offset) = value;
+}
+
+static inline void write16(volatile uint8_t* base, uint32_t offset, uint16_t value) {
+    *(volatile uint16_t*)(base + offset) = value;
+}
+
+static inline void write32(volatile uint8_t* base, uint32_t offset, uint32_t value) {
+    *(volatile uint32_t*)(base + offset) = value;
+}
+
+// 64-bit registers may be written as two halves, low first.
+static inline void write64(volatile uint8_t* base, uint32_t offset, uint64_t value) {
+    write32(base, offset, (uint32_t)value);
+    write32(base, offset + 4, (uint32_t)(value >> 32));
+}
+
+static void set_status(VirtioDevice* vdev, uint8_t bits) {
+    write8(vdev->common, COMMON_DEVICE_STATUS, read8(vdev->common, COMMON_DEVICE_STATUS) | bits);
+}
+
+void Virtqueue::add(uint16_t head) {
+    avail[2 + (avail_idx & (size - 1))] = head;
+    avail_idx++;
+}
+
+// Has the device's event index been passed by the entries published
+// between `old_idx` and `new_idx`? (vring_need_event)
+static inline bool need_event(uint16_t event, uint16_t new_idx, uint16_t old_idx) {
+    return (uint16_t)(new_idx - event - 1) < (uint16_t)(new_idx - old_idx);
+}
+
+bool Virtqueue::kick() {
+    uint16_t old_idx = kicked_idx;
+    uint16_t new_idx = avail_idx;
+    if (old_idx == new_idx) {
+        return false;
+    }
+    kicked_idx = new_idx;
+
+    // Ring entries become visible before the index that publishes them, and
+    // the index before the device's suppression state is read; the latter
+    // is a store-load ordering and needs a full fence.
+    __atomic_store_n(&avail[1], new_idx, __ATOMIC_RELEASE);
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    bool needed;
+    if (event_idx) {
+        needed = need_event(used[2 + size * 4], new_idx, old_idx);
+    } else {
+        needed = !(used[0] & VIRTQ_USED_F_NO_NOTIFY);
+    }
+
+    if (needed) {
+        *notify = index;
+    }
+    return needed;
+}
+
+bool Virtqueue::pop_used(uint32_t* id, uint32_t* len) {
+    if (last_used == __atomic_load_n(&used[1], __ATOMIC_ACQUIRE)) {
+        return false;
+    }
+
+    volatile VirtqUsedElem* elem = &used_ring[last_used & (size - 1)];
+    *id = elem->id;
+    *len = elem->len;
+    last_used++;
+    return true;
+}
+
+bool Virtqueue::arm() {
+    // With EVENT_IDX the device interrupts once used->idx passes
+    // used_event, so completions arriving while the previous batch is
+    // being reaped raise no further interrupts.
+    if (event_idx) {
+        avail[2 + size] = last_used;
+    }
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    return __atomic_load_n(&used[1], __ATOMIC_ACQUIRE) == last_used;
+}
+
+error_t Virtio::probe(VirtioDevice* vdev, PciDevice* pci) {
+    vdev->pci = pci;
+
+    for (uint8_t cap = PCI::find_capability(pci, PCI_CAP_VENDOR); cap;
+         cap = PCI::find_capability(pci, PCI_CAP_VENDOR, cap)) {
+        uint8_t type = PCI::read8(pci, cap + VIRTIO_CAP_CFG_TYPE);
+        uint8_t bar = PCI::read8(pci, cap + VIRTIO_CAP_BAR);
+        uint32_t offset = PCI::read32(pci, cap + VIRTIO_CAP_OFFSET);
+        uint32_t length = PCI::read32(pci, cap + VIRTIO_CAP_LENGTH);
+
+        volatile uint8_t** slot;
+        switch (type) {
+        case VIRTIO_PCI_CAP_COMMON_CFG: slot = &vdev->common; break;
+        case VIRTIO_PCI_CAP_NOTIFY_CFG: slot = &vdev->notify_base; break;
+        case VIRTIO_PCI_CAP_ISR_CFG: slot = &vdev->isr; break;
+        case VIRTIO_PCI_CAP_DEVICE_CFG: slot = &vdev->device_cfg; break;
+        default: continue;
+        }
+
+        // The first structure of each type is the preferred one; I/O BARs
+        // are not supported.
+        if (*slot || bar > 5 || length == 0 || (PCI::read32(pci, PCI_BAR0 + bar * 4) & 1)) {
+            continue;
+        }
+
+        *slot = (volatile uint8_t*)VMM::map_mmio(PCI::get_bar(pci, bar) + offset, length);
+        if (type == VIRTIO_PCI_CAP_NOTIFY_CFG) {
+            vdev->notify_multiplier = PCI::read32(pci, cap + VIRTIO_CAP_NOTIFY_MULTIPLIER);
+        }
+    }
+
+    if (!vdev->common || !vdev->notify_base || !vdev->isr) {
+        return E_NOSYS;
+    }
+
+    PCI::enable_bus_master(pci);
+
+    write8(vdev->common, COMMON_DEVICE_STATUS, 0);
+    while (read8(vdev->common, COMMON_DEVICE_STATUS) != 0) {
+        CPU::relax();
+    }
+
+    write16(vdev->common, COMMON_MSIX_CONFIG, VIRTIO_MSI_NO_VECTOR);
+    set_status(vdev, VIRTIO_STATUS_ACKNOWLEDGE | VIRTIO_STATUS_DRIVER);
+    return E_OK;
+}
+
+error_t Virtio::negotiate(VirtioDevice* vdev, uint64_t wanted) {
+    uint64_t offered = 0;
+    for (uint32_t i = 0; i < 2; i++) {
+        write32(vdev->common, COMMON_DEVICE_FEATURE_SELECT, i);
+        offered |= (uint64_t)read32(vdev->common, COMMON_DEVICE_FEATURE) << (i * 32);
+    }
+
+    if (!(offered & BIT(VIRTIO_F_VERSION_1))) {
+        return E_NOSYS;
+    }
+
+    uint64_t features = offered & (wanted | BIT(VIRTIO_F_VERSION_1));
+    for (uint32_t i = 0; i < 2; i++) {
+        write32(vdev->common, COMMON_DRIVER_FEATURE_SELECT, i);
+        write32(vdev->common, COMMON_DRIVER_FEATURE, (uint32_t)(features >> (i * 32)));
+    }
+
+    set_status(vdev, VIRTIO_STATUS_FEATURES_OK);
+    if (!(read8(vdev->common, COMMON_DEVICE_STATUS) & VIRTIO_STATUS_FEATURES_OK)) {
+        return E_INVAL;
+    }
+
+    vdev->features = features;
+    return E_OK;
+}
+
+uint16_t Virtio::get_num_queues(VirtioDevice* vdev) {
+    return read16(vdev->common, COMMON_NUM_QUEUES);
+}
+
+error_t Virtio::setup_queue(VirtioDevice* vdev, Virtqueue* vq, uint16_t index, uint16_t max_size,
+                            uint16_t msix_entry) {
+    write16(vdev->common, COMMON_QUEUE_SELECT, index);
+
+    // Split queue sizes are powers of two, and so is every cap we pass.
+    uint16_t size = MIN(read16(vdev->common, COMMON_QUEUE_SIZE), MIN(max_size, Virtqueue::MAX_SIZE));
+    if (size == 0 || (size & (size - 1))) {
+        return E_INVAL;
+    }
+
+    size_t avail_offset = size * sizeof(VirtqDesc);
+    size_t used_offset = ALIGN_UP(avail_offset + 6 + 2 * size, 4);
+    size_t pages = ALIGN_UP(used_offset + 6 + sizeof(VirtqUsedElem) * size, PAGE_SIZE) / PAGE_SIZE;
+
+    uint64_t phys = PMM::alloc_pages(pages);
+    if (!phys) {
+        return E_NOMEM;
+    }
+
+    uint8_t* base = (uint8_t*)(phys + KERNEL_VIRTUAL_BASE);
+    zero_pages(base, pages);
+
+    vq->index = index;
+    vq->size = size;
+    vq->desc = (VirtqDesc*)base;
+    vq->avail = (volatile uint16_t*)(base + avail_offset);
+    vq->used = (volatile uint16_t*)(base + used_offset);
+    vq->used_ring = (volatile VirtqUsedElem*)(base + used_offset + 4);
+    vq->phys = phys;
+    vq->pages = pages;
+    vq->avail_idx = 0;
+    vq->kicked_idx = 0;
+    vq->last_used = 0;
+    vq->event_idx = has_feature(vdev, VIRTIO_F_RING_EVENT_IDX);
+
+    write16(vdev->common, COMMON_QUEUE_SIZE, size);
+    write64(vdev->common, COMMON_QUEUE_DESC, phys);
+    write64(vdev->common, COMMON_QUEUE_DRIVER, phys + avail_offset);
+    write64(vdev->common, COMMON_QUEUE_DEVICE, phys + used_offset);
+
+    // The device answers NO_VECTOR if it could not take the entry.
+    write16(vdev->common, COMMON_QUEUE_MSIX_VECTOR, msix_entry);
+    if (read16(vdev->common, COMMON_QUEUE_MSIX_VECTOR) != msix_entry) {
+        free_queue(vq);
+        return E_BUSY;
+    }
+
+    uint16_t notify_off = read16(vdev->common, COMMON_QUEUE_NOTIFY_OFF);
+    vq->notify = (volatile uint16_t*)(vdev->notify_base + (uint64_t)notify_off * vdev->notify_multiplier);
+
+    write16(vdev->common, COMMON_QUEUE_ENABLE, 1);
+    return E_OK;
+}
+
+void Virtio::free_queue(Virtqueue* vq) {
+    if (vq->phys) {
+        PMM::free_pages(vq->phys, vq->pages);
+        vq->phys = 0;
+    }
+}
+
+void Virtio::ready(VirtioDevice* vdev) {
+    set_status(vdev, VIRTIO_STATUS_DRIVER_OK);
+}
+
+void Virtio::fail(VirtioDevice* vdev) {
+    set_status(vdev, VIRTIO_STATUS_FAILED);
+}
+
+uint8_t Virtio::read_isr(VirtioDevice* vdev) {
+    return *vdev->isr;
+}
+
+void Virtio::read_config(VirtioDevice* vdev, uint32_t offset, void* buffer, size_t size) {
+    // Fields are read at their natural width (64-bit ones as two halves);
+    // a generation change means the device updated them mid-read.
+    uint8_t generation;
+    do {
+        generation = read8(vdev->common, COMMON_CONFIG_GENERATION);
+        switch (size) {
+        case 1: *(uint8_t*)buffer = read8(vdev->device_cfg, offset); break;
+        case 2: *(uint16_t*)buffer = read16(vdev->device_cfg, offset); break;
+        case 4: *(uint32_t*)buffer = read32(vdev->device_cfg, offset); break;
+        case 8:
+            *(uint64_t*)buffer = read32(vdev->device_cfg, offset) |
+                                 (uint64_t)read32(vdev->device_cfg, offset + 4) << 32;
+            break;
+        default:
+            for (size_t i = 0; i < size; i++) {
+                ((uint8_t*)buffer)[i] = read8(vdev->device_cfg, offset + i);
+            }
+        }
+    } while (generation != read8(vdev->common, COMMON_CONFIG_GENERATION));
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,580 @@
+#include <kernel/drivers/virtio_blk.h>
+#include <kernel/drivers/pci.h>
+#include <kernel/block/block.h>
+#include <kernel/irq/irq.h>
+#include <kernel/irq/softirq.h>
+#include <kernel/memory/heap.h>
+#include <kernel/memory/pmm.h>
+#include <kernel/memory/copy.h>
+#include <kernel/sync/spinlock.h>
+#include <kernel/sync/completion.h>
+#include <kernel/process/scheduler.h>
+#include <kernel/arch/x86_64/cpu.h>
+#include <kernel/console.h>
+
+namespace Core {
+
+#define VIRTIO_DEVICE_BLK_MODERN       0x1042
+#define VIRTIO_DEVICE_BLK_TRANSITIONAL 0x1001
+
+#define VIRTIO_BLK_F_SEG_MAX  2
+#define VIRTIO_BLK_F_RO       5
+#define VIRTIO_BLK_F_BLK_SIZE 6
+#define VIRTIO_BLK_F_FLUSH    9
+#define VIRTIO_BLK_F_MQ       12
+
+// struct virtio_blk_config
+#define VIRTIO_BLK_CFG_CAPACITY   0x00
+#define VIRTIO_BLK_CFG_SEG_MAX    0x0C
+#define VIRTIO_BLK_CFG_BLK_SIZE   0x14
+#define VIRTIO_BLK_CFG_NUM_QUEUES 0x22
+
+#define VIRTIO_BLK_S_OK     0
+#define VIRTIO_BLK_S_UNSUPP 2
+
+// Header, up to VIRTIO_BLK_MAX_SEGMENTS data buffers, status.
+#define TABLE_ENTRIES (VIRTIO_BLK_MAX_SEGMENTS + 2)
+
+struct VirtioBlkHeader {
+    uint32_t type;
+    uint32_t reserved;
+    uint64_t sector;
+} PACKED;
+
+// The per-slot buffers the device reads the header from and writes the
+// status to.
+struct SlotDma {
+    VirtioBlkHeader header;
+    volatile uint8_t status;
+    uint8_t pad[15];
+};
+
+struct VirtioBlkQueue {
+    Virtqueue vq;
+    Spinlock lock;
+    bool indirect;
+    uint16_t chain;             // descriptors per slot without indirect
+    uint16_t depth;
+    uint16_t free_count;
+    uint16_t* free_slots;
+    VirtioBlkRequest** inflight;
+    SlotDma* slots;
+    VirtqDesc* tables;          // TABLE_ENTRIES per slot, if indirect
+    uint64_t dma_phys;
+    size_t dma_pages;
+    VirtioBlkStats stats;
+} ALIGNED(64);
+
+// Finished requests wait here for the block softirq, which runs on the CPU
+// that took the interrupt.
+struct DoneList {
+    VirtioBlkRequest* head;
+    VirtioBlkRequest* tail;
+} ALIGNED(64);
+
+static VirtioBlkDevice* devices = nullptr;
+static DoneList done_lists[CPU::MAX_CPUS];
+
+static uint64_t dma_addr(VirtioBlkQueue* q, const void* ptr) {
+    return q->dma_phys + ((uint64_t)ptr - (q->dma_phys + KERNEL_VIRTUAL_BASE));
+}
+
+static void finish(VirtioBlkRequest* head, VirtioBlkRequest* tail) {
+    uint64_t flags = CPU::irq_save();
+    DoneList& list = done_lists[CPU::id()];
+
+    tail->next = nullptr;
+    if (list.tail) {
+        list.tail->next = head;
+    } else {
+        list.head = head;
+    }
+    list.tail = tail;
+
+    Softirq::raise(SOFTIRQ_BLOCK);
+    CPU::irq_restore(flags);
+}
+
+static void run_completions() {
+    uint64_t flags = CPU::irq_save();
+    DoneList& list = done_lists[CPU::id()];
+    VirtioBlkRequest* req = list.head;
+    list.head = list.tail = nullptr;
+    CPU::irq_restore(flags);
+
+    while (req) {
+        VirtioBlkRequest* next = req->next;
+        req->done(req);
+        req = next;
+    }
+}
+
+static error_t check(VirtioBlkDevice* dev, VirtioBlkRequest* req) {
+    if (req->type == VIRTIO_BLK_T_FLUSH) {
+        return req->segment_count == 0 ? E_OK : E_INVAL;
+    }
+    if (req->type != VIRTIO_BLK_T_IN && req->type != VIRTIO_BLK_T_OUT) {
+        return E_INVAL;
+    }
+    if (req->type == VIRTIO_BLK_T_OUT && dev->read_only) {
+        return E_PERM;
+    }
+    if (req->segment_count == 0 || req->segment_count > dev->max_segments) {
+        return E_INVAL;
+    }
+
+    uint64_t bytes = 0;
+    for (uint32_t i = 0; i < req->segment_count; i++) {
+        if (req->segments[i].len == 0) {
+            return E_INVAL;
+        }
+        bytes += req->segments[i].len;
+    }
+
+    uint64_t sectors = bytes / VirtioBlk::SECTOR_SIZE;
+    if (bytes % VirtioBlk::SECTOR_SIZE || req->sector > dev->capacity || sectors > dev->capacity - req->sector) {
+        return E_INVAL;
+    }
+    return E_OK;
+}
+
+// Builds the request's chain in its slot and returns the head descriptor.
+static uint16_t fill(VirtioBlkQueue* q, uint16_t slot, VirtioBlkRequest* req) {
+    SlotDma* dma = &q->slots[slot];
+    dma->header.type = req->type;
+    dma->header.reserved = 0;
+    dma->header.sector = req->type == VIRTIO_BLK_T_FLUSH ? 0 : req->sector;
+    dma->status = 0xFF;
+
+    // Indirect tables index from 0; direct chains live at a fixed offset
+    // in the ring's own table.
+    VirtqDesc* table;
+    uint16_t base;
+    if (q->indirect) {
+        table = &q->tables[slot * TABLE_ENTRIES];
+        base = 0;
+    } else {
+        base = slot * q->chain;
+        table = &q->vq.desc[base];
+    }
+
+    uint16_t data_flags = req->type == VIRTIO_BLK_T_IN ? VIRTQ_DESC_F_WRITE : 0;
+    uint32_t n = 0;
+    table[n] = {dma_addr(q, &dma->header), sizeof(VirtioBlkHeader), VIRTQ_DESC_F_NEXT, (uint16_t)(base + 1)};
+    for (uint32_t i = 0; i < req->segment_count; i++) {
+        n++;
+        table[n] = {req->segments[i].phys, req->segments[i].len, (uint16_t)(VIRTQ_DESC_F_NEXT | data_flags),
+                    (uint16_t)(base + n + 1)};
+    }
+    n++;
+    table[n] = {dma_addr(q, (const void*)&dma->status), 1, VIRTQ_DESC_F_WRITE, 0};
+
+    q->inflight[slot] = req;
+    if (!q->indirect) {
+        return base;
+    }
+
+    q->vq.desc[slot] = {dma_addr(q, table), (n + 1) * (uint32_t)sizeof(VirtqDesc), VIRTQ_DESC_F_INDIRECT, 0};
+    return slot;
+}
+
+uint32_t VirtioBlk::submit(VirtioBlkDevice* dev, uint32_t queue, VirtioBlkRequest** list) {
+    VirtioBlkQueue* q = &dev->queues[queue % dev->queue_count];
+    VirtioBlkRequest* rejected = nullptr;
+    VirtioBlkRequest* rejected_tail = nullptr;
+    uint32_t taken = 0;
+    uint32_t placed = 0;
+
+    uint64_t flags = q->lock.lock_irqsave();
+    while (*list && q->free_count > 0) {
+        VirtioBlkRequest* req = *list;
+        *list = req->next;
+        taken++;
+
+        // Without VIRTIO_BLK_F_FLUSH the device writes through, so a flush
+        // has nothing to wait for.
+        req->result = check(dev, req);
+        if (req->result != E_OK || (req->type == VIRTIO_BLK_T_FLUSH && !dev->can_flush)) {
+            req->next = nullptr;
+            if (rejected_tail) {
+                rejected_tail->next = req;
+            } else {
+                rejected = req;
+            }
+            rejected_tail = req;
+            continue;
+        }
+
+        uint16_t slot = q->free_slots[--q->free_count];
+        q->vq.add(fill(q, slot, req));
+        placed++;
+    }
+
+    if (placed) {
+        q->stats.submitted += placed;
+        if (q->vq.kick()) {
+            q->stats.kicks++;
+        }
+    }
+    q->lock.unlock_irqrestore(flags);
+
+    if (rejected) {
+        finish(rejected, rejected_tail);
+    }
+    return taken;
+}
+
+// Called with interrupts off. Keeps reaping until the queue is re-armed
+// with nothing outstanding, so a completion that raced the re-arm is not
+// left waiting for an interrupt the device suppressed.
+static void reap(VirtioBlkQueue* q) {
+    VirtioBlkRequest* head = nullptr;
+    VirtioBlkRequest* tail = nullptr;
+    uint32_t bad = 0;
+
+    q->lock.lock();
+    q->stats.interrupts++;
+    do {
+        uint32_t id, len;
+        while (q->vq.pop_used(&id, &len)) {
+            // The id comes from the device. Without indirect descriptors it
+            // must name the head of a slot's chain, and the slot must be in
+            // flight, or a bad id would complete some other request.
+            if (id >= q->vq.size || (!q->indirect && id % q->chain != 0)) {
+                bad++;
+                continue;
+            }
+            uint16_t slot = q->indirect ? id : id / q->chain;
+            VirtioBlkRequest* req = slot < q->depth ? q->inflight[slot] : nullptr;
+            if (!req) {
+                bad++;
+                continue;
+            }
+            q->inflight[slot] = nullptr;
+            q->free_slots[q->free_count++] = slot;
+
+            uint8_t status = q->slots[slot].status;
+            req->result = status == VIRTIO_BLK_S_OK ? E_OK : status == VIRTIO_BLK_S_UNSUPP ? E_NOSYS : E_IO;
+            req->next = nullptr;
+            if (tail) {
+                tail->next = req;
+            } else {
+                head = req;
+            }
+            tail = req;
+            q->stats.completed++;
+        }
+    } while (!q->vq.arm());
+    q->stats.bad_completions += bad;
+    q->lock.unlock();
+
+    if (bad) {
+        Console::printf("[VIRTIO] Ignored %u used-ring entries with bad ids\n", bad);
+    }
+
+    if (head) {
+        finish(head, tail);
+    }
+}
+
+static bool queue_interrupt(uint8_t, void* data) {
+    reap((VirtioBlkQueue*)data);
+    return true;
+}
+
+// INTx may be shared; the ISR register says whether this device raised it.
+static bool legacy_interrupt(uint8_t, void* data) {
+    VirtioBlkDevice* dev = (VirtioBlkDevice*)data;
+    if (!(Virtio::read_isr(&dev->vdev) & 1)) {
+        return false;
+    }
+
+    for (uint32_t i = 0; i < dev->queue_count; i++) {
+        reap(&dev->queues[i]);
+    }
+    return true;
+}
+
+static error_t setup_queue(VirtioBlkDevice* dev, VirtioBlkQueue* q, uint16_t index, uint16_t msix_entry) {
+    error_t err = Virtio::setup_queue(&dev->vdev, &q->vq, index, VirtioBlk::QUEUE_SIZE, msix_entry);
+    if (err != E_OK) {
+        return err;
+    }
+
+    q->lock.set_name("virtio_blk_queue");
+    q->indirect = Virtio::has_feature(&dev->vdev, VIRTIO_F_RING_INDIRECT_DESC);
+    if (q->indirect) {
+        q->depth = q->vq.size;
+    } else {
+        // The device may offer a smaller queue than asked for; a request
+        // then gets only what is left after its header and status.
+        if (q->vq.size < 3) {
+            return E_INVAL;
+        }
+        q->chain = MIN(dev->max_segments + 2, (uint32_t)q->vq.size);
+        q->depth = q->vq.size / q->chain;
+        dev->max_segments = MIN(dev->max_segments, (uint32_t)q->chain - 2);
+    }
+
+    size_t tables = q->indirect ? (size_t)q->depth * TABLE_ENTRIES * sizeof(VirtqDesc) : 0;
+    q->dma_pages = ALIGN_UP(q->depth * sizeof(SlotDma) + tables, PAGE_SIZE) / PAGE_SIZE;
+    q->dma_phys = PMM::alloc_pages(q->dma_pages);
+    q->free_slots = (uint16_t*)Heap::malloc(q->depth * sizeof(uint16_t));
+    q->inflight = (VirtioBlkRequest**)Heap::calloc(q->depth, sizeof(VirtioBlkRequest*));
+    if (!q->dma_phys || !q->free_slots || !q->inflight) {
+        return E_NOMEM;
+    }
+
+    uint8_t* base = (uint8_t*)(q->dma_phys + KERNEL_VIRTUAL_BASE);
+    zero_pages(base, q->dma_pages);
+    q->slots = (SlotDma*)base;
+    q->tables = (VirtqDesc*)(base + q->depth * sizeof(SlotDma));
+
+    // Handed out from the top, so slot 0 goes first.
+    for (uint16_t i = 0; i < q->depth; i++) {
+        q->free_slots[i] = q->depth - 1 - i;
+    }
+    q->free_count = q->depth;
+    return E_OK;
+}
+
+static void destroy(VirtioBlkDevice* dev) {
+    Virtio::fail(&dev->vdev);
+
+    if (dev->queues) {
+        for (uint32_t i = 0; i < dev->queue_count; i++) {
+            VirtioBlkQueue* q = &dev->queues[i];
+            Virtio::free_queue(&q->vq);
+            if (q->dma_phys) PMM::free_pages(q->dma_phys, q->dma_pages);
+            if (q->free_slots) Heap::free(q->free_slots);
+            if (q->inflight) Heap::free(q->inflight);
+        }
+        Heap::free(dev->queues);
+    }
+
+    PCI::free_irq_vectors(dev->vdev.pci);
+    Heap::free(dev);
+}
+
+static VirtioBlkDevice* probe(PciDevice* pci, uint32_t index) {
+    VirtioBlkDevice* dev = (VirtioBlkDevice*)Heap::calloc(1, sizeof(VirtioBlkDevice));
+    if (!dev) {
+        return nullptr;
+    }
+
+    VirtioDevice* vdev = &dev->vdev;
+    uint64_t wanted = BIT(VIRTIO_F_RING_INDIRECT_DESC) | BIT(VIRTIO_F_RING_EVENT_IDX) |
+                      BIT(VIRTIO_BLK_F_SEG_MAX) | BIT(VIRTIO_BLK_F_RO) | BIT(VIRTIO_BLK_F_BLK_SIZE) |
+                      BIT(VIRTIO_BLK_F_FLUSH) | BIT(VIRTIO_BLK_F_MQ);
+    if (Virtio::probe(vdev, pci) != E_OK || !vdev->device_cfg || Virtio::negotiate(vdev, wanted) != E_OK) {
+        if (vdev->common) Virtio::fail(vdev);
+        Heap::free(dev);
+        return nullptr;
+    }
+
+    dev->name[0] = 'v';
+    dev->name[1] = 'd';
+    dev->name[2] = 'a' + index;
+    Virtio::read_config(vdev, VIRTIO_BLK_CFG_CAPACITY, &dev->capacity, sizeof(uint64_t));
+
+    dev->block_size = VirtioBlk::SECTOR_SIZE;
+    if (Virtio::has_feature(vdev, VIRTIO_BLK_F_BLK_SIZE)) {
+        Virtio::read_config(vdev, VIRTIO_BLK_CFG_BLK_SIZE, &dev->block_size, sizeof(uint32_t));
+    }
+
+    // With indirect descriptors seg_max bounds the table, otherwise the
+    // queue size does; setup_queue() lowers this further if the device
+    // gives a queue smaller than QUEUE_SIZE.
+    dev->max_segments = VIRTIO_BLK_MAX_SEGMENTS;
+    if (Virtio::has_feature(vdev, VIRTIO_BLK_F_SEG_MAX)) {
+        uint32_t seg_max;
+        Virtio::read_config(vdev, VIRTIO_BLK_CFG_SEG_MAX, &seg_max, sizeof(uint32_t));
+        if (seg_max) dev->max_segments = MIN(dev->max_segments, seg_max);
+    }
+    if (!Virtio::has_feature(vdev, VIRTIO_F_RING_INDIRECT_DESC)) {
+        dev->max_segments = MIN(dev->max_segments, (uint32_t)VirtioBlk::QUEUE_SIZE - 2);
+    }
+
+    dev->read_only = Virtio::has_feature(vdev, VIRTIO_BLK_F_RO);
+    dev->can_flush = Virtio::has_feature(vdev, VIRTIO_BLK_F_FLUSH);
+
+    uint16_t device_queues = 1;
+    if (Virtio::has_feature(vdev, VIRTIO_BLK_F_MQ)) {
+        Virtio::read_config(vdev, VIRTIO_BLK_CFG_NUM_QUEUES, &device_queues, sizeof(uint16_t));
+        device_queues = MAX(device_queues, (uint16_t)1);
+    }
+
+    // One queue per CPU, each with its own MSI-X vector on that CPU. Fewer
+    // vectors mean fewer queues; without MSI-X everything shares INTx.
+    uint32_t wanted_queues = MIN((uint32_t)device_queues, CPU::online_count());
+    int vectors = PCI::alloc_irq_vectors(pci, 1, wanted_queues, PCI_IRQ_MSIX | PCI_IRQ_LEGACY);
+    if (vectors < 0) {
+        destroy(dev);
+        return nullptr;
+    }
+
+    bool msix = pci->irq_mode == PCI_IRQ_MSIX;
+    dev->queue_count = msix ? (uint32_t)vectors : 1;
+    dev->queues = (VirtioBlkQueue*)Heap::calloc(dev->queue_count, sizeof(VirtioBlkQueue));
+    if (!dev->queues) {
+        destroy(dev);
+        return nullptr;
+    }
+
+    for (uint32_t i = 0; i < dev->queue_count; i++) {
+        if (setup_queue(dev, &dev->queues[i], i, msix ? i : VIRTIO_MSI_NO_VECTOR) != E_OK) {
+            destroy(dev);
+            return nullptr;
+        }
+    }
+    dev->queue_depth = dev->queues[0].depth;
+
+    Virtio::ready(vdev);
+
+    if (msix) {
+        for (uint32_t i = 0; i < dev->queue_count; i++) {
+            request_irq(PCI::irq_vector(pci, i), queue_interrupt, &dev->queues[i], dev->name);
+        }
+    } else {
+        request_irq(PCI::irq_vector(pci, 0), legacy_interrupt, dev, dev->name, IRQF_SHARED);
+    }
+
+    return dev;
+}
+
+static void block_done(VirtioBlkRequest* vreq) {
+    Block::complete((BlockRequest*)vreq->private_data, vreq->result);
+}
+
+// Each block request carries its VirtioBlkRequest in driver_data, so
+// nothing is allocated on the way down.
+static uint32_t queue_requests(BlockDevice* bdev, uint32_t hw_queue, BlockRequest** list) {
+    VirtioBlkDevice* dev = (VirtioBlkDevice*)bdev->private_data;
+    VirtioBlkRequest* head = nullptr;
+    VirtioBlkRequest** tail = &head;
+
+    for (BlockRequest* req = *list; req; req = req->next) {
+        VirtioBlkRequest* vreq = (VirtioBlkRequest*)req->driver_data;
+        switch (req->op) {
+        case BlockOp::READ:  vreq->type = VIRTIO_BLK_T_IN; break;
+        case BlockOp::WRITE: vreq->type = VIRTIO_BLK_T_OUT; break;
+        case BlockOp::FLUSH: vreq->type = VIRTIO_BLK_T_FLUSH; break;
+        }
+        vreq->sector = req->sector;
+        vreq->segment_count = req->segment_count;
+        for (uint32_t i = 0; i < req->segment_count; i++) {
+            vreq->segments[i] = {req->segments[i].phys, req->segments[i].len};
+        }
+        vreq->done = block_done;
+        vreq->private_data = req;
+        *tail = vreq;
+        tail = &vreq->next;
+    }
+    *tail = nullptr;
+
+    uint32_t taken = VirtioBlk::submit(dev, hw_queue, &head);
+    *list = head ? (BlockRequest*)head->private_data : nullptr;
+    return taken;
+}
+
+static const BlockDeviceOps block_ops = {
+    queue_requests,
+};
+
+static void register_block(VirtioBlkDevice* dev) {
+    BlockDevice* bdev = &dev->block;
+    copy_bytes(bdev->name, dev->name, sizeof(dev->name));
+    bdev->capacity = dev->capacity;
+    bdev->max_segments = dev->max_segments;
+    bdev->max_sectors = VirtioBlk::MAX_SECTORS;
+    bdev->hw_queue_count = dev->queue_count;
+    bdev->hw_queue_depth = dev->queue_depth;
+    bdev->cmd_size = sizeof(VirtioBlkRequest);
+    bdev->ops = &block_ops;
+    bdev->private_data = dev;
+
+    error_t err = Block::register_device(bdev);
+    if (err != E_OK) {
+        Console::printf("[VIRTIO] %s: block layer registration failed (%d); only raw VirtioBlk I/O works\n",
+                        dev->name, err);
+    }
+}
+
+void VirtioBlk::initialize() {
+    Softirq::register_handler(SOFTIRQ_BLOCK, run_completions);
+
+    VirtioBlkDevice** tail = &devices;
+    uint32_t count = 0;
+
+    for (PciDevice* pci = PCI::get_devices(); pci && count < 26; pci = pci->next) {
+        if (pci->vendor_id != VIRTIO_VENDOR_ID ||
+            (pci->device_id != VIRTIO_DEVICE_BLK_MODERN && pci->device_id != VIRTIO_DEVICE_BLK_TRANSITIONAL)) {
+            continue;
+        }
+
+        VirtioBlkDevice* dev = probe(pci, count);
+        if (!dev) {
+            Console::printf("[VIRTIO] %02x:%02x.%x: unsupported block device\n", pci->bus, pci->slot, pci->func);
+            continue;
+        }
+
+        *tail = dev;
+        tail = &dev->next;
+        count++;
+
+        Console::printf("[VIRTIO] %s: %llu MB, %u queues x %u%s%s%s\n", dev->name,
+                        dev->capacity * SECTOR_SIZE / (1024 * 1024), dev->queue_count, dev->queue_depth,
+                        dev->queues[0].indirect ? ", indirect" : "",
+                        Virtio::has_feature(&dev->vdev, VIRTIO_F_RING_EVENT_IDX) ? ", event-idx" : "",
+                        dev->read_only ? ", read-only" : "");
+        register_block(dev);
+    }
+}
+
+VirtioBlkDevice* VirtioBlk::get_devices() {
+    return devices;
+}
+
+static void sync_done(VirtioBlkRequest* req) {
+    ((Completion*)req->private_data)->complete();
+}
+
+error_t VirtioBlk::rw(VirtioBlkDevice* dev, uint32_t type, uint64_t sector, uint64_t phys, uint32_t len) {
+    Completion done;
+    VirtioBlkRequest req;
+    req.type = type;
+    req.sector = sector;
+    req.segment_count = len ? 1 : 0;
+    req.segments[0] = {phys, len};
+    req.done = sync_done;
+    req.private_data = &done;
+    req.next = nullptr;
+
+    // Only waits for a slot if the queue is full.
+    VirtioBlkRequest* list = &req;
+    while (list) {
+        if (!submit(dev, queue_for_cpu(dev, CPU::id()), &list) && list) {
+            Scheduler::yield();
+        }
+    }
+
+    done.wait();
+    return req.result;
+}
+
+VirtioBlkStats VirtioBlk::get_stats(VirtioBlkDevice* dev) {
+    VirtioBlkStats total = {};
+    for (uint32_t i = 0; i < dev->queue_count; i++) {
+        VirtioBlkQueue* q = &dev->queues[i];
+        uint64_t flags = q->lock.lock_irqsave();
+        total.submitted += q->stats.submitted;
+        total.completed += q->stats.completed;
+        total.kicks += q->stats.kicks;
+        total.interrupts += q->stats.interrupts;
+        total.bad_completions += q->stats.bad_completions;
+        q->lock.unlock_irqrestore(flags);
+    }
+    return total;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,180 @@
+#include <kernel/fs/dcache.h>
+#include <kernel/memory/heap.h>
+#include <kernel/memory/slab.h>
+#include <kernel/sync/spinlock.h>
+#include <kernel/sync/percpu.h>
+
+namespace Core {
+
+static ObjectCache dentry_cache("dentry", sizeof(Dentry));
+
+static Dentry* buckets[DentryCache::BUCKETS];
+static Spinlock dcache_lock("dcache");
+
+// Negative entries, oldest first, for eviction.
+static Dentry* lru_head;
+static Dentry* lru_tail;
+static uint64_t negative_count;
+static uint64_t dentry_count;
+
+static PerCpuCounter hits;
+static PerCpuCounter negative_hits;
+static PerCpuCounter misses;
+
+static Dentry*& bucket_for(uint64_t hash) {
+    return buckets[(hash * 0x9E3779B97F4A7C15ULL) >> (64 - DentryCache::BUCKET_SHIFT)];
+}
+
+static bool name_equal(const Dentry* dentry, const char* name, uint32_t len) {
+    if (dentry->name_len != len) {
+        return false;
+    }
+    for (uint32_t i = 0; i < len; i++) {
+        if (dentry->name[i] != name[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+uint64_t DentryCache::hash_name(const Dentry* parent, const char* name, uint32_t len) {
+    uint64_t hash = 0xCBF29CE484222325ULL ^ ((uint64_t)parent >> 4);
+    for (uint32_t i = 0; i < len; i++) {
+        hash = (hash ^ (uint8_t)name[i]) * 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+Dentry* DentryCache::lookup(const Dentry* parent, const char* name, uint32_t len, uint64_t hash) {
+    for (Dentry* dentry = rcu_dereference(bucket_for(hash)); dentry; dentry = rcu_dereference(dentry->hash_next)) {
+        if (dentry->hash == hash && dentry->parent == parent && name_equal(dentry, name, len)) {
+            return dentry;
+        }
+    }
+    return nullptr;
+}
+
+static Dentry* alloc_dentry(Dentry* parent, const char* name, uint32_t len, Inode* inode) {
+    Dentry* dentry = (Dentry*)dentry_cache.zalloc();
+    if (!dentry) {
+        return nullptr;
+    }
+
+    char* copy = dentry->inline_name;
+    if (len >= sizeof(dentry->inline_name)) {
+        copy = (char*)Heap::malloc(len + 1);
+        if (!copy) {
+            dentry_cache.free(dentry);
+            return nullptr;
+        }
+    }
+    for (uint32_t i = 0; i < len; i++) {
+        copy[i] = name[i];
+    }
+    copy[len] = '\0';
+
+    dentry->parent = parent;
+    dentry->inode = inode;
+    dentry->name = copy;
+    dentry->name_len = len;
+    return dentry;
+}
+
+static void free_dentry(RcuHead* head) {
+    Dentry* dentry = (Dentry*)((uint8_t*)head - offsetof(Dentry, rcu));
+
+    if (dentry->inode) {
+        VFS::put_inode(dentry->inode);
+    }
+    if (dentry->name != dentry->inline_name) {
+        Heap::free((void*)dentry->name);
+    }
+    dentry_cache.free(dentry);
+}
+
+static void lru_remove(Dentry* dentry) {
+    if (dentry->lru_prev) dentry->lru_prev->lru_next = dentry->lru_next;
+    else lru_head = dentry->lru_next;
+    if (dentry->lru_next) dentry->lru_next->lru_prev = dentry->lru_prev;
+    else lru_tail = dentry->lru_prev;
+    negative_count--;
+}
+
+static void lru_append(Dentry* dentry) {
+    dentry->lru_prev = lru_tail;
+    dentry->lru_next = nullptr;
+    if (lru_tail) lru_tail->lru_next = dentry;
+    else lru_head = dentry;
+    lru_tail = dentry;
+    negative_count++;
+}
+
+// Unlinks `dentry` from its chain and frees it after a grace period.
+// Caller holds dcache_lock.
+static void unhash(Dentry* dentry) {
+    Dentry** link = &bucket_for(dentry->hash);
+    while (*link != dentry) {
+        link = &(*link)->hash_next;
+    }
+    rcu_assign_pointer(*link, dentry->hash_next);
+
+    if (!dentry->inode) {
+        lru_remove(dentry);
+    }
+    dentry_count--;
+    call_rcu(&dentry->rcu, free_dentry);
+}
+
+Dentry* DentryCache::add(Dentry* parent, const char* name, uint32_t len, uint64_t hash, Inode* inode) {
+    Dentry* dentry = alloc_dentry(parent, name, len, inode);
+
+    ScopedLock guard(dcache_lock);
+
+    // A stale entry must go even when the new one could not be allocated.
+    Dentry* old = lookup(parent, name, len, hash);
+    if (old) {
+        unhash(old);
+    }
+    if (!dentry) {
+        if (inode) VFS::put_inode(inode);
+        return nullptr;
+    }
+
+    dentry->hash = hash;
+    Dentry*& bucket = bucket_for(hash);
+    dentry->hash_next = bucket;
+    rcu_assign_pointer(bucket, dentry);
+    dentry_count++;
+
+    if (!inode) {
+        lru_append(dentry);
+        if (negative_count > VFS::MAX_NEGATIVE) {
+            unhash(lru_head);
+        }
+    }
+    return dentry;
+}
+
+Dentry* DentryCache::alloc_root(Inode* inode) {
+    return alloc_dentry(nullptr, "/", 1, inode);
+}
+
+void DentryCache::note_hit(bool negative) {
+    (negative ? negative_hits : hits).inc();
+}
+
+void DentryCache::note_miss() {
+    misses.inc();
+}
+
+DentryCacheStats DentryCache::get_stats() {
+    DentryCacheStats stats;
+    stats.hits = hits.sum();
+    stats.negative_hits = negative_hits.sum();
+    stats.misses = misses.sum();
+    stats.dentries = __atomic_load_n(&dentry_count, __ATOMIC_RELAXED);
+    stats.negative = __atomic_load_n(&negative_count, __ATOMIC_RELAXED);
+    return stats;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,321 @@
+#include <kernel/fs/initramfs.h>
+#include <kernel/fs/vfs.h>
+#include <kernel/memory/heap.h>
+#include <kernel/memory/slab.h>
+#include <kernel/memory/copy.h>
+
+namespace Core {
+
+#define CPIO_HEADER_SIZE 110
+#define CPIO_MODE_MASK   0170000
+#define CPIO_MODE_DIR    0040000
+#define CPIO_MODE_FILE   0100000
+
+struct RamNode {
+    Inode* inode;
+    const uint8_t* data;
+    RamNode* children;
+    RamNode* next;
+    uint32_t name_len;
+    char* name;
+    char inline_name[32];
+};
+
+struct CpioEntry {
+    const char* name;
+    uint32_t name_len;
+    uint32_t mode;
+    uint64_t data_offset;
+    uint64_t size;
+};
+
+static uint32_t file_count;
+
+// Nodes come from their own cache, with long names on the heap as for
+// dentries; an archive can hold far more entries than the heap.
+static ObjectCache node_cache("ramfs_node", sizeof(RamNode));
+
+static bool names_equal(const char* a, uint32_t a_len, const char* b, uint32_t b_len) {
+    if (a_len != b_len) return false;
+    for (uint32_t i = 0; i < a_len; i++) {
+        if (a[i] != b[i]) return false;
+    }
+    return true;
+}
+
+static uint64_t parse_hex(const uint8_t* field) {
+    uint64_t value = 0;
+    for (int i = 0; i < 8; i++) {
+        uint8_t c = field[i];
+        uint8_t digit = c >= 'a' ? c - 'a' + 10 : c >= 'A' ? c - 'A' + 10 : c - '0';
+        value = (value << 4) | (digit & 0xF);
+    }
+    return value;
+}
+
+static bool is_cpio(const uint8_t* data, uint64_t size) {
+    return size >= CPIO_HEADER_SIZE && data[0] == '0' && data[1] == '7' && data[2] == '0' &&
+           data[3] == '7' && data[4] == '0' && data[5] == '1';
+}
+
+// Decodes the header at `*offset` and advances past the entry. Returns
+// false at the trailer or on a malformed archive.
+static bool next_entry(const uint8_t* archive, uint64_t archive_size, uint64_t* offset, CpioEntry* entry) {
+    uint64_t pos = *offset;
+    if (pos + CPIO_HEADER_SIZE > archive_size || !is_cpio(archive + pos, archive_size - pos)) {
+        return false;
+    }
+
+    const uint8_t* header = archive + pos;
+    uint64_t name_size = parse_hex(header + 94);
+    entry->mode = parse_hex(header + 14);
+    entry->size = parse_hex(header + 54);
+
+    uint64_t name_offset = pos + CPIO_HEADER_SIZE;
+    entry->data_offset = ALIGN_UP(name_offset + name_size, 4);
+    if (!name_size || entry->data_offset + entry->size > archive_size) {
+        return false;
+    }
+
+    entry->name = (const char*)archive + name_offset;
+    entry->name_len = name_size - 1;
+    if (names_equal(entry->name, entry->name_len, "TRAILER!!!", 10)) {
+        return false;
+    }
+
+    *offset = ALIGN_UP(entry->data_offset + entry->size, 4);
+    return true;
+}
+
+static error_t ramfs_lookup(Inode* dir, const char* name, uint32_t len, Inode** result);
+static ssize_t ramfs_read(Inode* inode, void* buffer, size_t size, uint64_t offset);
+static error_t ramfs_readdir(Inode* dir, uint64_t* cursor, DirEntry* entry);
+
+static const InodeOps ramfs_ops = {
+    .lookup = ramfs_lookup,
+    .create = nullptr,
+    .unlink = nullptr,
+    .read = ramfs_read,
+    .write = nullptr,
+    .readdir = ramfs_readdir,
+    .readpage = nullptr,
+};
+
+static error_t ramfs_lookup(Inode* dir, const char* name, uint32_t len, Inode** result) {
+    RamNode* node = (RamNode*)dir->private_data;
+
+    for (RamNode* child = node->children; child; child = child->next) {
+        if (names_equal(child->name, child->name_len, name, len)) {
+            VFS::get_inode(child->inode);
+            *result = child->inode;
+            return E_OK;
+        }
+    }
+    return E_NOENT;
+}
+
+// Copies from the module pages straight into the caller's buffer. The data
+// is already in memory, so there is no point caching it again.
+static ssize_t ramfs_read(Inode* inode, void* buffer, size_t size, uint64_t offset) {
+    RamNode* node = (RamNode*)inode->private_data;
+    if (offset >= inode->size) {
+        return 0;
+    }
+
+    size = MIN(size, inode->size - offset);
+    copy_bytes(buffer, node->data + offset, size);
+    return size;
+}
+
+static error_t ramfs_readdir(Inode* dir, uint64_t* cursor, DirEntry* entry) {
+    RamNode* child = ((RamNode*)dir->private_data)->children;
+    for (uint64_t i = 0; child && i < *cursor; i++) {
+        child = child->next;
+    }
+    if (!child) {
+        return E_NOENT;
+    }
+
+    entry->ino = child->inode->ino;
+    entry->type = child->inode->type;
+    entry->name_len = child->name_len;
+    copy_bytes(entry->name, child->name, child->name_len);
+    entry->name[child->name_len] = '\0';
+    (*cursor)++;
+    return E_OK;
+}
+
+// The filesystem keeps the only long-lived reference to each inode, so
+// nodes live as long as the mount.
+static RamNode* add_node(SuperBlock* sb, RamNode* parent, const char* name, uint32_t len, InodeType type) {
+    RamNode* node = (RamNode*)node_cache.zalloc();
+    if (!node) {
+        return nullptr;
+    }
+
+    node->name = node->inline_name;
+    if (len >= sizeof(node->inline_name)) {
+        node->name = (char*)Heap::malloc(len + 1);
+    }
+    node->inode = node->name ? VFS::alloc_inode(sb, type, &ramfs_ops) : nullptr;
+    if (!node->inode) {
+        if (node->name && node->name != node->inline_name) Heap::free(node->name);
+        node_cache.free(node);
+        return nullptr;
+    }
+    node->inode->private_data = node;
+    node->name_len = len;
+    copy_bytes(node->name, name, len);
+    node->name[len] = '\0';
+
+    if (parent) {
+        node->next = parent->children;
+        parent->children = node;
+    }
+    return node;
+}
+
+// Tears down a tree whose mount failed. Each subtree is spliced in ahead
+// of the remaining siblings, so deep archives need no recursion.
+static void free_tree(RamNode* root) {
+    RamNode* list = root;
+    while (list) {
+        RamNode* node = list;
+        list = node->next;
+        if (node->children) {
+            RamNode* last = node->children;
+            while (last->next) last = last->next;
+            last->next = list;
+            list = node->children;
+        }
+
+        // The superblock goes away with the failed mount, before the
+        // inode's grace period ends.
+        node->inode->sb = nullptr;
+        VFS::put_inode(node->inode);
+        if (node->name != node->inline_name) {
+            Heap::free(node->name);
+        }
+        node_cache.free(node);
+    }
+}
+
+// Creates missing parent directories on the way, since archives need not
+// list them before their contents.
+static error_t add_entry(SuperBlock* sb, RamNode* root, const CpioEntry& entry, const uint8_t* archive) {
+    const char* path = entry.name;
+    const char* end = entry.name + entry.name_len;
+    RamNode* dir = root;
+
+    while (path < end) {
+        while (path < end && (*path == '/' || (*path == '.' && (path + 1 == end || path[1] == '/')))) {
+            path++;
+        }
+        if (path == end) {
+            return E_OK;
+        }
+
+        const char* name = path;
+        while (path < end && *path != '/') path++;
+        uint32_t len = path - name;
+        bool last = path == end;
+
+        RamNode* node = dir->children;
+        while (node && !names_equal(node->name, node->name_len, name, len)) {
+            node = node->next;
+        }
+
+        if (!node) {
+            bool is_file = last && (entry.mode & CPIO_MODE_MASK) == CPIO_MODE_FILE;
+            if (last && !is_file && (entry.mode & CPIO_MODE_MASK) != CPIO_MODE_DIR) {
+                return E_OK;
+            }
+
+            node = add_node(sb, dir, name, len, is_file ? InodeType::FILE : InodeType::DIRECTORY);
+            if (!node) {
+                return E_NOMEM;
+            }
+            if (is_file) {
+                node->data = archive + entry.data_offset;
+                node->inode->size = entry.size;
+                file_count++;
+            }
+        }
+
+        if (!last && node->inode->type != InodeType::DIRECTORY) {
+            return E_INVAL;
+        }
+        dir = node;
+    }
+    return E_OK;
+}
+
+static error_t ramfs_mount(SuperBlock* sb, const void* data) {
+    BootModule* module = (BootModule*)data;
+    const uint8_t* archive = BootModules::data(module);
+    uint64_t size = module->end - module->start;
+
+    // Nothing has been released yet on failure, so the module is handed
+    // back whole for release_unclaimed() to free.
+    RamNode* root = add_node(sb, nullptr, "", 0, InodeType::DIRECTORY);
+    if (!root) {
+        module->claimed = false;
+        return E_NOMEM;
+    }
+
+    uint32_t files_before = file_count;
+    CpioEntry entry;
+    uint64_t offset = 0;
+    while (next_entry(archive, size, &offset, &entry)) {
+        error_t err = add_entry(sb, root, entry, archive);
+        if (err != E_OK) {
+            free_tree(root);
+            file_count = files_before;
+            module->claimed = false;
+            return err;
+        }
+    }
+
+    // Headers and names have been copied out; only file data must stay.
+    uint64_t free_from = 0;
+    offset = 0;
+    while (next_entry(archive, size, &offset, &entry)) {
+        if ((entry.mode & CPIO_MODE_MASK) == CPIO_MODE_FILE && entry.size) {
+            BootModules::release_range(module, module->start + free_from, module->start + entry.data_offset);
+            free_from = ALIGN_UP(module->start + entry.data_offset + entry.size, PAGE_SIZE) - module->start;
+        }
+    }
+    BootModules::release_range(module, module->start + free_from, ALIGN_UP(module->end, PAGE_SIZE));
+
+    sb->root = root->inode;
+    VFS::get_inode(sb->root);
+    return E_OK;
+}
+
+static FileSystem initramfs = {
+    .name = "initramfs",
+    .mount = ramfs_mount,
+    .evict = nullptr,
+    .next = nullptr,
+};
+
+void Initramfs::initialize() {
+    VFS::register_filesystem(&initramfs);
+}
+
+error_t Initramfs::mount_root() {
+    for (uint32_t i = 0; i < BootModules::count(); i++) {
+        BootModule* module = BootModules::get(i);
+        if (!module->claimed && is_cpio(BootModules::data(module), module->end - module->start)) {
+            module->claimed = true;
+            return VFS::mount("initramfs", "/", module);
+        }
+    }
+    return E_NOENT;
+}
+
+uint32_t Initramfs::get_file_count() {
+    return file_count;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,350 @@
+#include <kernel/fs/page_cache.h>
+#include <kernel/memory/pmm.h>
+#include <kernel/memory/slab.h>
+#include <kernel/memory/copy.h>
+#include <kernel/sync/spinlock.h>
+#include <kernel/sync/percpu.h>
+
+namespace Core {
+
+#define PAGE_REFERENCED BIT(0)
+#define PAGE_READAHEAD  BIT(1)
+#define PAGE_PINNED     BIT(2)
+
+#define NO_MARKER ~0ULL
+
+static ObjectCache page_cache("cached_page", sizeof(CachedPage));
+static Spinlock cache_lock("page_cache");
+
+// Circular; new pages go in just behind the hand.
+static CachedPage* clock_hand;
+static uint64_t page_count;
+static uint64_t pinned_count;
+
+static PerCpuCounter hits;
+static PerCpuCounter misses;
+static PerCpuCounter readahead_pages;
+static PerCpuCounter evictions;
+
+static void* page_data(const CachedPage* page) {
+    return (void*)(page->phys + KERNEL_VIRTUAL_BASE);
+}
+
+static void free_page(RcuHead* head) {
+    CachedPage* page = (CachedPage*)((uint8_t*)head - offsetof(CachedPage, rcu));
+    PMM::free_page(page->phys);
+    page_cache.free(page);
+}
+
+static void clock_insert(CachedPage* page) {
+    if (!clock_hand) {
+        page->clock_next = page->clock_prev = page;
+        clock_hand = page;
+        return;
+    }
+    page->clock_next = clock_hand;
+    page->clock_prev = clock_hand->clock_prev;
+    clock_hand->clock_prev->clock_next = page;
+    clock_hand->clock_prev = page;
+}
+
+// Caller holds cache_lock. Readers may still be copying from the page, so
+// it is freed after a grace period.
+static void remove_page(CachedPage* page) {
+    if (page->flags & PAGE_PINNED) {
+        pinned_count--;
+    } else if (page->clock_next == page) {
+        clock_hand = nullptr;
+    } else {
+        if (clock_hand == page) clock_hand = page->clock_next;
+        page->clock_prev->clock_next = page->clock_next;
+        page->clock_next->clock_prev = page->clock_prev;
+    }
+
+    page->inode->pages.remove(page->index);
+    page->inode->cached_pages--;
+    page_count--;
+    call_rcu(&page->rcu, free_page);
+}
+
+size_t PageCache::reclaim(size_t target) {
+    ScopedLock guard(cache_lock);
+    size_t freed = 0;
+
+    // Two laps at most: the first may only clear referenced bits.
+    for (uint64_t scanned = 0; freed < target && clock_hand && scanned < 2 * page_count; scanned++) {
+        CachedPage* page = clock_hand;
+        if (__atomic_load_n(&page->flags, __ATOMIC_RELAXED) & PAGE_REFERENCED) {
+            __atomic_fetch_and(&page->flags, ~(uint32_t)PAGE_REFERENCED, __ATOMIC_RELAXED);
+            clock_hand = page->clock_next;
+        } else {
+            remove_page(page);
+            freed++;
+        }
+    }
+
+    evictions.add(freed);
+    return freed;
+}
+
+// Evicted pages come back to the PMM only after a grace period, so this
+// reclaims ahead of need rather than after an allocation failure.
+static CachedPage* alloc_page() {
+    if (PMM::get_free_memory() < PageCache::LOW_WATERMARK) {
+        PageCache::reclaim(PageCache::RECLAIM_BATCH);
+    }
+
+    uint64_t phys = PMM::alloc_page();
+    if (!phys) {
+        return nullptr;
+    }
+
+    CachedPage* page = (CachedPage*)page_cache.zalloc();
+    if (!page) {
+        PMM::free_page(phys);
+        return nullptr;
+    }
+    page->phys = phys;
+    return page;
+}
+
+// Reads pages [start, start + count) that are not cached yet, clipped to
+// the end of the file. Only a failure on the first page is reported; the
+// rest is speculative, as is all of an async window.
+static error_t fill(Inode* inode, uint64_t start, uint64_t count, uint64_t marker, bool async) {
+    uint64_t end = ALIGN_UP(__atomic_load_n(&inode->size, __ATOMIC_RELAXED), PAGE_SIZE) >> PAGE_SHIFT;
+    count = MIN(count, end > start ? end - start : 0);
+
+    for (uint64_t index = start; index < start + count; index++) {
+        rcu_read_lock();
+        bool cached = inode->pages.lookup(index) != nullptr;
+        rcu_read_unlock();
+        if (cached) {
+            continue;
+        }
+
+        CachedPage* page = alloc_page();
+        error_t err = page ? inode->ops->readpage(inode, index, page_data(page)) : E_NOMEM;
+        if (err != E_OK) {
+            if (page) free_page(&page->rcu);
+            return index == start ? err : E_OK;
+        }
+
+        page->index = index;
+        page->inode = inode;
+        page->flags = index == marker ? PAGE_READAHEAD : 0;
+
+        ScopedLock guard(cache_lock);
+        if (inode->pages.lookup(index)) {
+            // Filled by a racing reader.
+            free_page(&page->rcu);
+            continue;
+        }
+        if (inode->pages.insert(index, page) != E_OK) {
+            // No memory for tree nodes. The caller retries until the first
+            // page is cached, so it must see the failure.
+            free_page(&page->rcu);
+            return index == start ? E_NOMEM : E_OK;
+        }
+        clock_insert(page);
+        inode->cached_pages++;
+        inode->cache_end = MAX(inode->cache_end, index + 1);
+        page_count++;
+        if (index != start || async) {
+            readahead_pages.inc();
+        }
+    }
+    return E_OK;
+}
+
+// A miss: sequential streams get the next, larger window, anything else
+// just the page asked for.
+static error_t sync_readahead(Inode* inode, Readahead* ra, uint64_t index) {
+    bool sequential = index == 0 || index == ra->prev_index + 1 ||
+                      (ra->size && index == ra->start + ra->size);
+
+    if (!sequential) {
+        ra->start = index;
+        ra->size = 0;
+        return fill(inode, index, 1, NO_MARKER, false);
+    }
+
+    uint32_t size = ra->size ? MIN(ra->size * 2, PageCache::READAHEAD_MAX) : PageCache::READAHEAD_MIN;
+    ra->start = index;
+    ra->size = size;
+    return fill(inode, index, size, index + size / 2, false);
+}
+
+// The reader reached a window's marker: read the following window now,
+// marked at its first page so the stream stays one window ahead.
+static void async_readahead(Inode* inode, Readahead* ra) {
+    uint64_t start = ra->start + ra->size;
+    uint32_t size = MIN(ra->size * 2, PageCache::READAHEAD_MAX);
+
+    ra->start = start;
+    ra->size = size;
+    fill(inode, start, size, start, true);
+}
+
+ssize_t PageCache::read(Inode* inode, Readahead* ra, void* buffer, size_t size, uint64_t offset) {
+    uint64_t file_size = __atomic_load_n(&inode->size, __ATOMIC_RELAXED);
+    if (offset >= file_size) {
+        return 0;
+    }
+    size = MIN(size, file_size - offset);
+
+    size_t done = 0;
+    while (done < size) {
+        uint64_t pos = offset + done;
+        uint64_t index = pos >> PAGE_SHIFT;
+        size_t page_offset = pos & (PAGE_SIZE - 1);
+        size_t chunk = MIN(PAGE_SIZE - page_offset, size - done);
+        bool marker = false;
+
+        rcu_read_lock();
+        CachedPage* page = (CachedPage*)inode->pages.lookup(index);
+        if (!page && (inode->flags & INODE_MEMORY_BACKED)) {
+            rcu_read_unlock();
+            zero_bytes((uint8_t*)buffer + done, chunk);
+            done += chunk;
+            continue;
+        }
+        if (page) {
+            copy_bytes((uint8_t*)buffer + done, (uint8_t*)page_data(page) + page_offset, chunk);
+
+            // Avoid dirtying the line when the bits are already right.
+            uint32_t flags = __atomic_load_n(&page->flags, __ATOMIC_RELAXED);
+            if (!(flags & PAGE_REFERENCED)) {
+                __atomic_fetch_or(&page->flags, PAGE_REFERENCED, __ATOMIC_RELAXED);
+            }
+            if (flags & PAGE_READAHEAD) {
+                marker = __atomic_fetch_and(&page->flags, ~(uint32_t)PAGE_READAHEAD, __ATOMIC_RELAXED) & PAGE_READAHEAD;
+            }
+        }
+        rcu_read_unlock();
+
+        if (!page) {
+            misses.inc();
+            error_t err = sync_readahead(inode, ra, index);
+            if (err != E_OK) {
+                return done ? (ssize_t)done : (ssize_t)err;
+            }
+            continue;
+        }
+
+        hits.inc();
+        if (marker) {
+            async_readahead(inode, ra);
+        }
+        ra->prev_index = index;
+        done += chunk;
+    }
+    return done;
+}
+
+// Pinned pages are only removed with their inode, so a writer can use the
+// page outside the read-side section. Readers find a new page as soon as
+// it is inserted, so it is filled first: from `whole_page` when a full
+// page is being written (and then `*filled` is set), otherwise with zeros.
+static CachedPage* get_pinned(Inode* inode, uint64_t index, const void* whole_page, bool* filled) {
+    *filled = false;
+    rcu_read_lock();
+    CachedPage* page = (CachedPage*)inode->pages.lookup(index);
+    rcu_read_unlock();
+    if (page) {
+        return page;
+    }
+
+    page = alloc_page();
+    if (!page) {
+        return nullptr;
+    }
+    if (whole_page) {
+        copy_bytes(page_data(page), whole_page, PAGE_SIZE);
+    } else {
+        zero_pages(page_data(page), 1);
+    }
+    page->index = index;
+    page->inode = inode;
+    page->flags = PAGE_PINNED;
+
+    ScopedLock guard(cache_lock);
+    CachedPage* existing = (CachedPage*)inode->pages.lookup(index);
+    if (existing || inode->pages.insert(index, page) != E_OK) {
+        free_page(&page->rcu);
+        return existing;
+    }
+    inode->cached_pages++;
+    inode->cache_end = MAX(inode->cache_end, index + 1);
+    page_count++;
+    pinned_count++;
+    *filled = whole_page != nullptr;
+    return page;
+}
+
+ssize_t PageCache::write(Inode* inode, const void* buffer, size_t size, uint64_t offset) {
+    size_t done = 0;
+
+    while (done < size) {
+        uint64_t pos = offset + done;
+        size_t page_offset = pos & (PAGE_SIZE - 1);
+        size_t chunk = MIN(PAGE_SIZE - page_offset, size - done);
+
+        const uint8_t* src = (const uint8_t*)buffer + done;
+        bool filled;
+        CachedPage* page = get_pinned(inode, pos >> PAGE_SHIFT, chunk == PAGE_SIZE ? src : nullptr, &filled);
+        if (!page) {
+            break;
+        }
+        if (!filled) {
+            copy_bytes((uint8_t*)page_data(page) + page_offset, src, chunk);
+        }
+        done += chunk;
+    }
+
+    uint64_t end = offset + done;
+    uint64_t old_size = __atomic_load_n(&inode->size, __ATOMIC_RELAXED);
+    while (end > old_size &&
+           !__atomic_compare_exchange_n(&inode->size, &old_size, end, true, __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+    }
+
+    return done || !size ? (ssize_t)done : (ssize_t)E_NOMEM;
+}
+
+void PageCache::invalidate(Inode* inode, uint64_t offset, size_t size) {
+    if (!size) {
+        return;
+    }
+
+    ScopedLock guard(cache_lock);
+    uint64_t last = MIN((offset + size - 1) >> PAGE_SHIFT, inode->cache_end);
+    for (uint64_t index = offset >> PAGE_SHIFT; index <= last && inode->cached_pages; index++) {
+        CachedPage* page = (CachedPage*)inode->pages.lookup(index);
+        if (page) {
+            remove_page(page);
+        }
+    }
+}
+
+void PageCache::evict_inode(Inode* inode) {
+    ScopedLock guard(cache_lock);
+    for (uint64_t index = 0; index < inode->cache_end && inode->cached_pages; index++) {
+        CachedPage* page = (CachedPage*)inode->pages.lookup(index);
+        if (page) {
+            remove_page(page);
+        }
+    }
+}
+
+PageCacheStats PageCache::get_stats() {
+    PageCacheStats stats;
+    stats.hits = hits.sum();
+    stats.misses = misses.sum();
+    stats.readahead = readahead_pages.sum();
+    stats.evictions = evictions.sum();
+    stats.pages = __atomic_load_n(&page_count, __ATOMIC_RELAXED);
+    stats.pinned = __atomic_load_n(&pinned_count, __ATOMIC_RELAXED);
+    return stats;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,303 @@
+#include <kernel/fs/tmpfs.h>
+#include <kernel/fs/vfs.h>
+#include <kernel/memory/heap.h>
+#include <kernel/memory/pmm.h>
+#include <kernel/memory/slab.h>
+#include <kernel/memory/copy.h>
+
+namespace Core {
+
+struct TmpEntry {
+    TmpEntry* hash_next;
+    TmpEntry* next;
+    TmpEntry** prev_link;
+    Inode* inode;
+    uint64_t hash;
+    uint64_t cookie;
+    uint32_t name_len;
+    char* name;
+    char inline_name[32];
+};
+
+// Entries are chained in a hash table for lookup and kept on a list in
+// creation order for readdir. Everything runs under the directory inode's
+// lock, which the VFS holds around directory operations.
+struct TmpDir {
+    TmpEntry** buckets;
+    uint32_t bucket_count;
+    uint32_t entry_count;
+    TmpEntry* first;
+    TmpEntry** last_link;
+    uint64_t next_cookie;
+};
+
+// Entries come from their own cache, with long names on the heap as for
+// dentries. Bucket arrays outgrow the heap too, so beyond a small table
+// they take whole pages.
+static ObjectCache entry_cache("tmpfs_entry", sizeof(TmpEntry));
+
+#define HEAP_BUCKETS 64
+
+static TmpEntry** alloc_buckets(uint32_t count) {
+    if (count <= HEAP_BUCKETS) {
+        return (TmpEntry**)Heap::calloc(count, sizeof(TmpEntry*));
+    }
+
+    size_t pages = ALIGN_UP(count * sizeof(TmpEntry*), PAGE_SIZE) / PAGE_SIZE;
+    uint64_t phys = PMM::alloc_pages(pages);
+    if (!phys) {
+        return nullptr;
+    }
+    zero_pages((void*)(phys + KERNEL_VIRTUAL_BASE), pages);
+    return (TmpEntry**)(phys + KERNEL_VIRTUAL_BASE);
+}
+
+static void free_buckets(TmpEntry** buckets, uint32_t count) {
+    if (count <= HEAP_BUCKETS) {
+        Heap::free(buckets);
+    } else {
+        PMM::free_pages((uint64_t)buckets - KERNEL_VIRTUAL_BASE,
+                        ALIGN_UP(count * sizeof(TmpEntry*), PAGE_SIZE) / PAGE_SIZE);
+    }
+}
+
+static TmpEntry* alloc_entry(const char* name, uint32_t len) {
+    TmpEntry* entry = (TmpEntry*)entry_cache.zalloc();
+    if (!entry) {
+        return nullptr;
+    }
+
+    entry->name = entry->inline_name;
+    if (len >= sizeof(entry->inline_name)) {
+        entry->name = (char*)Heap::malloc(len + 1);
+        if (!entry->name) {
+            entry_cache.free(entry);
+            return nullptr;
+        }
+    }
+    copy_bytes(entry->name, name, len);
+    entry->name[len] = '\0';
+    entry->name_len = len;
+    return entry;
+}
+
+static void free_entry(TmpEntry* entry) {
+    if (entry->name != entry->inline_name) {
+        Heap::free(entry->name);
+    }
+    entry_cache.free(entry);
+}
+
+static uint64_t hash_name(const char* name, uint32_t len) {
+    uint64_t hash = 0xCBF29CE484222325ULL;
+    for (uint32_t i = 0; i < len; i++) {
+        hash = (hash ^ (uint8_t)name[i]) * 0x100000001B3ULL;
+    }
+    return hash;
+}
+
+static TmpEntry** bucket_for(TmpDir* dir, uint64_t hash) {
+    return &dir->buckets[hash & (dir->bucket_count - 1)];
+}
+
+static TmpEntry** find_link(TmpDir* dir, const char* name, uint32_t len, uint64_t hash) {
+    TmpEntry** link = bucket_for(dir, hash);
+    while (*link) {
+        TmpEntry* entry = *link;
+        if (entry->hash == hash && entry->name_len == len) {
+            uint32_t i = 0;
+            while (i < len && entry->name[i] == name[i]) i++;
+            if (i == len) {
+                return link;
+            }
+        }
+        link = &entry->hash_next;
+    }
+    return link;
+}
+
+// Doubles the table once the load factor passes one. A failed resize just
+// leaves longer chains.
+static void grow(TmpDir* dir) {
+    uint32_t count = dir->bucket_count * 2;
+    TmpEntry** buckets = alloc_buckets(count);
+    if (!buckets) {
+        return;
+    }
+
+    TmpEntry** old = dir->buckets;
+    uint32_t old_count = dir->bucket_count;
+    dir->buckets = buckets;
+    dir->bucket_count = count;
+
+    for (uint32_t i = 0; i < old_count; i++) {
+        while (old[i]) {
+            TmpEntry* entry = old[i];
+            old[i] = entry->hash_next;
+            TmpEntry** bucket = bucket_for(dir, entry->hash);
+            entry->hash_next = *bucket;
+            *bucket = entry;
+        }
+    }
+    free_buckets(old, old_count);
+}
+
+static error_t tmpfs_lookup(Inode* dir, const char* name, uint32_t len, Inode** result);
+static error_t tmpfs_create(Inode* dir, const char* name, uint32_t len, InodeType type, Inode** result);
+static error_t tmpfs_unlink(Inode* dir, const char* name, uint32_t len, Inode* inode);
+static error_t tmpfs_readdir(Inode* dir, uint64_t* cursor, DirEntry* entry);
+
+static const InodeOps tmpfs_ops = {
+    .lookup = tmpfs_lookup,
+    .create = tmpfs_create,
+    .unlink = tmpfs_unlink,
+    .read = nullptr,
+    .write = nullptr,
+    .readdir = tmpfs_readdir,
+    .readpage = nullptr,
+};
+
+static Inode* alloc_inode(SuperBlock* sb, InodeType type) {
+    Inode* inode = VFS::alloc_inode(sb, type, &tmpfs_ops);
+    if (!inode) {
+        return nullptr;
+    }
+
+    if (type == InodeType::FILE) {
+        inode->flags = INODE_MEMORY_BACKED;
+        return inode;
+    }
+
+    TmpDir* dir = (TmpDir*)Heap::calloc(1, sizeof(TmpDir));
+    TmpEntry** buckets = alloc_buckets(Tmpfs::MIN_BUCKETS);
+    if (!dir || !buckets) {
+        Heap::free(dir);
+        if (buckets) free_buckets(buckets, Tmpfs::MIN_BUCKETS);
+        VFS::put_inode(inode);
+        return nullptr;
+    }
+    dir->buckets = buckets;
+    dir->bucket_count = Tmpfs::MIN_BUCKETS;
+    dir->last_link = &dir->first;
+    inode->private_data = dir;
+    return inode;
+}
+
+static error_t tmpfs_lookup(Inode* dir, const char* name, uint32_t len, Inode** result) {
+    TmpEntry* entry = *find_link((TmpDir*)dir->private_data, name, len, hash_name(name, len));
+    if (!entry) {
+        return E_NOENT;
+    }
+
+    VFS::get_inode(entry->inode);
+    *result = entry->inode;
+    return E_OK;
+}
+
+static error_t tmpfs_create(Inode* parent, const char* name, uint32_t len, InodeType type, Inode** result) {
+    TmpDir* dir = (TmpDir*)parent->private_data;
+    uint64_t hash = hash_name(name, len);
+    if (*find_link(dir, name, len, hash)) {
+        return E_BUSY;
+    }
+
+    TmpEntry* entry = alloc_entry(name, len);
+    Inode* inode = entry ? alloc_inode(parent->sb, type) : nullptr;
+    if (!inode) {
+        if (entry) free_entry(entry);
+        return E_NOMEM;
+    }
+
+    entry->inode = inode;
+    entry->hash = hash;
+    entry->cookie = dir->next_cookie++;
+
+    TmpEntry** bucket = bucket_for(dir, hash);
+    entry->hash_next = *bucket;
+    *bucket = entry;
+
+    entry->prev_link = dir->last_link;
+    *dir->last_link = entry;
+    dir->last_link = &entry->next;
+
+    if (++dir->entry_count > dir->bucket_count) {
+        grow(dir);
+    }
+
+    // One reference stays with the entry, the other goes to the caller.
+    VFS::get_inode(inode);
+    *result = inode;
+    return E_OK;
+}
+
+static error_t tmpfs_unlink(Inode* parent, const char* name, uint32_t len, Inode*) {
+    TmpDir* dir = (TmpDir*)parent->private_data;
+    TmpEntry** link = find_link(dir, name, len, hash_name(name, len));
+    TmpEntry* entry = *link;
+    if (!entry) {
+        return E_NOENT;
+    }
+
+    *link = entry->hash_next;
+    *entry->prev_link = entry->next;
+    if (entry->next) {
+        entry->next->prev_link = entry->prev_link;
+    } else {
+        dir->last_link = entry->prev_link;
+    }
+    dir->entry_count--;
+
+    // The data goes with the inode, once open files let go of it.
+    VFS::put_inode(entry->inode);
+    free_entry(entry);
+    return E_OK;
+}
+
+// The cursor is the cookie of the next entry to return, so entries removed
+// between calls do not shift the position.
+static error_t tmpfs_readdir(Inode* parent, uint64_t* cursor, DirEntry* out) {
+    TmpDir* dir = (TmpDir*)parent->private_data;
+    TmpEntry* entry = dir->first;
+    while (entry && entry->cookie < *cursor) {
+        entry = entry->next;
+    }
+    if (!entry) {
+        return E_NOENT;
+    }
+
+    out->ino = entry->inode->ino;
+    out->type = entry->inode->type;
+    out->name_len = entry->name_len;
+    copy_bytes(out->name, entry->name, entry->name_len);
+    out->name[entry->name_len] = '\0';
+    *cursor = entry->cookie + 1;
+    return E_OK;
+}
+
+// File data is dropped by the page cache. Directories cannot be unlinked,
+// so one only gets here if its setup failed.
+static void tmpfs_evict(Inode* inode) {
+    TmpDir* dir = (TmpDir*)inode->private_data;
+    if (dir) {
+        free_buckets(dir->buckets, dir->bucket_count);
+        Heap::free(dir);
+    }
+}
+
+static error_t tmpfs_mount(SuperBlock* sb, const void*) {
+    sb->root = alloc_inode(sb, InodeType::DIRECTORY);
+    return sb->root ? E_OK : E_NOMEM;
+}
+
+static FileSystem tmpfs = {
+    .name = "tmpfs",
+    .mount = tmpfs_mount,
+    .evict = tmpfs_evict,
+    .next = nullptr,
+};
+
+void Tmpfs::initialize() {
+    VFS::register_filesystem(&tmpfs);
+}
+
+}
\ No newline at end of file
@@ -1,10 +1,526 @@
 #include <kernel/fs/vfs.h>
+#include <kernel/fs/dcache.h>
+#include <kernel/fs/page_cache.h>
+#include <kernel/memory/heap.h>
+#include <kernel/memory/slab.h>
 #include <kernel/console.h>
 
 namespace Core {
 
+static ObjectCache inode_cache("inode", sizeof(Inode));
+static ObjectCache file_cache("file", sizeof(File));
+
+static FileSystem* filesystems;
+static Mount* mounts;
+static Mount* root_mount;
+static Mutex mount_lock;
+static uint64_t next_ino = 1;
+
+struct PathPoint {
+    Mount* mnt;
+    Dentry* dentry;
+};
+
+struct Component {
+    const char* name;
+    uint32_t len;
+};
+
 void VFS::initialize() {
     Console::printf("[VFS] Virtual File System initialized\n");
 }
 
+error_t VFS::register_filesystem(FileSystem* fs) {
+    ScopedMutex guard(mount_lock);
+    fs->next = filesystems;
+    filesystems = fs;
+    return E_OK;
+}
+
+static FileSystem* find_filesystem(const char* name) {
+    for (FileSystem* fs = filesystems; fs; fs = fs->next) {
+        const char* a = fs->name;
+        const char* b = name;
+        while (*a && *a == *b) {
+            a++;
+            b++;
+        }
+        if (*a == *b) {
+            return fs;
+        }
+    }
+    return nullptr;
+}
+
+Inode* VFS::alloc_inode(SuperBlock* sb, InodeType type, const InodeOps* ops) {
+    Inode* inode = (Inode*)inode_cache.zalloc();
+    if (!inode) {
+        return nullptr;
+    }
+
+    inode->ino = __atomic_fetch_add(&next_ino, 1, __ATOMIC_RELAXED);
+    inode->type = type;
+    inode->refs = 1;
+    inode->sb = sb;
+    inode->ops = ops;
+    return inode;
+}
+
+void VFS::get_inode(Inode* inode) {
+    __atomic_fetch_add(&inode->refs, 1, __ATOMIC_RELAXED);
+}
+
+static void free_inode(RcuHead* head) {
+    Inode* inode = (Inode*)((uint8_t*)head - offsetof(Inode, rcu));
+
+    if (inode->cached_pages) {
+        PageCache::evict_inode(inode);
+    }
+    if (inode->sb && inode->sb->fs->evict) {
+        inode->sb->fs->evict(inode);
+    }
+    inode_cache.free(inode);
+}
+
+// Walkers may still be reading the inode through a dentry they found
+// under RCU, so the free waits for a grace period.
+void VFS::put_inode(Inode* inode) {
+    if (__atomic_sub_fetch(&inode->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+        call_rcu(&inode->rcu, free_inode);
+    }
+}
+
+static bool is_dir(const Dentry* dentry) {
+    return dentry->inode && dentry->inode->type == InodeType::DIRECTORY;
+}
+
+static void follow_mounts(PathPoint* point) {
+    Mount* mnt;
+    while ((mnt = __atomic_load_n(&point->dentry->mounted, __ATOMIC_ACQUIRE))) {
+        point->mnt = mnt;
+        point->dentry = mnt->root;
+    }
+}
+
+static void follow_dotdot(PathPoint* point) {
+    while (point->dentry == point->mnt->root && point->mnt->parent) {
+        point->dentry = point->mnt->mountpoint;
+        point->mnt = point->mnt->parent;
+    }
+    if (point->dentry->parent) {
+        point->dentry = point->dentry->parent;
+    }
+    follow_mounts(point);
+}
+
+// Asks the filesystem about a name the cache does not know and caches the
+// answer, positive or negative. Called and returns under rcu_read_lock();
+// the read-side section is dropped while the driver runs. Parents are
+// directory dentries, which are never freed.
+static error_t lookup_slow(Dentry* parent, const char* name, uint32_t len, uint64_t hash, Dentry** result) {
+    Inode* dir = parent->inode;
+    rcu_read_unlock();
+
+    dir->lock.lock();
+    rcu_read_lock();
+    Dentry* dentry = DentryCache::lookup(parent, name, len, hash);
+    if (dentry) {
+        // Cached by a racing walker while we waited for the lock.
+        dir->lock.unlock();
+        *result = dentry;
+        return E_OK;
+    }
+    rcu_read_unlock();
+
+    Inode* inode = nullptr;
+    error_t err = dir->ops->lookup ? dir->ops->lookup(dir, name, len, &inode) : E_NOENT;
+    DentryCache::note_miss();
+
+    rcu_read_lock();
+    if (err == E_OK || err == E_NOENT) {
+        dentry = DentryCache::add(parent, name, len, hash, inode);
+        err = dentry ? E_OK : E_NOMEM;
+    }
+    dir->lock.unlock();
+
+    *result = dentry;
+    return err;
+}
+
+// Walks `path` from `point`, staying inside one RCU read-side section
+// except around driver lookups. With `last` set, stops at the parent of
+// the final component and returns that component instead. Caller holds
+// rcu_read_lock().
+static error_t walk(PathPoint* point, const char* path, Component* last) {
+    if (*path != '/') {
+        return E_INVAL;
+    }
+    follow_mounts(point);
+
+    while (true) {
+        while (*path == '/') path++;
+        if (!*path) {
+            return last ? E_INVAL : E_OK;
+        }
+
+        const char* name = path;
+        while (*path && *path != '/') path++;
+        uint32_t len = path - name;
+        if (len > NAME_MAX) {
+            return E_INVAL;
+        }
+
+        const char* rest = path;
+        while (*rest == '/') rest++;
+        if (last && !*rest) {
+            if ((len == 1 && name[0] == '.') || (len == 2 && name[0] == '.' && name[1] == '.')) {
+                return E_INVAL;
+            }
+            last->name = name;
+            last->len = len;
+            return E_OK;
+        }
+
+        if (!is_dir(point->dentry)) {
+            return E_INVAL;
+        }
+        if (len == 1 && name[0] == '.') {
+            continue;
+        }
+        if (len == 2 && name[0] == '.' && name[1] == '.') {
+            follow_dotdot(point);
+            continue;
+        }
+
+        uint64_t hash = DentryCache::hash_name(point->dentry, name, len);
+        Dentry* dentry = DentryCache::lookup(point->dentry, name, len, hash);
+        if (LIKELY(dentry)) {
+            DentryCache::note_hit(!dentry->inode);
+        } else {
+            error_t err = lookup_slow(point->dentry, name, len, hash, &dentry);
+            if (err != E_OK) {
+                return err;
+            }
+        }
+
+        if (!dentry->inode) {
+            return E_NOENT;
+        }
+        point->dentry = dentry;
+        follow_mounts(point);
+    }
+}
+
+static error_t resolve(Mount* mnt, const char* path, Inode** result) {
+    if (!mnt) {
+        return E_NOENT;
+    }
+
+    PathPoint point = {mnt, mnt->root};
+    rcu_read_lock();
+    error_t err = walk(&point, path, nullptr);
+    if (err == E_OK) {
+        // The dentry's own reference keeps the count above zero here.
+        VFS::get_inode(point.dentry->inode);
+        *result = point.dentry->inode;
+    }
+    rcu_read_unlock();
+    return err;
+}
+
+static Mount* get_root() {
+    return __atomic_load_n(&root_mount, __ATOMIC_ACQUIRE);
+}
+
+error_t VFS::lookup(const char* path, Inode** result) {
+    return resolve(get_root(), path, result);
+}
+
+error_t VFS::lookup_at(Mount* mnt, const char* path, Inode** result) {
+    return resolve(mnt, path, result);
+}
+
+static Mount* new_mount(const char* name, const void* data) {
+    FileSystem* fs = find_filesystem(name);
+    if (!fs) {
+        return nullptr;
+    }
+
+    Mount* mnt = (Mount*)Heap::calloc(1, sizeof(Mount));
+    if (!mnt) {
+        return nullptr;
+    }
+
+    mnt->sb.fs = fs;
+    if (fs->mount(&mnt->sb, data) != E_OK || !mnt->sb.root) {
+        Heap::free(mnt);
+        return nullptr;
+    }
+
+    mnt->root = DentryCache::alloc_root(mnt->sb.root);
+    if (!mnt->root) {
+        VFS::put_inode(mnt->sb.root);
+        Heap::free(mnt);
+        return nullptr;
+    }
+    return mnt;
+}
+
+Mount* VFS::kern_mount(const char* name, const void* data) {
+    ScopedMutex guard(mount_lock);
+    return new_mount(name, data);
+}
+
+error_t VFS::mount(const char* name, const char* path, const void* data) {
+    ScopedMutex guard(mount_lock);
+    PathPoint point = {root_mount, nullptr};
+
+    if (root_mount) {
+        // Mount roots and directory dentries are never freed, so the
+        // mountpoint outlives the read-side section.
+        point.dentry = root_mount->root;
+        rcu_read_lock();
+        error_t err = walk(&point, path, nullptr);
+        rcu_read_unlock();
+        if (err != E_OK) {
+            return err;
+        }
+        if (!is_dir(point.dentry)) {
+            return E_INVAL;
+        }
+    } else if (path[0] != '/' || path[1] != '\0') {
+        return E_NOENT;
+    }
+
+    Mount* mnt = new_mount(name, data);
+    if (!mnt) {
+        return E_NOMEM;
+    }
+
+    mnt->next = mounts;
+    mounts = mnt;
+
+    if (!root_mount) {
+        __atomic_store_n(&root_mount, mnt, __ATOMIC_RELEASE);
+    } else {
+        mnt->parent = point.mnt;
+        mnt->mountpoint = point.dentry;
+        __atomic_store_n(&point.dentry->mounted, mnt, __ATOMIC_RELEASE);
+    }
+
+    Console::printf("[VFS] Mounted %s on %s\n", name, path);
+    return E_OK;
+}
+
+// Resolves the parent directory of `path` and locks it, returning the
+// final component and its hash.
+static error_t lock_parent(Mount* root, const char* path, Dentry** parent, Component* last, uint64_t* hash) {
+    if (!root) {
+        return E_NOENT;
+    }
+
+    PathPoint point = {root, root->root};
+    rcu_read_lock();
+    error_t err = walk(&point, path, last);
+    rcu_read_unlock();
+    if (err != E_OK) {
+        return err;
+    }
+    if (!is_dir(point.dentry)) {
+        return E_INVAL;
+    }
+
+    *parent = point.dentry;
+    *hash = DentryCache::hash_name(point.dentry, last->name, last->len);
+    point.dentry->inode->lock.lock();
+    return E_OK;
+}
+
+// With the parent locked, whether the name exists: from the cache if
+// possible, otherwise from the filesystem. Returns the inode with a
+// reference, or nullptr.
+static Inode* find_child(Dentry* parent, const Component& last, uint64_t hash) {
+    Inode* dir = parent->inode;
+    Inode* inode = nullptr;
+
+    rcu_read_lock();
+    Dentry* dentry = DentryCache::lookup(parent, last.name, last.len, hash);
+    if (dentry && dentry->inode) {
+        VFS::get_inode(dentry->inode);
+        inode = dentry->inode;
+    }
+    rcu_read_unlock();
+
+    if (!dentry && dir->ops->lookup) {
+        DentryCache::note_miss();
+        dir->ops->lookup(dir, last.name, last.len, &inode);
+    }
+    return inode;
+}
+
+error_t VFS::create_at(Mount* mnt, const char* path, InodeType type) {
+    Dentry* parent;
+    Component last;
+    uint64_t hash;
+
+    error_t err = lock_parent(mnt, path, &parent, &last, &hash);
+    if (err != E_OK) {
+        return err;
+    }
+
+    Inode* dir = parent->inode;
+    Inode* inode = find_child(parent, last, hash);
+    if (inode) {
+        put_inode(inode);
+        err = E_BUSY;
+    } else if (!dir->ops->create) {
+        err = E_NOSYS;
+    } else {
+        err = dir->ops->create(dir, last.name, last.len, type, &inode);
+        if (err == E_OK) {
+            rcu_read_lock();
+            if (!DentryCache::add(parent, last.name, last.len, hash, inode)) {
+                err = E_NOMEM;
+            }
+            rcu_read_unlock();
+        }
+    }
+
+    dir->lock.unlock();
+    return err;
+}
+
+// Directories cannot be removed: walkers rely on directory dentries
+// staying put.
+error_t VFS::unlink_at(Mount* mnt, const char* path) {
+    Dentry* parent;
+    Component last;
+    uint64_t hash;
+
+    error_t err = lock_parent(mnt, path, &parent, &last, &hash);
+    if (err != E_OK) {
+        return err;
+    }
+
+    Inode* dir = parent->inode;
+    Inode* inode = find_child(parent, last, hash);
+    if (!inode) {
+        err = E_NOENT;
+    } else if (inode->type == InodeType::DIRECTORY) {
+        err = E_INVAL;
+    } else if (!dir->ops->unlink) {
+        err = E_NOSYS;
+    } else {
+        err = dir->ops->unlink(dir, last.name, last.len, inode);
+        if (err == E_OK) {
+            // Drops the positive entry even if the negative one cannot be
+            // allocated.
+            rcu_read_lock();
+            DentryCache::add(parent, last.name, last.len, hash, nullptr);
+            rcu_read_unlock();
+        }
+    }
+
+    if (inode) {
+        put_inode(inode);
+    }
+    dir->lock.unlock();
+    return err;
+}
+
+error_t VFS::open_at(Mount* mnt, const char* path, File** result) {
+    Inode* inode;
+    error_t err = resolve(mnt, path, &inode);
+    if (err != E_OK) {
+        return err;
+    }
+
+    File* file = (File*)file_cache.zalloc();
+    if (!file) {
+        put_inode(inode);
+        return E_NOMEM;
+    }
+
+    file->inode = inode;
+    *result = file;
+    return E_OK;
+}
+
+error_t VFS::create(const char* path, InodeType type) {
+    return create_at(get_root(), path, type);
+}
+
+error_t VFS::unlink(const char* path) {
+    return unlink_at(get_root(), path);
+}
+
+error_t VFS::open(const char* path, File** result) {
+    return open_at(get_root(), path, result);
+}
+
+void VFS::close(File* file) {
+    put_inode(file->inode);
+    file_cache.free(file);
+}
+
+ssize_t VFS::read(File* file, void* buffer, size_t size) {
+    Inode* inode = file->inode;
+    if (inode->type != InodeType::FILE) {
+        return E_INVAL;
+    }
+
+    ssize_t count;
+    if (inode->ops->readpage || (inode->flags & INODE_MEMORY_BACKED)) {
+        count = PageCache::read(inode, &file->ra, buffer, size, file->offset);
+    } else if (inode->ops->read) {
+        count = inode->ops->read(inode, buffer, size, file->offset);
+    } else {
+        return E_NOSYS;
+    }
+    if (count > 0) {
+        file->offset += count;
+    }
+    return count;
+}
+
+ssize_t VFS::write(File* file, const void* buffer, size_t size) {
+    Inode* inode = file->inode;
+    if (inode->type != InodeType::FILE) {
+        return E_INVAL;
+    }
+
+    ssize_t count;
+    if (inode->flags & INODE_MEMORY_BACKED) {
+        count = PageCache::write(inode, buffer, size, file->offset);
+    } else if (inode->ops->write) {
+        count = inode->ops->write(inode, buffer, size, file->offset);
+    } else {
+        return E_NOSYS;
+    }
+    if (count > 0) {
+        if (inode->cached_pages && !(inode->flags & INODE_MEMORY_BACKED)) {
+            PageCache::invalidate(inode, file->offset, count);
+        }
+        file->offset += count;
+    }
+    return count;
+}
+
+error_t VFS::readdir(File* file, DirEntry* entry) {
+    Inode* inode = file->inode;
+    if (inode->type != InodeType::DIRECTORY) {
+        return E_INVAL;
+    }
+    if (!inode->ops->readdir) {
+        return E_NOSYS;
+    }
+
+    ScopedMutex guard(inode->lock);
+    return inode->ops->readdir(inode, &file->readdir_cursor, entry);
+}
+
+DentryCacheStats VFS::get_dcache_stats() {
+    return DentryCache::get_stats();
+}
+
 }
\ No newline at end of file
@@ -0,0 +1,64 @@
+#ifndef CORE_ACPI_H
+#define CORE_ACPI_H
+
+#include <kernel/types.h>
+
+namespace Core {
+
+struct AcpiHeader {
+    char signature[4];
+    uint32_t length;
+    uint8_t revision;
+    uint8_t checksum;
+    char oem_id[6];
+    char oem_table_id[8];
+    uint32_t oem_revision;
+    uint32_t creator_id;
+    uint32_t creator_revision;
+} PACKED;
+
+struct MadtHeader {
+    AcpiHeader header;
+    uint32_t lapic_address;
+    uint32_t flags;
+} PACKED;
+
+struct MadtEntry {
+    uint8_t type;
+    uint8_t length;
+} PACKED;
+
+#define MADT_LAPIC           0
+#define MADT_IOAPIC          1
+#define MADT_ISO             2
+
+struct MadtIoApic {
+    MadtEntry entry;
+    uint8_t id;
+    uint8_t reserved;
+    uint32_t address;
+    uint32_t gsi_base;
+} PACKED;
+
+struct MadtIso {
+    MadtEntry entry;
+    uint8_t bus;
+    uint8_t source;
+    uint32_t gsi;
+    uint16_t flags;
+} PACKED;
+
+namespace ACPI {
+
+// `rsdp` is the copy handed over by the bootloader; without one the BIOS
+// area is scanned.
+void initialize(const void* rsdp);
+bool is_present();
+
+// Returns the mapped table with the given signature, or nullptr.
+const AcpiHeader* find_table(const char* signature);
+
+}
+}
+
+#endif
\ No newline at end of file
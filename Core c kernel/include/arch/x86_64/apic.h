@@ -7,6 +7,7 @@ namespace Core {
 namespace APIC {
 
 void initialize();
+uint32_t get_id();
 void send_eoi();
 void send_ipi(uint32_t cpu, uint8_t vector);
 
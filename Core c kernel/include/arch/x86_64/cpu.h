@@ -0,0 +1,113 @@
+#ifndef CORE_CPU_H
+#define CORE_CPU_H
+
+#include <kernel/types.h>
+
+namespace Core {
+
+class Thread;
+
+namespace CPU {
+
+constexpr uint32_t MAX_CPUS = 64;
+
+#define IA32_FS_BASE_MSR        0xC0000100
+#define IA32_GS_BASE_MSR        0xC0000101
+#define IA32_KERNEL_GS_BASE_MSR 0xC0000102
+#define IA32_EFER_MSR           0xC0000080
+#define IA32_STAR_MSR           0xC0000081
+#define IA32_LSTAR_MSR          0xC0000082
+#define IA32_FMASK_MSR          0xC0000084
+
+// Per-CPU block, reachable through GS. `self` must stay the first member.
+struct Local {
+    Local* self;
+    uint32_t id;
+    uint32_t preempt_count;
+    Thread* current_thread;
+    Thread* idle_thread;
+    Thread* fpu_owner;
+    uint32_t irq_nesting;
+    uint32_t softirq_pending;
+    bool need_resched;
+    uint32_t apic_id;
+    uint64_t kernel_rsp;
+    uint64_t user_rsp;
+} ALIGNED(64);
+
+// Offsets used by the SYSCALL entry path (syscall.asm).
+#define CPU_LOCAL_NEED_RESCHED 48
+#define CPU_LOCAL_KERNEL_RSP   56
+#define CPU_LOCAL_USER_RSP     64
+
+static_assert(offsetof(Local, need_resched) == CPU_LOCAL_NEED_RESCHED, "syscall.asm");
+static_assert(offsetof(Local, kernel_rsp) == CPU_LOCAL_KERNEL_RSP, "syscall.asm");
+static_assert(offsetof(Local, user_rsp) == CPU_LOCAL_USER_RSP, "syscall.asm");
+
+void initialize();
+Local* get(uint32_t cpu);
+uint32_t online_count();
+
+static inline Local* local() {
+    Local* self;
+    __asm__ volatile("mov %%gs:0, %0" : "=r"(self));
+    return self;
+}
+
+static inline uint32_t id() {
+    uint32_t cpu;
+    __asm__ volatile("movl %%gs:%c1, %0" : "=r"(cpu) : "i"(offsetof(Local, id)));
+    return cpu;
+}
+
+static inline void preempt_disable() {
+    __asm__ volatile("incl %%gs:%c0" : : "i"(offsetof(Local, preempt_count)) : "memory");
+}
+
+static inline void preempt_enable() {
+    __asm__ volatile("decl %%gs:%c0" : : "i"(offsetof(Local, preempt_count)) : "memory");
+}
+
+static inline void cpuid(uint32_t leaf, uint32_t subleaf,
+                         uint32_t* eax, uint32_t* ebx, uint32_t* ecx, uint32_t* edx) {
+    __asm__ volatile("cpuid"
+                     : "=a"(*eax), "=b"(*ebx), "=c"(*ecx), "=d"(*edx)
+                     : "a"(leaf), "c"(subleaf));
+}
+
+static inline uint64_t read_msr(uint32_t msr) {
+    uint32_t eax, edx;
+    __asm__ volatile("rdmsr" : "=a"(eax), "=d"(edx) : "c"(msr));
+    return ((uint64_t)edx << 32) | eax;
+}
+
+static inline void write_msr(uint32_t msr, uint64_t value) {
+    __asm__ volatile("wrmsr" : : "c"(msr), "a"((uint32_t)value), "d"((uint32_t)(value >> 32)));
+}
+
+static inline uint64_t rdtsc() {
+    uint32_t eax, edx;
+    __asm__ volatile("rdtsc" : "=a"(eax), "=d"(edx));
+    return ((uint64_t)edx << 32) | eax;
+}
+
+static inline uint64_t irq_save() {
+    uint64_t flags;
+    __asm__ volatile("pushfq; pop %0; cli" : "=r"(flags) : : "memory");
+    return flags;
+}
+
+static inline void irq_restore(uint64_t flags) {
+    if (flags & BIT(9)) {
+        __asm__ volatile("sti" : : : "memory");
+    }
+}
+
+static inline void relax() {
+    __asm__ volatile("pause" : : : "memory");
+}
+
+}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,32 @@
+#ifndef CORE_FPU_H
+#define CORE_FPU_H
+
+#include <kernel/types.h>
+
+namespace Core {
+
+class Thread;
+
+namespace FPU {
+
+void initialize();
+size_t get_state_size();
+bool has_xsave();
+bool has_avx2();
+
+// Called by the scheduler just before switching to `next`. Registers are only
+// reloaded when the incoming thread actually touches the FPU (#NM).
+void switch_to(Thread* next);
+bool handle_device_not_available();
+void release(Thread* thread);
+
+}
+
+// Brackets in-kernel SIMD code. The section runs with preemption disabled
+// and must not be entered from interrupt context.
+void kernel_fpu_begin();
+void kernel_fpu_end();
+
+}
+
+#endif
\ No newline at end of file
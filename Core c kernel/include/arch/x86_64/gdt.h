@@ -6,8 +6,19 @@
 namespace Core {
 namespace GDT {
 
-void initialize();
+// SYSRET derives the user selectors from STAR, which needs user data
+// immediately below user code.
+#define KERNEL_CS    0x08
+#define KERNEL_DS    0x10
+#define USER_DS      0x18
+#define USER_CS      0x20
+#define TSS_SELECTOR 0x28
+
+// Loads the GDT and TSS of `cpu`, which must be the id CPU::initialize()
+// is about to give the calling CPU. The others act on the calling CPU's TSS.
+void initialize(uint32_t cpu);
 void install_tss(uint64_t rsp0);
+void set_ist(uint8_t ist, uint64_t rsp);
 
 }
 }
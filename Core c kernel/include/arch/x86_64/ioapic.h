@@ -0,0 +1,22 @@
+#ifndef CORE_IOAPIC_H
+#define CORE_IOAPIC_H
+
+#include <kernel/types.h>
+
+namespace Core {
+namespace IOAPIC {
+
+// Finds the IOAPICs in the MADT, masks every pin, retires the legacy 8259
+// PIC and wires ISA IRQ n to vector 32 + n on the boot CPU. Without an
+// IOAPIC the 8259 stays, remapped to the same vectors.
+void initialize();
+uint32_t get_pin_count();
+
+// Routes a global system interrupt to a newly allocated vector, masked until
+// request_irq(). Returns the vector or a negative error.
+int map_gsi(uint32_t gsi, bool level_triggered, bool active_low);
+
+}
+}
+
+#endif
\ No newline at end of file
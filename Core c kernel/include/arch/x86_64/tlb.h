@@ -0,0 +1,41 @@
+#ifndef CORE_TLB_H
+#define CORE_TLB_H
+
+#include <kernel/types.h>
+
+namespace Core {
+namespace TLB {
+
+// Above this many pages a batch reloads CR3 instead of invalidating each
+// page.
+constexpr uint32_t BATCH_PAGES = 32;
+
+// Pages whose translations changed under VMM::clear_pte() and friends.
+// flush() invalidates them on every CPU at once: one shootdown IPI per
+// batch instead of one per page.
+struct Batch {
+    uint64_t pages[BATCH_PAGES];
+    uint32_t count;
+    bool full;
+};
+
+void initialize();
+
+static inline void add(Batch* batch, uint64_t virt) {
+    if (batch->count < BATCH_PAGES) {
+        batch->pages[batch->count++] = virt;
+    } else {
+        batch->full = true;
+    }
+}
+
+// Waits for the other CPUs to acknowledge, so it must be called with
+// interrupts enabled and without holding any lock taken with irqsave.
+void flush(Batch* batch);
+
+uint64_t get_shootdown_count();
+
+}
+}
+
+#endif
\ No newline at end of file
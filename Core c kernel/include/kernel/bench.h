@@ -0,0 +1,48 @@
+#ifndef CORE_BENCH_H
+#define CORE_BENCH_H
+
+#include <kernel/types.h>
+
+namespace Core {
+namespace Bench {
+
+// In-kernel benchmarks, built only with `make BENCH=1` (CONFIG_BENCH). They
+// run from their own thread once the scheduler is up and report on the
+// console.
+
+constexpr uint32_t MAX_THREADS = 64;
+
+typedef void (*bench_func_t)(uint32_t index, void* arg);
+
+void start();
+
+// Runs `func` on `count` threads, spread round-robin over the online CPUs
+// and numbered from 0. All threads are released together; returns once
+// every one of them has finished.
+void run_threads(bench_func_t func, void* arg, uint32_t count);
+
+// One thread per online CPU; the index is the CPU number.
+void run_on_cpus(bench_func_t func, void* arg);
+
+uint64_t cycles_per_us();
+
+// Suites
+void spinlock();
+void rcu();
+void queues();
+void syscalls();
+void clock();
+void ipc();
+void channels();
+void io_rings();
+void memory_objects();
+void vfs();
+void page_cache();
+void tmpfs();
+void virtio_blk();
+void block();
+
+}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,190 @@
+#ifndef CORE_BLOCK_H
+#define CORE_BLOCK_H
+
+#include <kernel/types.h>
+
+namespace Core {
+
+struct BlockDevice;
+struct BlockQueue;
+
+constexpr uint32_t BLOCK_MAX_SEGMENTS = 32;
+constexpr uint32_t BLOCK_LATENCY_BUCKETS = 20;
+
+enum class BlockOp : uint8_t {
+    READ,
+    WRITE,
+    FLUSH,
+};
+
+// One physically contiguous transfer, typically a page. A flush carries no
+// data. `done` runs once the I/O finishes, from the block softirq (or from
+// submit() itself if the bio is rejected), and must not block.
+struct Bio {
+    BlockOp op;
+    uint64_t sector;
+    uint64_t phys;
+    uint32_t len;
+    error_t result;
+    void (*done)(Bio* bio);
+    void* private_data;
+    Bio* next;
+};
+
+struct BlockSegment {
+    uint64_t phys;
+    uint32_t len;
+};
+
+// What drivers see: adjacent bios merged into one I/O. Physically
+// contiguous bios share a segment.
+struct BlockRequest {
+    BlockDevice* dev;
+    BlockOp op;
+    uint64_t sector;
+    uint32_t sectors;
+    uint32_t segment_count;
+    BlockSegment segments[BLOCK_MAX_SEGMENTS];
+    Bio* bios;
+    Bio* bio_tail;
+    uint32_t bio_count;
+    uint32_t hw_queue;
+    uint64_t start_tsc;
+    uint64_t dispatch_tsc;
+
+    // Scheduler state; `next` also chains requests handed to the driver.
+    uint64_t deadline;
+    BlockRequest* next;
+    BlockRequest* sort_prev;
+    BlockRequest* sort_next;
+    BlockRequest* fifo_prev;
+    BlockRequest* fifo_next;
+    BlockRequest* hash_next;
+
+    // BlockDevice::cmd_size bytes reserved for the driver.
+    void* driver_data;
+};
+
+struct BlockDeviceOps {
+    // Takes requests from the front of *list for hardware queue `hw_queue`
+    // and returns how many it took; the rest stay in *list, in order. Every
+    // request taken is finished with Block::complete().
+    uint32_t (*queue_requests)(BlockDevice* dev, uint32_t hw_queue, BlockRequest** list);
+};
+
+// Decides the order in which staged requests reach the hardware queues.
+// Callbacks may run in softirq context and must not block.
+struct BlockScheduler {
+    const char* name;
+    error_t (*init)(BlockDevice* dev);
+    void (*exit)(BlockDevice* dev);
+
+    // Folds `bio` into a request that is still queued; true if it did.
+    bool (*merge)(BlockDevice* dev, Bio* bio);
+    // Takes requests staged on `cpu`, which is then run through
+    // Block::hw_queue_for_cpu().
+    void (*insert)(BlockDevice* dev, uint32_t cpu, BlockRequest* list);
+
+    // Hands out up to `max` requests for hardware queue `hw_queue`.
+    BlockRequest* (*dispatch)(BlockDevice* dev, uint32_t hw_queue, uint32_t max);
+
+    BlockScheduler* next;
+};
+
+// Accumulates bios in the submitting thread, merging them, until
+// Block::finish_plug() hands the lot to the device at once. Only the
+// outermost plug of a thread is active.
+struct BlockPlug {
+    BlockRequest* head;
+    BlockRequest* tail;
+    uint32_t count;
+    bool active;
+};
+
+struct BlockStats {
+    uint64_t bios;
+    uint64_t merges;
+    uint64_t requests;          // sent to the driver
+    uint64_t completed;
+    uint64_t errors;
+    uint64_t read_sectors;
+    uint64_t write_sectors;
+    uint64_t inflight;
+    uint64_t max_inflight;
+    uint64_t depth_sum;         // in flight at each dispatch, to average
+    uint64_t latency_us_sum;    // submit to completion
+    uint64_t device_us_sum;     // dispatch to completion
+    uint64_t latency[BLOCK_LATENCY_BUCKETS];   // log2 microsecond buckets
+};
+
+// Filled in by the driver before Block::register_device().
+struct BlockDevice {
+    char name[16];
+    uint64_t capacity;          // in 512-byte sectors
+    uint32_t max_segments;
+    uint32_t max_sectors;
+    uint32_t hw_queue_count;
+    uint32_t hw_queue_depth;
+    size_t cmd_size;
+    const BlockDeviceOps* ops;
+    void* private_data;
+
+    BlockQueue* queue;
+    const BlockScheduler* sched;
+    void* sched_data;
+    BlockDevice* next;
+};
+
+// Sits between filesystems and drivers. Bios are merged into requests in
+// the submitter's plug or in a per-CPU staging queue, ordered by the
+// device's scheduler and dispatched to the hardware queue of the
+// submitting CPU, never deeper than the queue allows. Requests waiting for
+// room keep absorbing adjacent bios, so a sequential stream reaches the
+// driver as a few large I/Os.
+class Block {
+public:
+    static constexpr uint32_t SECTOR_SIZE = 512;
+    static constexpr uint32_t MAX_REQUESTS = 512;
+    static constexpr uint32_t PLUG_MAX = 32;
+    static constexpr uint32_t MERGE_SCAN = 8;
+
+    static void initialize();
+
+    static void register_scheduler(BlockScheduler* sched);
+    // Only while the device is idle; E_BUSY otherwise.
+    static error_t set_scheduler(BlockDevice* dev, const char* name);
+
+    // Multiqueue devices start with "none", single-queue ones with
+    // "deadline".
+    static error_t register_device(BlockDevice* dev);
+    static BlockDevice* find(const char* name);
+    static BlockDevice* get_devices();
+
+    // May sleep while the device has MAX_REQUESTS outstanding, so not from
+    // interrupt context.
+    static void submit(BlockDevice* dev, Bio* bio);
+    static error_t submit_wait(BlockDevice* dev, Bio* bio);
+
+    static void start_plug(BlockPlug* plug);
+    static void finish_plug(BlockPlug* plug);
+
+    // Called by drivers, from softirq context, once per request taken.
+    static void complete(BlockRequest* req, error_t result);
+
+    // Helpers for schedulers.
+    static bool merge_bio(BlockRequest* req, Bio* bio);
+    static uint32_t hw_queue_for_cpu(BlockDevice* dev, uint32_t cpu) {
+        return cpu % dev->hw_queue_count;
+    }
+
+    static BlockStats get_stats(BlockDevice* dev);
+    static void reset_stats(BlockDevice* dev);
+    // Upper bound, in microseconds, of the latency bucket holding the given
+    // fraction of completions.
+    static uint64_t latency_percentile(const BlockStats& stats, uint32_t permille);
+    static void dump_stats();
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,25 @@
+#ifndef CORE_DEADLINE_H
+#define CORE_DEADLINE_H
+
+#include <kernel/types.h>
+
+namespace Core {
+
+// Block scheduler for single-queue devices. Reads and writes are each kept
+// sorted by sector and dispatched in ascending batches; a request whose
+// deadline has passed restarts the batch from the oldest one, and reads
+// are preferred over writes only a bounded number of times in a row.
+class Deadline {
+public:
+    static constexpr uint64_t READ_EXPIRE_MS = 500;
+    static constexpr uint64_t WRITE_EXPIRE_MS = 5000;
+    static constexpr uint32_t FIFO_BATCH = 16;
+    static constexpr uint32_t WRITES_STARVED = 2;
+    static constexpr uint32_t HASH_BUCKETS = 64;
+
+    static void initialize();
+};
+
+}
+
+#endif
\ No newline at end of file
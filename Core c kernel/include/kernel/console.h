@@ -2,6 +2,7 @@
 #define CORE_CONSOLE_H
 
 #include <kernel/types.h>
+#include <stdarg.h>
 
 namespace Core {
 
@@ -20,6 +21,10 @@ public:
     static void putchar(char c);
     static void write(const char* str);
     static void printf(const char* format, ...);
+
+    // Shared formatter, also used by other character devices.
+    typedef void (*putchar_func_t)(char c);
+    static void vprintf(putchar_func_t out, const char* format, va_list args);
     static void set_color(Color fg, Color bg);
 
 private:
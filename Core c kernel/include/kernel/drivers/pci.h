@@ -1,11 +1,74 @@
 #ifndef CORE_PCI_H
 #define CORE_PCI_H
 
+#include <kernel/types.h>
+
 namespace Core {
 
+#define PCI_CAP_MSI  0x05
+#define PCI_CAP_VENDOR 0x09
+#define PCI_CAP_MSIX 0x11
+
+#define PCI_IRQ_LEGACY BIT(0)
+#define PCI_IRQ_MSI    BIT(1)
+#define PCI_IRQ_MSIX   BIT(2)
+#define PCI_IRQ_ALL    (PCI_IRQ_LEGACY | PCI_IRQ_MSI | PCI_IRQ_MSIX)
+
+struct PciDevice {
+    uint8_t bus;
+    uint8_t slot;
+    uint8_t func;
+    uint16_t vendor_id;
+    uint16_t device_id;
+    uint8_t class_code;
+    uint8_t subclass;
+    uint8_t prog_if;
+    uint8_t irq_line;
+    uint8_t irq_pin;
+
+    // Capability offsets in config space, 0 if absent.
+    uint8_t msi_cap;
+    uint8_t msix_cap;
+    uint16_t msix_table_size;
+
+    uint32_t irq_mode;
+    uint16_t vector_count;
+    uint8_t* vectors;
+    volatile uint32_t* msix_table;
+
+    PciDevice* next;
+};
+
 class PCI {
 public:
     static void initialize();
+
+    static PciDevice* get_devices();
+    static PciDevice* find(uint16_t vendor_id, uint16_t device_id, PciDevice* from = nullptr);
+    static PciDevice* find_class(uint8_t class_code, uint8_t subclass, PciDevice* from = nullptr);
+
+    static uint32_t read32(PciDevice* dev, uint8_t offset);
+    static uint16_t read16(PciDevice* dev, uint8_t offset);
+    static uint8_t read8(PciDevice* dev, uint8_t offset);
+    static void write32(PciDevice* dev, uint8_t offset, uint32_t value);
+    static void write16(PciDevice* dev, uint8_t offset, uint16_t value);
+
+    // Returns the offset of the first `cap_id` capability after the one at
+    // `from` (0 starts at the head of the list), or 0. Devices may carry
+    // several vendor-specific capabilities.
+    static uint8_t find_capability(PciDevice* dev, uint8_t cap_id, uint8_t from = 0);
+    static uint64_t get_bar(PciDevice* dev, uint32_t index);
+    static void enable_bus_master(PciDevice* dev);
+
+    // Allocates between min_vecs and max_vecs interrupt vectors, trying
+    // MSI-X, then MSI, then the legacy line as allowed by `types`. MSI-X
+    // vector i starts out on CPU i % online CPUs so per-queue interrupts land
+    // on the queue's CPU; irq_set_affinity() can move them. Returns the
+    // number of vectors or a negative error. Vectors stay masked until
+    // request_irq().
+    static int alloc_irq_vectors(PciDevice* dev, uint32_t min_vecs, uint32_t max_vecs, uint32_t types);
+    static void free_irq_vectors(PciDevice* dev);
+    static int irq_vector(PciDevice* dev, uint32_t index);
 };
 
 }
@@ -0,0 +1,18 @@
+#ifndef CORE_RTC_H
+#define CORE_RTC_H
+
+#include <kernel/types.h>
+
+namespace Core {
+
+// CMOS real-time clock, read once at boot to seed wall-clock time. The RTC
+// is assumed to run in UTC.
+class RTC {
+public:
+    // Seconds since 1970-01-01 00:00:00 UTC.
+    static uint64_t read_unix_time();
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,23 @@
+#ifndef CORE_SERIAL_H
+#define CORE_SERIAL_H
+
+#include <kernel/types.h>
+
+namespace Core {
+
+// Polled 16550 UART on COM1.
+class Serial {
+public:
+    static void initialize();
+    static bool is_present();
+    static void putchar(char c);
+    static void write(const char* str);
+    static void printf(const char* format, ...);
+
+    // Returns the next received byte, or -1 if none is waiting.
+    static int read_char();
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,134 @@
+#ifndef CORE_VIRTIO_H
+#define CORE_VIRTIO_H
+
+#include <kernel/types.h>
+#include <kernel/drivers/pci.h>
+
+namespace Core {
+
+#define VIRTIO_VENDOR_ID 0x1AF4
+
+#define VIRTIO_STATUS_ACKNOWLEDGE BIT(0)
+#define VIRTIO_STATUS_DRIVER      BIT(1)
+#define VIRTIO_STATUS_DRIVER_OK   BIT(2)
+#define VIRTIO_STATUS_FEATURES_OK BIT(3)
+#define VIRTIO_STATUS_FAILED      BIT(7)
+
+// Feature bit numbers shared by every device type.
+#define VIRTIO_F_RING_INDIRECT_DESC 28
+#define VIRTIO_F_RING_EVENT_IDX     29
+#define VIRTIO_F_VERSION_1          32
+
+#define VIRTQ_DESC_F_NEXT     BIT(0)
+#define VIRTQ_DESC_F_WRITE    BIT(1)
+#define VIRTQ_DESC_F_INDIRECT BIT(2)
+
+#define VIRTQ_AVAIL_F_NO_INTERRUPT BIT(0)
+#define VIRTQ_USED_F_NO_NOTIFY     BIT(0)
+
+#define VIRTIO_MSI_NO_VECTOR 0xFFFF
+
+struct VirtqDesc {
+    uint64_t addr;
+    uint32_t len;
+    uint16_t flags;
+    uint16_t next;
+} PACKED;
+
+struct VirtqUsedElem {
+    uint32_t id;
+    uint32_t len;
+} PACKED;
+
+// Split virtqueue (virtio 1.x, section 2.7). The three rings share one
+// physically contiguous allocation. Not locked: the owner serializes
+// add()/kick() against pop_used()/arm().
+class Virtqueue {
+public:
+    static constexpr uint16_t MAX_SIZE = 256;
+
+    uint16_t index;
+    uint16_t size;
+
+    VirtqDesc* desc;
+
+    // Stages `head` in the next avail slot; the device sees nothing until
+    // kick().
+    void add(uint16_t head);
+
+    // Publishes everything added since the last kick and rings the doorbell
+    // once, unless the device asked not to be notified (EVENT_IDX or the
+    // NO_NOTIFY flag). Returns true if the doorbell was written.
+    bool kick();
+
+    // Takes the next completed chain, returning false when none is left.
+    bool pop_used(uint32_t* id, uint32_t* len);
+
+    // Asks for an interrupt on the next completion. Returns false if more
+    // completions slipped in meanwhile, so the caller polls again instead of
+    // waiting for an interrupt that was already suppressed.
+    bool arm();
+
+private:
+    friend class Virtio;
+
+    volatile uint16_t* avail;       // flags, idx, ring[size], used_event
+    volatile uint16_t* used;        // flags, idx, then the element ring
+    volatile VirtqUsedElem* used_ring;
+    volatile uint16_t* notify;
+    uint64_t phys;
+    size_t pages;
+    uint16_t avail_idx;
+    uint16_t kicked_idx;
+    uint16_t last_used;
+    bool event_idx;
+};
+
+// Modern (virtio 1.x) PCI transport. Legacy-only devices, which lack the
+// vendor capabilities, are refused.
+struct VirtioDevice {
+    PciDevice* pci;
+    volatile uint8_t* common;
+    volatile uint8_t* isr;
+    volatile uint8_t* device_cfg;
+    volatile uint8_t* notify_base;
+    uint32_t notify_multiplier;
+    uint64_t features;
+};
+
+class Virtio {
+public:
+    // Maps the configuration structures, resets the device and announces
+    // the driver.
+    static error_t probe(VirtioDevice* vdev, PciDevice* pci);
+
+    // Accepts the offered subset of `wanted` (VERSION_1 is always required)
+    // and sets FEATURES_OK. The result is left in vdev->features.
+    static error_t negotiate(VirtioDevice* vdev, uint64_t wanted);
+    static bool has_feature(VirtioDevice* vdev, uint32_t bit) {
+        return vdev->features & BIT(bit);
+    }
+
+    static uint16_t get_num_queues(VirtioDevice* vdev);
+
+    // Allocates and enables queue `index` with at most `max_size` entries,
+    // signalling completions on MSI-X table entry `msix_entry`
+    // (VIRTIO_MSI_NO_VECTOR for INTx).
+    static error_t setup_queue(VirtioDevice* vdev, Virtqueue* vq, uint16_t index, uint16_t max_size,
+                               uint16_t msix_entry);
+    static void free_queue(Virtqueue* vq);
+
+    static void ready(VirtioDevice* vdev);
+    static void fail(VirtioDevice* vdev);
+
+    // Reading clears the register; bit 0 reports a used-ring update.
+    static uint8_t read_isr(VirtioDevice* vdev);
+
+    // Device-specific configuration, read consistently across a
+    // configuration change.
+    static void read_config(VirtioDevice* vdev, uint32_t offset, void* buffer, size_t size);
+};
+
+}
+
+#endif
\ No newline at end of file
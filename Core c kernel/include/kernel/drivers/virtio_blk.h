@@ -0,0 +1,95 @@
+#ifndef CORE_VIRTIO_BLK_H
+#define CORE_VIRTIO_BLK_H
+
+#include <kernel/types.h>
+#include <kernel/drivers/virtio.h>
+#include <kernel/block/block.h>
+
+namespace Core {
+
+constexpr uint32_t VIRTIO_BLK_MAX_SEGMENTS = 30;
+
+enum VirtioBlkType : uint32_t {
+    VIRTIO_BLK_T_IN = 0,
+    VIRTIO_BLK_T_OUT = 1,
+    VIRTIO_BLK_T_FLUSH = 4,
+};
+
+struct VirtioBlkSegment {
+    uint64_t phys;
+    uint32_t len;
+};
+
+// One device request. Segments are physically contiguous runs whose
+// lengths add up to whole sectors; a flush carries none.
+struct VirtioBlkRequest {
+    uint32_t type;
+    uint64_t sector;
+    uint32_t segment_count;
+    VirtioBlkSegment segments[VIRTIO_BLK_MAX_SEGMENTS];
+
+    // Called from the block softirq with `result` set; must not block.
+    error_t result;
+    void (*done)(VirtioBlkRequest* req);
+    void* private_data;
+    VirtioBlkRequest* next;
+};
+
+struct VirtioBlkStats {
+    uint64_t submitted;
+    uint64_t completed;
+    uint64_t kicks;
+    uint64_t interrupts;
+    uint64_t bad_completions;   // used-ring ids that named no request
+};
+
+struct VirtioBlkQueue;
+
+struct VirtioBlkDevice {
+    VirtioDevice vdev;
+    char name[8];
+    uint64_t capacity;          // in 512-byte sectors
+    uint32_t block_size;
+    uint32_t max_segments;
+    bool read_only;
+    bool can_flush;
+    uint32_t queue_count;
+    uint32_t queue_depth;
+    VirtioBlkQueue* queues;
+    BlockDevice block;
+    VirtioBlkDevice* next;
+};
+
+// virtio-blk over the modern PCI transport. Each CPU gets its own
+// virtqueue where the device offers enough (VIRTIO_BLK_F_MQ), with its
+// MSI-X vector steered to that CPU. A request takes a single ring slot:
+// header, data and status go in an indirect table when the device supports
+// them, or in a fixed per-slot chain otherwise.
+class VirtioBlk {
+public:
+    static constexpr uint32_t SECTOR_SIZE = 512;
+    static constexpr uint16_t QUEUE_SIZE = 128;
+    // Largest request handed over by the block layer.
+    static constexpr uint32_t MAX_SECTORS = 1024;
+
+    static void initialize();
+    static VirtioBlkDevice* get_devices();
+
+    // Queues the chain of requests at *list (linked through `next`) on
+    // hardware queue `queue` and rings its doorbell at most once. Requests
+    // that do not fit stay in *list; malformed ones complete with E_INVAL.
+    // Returns the number taken off *list, rejected ones included.
+    static uint32_t submit(VirtioBlkDevice* dev, uint32_t queue, VirtioBlkRequest** list);
+    static uint32_t queue_for_cpu(VirtioBlkDevice* dev, uint32_t cpu) {
+        return cpu % dev->queue_count;
+    }
+
+    // Transfers `len` bytes at physical `phys` and waits for the result.
+    static error_t rw(VirtioBlkDevice* dev, uint32_t type, uint64_t sector, uint64_t phys, uint32_t len);
+
+    static VirtioBlkStats get_stats(VirtioBlkDevice* dev);
+};
+
+}
+
+#endif
\ No newline at end of file
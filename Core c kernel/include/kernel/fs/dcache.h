@@ -0,0 +1,39 @@
+#ifndef CORE_DCACHE_H
+#define CORE_DCACHE_H
+
+#include <kernel/types.h>
+#include <kernel/fs/vfs.h>
+
+namespace Core {
+
+// Hash table of dentries keyed by (parent, name). Lookups are lockless
+// under rcu_read_lock(); updates take a single lock and must also be
+// serialized per directory by the caller (the directory inode's lock).
+class DentryCache {
+public:
+    static constexpr uint32_t BUCKET_SHIFT = 12;
+    static constexpr uint32_t BUCKETS = 1 << BUCKET_SHIFT;
+
+    static uint64_t hash_name(const Dentry* parent, const char* name, uint32_t len);
+
+    // Returns a positive or negative entry, or nullptr if the name is not
+    // cached. Caller holds rcu_read_lock().
+    static Dentry* lookup(const Dentry* parent, const char* name, uint32_t len, uint64_t hash);
+
+    // Hashes an entry binding the name to `inode` (nullptr for a negative
+    // entry). Any cached entry for the name is dropped, even if this returns
+    // nullptr for lack of memory. The inode reference is consumed. Caller
+    // holds rcu_read_lock(), which keeps the returned entry alive.
+    static Dentry* add(Dentry* parent, const char* name, uint32_t len, uint64_t hash, Inode* inode);
+
+    // Unhashed entry for the root of a mount.
+    static Dentry* alloc_root(Inode* inode);
+
+    static void note_hit(bool negative);
+    static void note_miss();
+    static DentryCacheStats get_stats();
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,25 @@
+#ifndef CORE_INITRAMFS_H
+#define CORE_INITRAMFS_H
+
+#include <kernel/types.h>
+#include <kernel/memory/boot_modules.h>
+
+namespace Core {
+
+// Read-only filesystem over a cpio archive (newc format) loaded as a boot
+// module. File contents are read straight out of the module's pages; only
+// the directory tree is built on the heap. Module pages that hold no file
+// data are released once the archive is mounted.
+class Initramfs {
+public:
+    static void initialize();
+
+    // Mounts the first boot module holding a cpio archive on "/".
+    static error_t mount_root();
+
+    static uint32_t get_file_count();
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,65 @@
+#ifndef CORE_PAGE_CACHE_H
+#define CORE_PAGE_CACHE_H
+
+#include <kernel/types.h>
+#include <kernel/fs/vfs.h>
+
+namespace Core {
+
+struct CachedPage {
+    uint64_t phys;
+    uint64_t index;
+    Inode* inode;
+    uint32_t flags;
+    CachedPage* clock_prev;
+    CachedPage* clock_next;
+    RcuHead rcu;
+};
+
+struct PageCacheStats {
+    uint64_t hits;
+    uint64_t misses;
+    uint64_t readahead;
+    uint64_t evictions;
+    uint64_t pages;
+    uint64_t pinned;
+};
+
+// File pages cached per inode, indexed by page number in the inode's radix
+// tree. Hits are lockless under RCU; filling and reclaim take one global
+// lock. All cached pages sit on a clock: a hit sets the page's referenced
+// bit and the reclaim hand evicts pages whose bit it finds clear.
+//
+// Readahead follows the reader: a sequential miss reads a window that
+// doubles up to READAHEAD_MAX, and reaching a marked page inside a window
+// reads the next one before the reader gets there.
+//
+// Memory-backed inodes keep their only copy of the data here. Their pages
+// are pinned: off the clock, and freed only with the inode.
+class PageCache {
+public:
+    static constexpr uint32_t READAHEAD_MIN = 4;
+    static constexpr uint32_t READAHEAD_MAX = 64;
+    // Fills reclaim RECLAIM_BATCH pages first when free memory is lower.
+    static constexpr uint64_t LOW_WATERMARK = 4 * 1024 * 1024;
+    static constexpr uint32_t RECLAIM_BATCH = 32;
+
+    static ssize_t read(Inode* inode, Readahead* ra, void* buffer, size_t size, uint64_t offset);
+
+    // For INODE_MEMORY_BACKED inodes: copies into the cached pages,
+    // allocating pinned ones for holes, and extends the file size.
+    static ssize_t write(Inode* inode, const void* buffer, size_t size, uint64_t offset);
+
+    // Drops cached pages overlapping the byte range.
+    static void invalidate(Inode* inode, uint64_t offset, size_t size);
+    static void evict_inode(Inode* inode);
+
+    // Evicts up to `pages` unreferenced pages; returns how many went.
+    static size_t reclaim(size_t pages);
+
+    static PageCacheStats get_stats();
+};
+
+}
+
+#endif
\ No newline at end of file
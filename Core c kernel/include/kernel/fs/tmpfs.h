@@ -0,0 +1,21 @@
+#ifndef CORE_TMPFS_H
+#define CORE_TMPFS_H
+
+#include <kernel/types.h>
+
+namespace Core {
+
+// In-memory filesystem. File data lives in pinned page cache pages indexed
+// by the inode's radix tree, so reads and writes copy straight between the
+// caller and those pages, and holes in sparse files take no memory.
+// Directories are hash tables that grow with their entry count.
+class Tmpfs {
+public:
+    static constexpr uint32_t MIN_BUCKETS = 8;
+
+    static void initialize();
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -1,11 +1,177 @@
 #ifndef CORE_VFS_H
 #define CORE_VFS_H
 
+#include <kernel/types.h>
+#include <kernel/sync/rcu.h>
+#include <kernel/sync/mutex.h>
+#include <kernel/lib/radix_tree.h>
+
 namespace Core {
 
+constexpr uint32_t NAME_MAX = 255;
+constexpr uint32_t PATH_MAX = 4096;
+
+enum class InodeType : uint32_t {
+    FILE,
+    DIRECTORY,
+};
+
+struct Inode;
+struct SuperBlock;
+struct Mount;
+
+struct DirEntry {
+    uint64_t ino;
+    InodeType type;
+    uint32_t name_len;
+    char name[NAME_MAX + 1];
+};
+
+// Filesystem callbacks. Directory operations run with the directory's
+// lock held; a missing callback fails the operation with E_NOSYS.
+struct InodeOps {
+    // Returns the child inode with a reference held, or E_NOENT.
+    error_t (*lookup)(Inode* dir, const char* name, uint32_t len, Inode** result);
+    error_t (*create)(Inode* dir, const char* name, uint32_t len, InodeType type, Inode** result);
+    error_t (*unlink)(Inode* dir, const char* name, uint32_t len, Inode* inode);
+
+    ssize_t (*read)(Inode* inode, void* buffer, size_t size, uint64_t offset);
+    ssize_t (*write)(Inode* inode, const void* buffer, size_t size, uint64_t offset);
+
+    // Fills `entry` for the entry at `*cursor` and advances it; E_NOENT at
+    // the end. The cursor is private to the filesystem and starts at 0.
+    error_t (*readdir)(Inode* dir, uint64_t* cursor, DirEntry* entry);
+
+    // Fills one page of file data. When present, reads go through the page
+    // cache (fs/page_cache.h) instead of read().
+    error_t (*readpage)(Inode* inode, uint64_t index, void* page);
+};
+
+// The file's data lives only in its page cache pages, which are never
+// reclaimed; holes read as zeros without allocating. Used by tmpfs.
+constexpr uint32_t INODE_MEMORY_BACKED = BIT(0);
+
+struct Inode {
+    uint64_t ino;
+    InodeType type;
+    uint32_t refs;
+    uint32_t flags;
+    uint64_t size;
+    SuperBlock* sb;
+    const InodeOps* ops;
+    void* private_data;
+    Mutex lock;
+    RadixTree pages;
+    uint64_t cached_pages;
+    uint64_t cache_end;
+    RcuHead rcu;
+};
+
+struct FileSystem {
+    const char* name;
+    // Fills sb->root; `data` is passed through from VFS::mount().
+    error_t (*mount)(SuperBlock* sb, const void* data);
+    // Frees filesystem state of an inode whose last reference is gone. Runs
+    // from an RCU callback, so it must not block.
+    void (*evict)(Inode* inode);
+    FileSystem* next;
+};
+
+struct SuperBlock {
+    FileSystem* fs;
+    Inode* root;
+    void* private_data;
+};
+
+// Cached name -> inode binding. A dentry never changes once it is hashed:
+// creating or unlinking a name replaces the entry, so lockless walkers
+// always see a consistent one. Negative entries (inode == nullptr) record
+// names that are known not to exist. Directory dentries are never freed,
+// which lets a walk keep a parent across a blocking driver lookup.
+struct Dentry {
+    Dentry* parent;
+    Inode* inode;
+    Mount* mounted;
+    Dentry* hash_next;
+    Dentry* lru_prev;
+    Dentry* lru_next;
+    uint64_t hash;
+    uint32_t name_len;
+    const char* name;
+    RcuHead rcu;
+    char inline_name[32];
+};
+
+struct Mount {
+    SuperBlock sb;
+    Dentry* root;
+    Dentry* mountpoint;
+    Mount* parent;
+    Mount* next;
+};
+
+// Per-file readahead window, in pages.
+struct Readahead {
+    uint64_t start;
+    uint32_t size;
+    uint64_t prev_index;
+};
+
+struct File {
+    Inode* inode;
+    uint64_t offset;
+    uint64_t readdir_cursor;
+    Readahead ra;
+};
+
+struct DentryCacheStats {
+    uint64_t hits;
+    uint64_t negative_hits;
+    uint64_t misses;
+    uint64_t dentries;
+    uint64_t negative;
+};
+
 class VFS {
 public:
+    // Negative entries beyond this are evicted oldest first.
+    static constexpr uint32_t MAX_NEGATIVE = 4096;
+
     static void initialize();
+
+    static error_t register_filesystem(FileSystem* fs);
+
+    // Mounts a new instance of filesystem `name` on directory `path`. The
+    // first mount must be on "/" and becomes the root.
+    static error_t mount(const char* name, const char* path, const void* data);
+
+    // An instance reachable only through the returned Mount, for the _at
+    // calls below.
+    static Mount* kern_mount(const char* name, const void* data);
+
+    // Resolves an absolute path; the inode comes back with a reference held.
+    // The _at variants start from `mnt` instead of the root.
+    static error_t lookup(const char* path, Inode** result);
+    static error_t lookup_at(Mount* mnt, const char* path, Inode** result);
+
+    static error_t create(const char* path, InodeType type);
+    static error_t create_at(Mount* mnt, const char* path, InodeType type);
+    static error_t unlink(const char* path);
+    static error_t unlink_at(Mount* mnt, const char* path);
+
+    static error_t open(const char* path, File** result);
+    static error_t open_at(Mount* mnt, const char* path, File** result);
+    static void close(File* file);
+    static ssize_t read(File* file, void* buffer, size_t size);
+    static ssize_t write(File* file, const void* buffer, size_t size);
+    static error_t readdir(File* file, DirEntry* entry);
+
+    // For filesystems: a zeroed inode with one reference and a fresh number.
+    static Inode* alloc_inode(SuperBlock* sb, InodeType type, const InodeOps* ops);
+    static void get_inode(Inode* inode);
+    static void put_inode(Inode* inode);
+
+    static DentryCacheStats get_dcache_stats();
 };
 
 }
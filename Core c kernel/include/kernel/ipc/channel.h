@@ -0,0 +1,207 @@
+#ifndef CORE_CHANNEL_H
+#define CORE_CHANNEL_H
+
+#include <kernel/types.h>
+#include <kernel/ipc/object.h>
+#include <kernel/memory/shared.h>
+#include <kernel/sync/waitqueue.h>
+#include <kernel/process/workqueue.h>
+
+namespace Core {
+
+// Shared-memory message channel. One writer and one reader exchange
+// descriptors through a ring, and the payload lives in a data arena next to
+// it, so bulk data is written once and read in place. The kernel is entered
+// only to sleep, and to wake the reader when the ring goes from empty to
+// non-empty. A writer that finds the channel full raises writer_waiting
+// before sleeping, and the reader wakes it on its next release.
+//
+// Layout of the mapping: the ChannelShared page, the descriptor ring, then
+// the arena. Everything below is shared by both sides and by userspace.
+
+constexpr uint32_t CHANNEL_ALIGN = 64;
+
+struct ChannelDesc {
+    uint64_t offset;
+    uint32_t length;
+    uint32_t flags;
+};
+
+struct ChannelShared {
+    // Written by the writer.
+    uint32_t head ALIGNED(64);
+    uint32_t writer_waiting;
+
+    // Written by the reader. data_tail is the arena position up to which
+    // payloads have been consumed.
+    uint32_t tail ALIGNED(64);
+    uint64_t data_tail;
+
+    // Fixed at creation.
+    uint32_t slot_count ALIGNED(64);
+    uint32_t desc_offset;
+    uint64_t arena_offset;
+    uint64_t arena_size;
+};
+
+static inline ChannelDesc* channel_descs(ChannelShared* shared) {
+    return (ChannelDesc*)((uint8_t*)shared + shared->desc_offset);
+}
+
+static inline uint8_t* channel_arena(ChannelShared* shared) {
+    return (uint8_t*)shared + shared->arena_offset;
+}
+
+// Writer side. Keeps private copies of the reader's indices and only reads
+// the shared ones when the ring or arena looks full.
+class ChannelWriter {
+public:
+    void attach(ChannelShared* ring) {
+        shared = ring;
+        head = ring->head;
+        cached_tail = __atomic_load_n(&ring->tail, __ATOMIC_ACQUIRE);
+        cached_data_tail = __atomic_load_n(&ring->data_tail, __ATOMIC_ACQUIRE);
+        data_head = cached_data_tail;
+    }
+
+    // Returns `length` contiguous arena bytes for the next message, or
+    // nullptr if the ring or arena is full.
+    void* reserve(uint32_t length) {
+        uint64_t size = ALIGN_UP((uint64_t)length, CHANNEL_ALIGN);
+        uint64_t pos = data_head;
+        uint64_t offset = pos & (shared->arena_size - 1);
+
+        // Payloads never wrap; skip the remainder of the arena instead.
+        if (offset + size > shared->arena_size) {
+            pos += shared->arena_size - offset;
+        }
+
+        if (head - cached_tail == shared->slot_count ||
+            pos + size - cached_data_tail > shared->arena_size) {
+            cached_tail = __atomic_load_n(&shared->tail, __ATOMIC_ACQUIRE);
+            cached_data_tail = __atomic_load_n(&shared->data_tail, __ATOMIC_ACQUIRE);
+            if (head - cached_tail == shared->slot_count ||
+                pos + size - cached_data_tail > shared->arena_size) {
+                return nullptr;
+            }
+        }
+
+        reserved = pos;
+        return channel_arena(shared) + (pos & (shared->arena_size - 1));
+    }
+
+    // Publishes the last reservation. Returns true if the ring was empty,
+    // meaning the reader may be asleep and must be notified.
+    bool commit(uint32_t length, uint32_t flags) {
+        ChannelDesc* desc = &channel_descs(shared)[head & (shared->slot_count - 1)];
+        desc->offset = reserved;
+        desc->length = length;
+        desc->flags = flags;
+
+        data_head = reserved + ALIGN_UP((uint64_t)length, CHANNEL_ALIGN);
+        __atomic_store_n(&shared->head, head + 1, __ATOMIC_RELEASE);
+
+        // Pairs with the fence in ChannelReader::release(): either we see
+        // the reader's latest tail, or it sees this head before sleeping.
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        cached_tail = __atomic_load_n(&shared->tail, __ATOMIC_RELAXED);
+        return cached_tail == head++;
+    }
+
+    // Announces that the writer is about to sleep for space. Retry
+    // reserve() afterwards: the reader may have freed some meanwhile.
+    void prepare_wait() {
+        __atomic_store_n(&shared->writer_waiting, 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    }
+
+    // Value to pass to the kernel when waiting for space.
+    uint32_t wait_token() const { return cached_tail; }
+
+private:
+    ChannelShared* shared;
+    uint32_t head;
+    uint32_t cached_tail;
+    uint64_t data_head;
+    uint64_t cached_data_tail;
+    uint64_t reserved;
+};
+
+// Reader side. Messages are consumed strictly in order; a payload stays
+// valid until release().
+class ChannelReader {
+public:
+    void attach(ChannelShared* ring) {
+        shared = ring;
+        tail = ring->tail;
+        cached_head = __atomic_load_n(&ring->head, __ATOMIC_ACQUIRE);
+    }
+
+    const ChannelDesc* peek(void** data) {
+        if (tail == cached_head) {
+            cached_head = __atomic_load_n(&shared->head, __ATOMIC_ACQUIRE);
+            if (tail == cached_head) {
+                return nullptr;
+            }
+        }
+
+        const ChannelDesc* desc = &channel_descs(shared)[tail & (shared->slot_count - 1)];
+        *data = channel_arena(shared) + (desc->offset & (shared->arena_size - 1));
+        return desc;
+    }
+
+    // Frees the message returned by peek(). Returns true if the writer is
+    // waiting for space and must be notified.
+    bool release() {
+        const ChannelDesc* desc = &channel_descs(shared)[tail & (shared->slot_count - 1)];
+        __atomic_store_n(&shared->data_tail, desc->offset + ALIGN_UP((uint64_t)desc->length, CHANNEL_ALIGN),
+                         __ATOMIC_RELEASE);
+        __atomic_store_n(&shared->tail, tail + 1, __ATOMIC_RELEASE);
+
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        cached_head = __atomic_load_n(&shared->head, __ATOMIC_RELAXED);
+        tail++;
+        return __atomic_load_n(&shared->writer_waiting, __ATOMIC_RELAXED) &&
+               __atomic_exchange_n(&shared->writer_waiting, 0, __ATOMIC_RELAXED);
+    }
+
+    // Value to pass to the kernel when waiting for messages.
+    uint32_t wait_token() const { return tail; }
+
+private:
+    ChannelShared* shared;
+    uint32_t tail;
+    uint32_t cached_head;
+};
+
+enum class ChannelSide : uint32_t {
+    READER,
+    WRITER,
+};
+
+struct Channel {
+    KObject obj;
+    ChannelShared* shared;
+    SharedRegion region;
+    WaitQueue readers;
+    WaitQueue writers;
+    Work teardown;
+};
+
+// `slots` and `arena_size` must be powers of two and fit
+// SharedMemory::MAX_SIZE together with the header. Userspace reaches the
+// channel at region.user_addr for as long as it lives.
+Channel* channel_create(uint32_t slots, size_t arena_size);
+static inline void channel_put(Channel* channel) { kobject_put(&channel->obj); }
+
+// Sleeps while `side` has nothing to do: the reader until head moves past
+// `token`, the writer until tail moves past it. Tokens come from
+// wait_token().
+void channel_wait(Channel* channel, ChannelSide side, uint32_t token);
+
+// Wakes the given side after commit() or release() returned true.
+void channel_notify(Channel* channel, ChannelSide side);
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,66 @@
+#ifndef CORE_HANDLE_H
+#define CORE_HANDLE_H
+
+#include <kernel/types.h>
+#include <kernel/ipc/object.h>
+#include <kernel/sync/spinlock.h>
+
+namespace Core {
+
+// What a handle allows on its object. Rights can only be narrowed when a
+// handle is granted to another process.
+constexpr uint32_t RIGHT_READ = BIT(0);
+constexpr uint32_t RIGHT_WRITE = BIT(1);
+constexpr uint32_t RIGHT_TRANSFER = BIT(2);
+constexpr uint32_t RIGHTS_ALL = RIGHT_READ | RIGHT_WRITE | RIGHT_TRANSFER;
+
+// Per-process table of object references, indexed by small integers.
+// Lookups are lockless: the slot array is published with RCU and replaced
+// wholesale when it grows. Each slot packs the object pointer and the
+// handle's rights into one word so they are always read together. Zeroed
+// memory is an empty table.
+class HandleTable {
+public:
+    static constexpr uint32_t INITIAL_SLOTS = 16;
+    static constexpr uint32_t MAX_SLOTS = 4096;
+
+    // Stores a new reference to `obj`; returns the handle or a negative error.
+    int install(KObject* obj, uint32_t rights = RIGHTS_ALL);
+
+    // Returns the object with a reference held, or nullptr if the handle is
+    // empty, of a different type, or lacks any of `rights`. ObjectType::NONE
+    // matches any type. Drop it with kobject_put(). The handle's rights are
+    // stored in `*granted` if given.
+    KObject* get(int handle, ObjectType type, uint32_t rights = 0, uint32_t* granted = nullptr);
+
+    error_t close(int handle);
+    void close_all();
+
+    // Whether any handle in the table refers to `obj`. Lockless; call it
+    // inside rcu_read_lock().
+    bool holds(const KObject* obj);
+
+private:
+    struct Slots {
+        uint32_t capacity;
+        RcuHead rcu;
+        uint64_t entries[];
+    };
+
+    Slots* slots;
+    uint32_t next_free;
+    Spinlock lock;
+
+    static constexpr uint64_t RIGHTS_MASK = 7;
+
+    bool grow();
+    static size_t slots_bytes(uint32_t capacity);
+    static size_t slots_pages(uint32_t capacity);
+    static Slots* alloc_slots(uint32_t capacity);
+    static void free_slots(RcuHead* head);
+    static KObject* entry_object(uint64_t entry) { return (KObject*)(entry & ~RIGHTS_MASK); }
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,175 @@
+#ifndef CORE_IO_RING_H
+#define CORE_IO_RING_H
+
+#include <kernel/types.h>
+#include <kernel/ipc/object.h>
+#include <kernel/ipc/handle.h>
+#include <kernel/memory/shared.h>
+#include <kernel/sync/mutex.h>
+#include <kernel/sync/waitqueue.h>
+#include <kernel/process/workqueue.h>
+
+namespace Core {
+
+class Thread;
+class Process;
+
+// Asynchronous kernel calls through a pair of shared rings. Userspace
+// queues submission entries (SQEs) and the kernel consumes them in batches,
+// either on io_ring_enter() or, with IO_RING_SQPOLL, from a dedicated
+// kernel thread that needs no syscalls at all while it is busy. Results
+// come back as completion entries (CQEs) in whatever order the operations
+// finish.
+
+enum IoOpcode : uint8_t {
+    IO_OP_NOP = 0,
+    IO_OP_IPC_SEND,     // handle = endpoint, args[0] = label, args[1..4] = words
+    IO_OP_TIMEOUT,      // args[0] = nanoseconds from submission
+    IO_OP_MAP,          // args[0] = address, args[1] = length (up to IO_MAP_MAX): zeroed anonymous pages
+    IO_OP_UNMAP,        // args[0] = address, args[1] = length
+    IO_OP_BLOCK_READ,   // handle = memory object, args[0] = device index, args[1] = sector,
+    IO_OP_BLOCK_WRITE,  //   args[2] = page index in the object: one page of I/O
+    NR_IO_OPS
+};
+
+constexpr uint32_t IO_RING_MAX_ENTRIES = 4096;
+constexpr size_t IO_MAP_MAX = 4 * 1024 * 1024;
+
+// io_ring_create() flags
+constexpr uint32_t IO_RING_SQPOLL = BIT(0);
+
+// IoRingShared::flags, set by the polling thread before it sleeps
+constexpr uint32_t IO_RING_NEED_WAKEUP = BIT(0);
+
+// io_ring_enter() flags
+constexpr uint32_t IO_ENTER_GETEVENTS = BIT(0);
+constexpr uint32_t IO_ENTER_SQ_WAKEUP = BIT(1);
+
+struct IoSqe {
+    uint8_t opcode;
+    uint8_t flags;
+    uint16_t reserved;
+    int32_t handle;
+    uint64_t user_data;
+    uint64_t args[6];
+};
+
+static_assert(sizeof(IoSqe) == 64, "one SQE per cache line");
+
+struct IoCqe {
+    uint64_t user_data;
+    int64_t result;
+};
+
+// Start of the ring mapping. The SQE and CQE arrays follow at the given
+// offsets. Completions that find the CQ full are dropped and counted in
+// cq_overflow.
+struct IoRingShared {
+    // Written by the kernel.
+    uint32_t sq_head ALIGNED(64);
+    uint32_t flags;
+
+    // Written by userspace.
+    uint32_t sq_tail ALIGNED(64);
+
+    uint32_t cq_head ALIGNED(64);
+
+    // Written by the kernel.
+    uint32_t cq_tail ALIGNED(64);
+    uint32_t cq_overflow;
+
+    // Fixed at creation.
+    uint32_t sq_entries ALIGNED(64);
+    uint32_t cq_entries;
+    uint32_t sq_offset;
+    uint32_t cq_offset;
+};
+
+// Submitting side of a ring, for userspace and for kernel threads working
+// through the kernel alias.
+class IoRingClient {
+public:
+    void attach(IoRingShared* ring) {
+        shared = ring;
+        sqes = (IoSqe*)((uint8_t*)ring + ring->sq_offset);
+        cqes = (IoCqe*)((uint8_t*)ring + ring->cq_offset);
+        sq_tail = ring->sq_tail;
+        cq_head = ring->cq_head;
+    }
+
+    // Next free SQE, or nullptr while the kernel has not consumed enough.
+    IoSqe* get_sqe() {
+        if (sq_tail - __atomic_load_n(&shared->sq_head, __ATOMIC_ACQUIRE) == shared->sq_entries) {
+            return nullptr;
+        }
+        return &sqes[sq_tail++ & (shared->sq_entries - 1)];
+    }
+
+    // Publishes the SQEs filled in since the last call; returns how many.
+    uint32_t flush() {
+        uint32_t count = sq_tail - shared->sq_tail;
+        __atomic_store_n(&shared->sq_tail, sq_tail, __ATOMIC_RELEASE);
+        return count;
+    }
+
+    // With SQPOLL, call after flush(): true if the polling thread has gone
+    // to sleep and needs IO_ENTER_SQ_WAKEUP.
+    bool needs_wakeup() {
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        return __atomic_load_n(&shared->flags, __ATOMIC_RELAXED) & IO_RING_NEED_WAKEUP;
+    }
+
+    const IoCqe* peek_cqe() {
+        if (cq_head == __atomic_load_n(&shared->cq_tail, __ATOMIC_ACQUIRE)) {
+            return nullptr;
+        }
+        return &cqes[cq_head & (shared->cq_entries - 1)];
+    }
+
+    void cqe_seen() {
+        __atomic_store_n(&shared->cq_head, ++cq_head, __ATOMIC_RELEASE);
+    }
+
+private:
+    IoRingShared* shared;
+    IoSqe* sqes;
+    IoCqe* cqes;
+    uint32_t sq_tail;
+    uint32_t cq_head;
+};
+
+struct IoRing {
+    KObject obj;
+    IoRingShared* shared;
+    IoSqe* sqes;
+    IoCqe* cqes;
+    SharedRegion region;
+    Process* owner;             // SQPOLL only: whose handles SQEs name
+    // Private copies of the geometry; userspace can rewrite the shared one.
+    uint32_t sq_entries;
+    uint32_t cq_entries;
+    uint32_t sq_head;
+    uint32_t cq_tail;
+    Mutex submit_lock;
+    Spinlock cq_lock;
+    WaitQueue cq_wait;
+    WaitQueue sq_wait;
+    Thread* poll_thread;
+    bool stopping;
+    Work teardown;
+};
+
+// Handles named in SQEs resolve in the process calling io_ring_enter(),
+// or with SQPOLL in the creating process. The CQ holds twice `entries`,
+// which must be a power of two.
+IoRing* io_ring_create(uint32_t entries, uint32_t flags);
+static inline void io_ring_put(IoRing* ring) { kobject_put(&ring->obj); }
+
+// Consumes up to `to_submit` SQEs (the polling thread does this instead
+// with SQPOLL), then with IO_ENTER_GETEVENTS waits until at least
+// `min_complete` CQEs are available. Returns the number submitted.
+int io_ring_enter(IoRing* ring, uint32_t to_submit, uint32_t min_complete, uint32_t flags);
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,77 @@
+#ifndef CORE_IPC_H
+#define CORE_IPC_H
+
+#include <kernel/types.h>
+#include <kernel/ipc/object.h>
+#include <kernel/sync/spinlock.h>
+
+namespace Core {
+
+class Thread;
+
+constexpr uint32_t IPC_MSG_WORDS = 4;
+
+// Small enough to travel in registers across the syscall boundary (see the
+// SYS_IPC_* ABI in syscall.h) and to be copied straight from one thread's
+// buffer into the other's during the rendezvous.
+struct IpcMessage {
+    uint64_t label;
+    uint64_t words[IPC_MSG_WORDS];
+};
+
+// A one-way message queued on an endpoint with no thread behind it; see
+// ipc_send_async().
+struct IpcPendingSend {
+    IpcMessage msg;
+    void (*done)(IpcPendingSend* send, error_t result);
+    IpcPendingSend* next;
+};
+
+// Rendezvous point for synchronous IPC. Whichever side arrives first queues
+// on the endpoint; the other side copies the message and wakes it. Blocked
+// senders are served before pending asynchronous ones.
+struct Endpoint {
+    KObject obj;
+    Spinlock lock;
+    Thread* senders;
+    Thread* senders_tail;
+    Thread* receivers;
+    Thread* receivers_tail;
+    IpcPendingSend* pending;
+    IpcPendingSend* pending_tail;
+};
+
+Endpoint* endpoint_create();
+static inline void endpoint_put(Endpoint* ep) { kobject_put(&ep->obj); }
+
+// These operations block. A call leaves the receiver holding an implicit reply
+// right to the caller, consumed by ipc_reply() or ipc_reply_wait(); the
+// caller's message buffer receives the reply.
+error_t ipc_send(Endpoint* ep, const IpcMessage* msg);
+error_t ipc_receive(Endpoint* ep, IpcMessage* msg);
+error_t ipc_call(Endpoint* ep, IpcMessage* msg);
+error_t ipc_reply(const IpcMessage* msg);
+
+// Never blocks: delivers only if a receiver is already waiting, and returns
+// E_AGAIN otherwise.
+error_t ipc_try_send(Endpoint* ep, const IpcMessage* msg);
+
+// Never blocks: delivers to a waiting receiver and returns E_OK, or queues
+// `send` and returns E_AGAIN. A queued send's done() runs once a receiver
+// takes it, in that receiver's context, or with E_NOENT when the endpoint
+// is destroyed first. It must not block. The queue holds no reference on
+// the endpoint.
+error_t ipc_send_async(Endpoint* ep, IpcPendingSend* send);
+
+// Server loop primitive: reply to the current caller and wait for the next
+// message in one step, switching straight back to the caller when it is
+// local.
+error_t ipc_reply_wait(Endpoint* ep, IpcMessage* msg);
+
+// Direct switching is on by default; the benchmarks turn it off to measure
+// the run-queue path.
+void ipc_set_direct_switch(bool enabled);
+
+}
+
+#endif
\ No newline at end of file
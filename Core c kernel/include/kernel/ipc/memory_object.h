@@ -0,0 +1,66 @@
+#ifndef CORE_MEMORY_OBJECT_H
+#define CORE_MEMORY_OBJECT_H
+
+#include <kernel/types.h>
+#include <kernel/ipc/object.h>
+#include <kernel/process/workqueue.h>
+#include <kernel/sync/mutex.h>
+
+namespace Core {
+
+constexpr size_t MEMORY_OBJECT_MAX_SIZE = 256 * 1024 * 1024;
+
+struct MemoryMapping {
+    uint64_t addr;
+    int owner;                  // pid of the process that mapped it
+    bool writable;
+    MemoryMapping* next;
+};
+
+// A set of physical pages that can be mapped into user ranges, granted to
+// other processes through handles with narrower rights, or transferred:
+// the pages move to a new object by rewriting page-table entries, and the
+// data is never copied.
+struct MemoryObject {
+    KObject obj;
+    Mutex lock;
+    uint64_t* pages;
+    size_t page_count;
+    MemoryMapping* mappings;
+    uint32_t io_pins;           // block I/O in flight on the pages
+    Work teardown;
+};
+
+// Zeroed pages; `size` is rounded up to whole pages.
+MemoryObject* memory_object_create(size_t size);
+static inline void memory_object_put(MemoryObject* mem) { kobject_put(&mem->obj); }
+
+error_t memory_object_map(MemoryObject* mem, uint64_t addr, bool writable);
+// Any mapping may go if `owner` is negative; otherwise only one that
+// process `owner` made, or E_PERM.
+error_t memory_object_unmap(MemoryObject* mem, uint64_t addr, int owner = -1);
+
+// Moves the pages of `mem` into a new object, mapped writable at `dest`
+// unless it is 0. Every existing mapping of `mem` is torn down, with a
+// single TLB flush covering the whole transfer, and `mem` is left empty.
+// Its mapping records are kept until the transfer is finished or restored.
+error_t memory_object_transfer(MemoryObject* mem, uint64_t dest, MemoryObject** result);
+
+// Drops the records of the mappings a transfer tore down, once its result
+// has been handed on.
+void memory_object_finish_transfer(MemoryObject* mem);
+
+// Undoes a transfer whose result could not be handed on: the pages go back
+// to `mem` and are mapped again where they were, and `moved` is left empty.
+void memory_object_restore(MemoryObject* mem, MemoryObject* moved);
+
+// Keeps page `index` in `mem` for device I/O and returns its physical
+// address, or 0 if there is no such page. A pinned object refuses to be
+// transferred (E_BUSY); the caller also holds a reference until it unpins.
+// Unpinning does not sleep.
+uint64_t memory_object_pin(MemoryObject* mem, size_t index);
+void memory_object_unpin(MemoryObject* mem);
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,57 @@
+#ifndef CORE_OBJECT_H
+#define CORE_OBJECT_H
+
+#include <kernel/types.h>
+#include <kernel/sync/rcu.h>
+
+namespace Core {
+
+enum class ObjectType : uint32_t {
+    NONE,
+    ENDPOINT,
+    CHANNEL,
+    IO_RING,
+    MEMORY,
+};
+
+// Reference-counted kernel object reachable through process handles.
+// Handle lookups are lockless, so release() must defer the actual free past
+// an RCU grace period (the embedded RcuHead is there for that).
+struct KObject {
+    ObjectType type;
+    uint32_t refs;
+    void (*release)(KObject* obj);
+    RcuHead rcu;
+};
+
+static inline void kobject_init(KObject* obj, ObjectType type, void (*release)(KObject*)) {
+    obj->type = type;
+    obj->refs = 1;
+    obj->release = release;
+}
+
+static inline void kobject_get(KObject* obj) {
+    __atomic_fetch_add(&obj->refs, 1, __ATOMIC_RELAXED);
+}
+
+// Fails once the last reference is gone; for lookups under rcu_read_lock().
+static inline bool kobject_tryget(KObject* obj) {
+    uint32_t refs = __atomic_load_n(&obj->refs, __ATOMIC_RELAXED);
+    while (refs) {
+        if (__atomic_compare_exchange_n(&obj->refs, &refs, refs + 1, true,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static inline void kobject_put(KObject* obj) {
+    if (__atomic_sub_fetch(&obj->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+        obj->release(obj);
+    }
+}
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,80 @@
+#ifndef CORE_IRQ_H
+#define CORE_IRQ_H
+
+#include <kernel/types.h>
+
+namespace Core {
+
+// Returns true if the device actually raised the interrupt, so shared lines
+// can tell a spurious one from a handled one.
+typedef bool (*irq_handler_t)(uint8_t vector, void* data);
+
+#define IRQF_SHARED BIT(0)
+
+// Interrupt controller hooks for a vector whose source can be masked or
+// steered (IOAPIC pins, MSI). `hwirq` is the controller's own number.
+struct IrqChip {
+    const char* name;
+    void (*mask)(uint32_t hwirq);
+    void (*unmask)(uint32_t hwirq);
+    error_t (*set_affinity)(uint32_t hwirq, uint8_t vector, uint32_t cpu);
+};
+
+// Attaches `handler` to a device vector (32-255). Several handlers may share
+// a vector only if all of them pass IRQF_SHARED; they run in registration
+// order. `data` identifies the handler to free_irq().
+error_t request_irq(uint8_t vector, irq_handler_t handler, void* data, const char* name,
+                    uint32_t flags = 0);
+void free_irq(uint8_t vector, void* data);
+
+// Steers the vector's source to `cpu` and exempts it from balancing.
+error_t irq_set_affinity(uint8_t vector, uint32_t cpu);
+
+namespace IRQ {
+
+constexpr uint32_t LATENCY_BUCKETS = 32;
+constexpr uint32_t NR_VECTORS = 256;
+constexpr uint32_t FIRST_DEVICE_VECTOR = 32;
+constexpr uint32_t ISA_VECTOR_BASE = 32;
+constexpr uint32_t FIRST_DYNAMIC_VECTOR = 48;
+constexpr uint32_t LAST_DYNAMIC_VECTOR = 0xEF;
+constexpr uint32_t BALANCE_INTERVAL_MS = 1000;
+constexpr uint64_t BALANCE_MIN_RATE = 100;
+constexpr uint8_t TLB_SHOOTDOWN_VECTOR = 0xF0;
+constexpr uint8_t SPURIOUS_VECTOR = 0xFF;
+
+// Bracket every hardware interrupt. exit() records how long interrupts were
+// held off and, on the outermost level, runs pending softirqs with
+// interrupts enabled.
+void enter();
+void exit(uint64_t start_tsc);
+bool in_interrupt();
+
+// Runs the handlers registered for `vector`; called with interrupts off.
+void dispatch(uint8_t vector);
+
+// Vectors 32-47 belong to the ISA IRQs; drivers needing their own vector
+// (PCI INTx, MSI) allocate one from the dynamic range.
+int alloc_vector();
+void free_vector(uint8_t vector);
+
+// Called by interrupt controllers once a vector is wired to a source. The
+// source stays masked until the first handler is requested.
+void set_chip(uint8_t vector, const IrqChip* chip, uint32_t hwirq);
+uint32_t get_affinity(uint8_t vector);
+
+// Periodically spreads the busiest steerable vectors across online CPUs.
+// Does nothing on a uniprocessor.
+void start_balancer();
+
+uint64_t get_count(uint8_t vector);
+uint64_t get_count(uint8_t vector, uint32_t cpu);
+void dump_stats();
+
+uint64_t get_latency_count(uint32_t bucket);
+void dump_latency_histogram();
+
+}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,45 @@
+#ifndef CORE_SOFTIRQ_H
+#define CORE_SOFTIRQ_H
+
+#include <kernel/types.h>
+
+namespace Core {
+
+enum SoftirqVector : uint32_t {
+    SOFTIRQ_TIMER = 0,
+    SOFTIRQ_BLOCK,
+    SOFTIRQ_TASKLET,
+    SOFTIRQ_RCU,
+    NR_SOFTIRQS
+};
+
+typedef void (*softirq_handler_t)();
+
+class Softirq {
+public:
+    // One pass over the pending vectors is repeated at most this many times,
+    // and never past this many timer ticks, before the rest is handed to the
+    // per-CPU ksoftirqd thread.
+    static constexpr uint32_t MAX_RESTART = 10;
+    static constexpr uint64_t MAX_TICKS = 2;
+
+    static void initialize();
+    static void start_threads();
+    static void register_handler(SoftirqVector vector, softirq_handler_t handler);
+    static void raise(SoftirqVector vector);
+    static void run_pending();
+    static bool has_pending();
+};
+
+struct Tasklet {
+    void (*func)(void*);
+    void* data;
+    Tasklet* next;
+    uint32_t scheduled;
+
+    static void schedule(Tasklet* tasklet);
+};
+
+}
+
+#endif
\ No newline at end of file
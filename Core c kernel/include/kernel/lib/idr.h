@@ -0,0 +1,40 @@
+#ifndef CORE_IDR_H
+#define CORE_IDR_H
+
+#include <kernel/types.h>
+#include <kernel/lib/radix_tree.h>
+#include <kernel/sync/spinlock.h>
+
+namespace Core {
+
+// Integer ID allocator with reuse: a lazily populated bitmap hands out IDs
+// cyclically and a radix tree maps each live ID to its object. A null object
+// reserves a bare ID that find() will not resolve. find() is lockless; call
+// it inside rcu_read_lock() and free objects only after a grace period.
+class IDR {
+public:
+    void initialize(int min_id, int max_id);
+    int alloc(void* object);
+    void remove(int id);
+    void* find(int id) const;
+    size_t get_count() const { return count; }
+
+private:
+    static constexpr uint32_t BITS_PER_CHUNK = PAGE_SIZE * 8;
+    static constexpr uint32_t MAX_CHUNKS = 128;
+
+    uint64_t* chunks[MAX_CHUNKS];
+    uint32_t chunk_free[MAX_CHUNKS];
+    RadixTree objects;
+    int min_id;
+    int max_id;
+    int next_id;
+    size_t count;
+    Spinlock lock;
+
+    int find_free_from(int start);
+};
+
+}
+
+#endif
\ No newline at end of file
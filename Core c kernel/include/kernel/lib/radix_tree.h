@@ -0,0 +1,48 @@
+#ifndef CORE_RADIX_TREE_H
+#define CORE_RADIX_TREE_H
+
+#include <kernel/types.h>
+#include <kernel/memory/slab.h>
+#include <kernel/sync/rcu.h>
+
+namespace Core {
+
+// Sparse index -> pointer map with 64-way nodes. Callers serialize updates;
+// lookup() may run concurrently with them inside rcu_read_lock(), since
+// removed nodes are only freed after a grace period.
+class RadixTree {
+public:
+    void initialize();
+    error_t insert(uint64_t index, void* item);
+    void* lookup(uint64_t index) const;
+    void* remove(uint64_t index);
+    bool is_empty() const { return root == nullptr; }
+
+private:
+    static constexpr uint32_t MAP_SHIFT = 6;
+    static constexpr uint32_t MAP_SIZE = 1 << MAP_SHIFT;
+    static constexpr uint64_t MAP_MASK = MAP_SIZE - 1;
+
+    struct Node {
+        void* slots[MAP_SIZE];
+        Node* parent;
+        uint32_t count;
+        uint32_t offset;
+        uint32_t level;
+        RcuHead rcu;
+    };
+
+    static ObjectCache node_cache;
+
+    Node* root;
+    uint32_t height;
+
+    static uint64_t max_index(uint32_t levels);
+    static void free_node(RcuHead* head);
+    error_t extend(uint64_t index);
+    void shrink();
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,41 @@
+#ifndef CORE_BOOT_MODULES_H
+#define CORE_BOOT_MODULES_H
+
+#include <kernel/types.h>
+
+namespace Core {
+
+struct BootModule {
+    uint64_t start;
+    uint64_t end;
+    char cmdline[64];
+    bool claimed;
+};
+
+// Files loaded next to the kernel by the bootloader. Their pages stay
+// reserved until released: a user claims a module and gives back the
+// parts it does not need, and release_unclaimed() frees the rest once
+// boot is done.
+class BootModules {
+public:
+    static constexpr uint32_t MAX_MODULES = 8;
+
+    // Called while parsing multiboot information, before the PMM is up.
+    static void add(uint64_t start, uint64_t end, const char* cmdline);
+
+    static uint32_t count();
+    static BootModule* get(uint32_t index);
+
+    // The module contents through the kernel's physical alias.
+    static const uint8_t* data(const BootModule* module) {
+        return (const uint8_t*)(module->start + KERNEL_VIRTUAL_BASE);
+    }
+
+    static void release_range(BootModule* module, uint64_t start, uint64_t end);
+    static size_t release_unclaimed();
+    static size_t get_released();
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,17 @@
+#ifndef CORE_COPY_H
+#define CORE_COPY_H
+
+#include <kernel/types.h>
+
+namespace Core {
+
+void copy_pages(void* dst, const void* src, size_t count);
+void zero_pages(void* dst, size_t count);
+
+// Arbitrary lengths and alignment, for partial pages.
+void copy_bytes(void* dst, const void* src, size_t len);
+void zero_bytes(void* dst, size_t len);
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,33 @@
+#ifndef CORE_KSTACK_H
+#define CORE_KSTACK_H
+
+#include <kernel/types.h>
+
+namespace Core {
+
+// Kernel thread stacks live in their own virtual area, each preceded by an
+// unmapped guard page. Only the top page is committed up front; deeper pages
+// are faulted in on first touch.
+class KernelStack {
+public:
+    static constexpr size_t STACK_SIZE = 64 * 1024;
+    static constexpr size_t GUARD_SIZE = PAGE_SIZE;
+    static constexpr size_t SLOT_SIZE = STACK_SIZE + GUARD_SIZE;
+    static constexpr uint32_t CACHE_SIZE = 8;
+    static constexpr uint32_t FAULT_RESERVE = 4;
+    static constexpr uint8_t FAULT_IST = 1;
+
+    // Sets up the boot CPU too; others call init_cpu() as they come up.
+    static void initialize();
+    static void init_cpu();
+    static uint64_t alloc();
+    static void free(uint64_t base);
+    // Backs a page of the stack the faulting code was running on, taking it
+    // from this CPU's reserve only; rsp is the interrupted stack pointer.
+    static bool handle_fault(uint64_t addr, uint64_t rsp);
+    static size_t get_committed_pages();
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -8,6 +8,11 @@ namespace Core {
 
 class PMM {
 public:
+    static constexpr size_t MAX_RESERVED = 16;
+
+    // Keeps [start, end) away from the allocator, for boot data that lives
+    // past the kernel image. Only valid before initialize().
+    static void reserve_early(uint64_t start, uint64_t end);
     static void initialize(uint64_t total_memory, uint64_t kernel_end);
     static uint64_t alloc_page();
     static uint64_t alloc_pages(size_t count);
@@ -18,6 +23,9 @@ public:
     static uint64_t get_free_memory();
     static void mark_region_used(uint64_t start, uint64_t end);
     static void mark_region_free(uint64_t start, uint64_t end);
+    // Hands a reserved region back once nothing uses it; rounded inward to
+    // whole pages.
+    static void release_region(uint64_t start, uint64_t end);
     
 private:
     static constexpr size_t MAX_ORDER = 11;
@@ -27,13 +35,22 @@ private:
         size_t order;
     };
     
+    struct Region {
+        uint64_t start;
+        uint64_t end;
+    };
+
     static FreeBlock* free_lists[MAX_ORDER];
+    static Region reserved[MAX_RESERVED];
+    static size_t reserved_count;
     static uint64_t* bitmap;
     static size_t total_pages;
-    static size_t free_pages;
+    static size_t free_page_count;
     static Spinlock lock;
     
     static size_t get_order(size_t pages);
+    static uint64_t place_bitmap(uint64_t start, uint64_t size);
+    static void free_unreserved(uint64_t start, uint64_t end);
     static void split_block(uint64_t addr, size_t order);
     static uint64_t try_merge_buddy(uint64_t addr, size_t order);
     static uint64_t get_buddy(uint64_t addr, size_t order);
@@ -0,0 +1,32 @@
+#ifndef CORE_SHARED_H
+#define CORE_SHARED_H
+
+#include <kernel/types.h>
+
+namespace Core {
+
+// Zeroed, physically contiguous block that the kernel reaches through its
+// alias and userspace through a mapping in the shared window. There is a
+// single address space, so one mapping serves every process.
+struct SharedRegion {
+    void* kernel;
+    uint64_t phys;
+    uint64_t user_addr;
+    size_t pages;
+};
+
+class SharedMemory {
+public:
+    static constexpr size_t MAX_SIZE = 4 * 1024 * 1024;
+
+    static bool alloc(SharedRegion* region, size_t size);
+
+    // Shoots the mapping down on every CPU, so like TLB::flush() it needs
+    // process context with interrupts enabled; owners whose last reference
+    // can drop anywhere free their region from a workqueue.
+    static void free(SharedRegion* region);
+};
+
+}
+
+#endif
\ No newline at end of file
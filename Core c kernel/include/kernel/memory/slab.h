@@ -0,0 +1,46 @@
+#ifndef CORE_SLAB_H
+#define CORE_SLAB_H
+
+#include <kernel/types.h>
+#include <kernel/sync/spinlock.h>
+
+namespace Core {
+
+// Fixed-size object cache carved out of whole PMM pages. Objects sit at
+// multiples of the object size from the start of a page, so a size that is
+// a multiple of 64 gives 64-byte aligned objects.
+class ObjectCache {
+public:
+    ObjectCache(const char* name, size_t object_size);
+
+    // For sizes only known at boot. Must come before the first alloc() and
+    // stay at most PAGE_SIZE.
+    void set_object_size(size_t size);
+
+    void* alloc();
+    void* zalloc();
+    void free(void* object);
+
+    const char* get_name() const { return name; }
+    size_t get_object_size() const { return object_size; }
+    size_t get_allocated() const { return allocated; }
+    size_t get_pages() const { return pages; }
+
+private:
+    struct FreeObject {
+        FreeObject* next;
+    };
+
+    const char* name;
+    size_t object_size;
+    size_t allocated;
+    size_t pages;
+    FreeObject* free_list;
+    Spinlock lock;
+
+    bool grow();
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -2,6 +2,7 @@
 #define CORE_VMM_H
 
 #include <kernel/types.h>
+#include <kernel/sync/spinlock.h>
 
 namespace Core {
 
@@ -11,13 +12,46 @@ public:
     static void* map_page(uint64_t virt, uint64_t phys, uint32_t flags);
     static void unmap_page(uint64_t virt);
     static uint64_t virt_to_phys(uint64_t virt);
-    
+
+    // Allocates any missing page tables under [virt, virt + length) now, so
+    // later mappings there never enter the PMM. False if out of memory.
+    static bool populate_tables(uint64_t virt, size_t length);
+
+    // Maps device registers (or firmware tables) that lie outside the boot
+    // mapping into an uncached window. Mappings are permanent.
+    static void* map_mmio(uint64_t phys, size_t size);
+
+    // Page-table edits that leave TLB invalidation to the caller, so a
+    // batch of changes can share one flush (see TLB::Batch). Installing a
+    // mapping where none was present needs no flush at all. get_pte() and
+    // clear_pte() return the raw entry, or 0 if nothing was mapped.
+    static void set_pte(uint64_t virt, uint64_t phys, uint32_t flags);
+    static uint64_t get_pte(uint64_t virt);
+    static uint64_t clear_pte(uint64_t virt);
+
+    // Anonymous and object mappings go below the shared window. Check and
+    // fill a range under user_map_lock so two mappings cannot claim the
+    // same pages.
+    static bool is_user_range(uint64_t virt, size_t length);
+    static bool is_range_free(uint64_t virt, size_t length);
+    static Spinlock user_map_lock;
+
     enum Flags {
         PRESENT = 1 << 0,
         WRITABLE = 1 << 1,
         USER = 1 << 2,
+        WRITE_THROUGH = 1 << 3,
+        CACHE_DISABLE = 1 << 4,
+        // Software bit: the page belongs to the mapping itself and is
+        // freed when it is unmapped.
+        ANONYMOUS = 1 << 9,
         NO_EXECUTE = 1ULL << 63
     };
+
+    static constexpr uint64_t ADDRESS_MASK = 0x000FFFFFFFFFF000ULL;
+
+private:
+    static uint64_t* walk(uint64_t virt, uint32_t flags, bool create);
 };
 
 }
@@ -8,7 +8,10 @@
 #define MULTIBOOT_TAG_TYPE_END               0
 #define MULTIBOOT_TAG_TYPE_CMDLINE           1
 #define MULTIBOOT_TAG_TYPE_BOOT_LOADER_NAME  2
+#define MULTIBOOT_TAG_TYPE_MODULE            3
 #define MULTIBOOT_TAG_TYPE_MMAP              6
+#define MULTIBOOT_TAG_TYPE_ACPI_OLD          14
+#define MULTIBOOT_TAG_TYPE_ACPI_NEW          15
 
 #define MULTIBOOT_MEMORY_AVAILABLE          1
 #define MULTIBOOT_MEMORY_RESERVED           2
@@ -31,6 +34,20 @@ typedef struct multiboot_mmap_entry {
     uint32_t zero;
 } PACKED multiboot_memory_map_t;
 
+struct multiboot_tag_module {
+    uint32_t type;
+    uint32_t size;
+    uint32_t mod_start;
+    uint32_t mod_end;
+    char cmdline[0];
+} PACKED;
+
+struct multiboot_tag_acpi {
+    uint32_t type;
+    uint32_t size;
+    uint8_t rsdp[0];
+} PACKED;
+
 struct multiboot_tag_mmap {
     uint32_t type;
     uint32_t size;
@@ -2,26 +2,102 @@
 #define CORE_PROCESS_H
 
 #include <kernel/types.h>
+#include <kernel/sync/spinlock.h>
+#include <kernel/sync/rcu.h>
+#include <kernel/ipc/handle.h>
 
 namespace Core {
 
 typedef void* (*thread_func_t)(void*);
 
+class Process;
+struct IpcMessage;
+struct BlockPlug;
+
+class Thread {
+public:
+    enum class State : uint8_t {
+        READY,
+        RUNNING,
+        BLOCKED,
+        DEAD
+    };
+
+    int get_tid() const { return tid; }
+    Process* get_process() const { return process; }
+    State get_state() const { return state; }
+
+    int tid;
+    State state;
+    bool on_rq;
+    uint32_t cpu;
+    Process* process;
+    const char* name;
+    thread_func_t func;
+    void* arg;
+    void* exit_value;
+    void* fpu_state;
+
+    uint64_t saved_rsp;
+    uint64_t stack_base;
+    uint64_t stack_top;
+
+    uint64_t wake_tick;
+    Thread* run_next;
+    Thread* sleep_next;
+    Thread* process_next;
+    Thread* process_prev;
+    RcuHead rcu;
+
+    // IPC rendezvous state, guarded by the endpoint lock while queued.
+    IpcMessage* ipc_buffer;
+    Thread* ipc_next;
+    Thread* ipc_caller;
+    error_t ipc_result;
+    bool ipc_is_call;
+
+    // Outermost active plug; see Block::start_plug().
+    BlockPlug* plug;
+};
+
 class Process {
 public:
     int get_pid() const { return pid; }
-    
-private:
+    const char* get_name() const { return name; }
+
     int pid;
-    friend class ProcessManager;
+    const char* name;
+    int exit_code;
+    uint32_t refs;              // one for the live threads, plus get()s
+    uint32_t thread_count;
+    Thread* threads;
+    Spinlock lock;
+    HandleTable handles;
+    RcuHead rcu;
 };
 
 class ProcessManager {
 public:
+    static constexpr int PID_MAX = 1 << 22;
+
     static void initialize();
     static Process* create_kernel_process(const char* name, thread_func_t func, void* arg);
+    static Thread* create_thread(Process* process, const char* name, thread_func_t func, void* arg, int cpu = -1);
+    static Thread* create_kernel_thread(const char* name, thread_func_t func, void* arg, int cpu = -1);
+    // Lockless; the result stays valid until rcu_read_unlock().
+    static Process* find_process(int pid);
+    // Keeps the Process itself allocated after its last thread is reaped;
+    // its handle table is empty by then.
+    static void get(Process* proc);
+    static void put(Process* proc);
+    static Thread* find_thread(int tid);
     static Process* get_current();
+    static Thread* get_current_thread();
     static void exit(int code);
+    static void exit_thread(void* value);
+    static void reap(Thread* thread);
+    static size_t get_process_count();
+    static size_t get_thread_count();
 };
 
 }
@@ -1,13 +1,29 @@
 #ifndef CORE_SCHEDULER_H
 #define CORE_SCHEDULER_H
 
+#include <kernel/types.h>
+
 namespace Core {
 
+class Thread;
+
 class Scheduler {
 public:
+    static constexpr uint32_t TIME_SLICE_TICKS = 10;
+
     static void initialize();
     static void start();
     static void yield();
+    static void schedule();
+    static void switch_to(Thread* next);
+    static void enqueue(Thread* thread);
+    static void enqueue_on(Thread* thread, uint32_t cpu);
+    static bool wake(Thread* thread);
+    static bool can_block();
+    static void sleep_until(uint64_t tick);
+    static void tick();
+    static void finish_switch();
+    static uint64_t get_switch_count();
 };
 
 }
@@ -0,0 +1,47 @@
+#ifndef CORE_WORKQUEUE_H
+#define CORE_WORKQUEUE_H
+
+#include <kernel/types.h>
+#include <kernel/arch/x86_64/cpu.h>
+#include <kernel/sync/waitqueue.h>
+
+namespace Core {
+
+struct Work {
+    void (*func)(Work*);
+    Work* next;
+    uint32_t pending;
+};
+
+// Per-CPU worker threads that run deferred work in process context. Queueing
+// is a lock-free push, so it is safe from hard interrupt handlers.
+class WorkQueue {
+public:
+    static constexpr uint32_t BATCH_SIZE = 32;
+
+    static void initialize();
+    static WorkQueue* create(const char* name);
+    static WorkQueue* system();
+
+    bool queue(Work* work);
+    bool queue_on(uint32_t cpu, Work* work);
+    void flush();
+
+private:
+    struct Worker {
+        WorkQueue* queue;
+        Work* pending;
+        WaitQueue wait;
+        uint64_t executed;
+        uint32_t cpu;
+    } ALIGNED(64);
+
+    const char* name;
+    Worker workers[CPU::MAX_CPUS];
+
+    static void* worker_main(void* arg);
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,28 @@
+#ifndef CORE_COMPLETION_H
+#define CORE_COMPLETION_H
+
+#include <kernel/types.h>
+#include <kernel/sync/waitqueue.h>
+
+namespace Core {
+
+class Completion {
+public:
+    Completion() : done(0) {}
+
+    void wait();
+    bool try_wait();
+    void complete();
+    void complete_all();
+    void reinit() { __atomic_store_n(&done, 0, __ATOMIC_RELEASE); }
+
+private:
+    static constexpr uint32_t DONE_ALL = ~0U;
+
+    uint32_t done;
+    WaitQueue waiters;
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,20 @@
+#ifndef CORE_FUTEX_H
+#define CORE_FUTEX_H
+
+#include <kernel/types.h>
+
+namespace Core {
+
+// Address-keyed wait/wake. Waiters sleep only if the word still holds the
+// expected value once the hash bucket is locked.
+class Futex {
+public:
+    static constexpr uint32_t BUCKETS = 256;
+
+    static error_t wait(uint32_t* addr, uint32_t expected);
+    static uint32_t wake(uint32_t* addr, uint32_t count);
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,93 @@
+#ifndef CORE_LFSTACK_H
+#define CORE_LFSTACK_H
+
+#include <kernel/types.h>
+
+namespace Core {
+
+struct LfStackNode {
+    LfStackNode* next;
+};
+
+// Intrusive lock-free LIFO. The head pairs the top pointer with a
+// generation tag updated by a 16-byte cmpxchg, so a node that is popped and
+// pushed back between another CPU's read and its cmpxchg (ABA) is detected.
+// pop() reads the top node's link after it may have been popped elsewhere,
+// so nodes must come from memory that stays mapped (ObjectCache, static
+// pools) rather than being returned to the PMM.
+class LfStack {
+public:
+    LfStack() : head{nullptr, 0} {}
+
+    void push(LfStackNode* node) {
+        Head old = read_head();
+        Head desired;
+
+        do {
+            node->next = old.top;
+            desired.top = node;
+            desired.tag = old.tag + 1;
+        } while (!compare_exchange(old, desired));
+    }
+
+    LfStackNode* pop() {
+        Head old = read_head();
+        Head desired;
+
+        while (old.top) {
+            desired.top = __atomic_load_n(&old.top->next, __ATOMIC_RELAXED);
+            desired.tag = old.tag + 1;
+            if (compare_exchange(old, desired)) {
+                return old.top;
+            }
+        }
+
+        return nullptr;
+    }
+
+    // Detaches the whole stack at once.
+    LfStackNode* pop_all() {
+        Head old = read_head();
+        Head desired = { nullptr, 0 };
+
+        do {
+            desired.tag = old.tag + 1;
+        } while (old.top && !compare_exchange(old, desired));
+
+        return old.top;
+    }
+
+    bool is_empty() const {
+        return __atomic_load_n(&head.top, __ATOMIC_RELAXED) == nullptr;
+    }
+
+private:
+    struct Head {
+        LfStackNode* top;
+        uint64_t tag;
+    } ALIGNED(16);
+
+    Head head;
+
+    // A torn read is harmless: the cmpxchg fails and reloads both halves.
+    Head read_head() const {
+        Head value;
+        value.tag = __atomic_load_n(&head.tag, __ATOMIC_ACQUIRE);
+        value.top = __atomic_load_n(&head.top, __ATOMIC_ACQUIRE);
+        return value;
+    }
+
+    // On failure `expected` is refreshed with the current head.
+    bool compare_exchange(Head& expected, Head desired) {
+        bool success;
+        __asm__ volatile("lock cmpxchg16b %1"
+                         : "=@ccz"(success), "+m"(head), "+a"(expected.top), "+d"(expected.tag)
+                         : "b"(desired.top), "c"(desired.tag)
+                         : "memory");
+        return success;
+    }
+};
+
+}
+
+#endif
\ No newline at end of file
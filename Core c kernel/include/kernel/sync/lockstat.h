@@ -0,0 +1,51 @@
+#ifndef CORE_LOCKSTAT_H
+#define CORE_LOCKSTAT_H
+
+#include <kernel/types.h>
+
+namespace Core {
+
+class Spinlock;
+
+// Per-class spinlock statistics, collected only when the kernel is built
+// with CONFIG_LOCKSTAT (`make LOCKSTAT=1`). Times are in TSC cycles.
+struct LockSite {
+    uint64_t ip;
+    uint64_t contended;
+    uint64_t wait_cycles;
+};
+
+struct LockClass {
+    static constexpr uint32_t TOP_SITES = 4;
+
+    const char* name;
+    uint64_t key;
+    uint64_t acquisitions;
+    uint64_t contended;
+    uint64_t wait_total;
+    uint64_t wait_max;
+    uint64_t hold_total;
+    uint64_t hold_max;
+    uint32_t sites_busy;
+    LockSite sites[TOP_SITES];
+};
+
+class Lockstat {
+public:
+    static constexpr uint32_t MAX_CLASSES = 128;
+
+    static void acquired(Spinlock* lock, uint64_t ip, uint64_t wait_cycles, bool contended);
+    static void released(Spinlock* lock);
+
+    // Writes all classes, hottest (by total wait) first, to the serial port.
+    static void dump();
+    static void reset();
+
+    // Starts a thread that dumps on 'l' and resets on 'r' from the serial
+    // console.
+    static void start_monitor();
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,89 @@
+#ifndef CORE_MPSC_QUEUE_H
+#define CORE_MPSC_QUEUE_H
+
+#include <kernel/types.h>
+
+namespace Core {
+
+// Bounded multi-producer/single-consumer queue (Vyukov). Every cell carries
+// a sequence number telling producers and the consumer whose turn it is, so
+// producers only contend on one cmpxchg of the enqueue index and never on
+// the consumer's line. SIZE must be a power of two. Unlike most kernel
+// objects, zeroed memory is not a valid queue: construct it or call
+// initialize().
+template <typename T, uint32_t SIZE>
+class MpscQueue {
+    static_assert(SIZE >= 2 && (SIZE & (SIZE - 1)) == 0, "MpscQueue size must be a power of two");
+
+public:
+    MpscQueue() { initialize(); }
+
+    void initialize() {
+        for (uint32_t i = 0; i < SIZE; i++) {
+            cells[i].sequence = i;
+        }
+        enqueue_pos.value = 0;
+        dequeue_pos.value = 0;
+    }
+
+    bool enqueue(const T& item) {
+        uint64_t pos = __atomic_load_n(&enqueue_pos.value, __ATOMIC_RELAXED);
+        Cell* cell;
+
+        while (true) {
+            cell = &cells[pos & MASK];
+            uint64_t seq = __atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE);
+            int64_t diff = (int64_t)(seq - pos);
+
+            if (diff == 0) {
+                if (__atomic_compare_exchange_n(&enqueue_pos.value, &pos, pos + 1, true,
+                                                __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                    break;
+                }
+            } else if (diff < 0) {
+                return false;
+            } else {
+                pos = __atomic_load_n(&enqueue_pos.value, __ATOMIC_RELAXED);
+            }
+        }
+
+        cell->item = item;
+        __atomic_store_n(&cell->sequence, pos + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    // Single consumer only.
+    bool dequeue(T& item) {
+        uint64_t pos = dequeue_pos.value;
+        Cell* cell = &cells[pos & MASK];
+
+        if (__atomic_load_n(&cell->sequence, __ATOMIC_ACQUIRE) != pos + 1) {
+            return false;
+        }
+
+        item = cell->item;
+        __atomic_store_n(&cell->sequence, pos + SIZE, __ATOMIC_RELEASE);
+        dequeue_pos.value = pos + 1;
+        return true;
+    }
+
+private:
+    static constexpr uint64_t MASK = SIZE - 1;
+
+    struct Cell {
+        uint64_t sequence;
+        T item;
+    };
+
+    struct Position {
+        uint64_t value;
+    } ALIGNED(64);
+
+    Position enqueue_pos;
+    Position dequeue_pos;
+    Cell cells[SIZE];
+};
+
+}
+
+#endif
\ No newline at end of file
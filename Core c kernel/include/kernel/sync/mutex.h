@@ -0,0 +1,47 @@
+#ifndef CORE_MUTEX_H
+#define CORE_MUTEX_H
+
+#include <kernel/types.h>
+#include <kernel/sync/waitqueue.h>
+
+namespace Core {
+
+class Thread;
+
+// Sleeping lock. Contended acquirers spin while the owner is running on
+// another CPU, since it is likely to release soon, and block otherwise.
+class Mutex {
+public:
+    static constexpr uint32_t SPIN_LIMIT = 1000;
+
+    Mutex() : owner(nullptr) {}
+
+    void lock();
+    bool try_lock();
+    void unlock();
+    bool is_locked() const { return __atomic_load_n(&owner, __ATOMIC_RELAXED) != nullptr; }
+
+private:
+    Thread* owner;
+    WaitQueue waiters;
+
+    bool spin_on_owner();
+};
+
+class ScopedMutex {
+public:
+    explicit ScopedMutex(Mutex& mutex) : mutex(mutex) {
+        mutex.lock();
+    }
+
+    ~ScopedMutex() {
+        mutex.unlock();
+    }
+
+private:
+    Mutex& mutex;
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,77 @@
+#ifndef CORE_PERCPU_H
+#define CORE_PERCPU_H
+
+#include <kernel/types.h>
+#include <kernel/arch/x86_64/cpu.h>
+
+namespace Core {
+
+// One instance of T per CPU, each on its own cache line. local() is only
+// stable while preemption (or interrupts) is disabled; get_cpu()/put_cpu()
+// bracket that.
+template <typename T>
+class PerCpu {
+public:
+    T& local() { return slots[CPU::id()].value; }
+    T& get(uint32_t cpu) { return slots[cpu].value; }
+    const T& get(uint32_t cpu) const { return slots[cpu].value; }
+
+    T& get_cpu() {
+        CPU::preempt_disable();
+        return local();
+    }
+
+    void put_cpu() {
+        CPU::preempt_enable();
+    }
+
+    template <typename Func>
+    void for_each(Func func) {
+        for (uint32_t cpu = 0; cpu < CPU::online_count(); cpu++) {
+            func(cpu, slots[cpu].value);
+        }
+    }
+
+private:
+    struct Slot {
+        T value;
+    } ALIGNED(64);
+
+    Slot slots[CPU::MAX_CPUS];
+};
+
+// Statistics counter that is cheap to bump from any context: each CPU adds
+// to its own slot with a single non-locked instruction, which an interrupt
+// cannot split. Reads sum all slots and may miss concurrent updates.
+class PerCpuCounter {
+public:
+    void add(int64_t delta) {
+        CPU::preempt_disable();
+        int64_t* slot = &counts.local();
+        __asm__ volatile("addq %1, %0" : "+m"(*slot) : "er"(delta));
+        CPU::preempt_enable();
+    }
+
+    void inc() { add(1); }
+
+    int64_t sum() const {
+        int64_t total = 0;
+        for (uint32_t cpu = 0; cpu < CPU::online_count(); cpu++) {
+            total += __atomic_load_n(&counts.get(cpu), __ATOMIC_RELAXED);
+        }
+        return total;
+    }
+
+    void reset() {
+        for (uint32_t cpu = 0; cpu < CPU::MAX_CPUS; cpu++) {
+            __atomic_store_n(&counts.get(cpu), 0, __ATOMIC_RELAXED);
+        }
+    }
+
+private:
+    PerCpu<int64_t> counts = {};
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,60 @@
+#ifndef CORE_RCU_H
+#define CORE_RCU_H
+
+#include <kernel/types.h>
+#include <kernel/arch/x86_64/cpu.h>
+
+namespace Core {
+
+// Read-copy-update. Readers only disable preemption; updaters publish new
+// versions with rcu_assign_pointer() and free old ones once every CPU has
+// passed through a quiescent state (context switch, idle, or a timer tick
+// outside any read-side section).
+
+struct RcuHead {
+    RcuHead* next;
+    void (*func)(RcuHead* head);
+};
+
+typedef void (*rcu_callback_t)(RcuHead* head);
+
+static inline void rcu_read_lock() {
+    CPU::preempt_disable();
+}
+
+static inline void rcu_read_unlock() {
+    CPU::preempt_enable();
+}
+
+template <typename T>
+static inline T rcu_dereference(T& pointer) {
+    return __atomic_load_n(&pointer, __ATOMIC_CONSUME);
+}
+
+template <typename T, typename V>
+static inline void rcu_assign_pointer(T& pointer, V value) {
+    __atomic_store_n(&pointer, (T)value, __ATOMIC_RELEASE);
+}
+
+// Runs `func` from softirq context after a full grace period. Callbacks
+// must not block.
+void call_rcu(RcuHead* head, rcu_callback_t func);
+
+// Waits for a full grace period. Must be called from a context that can
+// block.
+void synchronize_rcu();
+
+class RCU {
+public:
+    // Callbacks invoked per softirq pass before the rest is deferred.
+    static constexpr uint32_t BATCH_LIMIT = 64;
+
+    static void initialize();
+    static void tick();
+    static void note_context_switch();
+    static uint64_t get_completed();
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,89 @@
+#ifndef CORE_RWLOCK_H
+#define CORE_RWLOCK_H
+
+#include <kernel/types.h>
+#include <kernel/sync/spinlock.h>
+#include <kernel/arch/x86_64/cpu.h>
+
+namespace Core {
+
+// Reader-writer spinlock for read-mostly data. Each CPU counts its readers
+// on its own cache line, so readers on different CPUs never touch a shared
+// line unless a writer is active. Writers are preferred: once one announces
+// itself, new readers wait until it is done. Both sides disable preemption.
+//
+// The per-CPU counters make this lock large (one cache line per CPU); use it
+// for a handful of global structures, not per-object. If the read side is
+// taken from interrupt context, writers must use write_lock_irqsave.
+class RWLock {
+public:
+    RWLock() : readers(), writer(0) {}
+
+    void read_lock();
+    void read_unlock();
+    void write_lock();
+    void write_unlock();
+
+    uint64_t read_lock_irqsave() {
+        uint64_t flags = CPU::irq_save();
+        read_lock();
+        return flags;
+    }
+
+    void read_unlock_irqrestore(uint64_t flags) {
+        read_unlock();
+        CPU::irq_restore(flags);
+    }
+
+    uint64_t write_lock_irqsave() {
+        uint64_t flags = CPU::irq_save();
+        write_lock();
+        return flags;
+    }
+
+    void write_unlock_irqrestore(uint64_t flags) {
+        write_unlock();
+        CPU::irq_restore(flags);
+    }
+
+private:
+    struct ReaderCount {
+        uint32_t count;
+    } ALIGNED(64);
+
+    ReaderCount readers[CPU::MAX_CPUS];
+    uint32_t writer;
+    Spinlock writer_lock;
+};
+
+class ScopedReadLock {
+public:
+    explicit ScopedReadLock(RWLock& lock) : lock(lock) {
+        lock.read_lock();
+    }
+
+    ~ScopedReadLock() {
+        lock.read_unlock();
+    }
+
+private:
+    RWLock& lock;
+};
+
+class ScopedWriteLock {
+public:
+    explicit ScopedWriteLock(RWLock& lock) : lock(lock) {
+        lock.write_lock();
+    }
+
+    ~ScopedWriteLock() {
+        lock.write_unlock();
+    }
+
+private:
+    RWLock& lock;
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,25 @@
+#ifndef CORE_SEMAPHORE_H
+#define CORE_SEMAPHORE_H
+
+#include <kernel/types.h>
+#include <kernel/sync/waitqueue.h>
+
+namespace Core {
+
+class Semaphore {
+public:
+    explicit Semaphore(int32_t initial = 0) : count(initial) {}
+
+    void down();
+    bool try_down();
+    void up();
+    int32_t get_count() const { return __atomic_load_n(&count, __ATOMIC_RELAXED); }
+
+private:
+    int32_t count;
+    WaitQueue waiters;
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,51 @@
+#ifndef CORE_SEQLOCK_H
+#define CORE_SEQLOCK_H
+
+#include <kernel/types.h>
+#include <kernel/arch/x86_64/cpu.h>
+
+namespace Core {
+
+// Sequence counter for small, frequently read records. Writers must already
+// be serialized (by a lock or by running on a single CPU); readers never
+// write shared memory and simply retry if they raced with an update:
+//
+//     uint32_t seq;
+//     do {
+//         seq = counter.read_begin();
+//         copy = record;
+//     } while (counter.read_retry(seq));
+class SeqCount {
+public:
+    SeqCount() : sequence(0) {}
+
+    uint32_t read_begin() const {
+        uint32_t seq;
+        while ((seq = __atomic_load_n(&sequence, __ATOMIC_ACQUIRE)) & 1) {
+            CPU::relax();
+        }
+        return seq;
+    }
+
+    bool read_retry(uint32_t seq) const {
+        __atomic_thread_fence(__ATOMIC_ACQUIRE);
+        return __atomic_load_n(&sequence, __ATOMIC_RELAXED) != seq;
+    }
+
+    void write_begin() {
+        __atomic_store_n(&sequence, sequence + 1, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+    }
+
+    void write_end() {
+        __atomic_thread_fence(__ATOMIC_RELEASE);
+        __atomic_store_n(&sequence, sequence + 1, __ATOMIC_RELAXED);
+    }
+
+private:
+    uint32_t sequence;
+};
+
+}
+
+#endif
\ No newline at end of file
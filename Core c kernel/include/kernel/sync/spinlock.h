@@ -2,31 +2,110 @@
 #define CORE_SPINLOCK_H
 
 #include <kernel/types.h>
+#include <kernel/arch/x86_64/cpu.h>
 
 namespace Core {
 
+struct LockClass;
+
+// Queued spinlock. The uncontended path is a single cmpxchg on the lock
+// word; contended waiters join an MCS queue built from per-CPU nodes and
+// each spins on its own cache line, so the lock is handed over in FIFO
+// order. Holding the lock disables preemption. Zeroed memory is a valid
+// unlocked lock.
+//
+// There is deliberately no ticket fast path: a ticket pair needs its own
+// halves of the word, the MCS tail needs the rest, and the queue already
+// gives waiters FIFO order, so tickets would add a second ordering to keep
+// in step without making anything fairer. Uncontended, cmpxchg costs the
+// same single locked instruction a ticket xadd would.
+//
+// With CONFIG_LOCKSTAT, lock()/unlock() are out of line and feed the
+// statistics in Lockstat. The name groups locks into a class; unnamed locks
+// are classed by the call site that first took them.
 class Spinlock {
 public:
-    Spinlock() : locked(0) {}
-    
-    void lock() {
-        while (__atomic_test_and_set(&locked, __ATOMIC_ACQUIRE)) {
-            while (__atomic_load_n(&locked, __ATOMIC_RELAXED)) {
-                __asm__ volatile("pause");
-            }
-        }
+    Spinlock() : val(0) {}
+    explicit Spinlock(const char* name) : val(0) { set_name(name); }
+
+#ifdef CONFIG_LOCKSTAT
+    void lock();
+    void unlock();
+    bool try_lock();
+    void set_name(const char* lock_name) { name = lock_name; }
+#else
+    void lock() { raw_lock(); }
+    void unlock() { raw_unlock(); }
+    bool try_lock() { return raw_try_lock(); }
+    void set_name(const char*) {}
+#endif
+
+    uint64_t lock_irqsave() {
+        uint64_t flags = CPU::irq_save();
+        lock();
+        return flags;
     }
-    
-    void unlock() {
-        __atomic_clear(&locked, __ATOMIC_RELEASE);
+
+    void unlock_irqrestore(uint64_t flags) {
+        unlock();
+        CPU::irq_restore(flags);
     }
-    
-    bool try_lock() {
-        return !__atomic_test_and_set(&locked, __ATOMIC_ACQUIRE);
+
+    bool is_locked() const {
+        return __atomic_load_n(&val, __ATOMIC_RELAXED) != 0;
     }
     
 private:
-    volatile int locked;
+    friend class Lockstat;
+
+    static constexpr uint32_t LOCKED_VAL = 1;
+    static constexpr uint32_t TAIL_SHIFT = 16;
+
+    bool fast_try_lock() {
+        uint32_t expected = 0;
+        return __atomic_compare_exchange_n(&val, &expected, LOCKED_VAL, false,
+                                           __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+    }
+
+    void raw_lock() {
+        CPU::preempt_disable();
+        if (!fast_try_lock()) {
+            lock_slowpath();
+        }
+    }
+
+    void raw_unlock() {
+        __atomic_store_n(&locked, 0, __ATOMIC_RELEASE);
+        CPU::preempt_enable();
+    }
+
+    bool raw_try_lock() {
+        CPU::preempt_disable();
+        if (fast_try_lock()) {
+            return true;
+        }
+        CPU::preempt_enable();
+        return false;
+    }
+
+    void lock_slowpath();
+
+    // `locked` is the owner byte; `tail` encodes (cpu + 1, node index) of
+    // the last queued waiter, or zero when nobody is queued.
+    union {
+        uint32_t val;
+        struct {
+            uint8_t locked;
+            uint8_t reserved;
+            uint16_t tail;
+        };
+    };
+
+#ifdef CONFIG_LOCKSTAT
+    const char* name = nullptr;
+    LockClass* lock_class = nullptr;
+    uint64_t acquired_at = 0;
+#endif
 };
 
 class ScopedLock {
@@ -43,6 +122,23 @@ private:
     Spinlock& lock;
 };
 
+// Same as ScopedLock, but also keeps local interrupts off while held. Use it
+// for any lock that is also taken from interrupt or softirq context.
+class ScopedIrqLock {
+public:
+    explicit ScopedIrqLock(Spinlock& lock) : lock(lock) {
+        flags = lock.lock_irqsave();
+    }
+
+    ~ScopedIrqLock() {
+        lock.unlock_irqrestore(flags);
+    }
+
+private:
+    Spinlock& lock;
+    uint64_t flags;
+};
+
 }
 
 #endif
\ No newline at end of file
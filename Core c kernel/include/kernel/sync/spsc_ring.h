@@ -0,0 +1,74 @@
+#ifndef CORE_SPSC_RING_H
+#define CORE_SPSC_RING_H
+
+#include <kernel/types.h>
+
+namespace Core {
+
+// Bounded single-producer/single-consumer ring. Producer and consumer
+// indices live on separate cache lines, and each side keeps a cached copy
+// of the other's index so it only touches the shared line when the ring
+// looks full (or empty). SIZE must be a power of two.
+template <typename T, uint32_t SIZE>
+class SpscRing {
+    static_assert(SIZE && (SIZE & (SIZE - 1)) == 0, "SpscRing size must be a power of two");
+
+public:
+    bool push(const T& item) {
+        uint32_t head = producer.head;
+
+        if (head - producer.cached_tail == SIZE) {
+            producer.cached_tail = __atomic_load_n(&consumer.tail, __ATOMIC_ACQUIRE);
+            if (head - producer.cached_tail == SIZE) {
+                return false;
+            }
+        }
+
+        slots[head & MASK] = item;
+        __atomic_store_n(&producer.head, head + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    bool pop(T& item) {
+        uint32_t tail = consumer.tail;
+
+        if (tail == consumer.cached_head) {
+            consumer.cached_head = __atomic_load_n(&producer.head, __ATOMIC_ACQUIRE);
+            if (tail == consumer.cached_head) {
+                return false;
+            }
+        }
+
+        item = slots[tail & MASK];
+        __atomic_store_n(&consumer.tail, tail + 1, __ATOMIC_RELEASE);
+        return true;
+    }
+
+    uint32_t size() const {
+        return __atomic_load_n(&producer.head, __ATOMIC_ACQUIRE) -
+               __atomic_load_n(&consumer.tail, __ATOMIC_ACQUIRE);
+    }
+
+    bool is_empty() const { return size() == 0; }
+
+private:
+    static constexpr uint32_t MASK = SIZE - 1;
+
+    struct ProducerSide {
+        uint32_t head;
+        uint32_t cached_tail;
+    } ALIGNED(64);
+
+    struct ConsumerSide {
+        uint32_t tail;
+        uint32_t cached_head;
+    } ALIGNED(64);
+
+    ProducerSide producer = {};
+    ConsumerSide consumer = {};
+    T slots[SIZE];
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,58 @@
+#ifndef CORE_WAITQUEUE_H
+#define CORE_WAITQUEUE_H
+
+#include <kernel/types.h>
+#include <kernel/sync/spinlock.h>
+#include <kernel/process/scheduler.h>
+
+namespace Core {
+
+class Thread;
+
+struct WaitQueueEntry {
+    Thread* thread;
+    WaitQueueEntry* next;
+    WaitQueueEntry* prev;
+    bool queued;
+
+    WaitQueueEntry() : thread(nullptr), next(nullptr), prev(nullptr), queued(false) {}
+};
+
+// FIFO of sleeping threads. Waiters queue themselves and mark their thread
+// blocked before re-checking their condition, so a wake that races with the
+// check is never lost.
+class WaitQueue {
+public:
+    WaitQueue() : head(nullptr), tail(nullptr) {}
+
+    void prepare_to_wait(WaitQueueEntry& entry);
+    void finish_wait(WaitQueueEntry& entry);
+    uint32_t wake(uint32_t count);
+    void wake_one() { wake(1); }
+    void wake_all() { wake(~0U); }
+    bool is_empty() const { return __atomic_load_n(&head, __ATOMIC_ACQUIRE) == nullptr; }
+
+    template <typename Condition>
+    void wait_event(Condition condition) {
+        if (condition()) return;
+
+        WaitQueueEntry entry;
+        while (true) {
+            prepare_to_wait(entry);
+            if (condition()) break;
+            Scheduler::schedule();
+        }
+        finish_wait(entry);
+    }
+
+private:
+    Spinlock lock;
+    WaitQueueEntry* head;
+    WaitQueueEntry* tail;
+
+    void unlink(WaitQueueEntry& entry);
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,90 @@
+#ifndef CORE_SYSCALL_H
+#define CORE_SYSCALL_H
+
+#include <kernel/types.h>
+#include <kernel/process/process.h>
+#include <kernel/arch/x86_64/cpu.h>
+
+namespace Core {
+
+// Userspace ABI: number in RAX, arguments in RDI, RSI, RDX, R10, R8, R9,
+// result (or a negative error_t) in RAX. RCX and R11 are clobbered by the
+// instruction itself; the other argument registers come back unchanged
+// unless the call returns values in them.
+//
+// IPC calls carry the message in registers: RDI = endpoint handle,
+// RSI = label, RDX, R10, R8, R9 = words. Calls that receive a message
+// return it in the same registers.
+//
+// Channels are driven from userspace through the shared layout in
+// ipc/channel.h; the kernel is only entered to wait and to notify. The
+// same goes for io rings (ipc/io_ring.h), which batch further kernel calls.
+//
+// Memory objects (ipc/memory_object.h) are shared by granting a handle with
+// narrower rights, or handed over with SYS_MEM_TRANSFER, which moves the
+// pages instead of copying them. Both take the target's pid and, in R10, a
+// handle to an endpoint or channel the target also holds; without that link
+// a process can only install into itself.
+enum SyscallNumber : uint64_t {
+    SYS_NULL = 0,
+    SYS_EXIT,
+    SYS_YIELD,
+    SYS_GETPID,
+    SYS_GETTID,
+    SYS_ENDPOINT_CREATE,
+    SYS_HANDLE_CLOSE,
+    SYS_IPC_SEND,
+    SYS_IPC_RECV,
+    SYS_IPC_CALL,
+    SYS_IPC_REPLY,
+    SYS_IPC_REPLY_RECV,
+    SYS_CHANNEL_CREATE,
+    SYS_CHANNEL_MAP,
+    SYS_CHANNEL_WAIT,
+    SYS_CHANNEL_NOTIFY,
+    SYS_IO_RING_CREATE,
+    SYS_IO_RING_MAP,
+    SYS_IO_RING_ENTER,
+    SYS_MEM_CREATE,
+    SYS_MEM_MAP,
+    SYS_MEM_UNMAP,
+    SYS_MEM_TRANSFER,
+    SYS_HANDLE_GRANT,
+    NR_SYSCALLS
+};
+
+// User registers saved at the top of the kernel stack by syscall_entry,
+// lowest address first.
+struct SyscallFrame {
+    uint64_t r9;
+    uint64_t r8;
+    uint64_t r10;
+    uint64_t rdx;
+    uint64_t rsi;
+    uint64_t rdi;
+    uint64_t rip;
+    uint64_t rflags;
+    uint64_t rsp;
+};
+
+typedef int64_t (*syscall_func_t)(uint64_t, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t);
+
+namespace Syscall {
+
+// Programs the SYSCALL MSRs on the calling CPU.
+void initialize();
+
+// Drops the current thread to ring 3 at `rip` with `rsp`; `arg` arrives in
+// RDI. The thread's kernel stack is reused for its later syscalls and
+// interrupts, so this never returns.
+[[noreturn]] void enter_user(uint64_t rip, uint64_t rsp, uint64_t arg);
+
+// The current thread's saved user registers; only valid inside a syscall.
+static inline SyscallFrame* frame() {
+    return (SyscallFrame*)(CPU::local()->current_thread->stack_top - sizeof(SyscallFrame));
+}
+
+}
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,29 @@
+#ifndef CORE_CLOCK_H
+#define CORE_CLOCK_H
+
+#include <kernel/types.h>
+
+namespace Core {
+
+// TSC-based timekeeping. The clock parameters live in the vDSO data page
+// (see vdso.h), so the kernel and user processes read time the same way
+// without a syscall.
+class Clock {
+public:
+    static constexpr uint32_t CALIBRATE_MS = 10;
+    static constexpr uint32_t SHIFT = 32;
+
+    static void initialize();
+
+    // Called from the timer softirq; refines the TSC frequency against the
+    // PIT over successively longer intervals.
+    static void tick();
+
+    static uint64_t monotonic_ns();
+    static uint64_t realtime_ns();
+    static uint64_t get_tsc_hz();
+};
+
+}
+
+#endif
\ No newline at end of file
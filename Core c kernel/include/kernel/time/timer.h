@@ -0,0 +1,30 @@
+#ifndef CORE_TIMER_H
+#define CORE_TIMER_H
+
+#include <kernel/types.h>
+
+namespace Core {
+
+// One-shot callback in PIT ticks. Each CPU keeps its pending timers sorted
+// by expiry; the callback runs from that CPU's timer softirq, so it must not
+// block.
+struct Timer {
+    void (*func)(Timer* timer);
+    uint64_t expires;
+    Timer* next;
+    uint32_t cpu;
+    bool pending;
+
+    // Queues an idle timer on the calling CPU to fire once
+    // PIT::get_ticks() reaches `expires`.
+    static void add(Timer* timer, uint64_t expires);
+
+    // Returns true if the timer was still pending and will not run.
+    static bool cancel(Timer* timer);
+
+    static void run_expired();
+};
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,48 @@
+#ifndef CORE_VDSO_H
+#define CORE_VDSO_H
+
+#include <kernel/types.h>
+#include <kernel/sync/seqlock.h>
+
+namespace Core {
+
+// User-visible clock ABI. Two read-only pages sit at fixed addresses in the
+// user half: the time data below, and a code page with the reader routines.
+//
+//     typedef uint64_t (*vdso_clock_t)();
+//     uint64_t now = ((vdso_clock_t)VDSO_CLOCK_MONOTONIC)();
+//
+// The routines only touch RAX, RCX, RDX, R8 and R9 and never enter the
+// kernel.
+#define VDSO_TEXT_ADDR       0x00007FFFFFFF0000ULL
+#define VDSO_DATA_ADDR       0x00007FFFFFFF1000ULL
+
+#define VDSO_CLOCK_MONOTONIC (VDSO_TEXT_ADDR + 0x00)
+#define VDSO_CLOCK_REALTIME  (VDSO_TEXT_ADDR + 0x40)
+
+// Readers retry while `seq` is odd or changed under them; the kernel side
+// is a plain SeqCount. Nanoseconds are
+//
+//     mono_base + ((rdtsc() - tsc_base) * mult >> shift)
+//
+// with a 128-bit intermediate; realtime adds realtime_offset.
+struct VdsoTimeData {
+    SeqCount seq;
+    uint32_t shift;
+    uint64_t mult;
+    uint64_t tsc_base;
+    uint64_t mono_base;
+    uint64_t realtime_offset;
+};
+
+// Offsets used by vdso.asm.
+static_assert(sizeof(SeqCount) == 4 && offsetof(VdsoTimeData, seq) == 0, "vdso.asm");
+static_assert(offsetof(VdsoTimeData, shift) == 4, "vdso.asm");
+static_assert(offsetof(VdsoTimeData, mult) == 8, "vdso.asm");
+static_assert(offsetof(VdsoTimeData, tsc_base) == 16, "vdso.asm");
+static_assert(offsetof(VdsoTimeData, mono_base) == 24, "vdso.asm");
+static_assert(offsetof(VdsoTimeData, realtime_offset) == 32, "vdso.asm");
+
+}
+
+#endif
\ No newline at end of file
@@ -45,6 +45,10 @@ typedef enum {
     E_INVAL = -2,
     E_PERM = -3,
     E_NOENT = -4,
+    E_AGAIN = -5,
+    E_BUSY = -6,
+    E_NOSYS = -7,
+    E_IO = -8,
 } error_t;
 
 #define PAGE_SIZE 4096
@@ -54,4 +58,16 @@ typedef enum {
 #define KERNEL_HEAP_START   0xFFFFFFFF90000000ULL
 #define KERNEL_HEAP_SIZE    (512ULL * 1024 * 1024)
 
+#define KERNEL_STACK_AREA_START 0xFFFFFF8000000000ULL
+#define KERNEL_STACK_AREA_SIZE  (64ULL * 1024 * 1024 * 1024)
+
+#define USER_SPACE_START  0x0000008000000000ULL
+#define USER_SPACE_END    0x0000800000000000ULL
+
+#define USER_SHARED_START 0x0000700000000000ULL
+#define USER_SHARED_SIZE  (64ULL * 1024 * 1024 * 1024)
+
+#define KERNEL_MMIO_START 0xFFFFFF0000000000ULL
+#define KERNEL_MMIO_SIZE  (1ULL * 1024 * 1024 * 1024)
+
 #endif
\ No newline at end of file
@@ -0,0 +1,81 @@
+#include <kernel/ipc/channel.h>
+#include <kernel/memory/slab.h>
+
+namespace Core {
+
+static ObjectCache channel_cache("channel", sizeof(Channel));
+
+static void free_channel(RcuHead* head) {
+    channel_cache.free((uint8_t*)head - offsetof(Channel, obj.rcu));
+}
+
+static void teardown_work(Work* work) {
+    Channel* channel = (Channel*)((uint8_t*)work - offsetof(Channel, teardown));
+
+    SharedMemory::free(&channel->region);
+    call_rcu(&channel->obj.rcu, free_channel);
+}
+
+// The last reference may go from reap with interrupts off, where the
+// region's shootdown cannot wait, so it is freed from the system workqueue.
+static void release_channel(KObject* obj) {
+    Channel* channel = (Channel*)((uint8_t*)obj - offsetof(Channel, obj));
+
+    channel->teardown.func = teardown_work;
+    WorkQueue::system()->queue(&channel->teardown);
+}
+
+Channel* channel_create(uint32_t slots, size_t arena_size) {
+    if (!slots || (slots & (slots - 1)) || arena_size < PAGE_SIZE || (arena_size & (arena_size - 1))) {
+        return nullptr;
+    }
+
+    size_t desc_bytes = ALIGN_UP((size_t)slots * sizeof(ChannelDesc), PAGE_SIZE);
+    size_t size = PAGE_SIZE + desc_bytes + arena_size;
+    if (size > SharedMemory::MAX_SIZE) {
+        return nullptr;
+    }
+
+    Channel* channel = (Channel*)channel_cache.zalloc();
+    if (!channel) {
+        return nullptr;
+    }
+
+    if (!SharedMemory::alloc(&channel->region, size)) {
+        channel_cache.free(channel);
+        return nullptr;
+    }
+
+    channel->shared = (ChannelShared*)channel->region.kernel;
+    channel->shared->slot_count = slots;
+    channel->shared->desc_offset = PAGE_SIZE;
+    channel->shared->arena_offset = PAGE_SIZE + desc_bytes;
+    channel->shared->arena_size = arena_size;
+
+    kobject_init(&channel->obj, ObjectType::CHANNEL, release_channel);
+    return channel;
+}
+
+void channel_wait(Channel* channel, ChannelSide side, uint32_t token) {
+    ChannelShared* shared = channel->shared;
+
+    if (side == ChannelSide::READER) {
+        channel->readers.wait_event([shared, token] {
+            return __atomic_load_n(&shared->head, __ATOMIC_ACQUIRE) != token;
+        });
+    } else {
+        channel->writers.wait_event([shared, token] {
+            return __atomic_load_n(&shared->tail, __ATOMIC_ACQUIRE) != token;
+        });
+    }
+}
+
+void channel_notify(Channel* channel, ChannelSide side) {
+    if (side == ChannelSide::READER) {
+        channel->readers.wake_all();
+    } else {
+        channel->writers.wake_all();
+    }
+}
+
+}
\ No newline at end of file
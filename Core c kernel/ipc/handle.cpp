@@ -0,0 +1,164 @@
+#include <kernel/ipc/handle.h>
+#include <kernel/memory/heap.h>
+#include <kernel/memory/pmm.h>
+#include <kernel/memory/copy.h>
+
+namespace Core {
+
+// Every process starts with a small table from the heap; a full-sized one
+// would take half of it, so beyond HEAP_SLOTS the array takes whole pages.
+#define HEAP_SLOTS 64
+
+size_t HandleTable::slots_bytes(uint32_t capacity) {
+    return sizeof(Slots) + capacity * sizeof(uint64_t);
+}
+
+size_t HandleTable::slots_pages(uint32_t capacity) {
+    return ALIGN_UP(slots_bytes(capacity), PAGE_SIZE) / PAGE_SIZE;
+}
+
+HandleTable::Slots* HandleTable::alloc_slots(uint32_t capacity) {
+    if (capacity <= HEAP_SLOTS) {
+        return (Slots*)Heap::calloc(1, slots_bytes(capacity));
+    }
+
+    uint64_t phys = PMM::alloc_pages(slots_pages(capacity));
+    if (!phys) {
+        return nullptr;
+    }
+    zero_pages((void*)(phys + KERNEL_VIRTUAL_BASE), slots_pages(capacity));
+    return (Slots*)(phys + KERNEL_VIRTUAL_BASE);
+}
+
+void HandleTable::free_slots(RcuHead* head) {
+    Slots* table = (Slots*)((uint8_t*)head - offsetof(Slots, rcu));
+    if (table->capacity <= HEAP_SLOTS) {
+        Heap::free(table);
+    } else {
+        PMM::free_pages((uint64_t)table - KERNEL_VIRTUAL_BASE, slots_pages(table->capacity));
+    }
+}
+
+bool HandleTable::grow() {
+    uint32_t old_capacity = slots ? slots->capacity : 0;
+    uint32_t capacity = old_capacity ? old_capacity * 2 : INITIAL_SLOTS;
+    if (capacity > MAX_SLOTS) {
+        return false;
+    }
+
+    Slots* grown = alloc_slots(capacity);
+    if (!grown) {
+        return false;
+    }
+
+    grown->capacity = capacity;
+    for (uint32_t i = 0; i < old_capacity; i++) {
+        grown->entries[i] = slots->entries[i];
+    }
+
+    Slots* old = slots;
+    rcu_assign_pointer(slots, grown);
+    if (old) {
+        call_rcu(&old->rcu, free_slots);
+    }
+    return true;
+}
+
+int HandleTable::install(KObject* obj, uint32_t rights) {
+    static_assert(alignof(KObject) > RIGHTS_MASK, "rights live in the pointer's low bits");
+    ScopedLock guard(lock);
+
+    while (true) {
+        uint32_t capacity = slots ? slots->capacity : 0;
+        for (uint32_t i = 0; i < capacity; i++) {
+            uint32_t handle = (next_free + i) % capacity;
+            if (!slots->entries[handle]) {
+                kobject_get(obj);
+                rcu_assign_pointer(slots->entries[handle], (uint64_t)obj | (rights & RIGHTS_MASK));
+                next_free = handle + 1;
+                return handle;
+            }
+        }
+
+        if (!grow()) {
+            return E_NOMEM;
+        }
+    }
+}
+
+KObject* HandleTable::get(int handle, ObjectType type, uint32_t rights, uint32_t* granted) {
+    KObject* obj = nullptr;
+
+    rcu_read_lock();
+    Slots* table = rcu_dereference(slots);
+    if (table && handle >= 0 && (uint32_t)handle < table->capacity) {
+        uint64_t entry = rcu_dereference(table->entries[handle]);
+        obj = entry_object(entry);
+        if (obj && ((entry & rights) != rights || (type != ObjectType::NONE && obj->type != type) || !kobject_tryget(obj))) {
+            obj = nullptr;
+        }
+        if (obj && granted) {
+            *granted = entry & RIGHTS_MASK;
+        }
+    }
+    rcu_read_unlock();
+
+    return obj;
+}
+
+bool HandleTable::holds(const KObject* obj) {
+    Slots* table = rcu_dereference(slots);
+    uint32_t capacity = table ? table->capacity : 0;
+
+    for (uint32_t i = 0; i < capacity; i++) {
+        if (entry_object(rcu_dereference(table->entries[i])) == obj) {
+            return true;
+        }
+    }
+    return false;
+}
+
+error_t HandleTable::close(int handle) {
+    KObject* obj = nullptr;
+
+    {
+        ScopedLock guard(lock);
+        if (slots && handle >= 0 && (uint32_t)handle < slots->capacity) {
+            obj = entry_object(slots->entries[handle]);
+            rcu_assign_pointer(slots->entries[handle], (uint64_t)0);
+            if ((uint32_t)handle < next_free) {
+                next_free = handle;
+            }
+        }
+    }
+
+    if (!obj) {
+        return E_NOENT;
+    }
+    kobject_put(obj);
+    return E_OK;
+}
+
+void HandleTable::close_all() {
+    Slots* table;
+
+    {
+        ScopedLock guard(lock);
+        table = slots;
+        rcu_assign_pointer(slots, (Slots*)nullptr);
+        next_free = 0;
+    }
+
+    if (!table) {
+        return;
+    }
+
+    for (uint32_t i = 0; i < table->capacity; i++) {
+        if (table->entries[i]) {
+            kobject_put(entry_object(table->entries[i]));
+        }
+    }
+    call_rcu(&table->rcu, free_slots);
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,469 @@
+#include <kernel/ipc/io_ring.h>
+#include <kernel/ipc/ipc.h>
+#include <kernel/ipc/memory_object.h>
+#include <kernel/block/block.h>
+#include <kernel/process/process.h>
+#include <kernel/process/scheduler.h>
+#include <kernel/memory/pmm.h>
+#include <kernel/memory/vmm.h>
+#include <kernel/memory/slab.h>
+#include <kernel/memory/copy.h>
+#include <kernel/time/timer.h>
+#include <kernel/arch/x86_64/pit.h>
+#include <kernel/arch/x86_64/tlb.h>
+
+namespace Core {
+
+// The polling thread spins (yielding) this long without work before it
+// sleeps and asks for an explicit wakeup.
+#define POLL_IDLE_MS 10
+
+// Sends that find no receiver waiting stay queued on the endpoint and
+// complete when one arrives.
+struct IoSend {
+    IpcPendingSend pending;
+    IoRing* ring;
+    uint64_t user_data;
+};
+
+static ObjectCache ring_cache("io_ring", sizeof(IoRing));
+static ObjectCache send_cache("io_send", sizeof(IoSend));
+
+struct IoTimeout {
+    Timer timer;
+    IoRing* ring;
+    uint64_t user_data;
+};
+
+static ObjectCache timeout_cache("io_timeout", sizeof(IoTimeout));
+
+// The memory object stays pinned and referenced until the device is done
+// with its page.
+struct IoBlock {
+    Bio bio;
+    IoRing* ring;
+    MemoryObject* mem;
+    uint64_t user_data;
+};
+
+static ObjectCache block_cache("io_block", sizeof(IoBlock));
+
+static void post(IoRing* ring, uint64_t user_data, int64_t result) {
+    IoRingShared* shared = ring->shared;
+
+    uint64_t flags = ring->cq_lock.lock_irqsave();
+    uint32_t tail = ring->cq_tail;
+    if (tail - __atomic_load_n(&shared->cq_head, __ATOMIC_ACQUIRE) >= ring->cq_entries) {
+        __atomic_fetch_add(&shared->cq_overflow, 1, __ATOMIC_RELAXED);
+    } else {
+        ring->cqes[tail & (ring->cq_entries - 1)] = {user_data, result};
+        __atomic_store_n(&ring->cq_tail, tail + 1, __ATOMIC_RELEASE);
+        __atomic_store_n(&shared->cq_tail, tail + 1, __ATOMIC_RELEASE);
+    }
+    ring->cq_lock.unlock_irqrestore(flags);
+
+    // Orders the cq_tail store before the waiter check; pairs with the
+    // fence in prepare_to_wait().
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (!ring->cq_wait.is_empty()) {
+        ring->cq_wait.wake_all();
+    }
+}
+
+static void send_done(IpcPendingSend* pending, error_t result) {
+    IoSend* send = (IoSend*)((uint8_t*)pending - offsetof(IoSend, pending));
+
+    post(send->ring, send->user_data, result);
+    io_ring_put(send->ring);
+    send_cache.free(send);
+}
+
+static void op_ipc_send(IoRing* ring, HandleTable* handles, const IoSqe& sqe) {
+    KObject* obj = handles->get(sqe.handle, ObjectType::ENDPOINT);
+    if (!obj) {
+        post(ring, sqe.user_data, E_INVAL);
+        return;
+    }
+    Endpoint* ep = (Endpoint*)((uint8_t*)obj - offsetof(Endpoint, obj));
+
+    IoSend* send = (IoSend*)send_cache.alloc();
+    if (!send) {
+        endpoint_put(ep);
+        post(ring, sqe.user_data, E_NOMEM);
+        return;
+    }
+
+    send->pending.msg.label = sqe.args[0];
+    for (uint32_t i = 0; i < IPC_MSG_WORDS; i++) {
+        send->pending.msg.words[i] = sqe.args[1 + i];
+    }
+    send->pending.done = send_done;
+    send->ring = ring;
+    send->user_data = sqe.user_data;
+
+    // The reference is taken first: a receiver may complete the send as
+    // soon as it is queued.
+    kobject_get(&ring->obj);
+    if (ipc_send_async(ep, &send->pending) == E_OK) {
+        send_done(&send->pending, E_OK);
+    }
+    endpoint_put(ep);
+}
+
+static void timeout_fired(Timer* timer) {
+    IoTimeout* timeout = (IoTimeout*)((uint8_t*)timer - offsetof(IoTimeout, timer));
+
+    post(timeout->ring, timeout->user_data, E_OK);
+    io_ring_put(timeout->ring);
+    timeout_cache.free(timeout);
+}
+
+static void op_timeout(IoRing* ring, const IoSqe& sqe) {
+    IoTimeout* timeout = (IoTimeout*)timeout_cache.zalloc();
+    if (!timeout) {
+        post(ring, sqe.user_data, E_NOMEM);
+        return;
+    }
+
+    // PIT ticks are milliseconds; never fire early.
+    uint64_t ticks = MAX((sqe.args[0] + 999999) / 1000000, 1ULL);
+
+    timeout->timer.func = timeout_fired;
+    timeout->ring = ring;
+    timeout->user_data = sqe.user_data;
+    kobject_get(&ring->obj);
+    Timer::add(&timeout->timer, PIT::get_ticks() + ticks);
+}
+
+static void block_done(Bio* bio) {
+    IoBlock* io = (IoBlock*)((uint8_t*)bio - offsetof(IoBlock, bio));
+
+    post(io->ring, io->user_data, bio->result);
+    memory_object_unpin(io->mem);
+    memory_object_put(io->mem);
+    io_ring_put(io->ring);
+    block_cache.free(io);
+}
+
+static BlockDevice* find_device(uint64_t index) {
+    BlockDevice* dev = Block::get_devices();
+    while (dev && index--) {
+        dev = dev->next;
+    }
+    return dev;
+}
+
+static void op_block(IoRing* ring, HandleTable* handles, const IoSqe& sqe, BlockOp op) {
+    // Reading from the device writes the pages, and writing reads them.
+    uint32_t rights = op == BlockOp::READ ? RIGHT_WRITE : RIGHT_READ;
+    KObject* obj = handles->get(sqe.handle, ObjectType::MEMORY, rights);
+    BlockDevice* dev = find_device(sqe.args[0]);
+    if (!obj || !dev) {
+        if (obj) kobject_put(obj);
+        post(ring, sqe.user_data, obj ? E_NOENT : E_INVAL);
+        return;
+    }
+    MemoryObject* mem = (MemoryObject*)((uint8_t*)obj - offsetof(MemoryObject, obj));
+
+    IoBlock* io = (IoBlock*)block_cache.zalloc();
+    uint64_t phys = io ? memory_object_pin(mem, sqe.args[2]) : 0;
+    if (!phys) {
+        block_cache.free(io);
+        memory_object_put(mem);
+        post(ring, sqe.user_data, io ? E_INVAL : E_NOMEM);
+        return;
+    }
+
+    io->bio.op = op;
+    io->bio.sector = sqe.args[1];
+    io->bio.phys = phys;
+    io->bio.len = PAGE_SIZE;
+    io->bio.done = block_done;
+    io->ring = ring;
+    io->mem = mem;
+    io->user_data = sqe.user_data;
+    kobject_get(&ring->obj);
+    Block::submit(dev, &io->bio);
+}
+
+// Pages waiting to be mapped are chained through their own first word,
+// which is cleared again as each one is mapped.
+static void free_page_list(uint64_t list) {
+    while (list) {
+        uint64_t next = *(uint64_t*)(list + KERNEL_VIRTUAL_BASE);
+        PMM::free_page(list);
+        list = next;
+    }
+}
+
+// Pages are allocated and zeroed before user_map_lock is taken, so the
+// locked part only checks the range and writes PTEs. Its page tables are
+// populated first, so nothing that was mapped ever needs rolling back.
+static error_t op_map(uint64_t addr, uint64_t length) {
+    if (!VMM::is_user_range(addr, length) || length > IO_MAP_MAX) {
+        return E_INVAL;
+    }
+
+    uint64_t list = 0;
+    for (uint64_t offset = 0; offset < length; offset += PAGE_SIZE) {
+        uint64_t phys = PMM::alloc_page();
+        if (!phys) {
+            free_page_list(list);
+            return E_NOMEM;
+        }
+        uint64_t* page = (uint64_t*)(phys + KERNEL_VIRTUAL_BASE);
+        zero_pages(page, 1);
+        page[0] = list;
+        list = phys;
+    }
+
+    error_t err = E_OK;
+    {
+        ScopedLock guard(VMM::user_map_lock);
+        if (!VMM::is_range_free(addr, length)) {
+            err = E_BUSY;
+        } else if (!VMM::populate_tables(addr, length)) {
+            err = E_NOMEM;
+        }
+        for (uint64_t offset = 0; err == E_OK && offset < length; offset += PAGE_SIZE) {
+            uint64_t* page = (uint64_t*)(list + KERNEL_VIRTUAL_BASE);
+            uint64_t phys = list;
+            list = page[0];
+            page[0] = 0;
+            VMM::set_pte(addr + offset, phys, VMM::PRESENT | VMM::WRITABLE | VMM::USER | VMM::ANONYMOUS);
+        }
+    }
+
+    free_page_list(list);
+    return err;
+}
+
+// Only pages this op allocated are freed; memory-object mappings in the
+// range are left alone. Pages go back to the PMM after each batched flush.
+static error_t op_unmap(uint64_t addr, uint64_t length) {
+    if (!VMM::is_user_range(addr, length)) {
+        return E_INVAL;
+    }
+
+    uint64_t offset = 0;
+    while (offset < length) {
+        TLB::Batch batch = {};
+        uint64_t freed[TLB::BATCH_PAGES];
+
+        {
+            ScopedLock guard(VMM::user_map_lock);
+            for (; offset < length && batch.count < TLB::BATCH_PAGES; offset += PAGE_SIZE) {
+                if (VMM::get_pte(addr + offset) & VMM::ANONYMOUS) {
+                    freed[batch.count] = VMM::clear_pte(addr + offset) & VMM::ADDRESS_MASK;
+                    TLB::add(&batch, addr + offset);
+                }
+            }
+        }
+
+        uint32_t count = batch.count;
+        TLB::flush(&batch);
+        for (uint32_t i = 0; i < count; i++) {
+            PMM::free_page(freed[i]);
+        }
+    }
+    return E_OK;
+}
+
+static void execute(IoRing* ring, HandleTable* handles, const IoSqe& sqe) {
+    switch (sqe.opcode) {
+        case IO_OP_NOP:
+            post(ring, sqe.user_data, E_OK);
+            break;
+        case IO_OP_IPC_SEND:
+            op_ipc_send(ring, handles, sqe);
+            break;
+        case IO_OP_TIMEOUT:
+            op_timeout(ring, sqe);
+            break;
+        case IO_OP_MAP:
+            post(ring, sqe.user_data, op_map(sqe.args[0], sqe.args[1]));
+            break;
+        case IO_OP_UNMAP:
+            post(ring, sqe.user_data, op_unmap(sqe.args[0], sqe.args[1]));
+            break;
+        case IO_OP_BLOCK_READ:
+            op_block(ring, handles, sqe, BlockOp::READ);
+            break;
+        case IO_OP_BLOCK_WRITE:
+            op_block(ring, handles, sqe, BlockOp::WRITE);
+            break;
+        default:
+            post(ring, sqe.user_data, E_INVAL);
+            break;
+    }
+}
+
+// Caller is the only consumer of the SQ: it holds submit_lock, or is the
+// polling thread. SQE handles are looked up in `handles`. Block I/O in one
+// batch is plugged, so adjacent SQEs reach the device as merged requests.
+static uint32_t submit(IoRing* ring, HandleTable* handles, uint32_t max) {
+    IoRingShared* shared = ring->shared;
+    uint32_t tail = __atomic_load_n(&shared->sq_tail, __ATOMIC_ACQUIRE);
+    uint32_t count = MIN(MIN(tail - ring->sq_head, ring->sq_entries), max);
+
+    BlockPlug plug;
+    Block::start_plug(&plug);
+    for (uint32_t i = 0; i < count; i++) {
+        // Userspace may scribble on the slot at any time; work on a copy.
+        IoSqe sqe = ring->sqes[ring->sq_head++ & (ring->sq_entries - 1)];
+        execute(ring, handles, sqe);
+    }
+    Block::finish_plug(&plug);
+
+    if (count) {
+        __atomic_store_n(&shared->sq_head, ring->sq_head, __ATOMIC_RELEASE);
+    }
+    return count;
+}
+
+static bool sq_pending(IoRing* ring) {
+    return __atomic_load_n(&ring->shared->sq_tail, __ATOMIC_ACQUIRE) != ring->sq_head;
+}
+
+static void free_ring_rcu(RcuHead* head) {
+    ring_cache.free((uint8_t*)head - offsetof(IoRing, obj.rcu));
+}
+
+static void teardown_work(Work* work) {
+    IoRing* ring = (IoRing*)((uint8_t*)work - offsetof(IoRing, teardown));
+
+    if (ring->owner) {
+        ProcessManager::put(ring->owner);
+    }
+    SharedMemory::free(&ring->region);
+    call_rcu(&ring->obj.rcu, free_ring_rcu);
+}
+
+// The region's shootdown has to wait for the other CPUs, and the last
+// reference may go from reap with interrupts off, so the ring is freed
+// from the system workqueue.
+static void free_ring(IoRing* ring) {
+    ring->teardown.func = teardown_work;
+    WorkQueue::system()->queue(&ring->teardown);
+}
+
+static void* poll_main(void* arg) {
+    IoRing* ring = (IoRing*)arg;
+    IoRingShared* shared = ring->shared;
+    uint64_t idle_since = PIT::get_ticks();
+
+    while (true) {
+        // Handle lookups go through the owner's table. The ring holds a
+        // reference on the owner, so the table outlives its threads; it is
+        // simply empty once the owner has exited.
+        bool stopping = __atomic_load_n(&ring->stopping, __ATOMIC_ACQUIRE);
+        uint32_t done = stopping ? 0 : submit(ring, &ring->owner->handles, ring->sq_entries);
+
+        if (stopping) {
+            break;
+        }
+        if (done || PIT::get_ticks() - idle_since < POLL_IDLE_MS) {
+            if (done) {
+                idle_since = PIT::get_ticks();
+            }
+            Scheduler::yield();
+            continue;
+        }
+
+        // Pairs with the fence in IoRingClient::needs_wakeup().
+        __atomic_fetch_or(&shared->flags, IO_RING_NEED_WAKEUP, __ATOMIC_RELAXED);
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        ring->sq_wait.wait_event([ring] {
+            return sq_pending(ring) || __atomic_load_n(&ring->stopping, __ATOMIC_ACQUIRE);
+        });
+        __atomic_fetch_and(&shared->flags, ~IO_RING_NEED_WAKEUP, __ATOMIC_RELAXED);
+        idle_since = PIT::get_ticks();
+    }
+
+    free_ring(ring);
+    return nullptr;
+}
+
+// Every in-flight operation holds a reference, so this only runs once
+// nothing can post to the ring any more.
+static void release_ring(KObject* obj) {
+    IoRing* ring = (IoRing*)((uint8_t*)obj - offsetof(IoRing, obj));
+
+    if (ring->poll_thread) {
+        __atomic_store_n(&ring->stopping, true, __ATOMIC_RELEASE);
+        ring->sq_wait.wake_all();
+        return;
+    }
+    free_ring(ring);
+}
+
+IoRing* io_ring_create(uint32_t entries, uint32_t flags) {
+    if (!entries || (entries & (entries - 1)) || entries > IO_RING_MAX_ENTRIES || (flags & ~IO_RING_SQPOLL)) {
+        return nullptr;
+    }
+
+    uint32_t cq_entries = entries * 2;
+    size_t sq_bytes = ALIGN_UP(entries * sizeof(IoSqe), PAGE_SIZE);
+    size_t cq_bytes = ALIGN_UP(cq_entries * sizeof(IoCqe), PAGE_SIZE);
+
+    IoRing* ring = (IoRing*)ring_cache.zalloc();
+    if (!ring) {
+        return nullptr;
+    }
+
+    if (!SharedMemory::alloc(&ring->region, PAGE_SIZE + sq_bytes + cq_bytes)) {
+        ring_cache.free(ring);
+        return nullptr;
+    }
+
+    ring->sq_entries = entries;
+    ring->cq_entries = cq_entries;
+    ring->sqes = (IoSqe*)((uint8_t*)ring->region.kernel + PAGE_SIZE);
+    ring->cqes = (IoCqe*)((uint8_t*)ring->region.kernel + PAGE_SIZE + sq_bytes);
+    ring->shared = (IoRingShared*)ring->region.kernel;
+    ring->shared->sq_entries = entries;
+    ring->shared->cq_entries = cq_entries;
+    ring->shared->sq_offset = PAGE_SIZE;
+    ring->shared->cq_offset = PAGE_SIZE + sq_bytes;
+    ring->cq_lock.set_name("io_ring_cq");
+    kobject_init(&ring->obj, ObjectType::IO_RING, release_ring);
+
+    if (flags & IO_RING_SQPOLL) {
+        ring->owner = ProcessManager::get_current();
+        ProcessManager::get(ring->owner);
+        ring->poll_thread = ProcessManager::create_kernel_thread("io_ring_sq", poll_main, ring);
+        if (!ring->poll_thread) {
+            free_ring(ring);
+            return nullptr;
+        }
+    }
+
+    return ring;
+}
+
+int io_ring_enter(IoRing* ring, uint32_t to_submit, uint32_t min_complete, uint32_t flags) {
+    int submitted = 0;
+
+    if (ring->poll_thread) {
+        if (flags & IO_ENTER_SQ_WAKEUP) {
+            ring->sq_wait.wake_all();
+        }
+    } else if (to_submit) {
+        ScopedMutex guard(ring->submit_lock);
+        submitted = submit(ring, &ProcessManager::get_current()->handles, to_submit);
+    }
+
+    if ((flags & IO_ENTER_GETEVENTS) && min_complete) {
+        IoRingShared* shared = ring->shared;
+        min_complete = MIN(min_complete, ring->cq_entries);
+        ring->cq_wait.wait_event([ring, shared, min_complete] {
+            return __atomic_load_n(&ring->cq_tail, __ATOMIC_ACQUIRE) -
+                   __atomic_load_n(&shared->cq_head, __ATOMIC_ACQUIRE) >= min_complete;
+        });
+    }
+
+    return submitted;
+}
+
+
+}
\ No newline at end of file
@@ -0,0 +1,305 @@
+#include <kernel/ipc/ipc.h>
+#include <kernel/process/process.h>
+#include <kernel/process/scheduler.h>
+#include <kernel/memory/slab.h>
+#include <kernel/arch/x86_64/cpu.h>
+
+namespace Core {
+
+static ObjectCache endpoint_cache("endpoint", sizeof(Endpoint));
+static bool direct_switch = true;
+
+static void free_endpoint(RcuHead* head) {
+    endpoint_cache.free((uint8_t*)head - offsetof(Endpoint, obj.rcu));
+}
+
+// Nobody can receive any more, so pending sends fail.
+static void release_endpoint(KObject* obj) {
+    Endpoint* ep = (Endpoint*)((uint8_t*)obj - offsetof(Endpoint, obj));
+
+    while (ep->pending) {
+        IpcPendingSend* send = ep->pending;
+        ep->pending = send->next;
+        send->done(send, E_NOENT);
+    }
+    call_rcu(&obj->rcu, free_endpoint);
+}
+
+Endpoint* endpoint_create() {
+    Endpoint* ep = (Endpoint*)endpoint_cache.zalloc();
+    if (!ep) {
+        return nullptr;
+    }
+
+    kobject_init(&ep->obj, ObjectType::ENDPOINT, release_endpoint);
+    ep->lock.set_name("endpoint");
+    return ep;
+}
+
+void ipc_set_direct_switch(bool enabled) {
+    direct_switch = enabled;
+}
+
+static void enqueue(Thread*& head, Thread*& tail, Thread* thread) {
+    thread->ipc_next = nullptr;
+    if (tail) {
+        tail->ipc_next = thread;
+    } else {
+        head = thread;
+    }
+    tail = thread;
+}
+
+static Thread* dequeue(Thread*& head, Thread*& tail) {
+    Thread* thread = head;
+    if (thread) {
+        head = thread->ipc_next;
+        if (!head) {
+            tail = nullptr;
+        }
+    }
+    return thread;
+}
+
+// Runs `target`, a blocked thread this CPU now owns, while the current
+// thread stays blocked. When both live on this CPU the run queue is skipped
+// entirely. Called with interrupts off.
+static void handoff(Thread* target) {
+    if (direct_switch && target->cpu == CPU::id()) {
+        Scheduler::switch_to(target);
+    } else {
+        Scheduler::wake(target);
+        Scheduler::schedule();
+    }
+}
+
+// Queues the current thread on `head` and sleeps until a partner completes
+// the transfer. Called with ep->lock held and interrupts off; drops the lock.
+static error_t block_on(Endpoint* ep, Thread*& head, Thread*& tail, IpcMessage* buffer,
+                        bool is_call) {
+    Thread* current = CPU::local()->current_thread;
+
+    current->ipc_buffer = buffer;
+    current->ipc_is_call = is_call;
+    current->ipc_result = E_OK;
+    current->state = Thread::State::BLOCKED;
+    enqueue(head, tail, current);
+
+    ep->lock.unlock();
+    Scheduler::schedule();
+    return current->ipc_result;
+}
+
+// Takes a queued sender's message. A caller stays blocked and becomes the
+// current thread's reply target; a plain sender is returned for waking.
+static Thread* take_message(Thread* sender, IpcMessage* msg) {
+    Thread* current = CPU::local()->current_thread;
+
+    *msg = *sender->ipc_buffer;
+    if (sender->ipc_is_call) {
+        current->ipc_caller = sender;
+        return nullptr;
+    }
+
+    current->ipc_caller = nullptr;
+    sender->ipc_result = E_OK;
+    return sender;
+}
+
+// Takes the oldest pending asynchronous send, if any. Called with ep->lock
+// held; the caller runs its done() after dropping the lock.
+static IpcPendingSend* take_pending(Endpoint* ep, IpcMessage* msg) {
+    IpcPendingSend* send = ep->pending;
+    if (send) {
+        ep->pending = send->next;
+        if (!ep->pending) {
+            ep->pending_tail = nullptr;
+        }
+        *msg = send->msg;
+        CPU::local()->current_thread->ipc_caller = nullptr;
+    }
+    return send;
+}
+
+// Hands a one-way message to a receiver taken off the endpoint and drops
+// the lock taken with `flags`.
+static void deliver(Endpoint* ep, Thread* receiver, const IpcMessage* msg, uint64_t flags) {
+    *receiver->ipc_buffer = *msg;
+    receiver->ipc_caller = nullptr;
+    receiver->ipc_result = E_OK;
+    ep->lock.unlock();
+
+    Scheduler::wake(receiver);
+    CPU::irq_restore(flags);
+}
+
+error_t ipc_send(Endpoint* ep, const IpcMessage* msg) {
+    uint64_t flags = ep->lock.lock_irqsave();
+
+    Thread* receiver = dequeue(ep->receivers, ep->receivers_tail);
+    if (!receiver) {
+        error_t err = block_on(ep, ep->senders, ep->senders_tail, (IpcMessage*)msg, false);
+        CPU::irq_restore(flags);
+        return err;
+    }
+
+    deliver(ep, receiver, msg, flags);
+    return E_OK;
+}
+
+error_t ipc_try_send(Endpoint* ep, const IpcMessage* msg) {
+    uint64_t flags = ep->lock.lock_irqsave();
+
+    Thread* receiver = dequeue(ep->receivers, ep->receivers_tail);
+    if (!receiver) {
+        ep->lock.unlock_irqrestore(flags);
+        return E_AGAIN;
+    }
+
+    deliver(ep, receiver, msg, flags);
+    return E_OK;
+}
+
+error_t ipc_send_async(Endpoint* ep, IpcPendingSend* send) {
+    uint64_t flags = ep->lock.lock_irqsave();
+
+    Thread* receiver = dequeue(ep->receivers, ep->receivers_tail);
+    if (!receiver) {
+        send->next = nullptr;
+        if (ep->pending_tail) {
+            ep->pending_tail->next = send;
+        } else {
+            ep->pending = send;
+        }
+        ep->pending_tail = send;
+        ep->lock.unlock_irqrestore(flags);
+        return E_AGAIN;
+    }
+
+    deliver(ep, receiver, &send->msg, flags);
+    return E_OK;
+}
+
+error_t ipc_receive(Endpoint* ep, IpcMessage* msg) {
+    uint64_t flags = ep->lock.lock_irqsave();
+
+    Thread* sender = dequeue(ep->senders, ep->senders_tail);
+    if (!sender) {
+        IpcPendingSend* send = take_pending(ep, msg);
+        if (send) {
+            ep->lock.unlock_irqrestore(flags);
+            send->done(send, E_OK);
+            return E_OK;
+        }
+
+        CPU::local()->current_thread->ipc_caller = nullptr;
+        error_t err = block_on(ep, ep->receivers, ep->receivers_tail, msg, false);
+        CPU::irq_restore(flags);
+        return err;
+    }
+
+    Thread* wake = take_message(sender, msg);
+    ep->lock.unlock();
+
+    if (wake) {
+        Scheduler::wake(wake);
+    }
+    CPU::irq_restore(flags);
+    return E_OK;
+}
+
+error_t ipc_call(Endpoint* ep, IpcMessage* msg) {
+    Thread* current = CPU::local()->current_thread;
+    uint64_t flags = ep->lock.lock_irqsave();
+
+    Thread* receiver = dequeue(ep->receivers, ep->receivers_tail);
+    if (!receiver) {
+        error_t err = block_on(ep, ep->senders, ep->senders_tail, msg, true);
+        CPU::irq_restore(flags);
+        return err;
+    }
+
+    // Fastpath: a server is already waiting, so deliver and switch to it.
+    *receiver->ipc_buffer = *msg;
+    receiver->ipc_caller = current;
+    receiver->ipc_result = E_OK;
+
+    current->ipc_buffer = msg;
+    current->ipc_is_call = true;
+    current->ipc_result = E_OK;
+    current->state = Thread::State::BLOCKED;
+    ep->lock.unlock();
+
+    handoff(receiver);
+    CPU::irq_restore(flags);
+    return current->ipc_result;
+}
+
+// Only the thread holding the reply right touches the blocked caller, so no
+// lock is needed to deliver into its buffer.
+static Thread* deliver_reply(const IpcMessage* msg) {
+    Thread* current = CPU::local()->current_thread;
+    Thread* caller = current->ipc_caller;
+
+    if (caller) {
+        current->ipc_caller = nullptr;
+        *caller->ipc_buffer = *msg;
+        caller->ipc_result = E_OK;
+    }
+    return caller;
+}
+
+error_t ipc_reply(const IpcMessage* msg) {
+    Thread* caller = deliver_reply(msg);
+    if (!caller) {
+        return E_INVAL;
+    }
+
+    Scheduler::wake(caller);
+    return E_OK;
+}
+
+error_t ipc_reply_wait(Endpoint* ep, IpcMessage* msg) {
+    Thread* caller = deliver_reply(msg);
+    uint64_t flags = ep->lock.lock_irqsave();
+
+    Thread* sender = dequeue(ep->senders, ep->senders_tail);
+    if (sender) {
+        // More work is already queued: take it without blocking.
+        Thread* wake = take_message(sender, msg);
+        ep->lock.unlock();
+
+        if (wake) Scheduler::wake(wake);
+        if (caller) Scheduler::wake(caller);
+        CPU::irq_restore(flags);
+        return E_OK;
+    }
+
+    IpcPendingSend* send = take_pending(ep, msg);
+    if (send) {
+        ep->lock.unlock();
+
+        if (caller) Scheduler::wake(caller);
+        CPU::irq_restore(flags);
+        send->done(send, E_OK);
+        return E_OK;
+    }
+
+    Thread* current = CPU::local()->current_thread;
+    current->ipc_buffer = msg;
+    current->ipc_is_call = false;
+    current->ipc_result = E_OK;
+    current->state = Thread::State::BLOCKED;
+    enqueue(ep->receivers, ep->receivers_tail, current);
+    ep->lock.unlock();
+
+    if (caller) {
+        handoff(caller);
+    } else {
+        Scheduler::schedule();
+    }
+    CPU::irq_restore(flags);
+    return current->ipc_result;
+}
+
+}
\ No newline at end of file
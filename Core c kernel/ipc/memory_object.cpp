@@ -0,0 +1,297 @@
+#include <kernel/ipc/memory_object.h>
+#include <kernel/memory/pmm.h>
+#include <kernel/memory/vmm.h>
+#include <kernel/memory/heap.h>
+#include <kernel/memory/slab.h>
+#include <kernel/memory/copy.h>
+#include <kernel/arch/x86_64/tlb.h>
+#include <kernel/process/process.h>
+
+namespace Core {
+
+static ObjectCache object_cache("memory_object", sizeof(MemoryObject));
+
+static uint32_t pte_flags(bool writable) {
+    return VMM::PRESENT | VMM::USER | (writable ? (uint32_t)VMM::WRITABLE : 0);
+}
+
+static void clear_mapping(MemoryObject* mem, MemoryMapping* mapping, TLB::Batch* batch) {
+    for (size_t i = 0; i < mem->page_count; i++) {
+        uint64_t virt = mapping->addr + i * PAGE_SIZE;
+        VMM::clear_pte(virt);
+        TLB::add(batch, virt);
+    }
+}
+
+// The page array of a large object is far bigger than the kernel heap, so
+// it takes whole pages of its own.
+static size_t array_pages(size_t page_count) {
+    return ALIGN_UP(page_count * sizeof(uint64_t), PAGE_SIZE) / PAGE_SIZE;
+}
+
+static uint64_t* alloc_page_array(size_t page_count) {
+    uint64_t phys = PMM::alloc_pages(array_pages(page_count));
+    return phys ? (uint64_t*)(phys + KERNEL_VIRTUAL_BASE) : nullptr;
+}
+
+static void free_page_array(uint64_t* pages, size_t page_count) {
+    if (pages) {
+        PMM::free_pages((uint64_t)pages - KERNEL_VIRTUAL_BASE, array_pages(page_count));
+    }
+}
+
+static void free_object(RcuHead* head) {
+    object_cache.free((uint8_t*)head - offsetof(MemoryObject, obj.rcu));
+}
+
+// The last reference may go from a context that cannot wait for a TLB
+// shootdown, so the pages are released from the system workqueue.
+static void teardown_work(Work* work) {
+    MemoryObject* mem = (MemoryObject*)((uint8_t*)work - offsetof(MemoryObject, teardown));
+    TLB::Batch batch = {};
+
+    while (mem->mappings) {
+        MemoryMapping* mapping = mem->mappings;
+        mem->mappings = mapping->next;
+        clear_mapping(mem, mapping, &batch);
+        Heap::free(mapping);
+    }
+    TLB::flush(&batch);
+
+    for (size_t i = 0; i < mem->page_count; i++) {
+        PMM::free_page(mem->pages[i]);
+    }
+    free_page_array(mem->pages, mem->page_count);
+
+    call_rcu(&mem->obj.rcu, free_object);
+}
+
+static void release_object(KObject* obj) {
+    MemoryObject* mem = (MemoryObject*)((uint8_t*)obj - offsetof(MemoryObject, obj));
+
+    mem->teardown.func = teardown_work;
+    WorkQueue::system()->queue(&mem->teardown);
+}
+
+static MemoryObject* alloc_object(uint64_t* pages, size_t page_count) {
+    MemoryObject* mem = (MemoryObject*)object_cache.zalloc();
+    if (!mem) {
+        return nullptr;
+    }
+
+    mem->pages = pages;
+    mem->page_count = page_count;
+    kobject_init(&mem->obj, ObjectType::MEMORY, release_object);
+    return mem;
+}
+
+MemoryObject* memory_object_create(size_t size) {
+    if (!size || size > MEMORY_OBJECT_MAX_SIZE) {
+        return nullptr;
+    }
+
+    size_t page_count = ALIGN_UP(size, PAGE_SIZE) / PAGE_SIZE;
+    uint64_t* pages = alloc_page_array(page_count);
+    if (!pages) {
+        return nullptr;
+    }
+
+    for (size_t i = 0; i < page_count; i++) {
+        pages[i] = PMM::alloc_page();
+        if (!pages[i]) {
+            while (i--) PMM::free_page(pages[i]);
+            free_page_array(pages, page_count);
+            return nullptr;
+        }
+        zero_pages((void*)(pages[i] + KERNEL_VIRTUAL_BASE), 1);
+    }
+
+    MemoryObject* mem = alloc_object(pages, page_count);
+    if (!mem) {
+        for (size_t i = 0; i < page_count; i++) PMM::free_page(pages[i]);
+        free_page_array(pages, page_count);
+    }
+    return mem;
+}
+
+// Installs PTEs for a new mapping; nothing was mapped there before, so no
+// TLB entries need invalidating. Caller holds mem->lock.
+static error_t add_mapping(MemoryObject* mem, uint64_t addr, bool writable) {
+    size_t length = mem->page_count * PAGE_SIZE;
+    if (!length || !VMM::is_user_range(addr, length)) {
+        return E_INVAL;
+    }
+
+    MemoryMapping* mapping = (MemoryMapping*)Heap::malloc(sizeof(MemoryMapping));
+    if (!mapping) {
+        return E_NOMEM;
+    }
+
+    {
+        ScopedLock guard(VMM::user_map_lock);
+        if (!VMM::is_range_free(addr, length)) {
+            Heap::free(mapping);
+            return E_BUSY;
+        }
+        for (size_t i = 0; i < mem->page_count; i++) {
+            VMM::set_pte(addr + i * PAGE_SIZE, mem->pages[i], pte_flags(writable));
+        }
+    }
+
+    mapping->addr = addr;
+    mapping->owner = ProcessManager::get_current()->get_pid();
+    mapping->writable = writable;
+    mapping->next = mem->mappings;
+    mem->mappings = mapping;
+    return E_OK;
+}
+
+error_t memory_object_map(MemoryObject* mem, uint64_t addr, bool writable) {
+    ScopedMutex guard(mem->lock);
+    return add_mapping(mem, addr, writable);
+}
+
+error_t memory_object_unmap(MemoryObject* mem, uint64_t addr, int owner) {
+    TLB::Batch batch = {};
+    MemoryMapping* mapping = nullptr;
+
+    {
+        ScopedMutex guard(mem->lock);
+        MemoryMapping** link = &mem->mappings;
+        while (*link && (*link)->addr != addr) {
+            link = &(*link)->next;
+        }
+        if (!*link) {
+            return E_NOENT;
+        }
+        if (owner >= 0 && (*link)->owner != owner) {
+            return E_PERM;
+        }
+
+        mapping = *link;
+        *link = mapping->next;
+        clear_mapping(mem, mapping, &batch);
+        TLB::flush(&batch);
+    }
+
+    Heap::free(mapping);
+    return E_OK;
+}
+
+error_t memory_object_transfer(MemoryObject* mem, uint64_t dest, MemoryObject** result) {
+    ScopedMutex guard(mem->lock);
+
+    if (!mem->page_count) {
+        return E_INVAL;
+    }
+    if (__atomic_load_n(&mem->io_pins, __ATOMIC_ACQUIRE)) {
+        return E_BUSY;
+    }
+
+    MemoryObject* moved = alloc_object(mem->pages, mem->page_count);
+    if (!moved) {
+        return E_NOMEM;
+    }
+
+    // Tear the old mappings down first so the destination may overlap one
+    // of them; only one flush is needed for both halves.
+    TLB::Batch batch = {};
+    for (MemoryMapping* mapping = mem->mappings; mapping; mapping = mapping->next) {
+        clear_mapping(mem, mapping, &batch);
+    }
+
+    if (dest) {
+        error_t err = add_mapping(moved, dest, true);
+        if (err != E_OK) {
+            for (MemoryMapping* mapping = mem->mappings; mapping; mapping = mapping->next) {
+                for (size_t i = 0; i < mem->page_count; i++) {
+                    VMM::set_pte(mapping->addr + i * PAGE_SIZE, mem->pages[i], pte_flags(mapping->writable));
+                }
+            }
+            object_cache.free(moved);
+            return err;
+        }
+    }
+    TLB::flush(&batch);
+
+    // The mapping records stay, so a transfer that can't be delivered can
+    // put them back; with no pages they map nothing meanwhile.
+    mem->pages = nullptr;
+    mem->page_count = 0;
+
+    *result = moved;
+    return E_OK;
+}
+
+void memory_object_finish_transfer(MemoryObject* mem) {
+    MemoryMapping* list;
+    {
+        ScopedMutex guard(mem->lock);
+        list = mem->mappings;
+        mem->mappings = nullptr;
+    }
+
+    while (list) {
+        MemoryMapping* mapping = list;
+        list = mapping->next;
+        Heap::free(mapping);
+    }
+}
+
+void memory_object_restore(MemoryObject* mem, MemoryObject* moved) {
+    uint64_t* pages;
+    size_t page_count;
+
+    {
+        ScopedMutex guard(moved->lock);
+        TLB::Batch batch = {};
+        while (moved->mappings) {
+            MemoryMapping* mapping = moved->mappings;
+            moved->mappings = mapping->next;
+            clear_mapping(moved, mapping, &batch);
+            Heap::free(mapping);
+        }
+        TLB::flush(&batch);
+
+        pages = moved->pages;
+        page_count = moved->page_count;
+        moved->pages = nullptr;
+        moved->page_count = 0;
+    }
+
+    // The old ranges were left unmapped, but another object may have been
+    // mapped over one since; that mapping of `mem` is dropped. The PTEs
+    // were not present, so nothing needs flushing.
+    ScopedMutex guard(mem->lock);
+    mem->pages = pages;
+    mem->page_count = page_count;
+
+    MemoryMapping** link = &mem->mappings;
+    while (MemoryMapping* mapping = *link) {
+        ScopedLock map_guard(VMM::user_map_lock);
+        if (!VMM::is_range_free(mapping->addr, page_count * PAGE_SIZE)) {
+            *link = mapping->next;
+            Heap::free(mapping);
+            continue;
+        }
+        for (size_t i = 0; i < page_count; i++) {
+            VMM::set_pte(mapping->addr + i * PAGE_SIZE, pages[i], pte_flags(mapping->writable));
+        }
+        link = &mapping->next;
+    }
+}
+
+uint64_t memory_object_pin(MemoryObject* mem, size_t index) {
+    ScopedMutex guard(mem->lock);
+    if (index >= mem->page_count) {
+        return 0;
+    }
+    __atomic_fetch_add(&mem->io_pins, 1, __ATOMIC_RELAXED);
+    return mem->pages[index];
+}
+
+void memory_object_unpin(MemoryObject* mem) {
+    __atomic_fetch_sub(&mem->io_pins, 1, __ATOMIC_RELEASE);
+}
+
+}
\ No newline at end of file
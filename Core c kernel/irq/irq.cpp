@@ -0,0 +1,351 @@
+#include <kernel/irq/irq.h>
+#include <kernel/irq/softirq.h>
+#include <kernel/memory/heap.h>
+#include <kernel/sync/spinlock.h>
+#include <kernel/sync/percpu.h>
+#include <kernel/sync/rcu.h>
+#include <kernel/process/process.h>
+#include <kernel/arch/x86_64/cpu.h>
+#include <kernel/arch/x86_64/pit.h>
+#include <kernel/console.h>
+
+namespace Core {
+
+struct IrqAction {
+    irq_handler_t handler;
+    void* data;
+    const char* name;
+    uint32_t flags;
+    IrqAction* next;
+    RcuHead rcu;
+};
+
+struct IrqDesc {
+    IrqAction* actions;
+    uint64_t unhandled;
+    const IrqChip* chip;
+    uint32_t hwirq;
+    uint32_t cpu;
+    bool pinned;
+};
+
+struct IrqCounts {
+    uint64_t vectors[IRQ::NR_VECTORS];
+};
+
+// Handler chains are read locklessly from interrupt context (which is an
+// RCU read-side section) and only modified under desc_lock.
+static IrqDesc descs[IRQ::NR_VECTORS];
+static Spinlock desc_lock("irq_desc");
+static PerCpu<IrqCounts> irq_counts;
+static uint64_t vector_map[IRQ::NR_VECTORS / 64];
+
+static void free_action(RcuHead* head) {
+    Heap::free((uint8_t*)head - offsetof(IrqAction, rcu));
+}
+
+error_t request_irq(uint8_t vector, irq_handler_t handler, void* data, const char* name,
+                    uint32_t flags) {
+    if (vector < IRQ::FIRST_DEVICE_VECTOR || vector == IRQ::SPURIOUS_VECTOR || !handler) {
+        return E_INVAL;
+    }
+
+    IrqAction* action = (IrqAction*)Heap::calloc(1, sizeof(IrqAction));
+    if (!action) {
+        return E_NOMEM;
+    }
+    action->handler = handler;
+    action->data = data;
+    action->name = name;
+    action->flags = flags;
+
+    uint64_t irq_flags = desc_lock.lock_irqsave();
+
+    IrqAction** link = &descs[vector].actions;
+    if (*link && (!((*link)->flags & IRQF_SHARED) || !(flags & IRQF_SHARED))) {
+        desc_lock.unlock_irqrestore(irq_flags);
+        Heap::free(action);
+        return E_BUSY;
+    }
+    bool first = !*link;
+    while (*link) {
+        link = &(*link)->next;
+    }
+    rcu_assign_pointer(*link, action);
+
+    const IrqChip* chip = descs[vector].chip;
+    if (first && chip) {
+        chip->unmask(descs[vector].hwirq);
+    }
+
+    desc_lock.unlock_irqrestore(irq_flags);
+    return E_OK;
+}
+
+void free_irq(uint8_t vector, void* data) {
+    IrqAction* found = nullptr;
+
+    uint64_t irq_flags = desc_lock.lock_irqsave();
+    for (IrqAction** link = &descs[vector].actions; *link; link = &(*link)->next) {
+        if ((*link)->data == data) {
+            found = *link;
+            rcu_assign_pointer(*link, found->next);
+            break;
+        }
+    }
+
+    const IrqChip* chip = descs[vector].chip;
+    if (found && !descs[vector].actions && chip) {
+        chip->mask(descs[vector].hwirq);
+    }
+    desc_lock.unlock_irqrestore(irq_flags);
+
+    if (found) {
+        call_rcu(&found->rcu, free_action);
+    }
+}
+
+static error_t set_affinity_locked(uint8_t vector, uint32_t cpu) {
+    IrqDesc* desc = &descs[vector];
+    if (!desc->chip || !desc->chip->set_affinity) {
+        return E_INVAL;
+    }
+    if (desc->cpu == cpu) {
+        return E_OK;
+    }
+
+    error_t err = desc->chip->set_affinity(desc->hwirq, vector, cpu);
+    if (err == E_OK) {
+        desc->cpu = cpu;
+    }
+    return err;
+}
+
+error_t irq_set_affinity(uint8_t vector, uint32_t cpu) {
+    if (cpu >= CPU::online_count()) {
+        return E_INVAL;
+    }
+
+    uint64_t irq_flags = desc_lock.lock_irqsave();
+    error_t err = set_affinity_locked(vector, cpu);
+    if (err == E_OK) {
+        descs[vector].pinned = true;
+    }
+    desc_lock.unlock_irqrestore(irq_flags);
+
+    return err;
+}
+
+namespace IRQ {
+
+// log2 buckets of interrupt-disabled time per hard IRQ, in TSC cycles.
+static uint64_t latency_histogram[CPU::MAX_CPUS][LATENCY_BUCKETS];
+
+void enter() {
+    CPU::local()->irq_nesting++;
+}
+
+void exit(uint64_t start_tsc) {
+    CPU::Local* local = CPU::local();
+    uint64_t cycles = CPU::rdtsc() - start_tsc;
+    uint32_t bucket = cycles ? 63 - __builtin_clzll(cycles) : 0;
+
+    latency_histogram[local->id][MIN(bucket, LATENCY_BUCKETS - 1)]++;
+
+    if (--local->irq_nesting == 0 && local->preempt_count == 0 && local->softirq_pending) {
+        Softirq::run_pending();
+    }
+}
+
+bool in_interrupt() {
+    CPU::Local* local = CPU::local();
+    return local->irq_nesting > 0 || local->preempt_count > 0;
+}
+
+void dispatch(uint8_t vector) {
+    irq_counts.local().vectors[vector]++;
+
+    bool handled = false;
+    for (IrqAction* action = rcu_dereference(descs[vector].actions); action;
+         action = rcu_dereference(action->next)) {
+        handled |= action->handler(vector, action->data);
+    }
+
+    if (UNLIKELY(!handled)) {
+        descs[vector].unhandled++;
+    }
+}
+
+int alloc_vector() {
+    int vector = E_BUSY;
+
+    uint64_t irq_flags = desc_lock.lock_irqsave();
+    for (uint32_t v = FIRST_DYNAMIC_VECTOR; v <= LAST_DYNAMIC_VECTOR; v++) {
+        if (!(vector_map[v / 64] & BIT(v % 64))) {
+            vector_map[v / 64] |= BIT(v % 64);
+            vector = v;
+            break;
+        }
+    }
+    desc_lock.unlock_irqrestore(irq_flags);
+
+    return vector;
+}
+
+void free_vector(uint8_t vector) {
+    uint64_t irq_flags = desc_lock.lock_irqsave();
+    vector_map[vector / 64] &= ~BIT(vector % 64);
+    descs[vector].chip = nullptr;
+    descs[vector].pinned = false;
+    desc_lock.unlock_irqrestore(irq_flags);
+}
+
+void set_chip(uint8_t vector, const IrqChip* chip, uint32_t hwirq) {
+    uint64_t irq_flags = desc_lock.lock_irqsave();
+    descs[vector].chip = chip;
+    descs[vector].hwirq = hwirq;
+    descs[vector].cpu = 0;
+    descs[vector].pinned = false;
+    desc_lock.unlock_irqrestore(irq_flags);
+}
+
+uint32_t get_affinity(uint8_t vector) {
+    return descs[vector].cpu;
+}
+
+uint64_t get_count(uint8_t vector, uint32_t cpu) {
+    return irq_counts.get(cpu).vectors[vector];
+}
+
+uint64_t get_count(uint8_t vector) {
+    uint64_t total = 0;
+    for (uint32_t cpu = 0; cpu < CPU::online_count(); cpu++) {
+        total += get_count(vector, cpu);
+    }
+    return total;
+}
+
+void dump_stats() {
+    Console::printf("[IRQ] vector   count      unhandled  cpu  handlers\n");
+    for (uint32_t vector = FIRST_DEVICE_VECTOR; vector < NR_VECTORS; vector++) {
+        uint64_t count = get_count(vector);
+        if (!count && !descs[vector].actions) {
+            continue;
+        }
+
+        Console::printf("  %3u      %10llu %10llu %4u ", vector, count, descs[vector].unhandled,
+                        descs[vector].cpu);
+        rcu_read_lock();
+        for (IrqAction* action = rcu_dereference(descs[vector].actions); action;
+             action = rcu_dereference(action->next)) {
+            Console::printf(" %s", action->name ? action->name : "?");
+        }
+        rcu_read_unlock();
+        Console::printf("\n");
+    }
+}
+
+struct BalanceSource {
+    uint8_t vector;
+    uint64_t rate;
+};
+
+// Greedy longest-first packing: each interval the busiest sources are
+// handed out one by one to whichever CPU has the least load so far. Nothing
+// moves unless the current spread is noticeably uneven.
+static void rebalance(uint64_t* last_counts) {
+    static BalanceSource sources[NR_VECTORS];
+    uint64_t current[CPU::MAX_CPUS] = {};
+    uint64_t planned[CPU::MAX_CPUS] = {};
+    uint32_t cpus = CPU::online_count();
+    uint32_t count = 0;
+
+    for (uint32_t vector = FIRST_DEVICE_VECTOR; vector < NR_VECTORS; vector++) {
+        uint64_t total = get_count(vector);
+        uint64_t rate = total - last_counts[vector];
+        last_counts[vector] = total;
+
+        IrqDesc* desc = &descs[vector];
+        if (!desc->chip || !desc->chip->set_affinity || !desc->actions) {
+            continue;
+        }
+
+        current[desc->cpu] += rate;
+        if (desc->pinned) {
+            planned[desc->cpu] += rate;
+        } else if (rate >= BALANCE_MIN_RATE) {
+            uint32_t i = count++;
+            while (i > 0 && sources[i - 1].rate < rate) {
+                sources[i] = sources[i - 1];
+                i--;
+            }
+            sources[i] = {(uint8_t)vector, rate};
+        }
+    }
+
+    uint64_t max_load = 0, min_load = ~0ULL;
+    for (uint32_t cpu = 0; cpu < cpus; cpu++) {
+        max_load = MAX(max_load, current[cpu]);
+        min_load = MIN(min_load, current[cpu]);
+    }
+    if (count == 0 || max_load - min_load < max_load / 4) {
+        return;
+    }
+
+    uint64_t irq_flags = desc_lock.lock_irqsave();
+    for (uint32_t i = 0; i < count; i++) {
+        uint32_t target = 0;
+        for (uint32_t cpu = 1; cpu < cpus; cpu++) {
+            if (planned[cpu] < planned[target]) {
+                target = cpu;
+            }
+        }
+        planned[target] += sources[i].rate;
+
+        if (!descs[sources[i].vector].pinned) {
+            set_affinity_locked(sources[i].vector, target);
+        }
+    }
+    desc_lock.unlock_irqrestore(irq_flags);
+}
+
+static void* balancer_main(void*) {
+    static uint64_t last_counts[NR_VECTORS];
+
+    while (true) {
+        PIT::sleep(BALANCE_INTERVAL_MS);
+        rebalance(last_counts);
+    }
+    return nullptr;
+}
+
+// Only the boot CPU is brought up for now, so in practice this reports
+// and returns until the APs are started.
+void start_balancer() {
+    if (CPU::online_count() < 2) {
+        Console::printf("[IRQ] Balancer not started: only %u CPU online\n", CPU::online_count());
+        return;
+    }
+    ProcessManager::create_kernel_thread("irqbalance", balancer_main, nullptr);
+}
+
+uint64_t get_latency_count(uint32_t bucket) {
+    uint64_t total = 0;
+    for (uint32_t cpu = 0; cpu < CPU::online_count(); cpu++) {
+        total += latency_histogram[cpu][bucket];
+    }
+    return total;
+}
+
+void dump_latency_histogram() {
+    Console::printf("[IRQ] Interrupt-disabled time per IRQ (TSC cycles):\n");
+    for (uint32_t bucket = 0; bucket < LATENCY_BUCKETS; bucket++) {
+        uint64_t count = get_latency_count(bucket);
+        if (count) {
+            Console::printf("  [%llu, %llu): %llu\n", 1ULL << bucket, 1ULL << (bucket + 1), count);
+        }
+    }
+}
+
+}
+}
\ No newline at end of file
@@ -0,0 +1,148 @@
+#include <kernel/irq/softirq.h>
+#include <kernel/process/process.h>
+#include <kernel/process/scheduler.h>
+#include <kernel/irq/irq.h>
+#include <kernel/sync/waitqueue.h>
+#include <kernel/arch/x86_64/cpu.h>
+#include <kernel/arch/x86_64/pit.h>
+
+namespace Core {
+
+struct TaskletList {
+    Tasklet* head;
+    Tasklet* tail;
+} ALIGNED(64);
+
+static softirq_handler_t handlers[NR_SOFTIRQS];
+static TaskletList tasklets[CPU::MAX_CPUS];
+static WaitQueue ksoftirqd_wait[CPU::MAX_CPUS];
+static bool threads_started = false;
+
+static void run_tasklets() {
+    uint64_t flags = CPU::irq_save();
+    TaskletList& list = tasklets[CPU::id()];
+    Tasklet* tasklet = list.head;
+    list.head = nullptr;
+    list.tail = nullptr;
+    CPU::irq_restore(flags);
+
+    while (tasklet) {
+        Tasklet* next = tasklet->next;
+        __atomic_store_n(&tasklet->scheduled, 0, __ATOMIC_RELEASE);
+        tasklet->func(tasklet->data);
+        tasklet = next;
+    }
+}
+
+// Runs pending vectors with interrupts enabled and preemption disabled.
+// Returns true if work was still pending when the budget ran out.
+static bool do_softirq() {
+    CPU::Local* local = CPU::local();
+    uint64_t deadline = PIT::get_ticks() + Softirq::MAX_TICKS;
+    uint32_t restart = Softirq::MAX_RESTART;
+
+    local->preempt_count++;
+
+    uint32_t pending;
+    while ((pending = local->softirq_pending) != 0) {
+        local->softirq_pending = 0;
+        __asm__ volatile("sti" : : : "memory");
+
+        while (pending) {
+            uint32_t vector = __builtin_ctz(pending);
+            pending &= pending - 1;
+            if (handlers[vector]) {
+                handlers[vector]();
+            }
+        }
+
+        __asm__ volatile("cli" : : : "memory");
+        if (--restart == 0 || PIT::get_ticks() >= deadline) {
+            break;
+        }
+    }
+
+    local->preempt_count--;
+    return local->softirq_pending != 0;
+}
+
+static void* ksoftirqd_main(void*) {
+    uint32_t cpu = CPU::id();
+
+    while (true) {
+        ksoftirqd_wait[cpu].wait_event([] { return Softirq::has_pending(); });
+
+        uint64_t flags = CPU::irq_save();
+        do_softirq();
+        CPU::irq_restore(flags);
+
+        if (CPU::local()->need_resched) {
+            Scheduler::schedule();
+        }
+    }
+
+    return nullptr;
+}
+
+void Softirq::initialize() {
+    for (uint32_t i = 0; i < NR_SOFTIRQS; i++) {
+        handlers[i] = nullptr;
+    }
+    register_handler(SOFTIRQ_TASKLET, run_tasklets);
+}
+
+void Softirq::start_threads() {
+    for (uint32_t cpu = 0; cpu < CPU::online_count(); cpu++) {
+        ProcessManager::create_kernel_thread("ksoftirqd", ksoftirqd_main, nullptr, cpu);
+    }
+    threads_started = true;
+}
+
+void Softirq::register_handler(SoftirqVector vector, softirq_handler_t handler) {
+    handlers[vector] = handler;
+}
+
+void Softirq::raise(SoftirqVector vector) {
+    uint64_t flags = CPU::irq_save();
+    CPU::local()->softirq_pending |= 1U << vector;
+
+    // Outside interrupt context nothing will reach irq exit soon.
+    if (!IRQ::in_interrupt() && threads_started) {
+        ksoftirqd_wait[CPU::id()].wake_one();
+    }
+    CPU::irq_restore(flags);
+}
+
+bool Softirq::has_pending() {
+    return CPU::local()->softirq_pending != 0;
+}
+
+void Softirq::run_pending() {
+    uint64_t flags = CPU::irq_save();
+
+    if (do_softirq() && threads_started) {
+        ksoftirqd_wait[CPU::id()].wake_one();
+    }
+
+    CPU::irq_restore(flags);
+}
+
+void Tasklet::schedule(Tasklet* tasklet) {
+    if (__atomic_exchange_n(&tasklet->scheduled, 1, __ATOMIC_ACQ_REL)) {
+        return;
+    }
+
+    uint64_t flags = CPU::irq_save();
+    TaskletList& list = tasklets[CPU::id()];
+    tasklet->next = nullptr;
+    if (list.tail) {
+        list.tail->next = tasklet;
+    } else {
+        list.head = tasklet;
+    }
+    list.tail = tasklet;
+    CPU::local()->softirq_pending |= 1U << SOFTIRQ_TASKLET;
+    CPU::irq_restore(flags);
+}
+
+}
\ No newline at end of file
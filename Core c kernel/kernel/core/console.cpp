@@ -87,7 +87,7 @@ void Console::update_cursor() {
     IO::outb(0x3D5, (uint8_t)((pos >> 8) & 0xFF));
 }
 
-static void print_number(uint64_t num, int base, bool uppercase, int width, char pad) {
+static void print_number(Console::putchar_func_t out, uint64_t num, int base, bool uppercase, int width, char pad) {
     char buffer[65];
     int i = 0;
     
@@ -106,23 +106,27 @@ static void print_number(uint64_t num, int base, bool uppercase, int width, char
     }
     
     while (i > 0) {
-        Console::putchar(buffer[--i]);
+        out(buffer[--i]);
     }
 }
 
-static void print_signed(int64_t num, int width, char pad) {
+static void print_signed(Console::putchar_func_t out, int64_t num, int width, char pad) {
     if (num < 0) {
-        Console::putchar('-');
+        out('-');
         num = -num;
         if (width > 0) width--;
     }
-    print_number((uint64_t)num, 10, false, width, pad);
+    print_number(out, (uint64_t)num, 10, false, width, pad);
 }
 
 void Console::printf(const char* format, ...) {
     va_list args;
     va_start(args, format);
-    
+    vprintf(putchar, format, args);
+    va_end(args);
+}
+
+void Console::vprintf(putchar_func_t out, const char* format, va_list args) {
     while (*format) {
         if (*format == '%') {
             format++;
@@ -160,7 +164,7 @@ void Console::printf(const char* format, ...) {
                     } else {
                         val = va_arg(args, int);
                     }
-                    print_signed(val, width, pad);
+                    print_signed(out, val, width, pad);
                     break;
                 }
                 case 'u': {
@@ -172,42 +176,42 @@ void Console::printf(const char* format, ...) {
                     } else {
                         val = va_arg(args, unsigned int);
                     }
-                    print_number(val, 10, false, width, pad);
+                    print_number(out, val, 10, false, width, pad);
                     break;
                 }
                 case 'x':
-                    print_number(va_arg(args, uint64_t), 16, false, width, pad);
+                    print_number(out, va_arg(args, uint64_t), 16, false, width, pad);
                     break;
                 case 'X':
-                    print_number(va_arg(args, uint64_t), 16, true, width, pad);
+                    print_number(out, va_arg(args, uint64_t), 16, true, width, pad);
                     break;
                 case 'p':
-                    write("0x");
-                    print_number((uint64_t)va_arg(args, void*), 16, false, 16, '0');
+                    out('0');
+                    out('x');
+                    print_number(out, (uint64_t)va_arg(args, void*), 16, false, 16, '0');
                     break;
                 case 'c':
-                    putchar((char)va_arg(args, int));
+                    out((char)va_arg(args, int));
                     break;
                 case 's': {
                     const char* str = va_arg(args, const char*);
-                    write(str ? str : "(null)");
+                    if (!str) str = "(null)";
+                    while (*str) out(*str++);
                     break;
                 }
                 case '%':
-                    putchar('%');
+                    out('%');
                     break;
                 default:
-                    putchar('%');
-                    putchar(*format);
+                    out('%');
+                    out(*format);
                     break;
             }
         } else {
-            putchar(*format);
+            out(*format);
         }
         format++;
     }
-    
-    va_end(args);
 }
 
 }
\ No newline at end of file
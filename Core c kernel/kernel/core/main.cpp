@@ -3,15 +3,36 @@
 #include <kernel/memory/pmm.h>
 #include <kernel/memory/vmm.h>
 #include <kernel/memory/heap.h>
+#include <kernel/memory/kstack.h>
 #include <kernel/arch/x86_64/gdt.h>
 #include <kernel/arch/x86_64/idt.h>
 #include <kernel/arch/x86_64/pit.h>
 #include <kernel/arch/x86_64/apic.h>
+#include <kernel/arch/x86_64/acpi.h>
+#include <kernel/arch/x86_64/ioapic.h>
+#include <kernel/arch/x86_64/cpu.h>
+#include <kernel/arch/x86_64/fpu.h>
+#include <kernel/arch/x86_64/tlb.h>
 #include <kernel/process/process.h>
 #include <kernel/process/scheduler.h>
+#include <kernel/process/workqueue.h>
+#include <kernel/irq/softirq.h>
+#include <kernel/irq/irq.h>
+#include <kernel/sync/rcu.h>
 #include <kernel/fs/vfs.h>
+#include <kernel/fs/initramfs.h>
+#include <kernel/fs/tmpfs.h>
+#include <kernel/memory/boot_modules.h>
+#include <kernel/block/block.h>
+#include <kernel/block/deadline.h>
 #include <kernel/drivers/pci.h>
+#include <kernel/drivers/virtio_blk.h>
+#include <kernel/drivers/serial.h>
+#include <kernel/sync/lockstat.h>
 #include <kernel/multiboot2.h>
+#include <kernel/bench.h>
+#include <kernel/syscall.h>
+#include <kernel/time/clock.h>
 
 extern "C" uint64_t _kernel_end;
 extern "C" uint64_t _kernel_physical_end;
@@ -25,6 +46,7 @@ public:
     uint64_t kernel_start;
     uint64_t kernel_end;
     const char* bootloader_name;
+    const void* rsdp;
     
     void print() {
         Console::printf("Core Microkernel v0.1.0\n");
@@ -34,7 +56,13 @@ public:
                        kernel_start, kernel_end, 
                        (kernel_end - kernel_start) / 1024);
         Console::printf("Total Memory: %llu MB\n", total_memory / (1024 * 1024));
-        Console::printf("Usable Memory: %llu MB\n\n", usable_memory / (1024 * 1024));
+        Console::printf("Usable Memory: %llu MB\n", usable_memory / (1024 * 1024));
+        for (uint32_t i = 0; i < BootModules::count(); i++) {
+            BootModule* module = BootModules::get(i);
+            Console::printf("Module: %s (%llu KB at 0x%llx)\n", module->cmdline,
+                            (module->end - module->start) / 1024, module->start);
+        }
+        Console::printf("\n");
     }
 };
 
@@ -51,6 +79,11 @@ static void parse_multiboot_info(uint32_t magic, uint64_t info_addr) {
     kernel_info.total_memory = 0;
     kernel_info.usable_memory = 0;
     kernel_info.bootloader_name = nullptr;
+    kernel_info.rsdp = nullptr;
+
+    // The information block stays in use (ACPI and module data point
+    // into it), so keep the PMM off it.
+    PMM::reserve_early(info_addr, info_addr + *(uint32_t*)info_addr);
 
     for (tag = (struct multiboot_tag*)(info_addr + 8);
          tag->type != MULTIBOOT_TAG_TYPE_END;
@@ -62,6 +95,20 @@ static void parse_multiboot_info(uint32_t magic, uint64_t info_addr) {
                 kernel_info.bootloader_name = str->string;
                 break;
             }
+            case MULTIBOOT_TAG_TYPE_MODULE: {
+                struct multiboot_tag_module *mod = (struct multiboot_tag_module*)tag;
+                BootModules::add(mod->mod_start, mod->mod_end, mod->cmdline);
+                break;
+            }
+            case MULTIBOOT_TAG_TYPE_ACPI_OLD:
+            case MULTIBOOT_TAG_TYPE_ACPI_NEW: {
+                // Prefer the ACPI 2.0 copy, which carries the XSDT address.
+                struct multiboot_tag_acpi *acpi = (struct multiboot_tag_acpi*)tag;
+                if (!kernel_info.rsdp || tag->type == MULTIBOOT_TAG_TYPE_ACPI_NEW) {
+                    kernel_info.rsdp = acpi->rsdp;
+                }
+                break;
+            }
             case MULTIBOOT_TAG_TYPE_MMAP: {
                 struct multiboot_tag_mmap *mmap = (struct multiboot_tag_mmap*)tag;
                 multiboot_memory_map_t *entry;
@@ -85,6 +132,7 @@ static void parse_multiboot_info(uint32_t magic, uint64_t info_addr) {
 }
 
 static void init_early_console() {
+    Serial::initialize();
     Console::initialize();
     Console::set_color(Console::Color::WHITE, Console::Color::BLACK);
     Console::clear();
@@ -94,13 +142,26 @@ static void init_kernel_subsystems() {
     Console::printf("[INIT] Initializing kernel subsystems...\n");
 
     Console::printf("[INIT] Setting up GDT... ");
-    GDT::initialize();
+    GDT::initialize(CPU::online_count());
+    Console::printf("OK\n");
+
+    Console::printf("[INIT] Setting up per-CPU data... ");
+    CPU::initialize();
     Console::printf("OK\n");
 
     Console::printf("[INIT] Setting up IDT... ");
     IDT::initialize();
     Console::printf("OK\n");
 
+    Console::printf("[INIT] Initializing FPU... ");
+    FPU::initialize();
+    Console::printf("OK (%s, %llu byte state)\n",
+                    FPU::has_xsave() ? "XSAVE" : "FXSAVE", FPU::get_state_size());
+
+    Console::printf("[INIT] Enabling SYSCALL... ");
+    Syscall::initialize();
+    Console::printf("OK\n");
+
     Console::printf("[INIT] Initializing physical memory... ");
     PMM::initialize(kernel_info.usable_memory, kernel_info.kernel_end);
     Console::printf("OK (%llu MB free)\n", PMM::get_free_memory() / (1024 * 1024));
@@ -113,14 +174,39 @@ static void init_kernel_subsystems() {
     Heap::initialize(KERNEL_HEAP_START, KERNEL_HEAP_SIZE);
     Console::printf("OK\n");
 
+    Console::printf("[INIT] Initializing kernel stacks... ");
+    KernelStack::initialize();
+    Console::printf("OK\n");
+
     Console::printf("[INIT] Initializing APIC... ");
     APIC::initialize();
     Console::printf("OK\n");
 
+    Console::printf("[INIT] Parsing ACPI tables... ");
+    ACPI::initialize(kernel_info.rsdp);
+    Console::printf(ACPI::is_present() ? "OK\n" : "not found\n");
+
+    Console::printf("[INIT] Initializing IOAPIC... ");
+    IOAPIC::initialize();
+    Console::printf("OK (%u pins)\n", IOAPIC::get_pin_count());
+
+    Console::printf("[INIT] Enabling TLB shootdown... ");
+    TLB::initialize();
+    Console::printf("OK\n");
+
+    Console::printf("[INIT] Initializing softirqs... ");
+    Softirq::initialize();
+    RCU::initialize();
+    Console::printf("OK\n");
+
     Console::printf("[INIT] Initializing PIT... ");
     PIT::initialize(1000);
     Console::printf("OK\n");
 
+    Console::printf("[INIT] Calibrating TSC clock... ");
+    Clock::initialize();
+    Console::printf("OK (%llu MHz)\n", Clock::get_tsc_hz() / 1000000);
+
     Console::printf("[INIT] Initializing process manager... ");
     ProcessManager::initialize();
     Console::printf("OK\n");
@@ -129,13 +215,38 @@ static void init_kernel_subsystems() {
     Scheduler::initialize();
     Console::printf("OK\n");
 
+    Console::printf("[INIT] Starting deferred work threads... ");
+    Softirq::start_threads();
+    WorkQueue::initialize();
+    IRQ::start_balancer();
+    Console::printf("OK\n");
+
     Console::printf("[INIT] Initializing VFS... ");
     VFS::initialize();
     Console::printf("OK\n");
 
+    Console::printf("[INIT] Mounting initramfs... ");
+    Initramfs::initialize();
+    Tmpfs::initialize();
+    if (Initramfs::mount_root() == E_OK) {
+        Console::printf("OK (%u files)\n", Initramfs::get_file_count());
+        VFS::mount("tmpfs", "/tmp", nullptr);
+    } else {
+        // Without an archive the root is a scratch filesystem.
+        Console::printf("no archive\n");
+        VFS::mount("tmpfs", "/", nullptr);
+    }
+    BootModules::release_unclaimed();
+    if (BootModules::get_released()) {
+        Console::printf("[INIT] Released %llu KB of boot module memory\n", BootModules::get_released() / 1024);
+    }
+
     Console::printf("[INIT] Scanning PCI bus... ");
     PCI::initialize();
     Console::printf("OK\n");
+    Block::initialize();
+    Deadline::initialize();
+    VirtioBlk::initialize();
 
     Console::printf("\n[INIT] All subsystems initialized successfully!\n\n");
 }
@@ -169,14 +280,6 @@ static void run_kernel_tests() {
     Console::printf("[TEST] All tests passed!\n\n");
 }
 
-static void idle_task(void*) {
-    Console::printf("[IDLE] Idle task started\n");
-    
-    while (true) {
-        __asm__ volatile("hlt");
-    }
-}
-
 }
 
 extern "C" void kernel_main(uint32_t magic, uint64_t multiboot_info) {
@@ -188,8 +291,13 @@ extern "C" void kernel_main(uint32_t magic, uint64_t multiboot_info) {
     init_kernel_subsystems();
     run_kernel_tests();
 
-    Console::printf("[INIT] Creating idle task...\n");
-    ProcessManager::create_kernel_process("idle", idle_task, nullptr);
+#ifdef CONFIG_LOCKSTAT
+    Lockstat::start_monitor();
+#endif
+
+#ifdef CONFIG_BENCH
+    Bench::start();
+#endif
 
     Console::printf("[INIT] Enabling interrupts...\n");
     __asm__ volatile("sti");
@@ -0,0 +1,391 @@
+#include <kernel/syscall.h>
+#include <kernel/process/process.h>
+#include <kernel/process/scheduler.h>
+#include <kernel/ipc/ipc.h>
+#include <kernel/ipc/channel.h>
+#include <kernel/ipc/io_ring.h>
+#include <kernel/ipc/memory_object.h>
+
+namespace Core {
+
+static_assert(NR_SYSCALLS == 24, "update NR_SYSCALLS in syscall.asm");
+
+static int64_t sys_null(uint64_t, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t) {
+    return 0;
+}
+
+static int64_t sys_exit(uint64_t code, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t) {
+    ProcessManager::exit_thread((void*)code);
+    return 0;
+}
+
+static int64_t sys_yield(uint64_t, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t) {
+    Scheduler::yield();
+    return 0;
+}
+
+static int64_t sys_getpid(uint64_t, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t) {
+    return ProcessManager::get_current()->get_pid();
+}
+
+static int64_t sys_gettid(uint64_t, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t) {
+    return ProcessManager::get_current_thread()->get_tid();
+}
+
+static int64_t sys_endpoint_create(uint64_t, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t) {
+    Endpoint* ep = endpoint_create();
+    if (!ep) {
+        return E_NOMEM;
+    }
+
+    int handle = ProcessManager::get_current()->handles.install(&ep->obj);
+    endpoint_put(ep);
+    return handle;
+}
+
+static int64_t sys_handle_close(uint64_t handle, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t) {
+    return ProcessManager::get_current()->handles.close((int)handle);
+}
+
+static Endpoint* get_endpoint(uint64_t handle) {
+    KObject* obj = ProcessManager::get_current()->handles.get((int)handle, ObjectType::ENDPOINT);
+    return obj ? (Endpoint*)((uint8_t*)obj - offsetof(Endpoint, obj)) : nullptr;
+}
+
+static void load_message(IpcMessage* msg) {
+    SyscallFrame* frame = Syscall::frame();
+    msg->label = frame->rsi;
+    msg->words[0] = frame->rdx;
+    msg->words[1] = frame->r10;
+    msg->words[2] = frame->r8;
+    msg->words[3] = frame->r9;
+}
+
+static void store_message(const IpcMessage* msg) {
+    SyscallFrame* frame = Syscall::frame();
+    frame->rsi = msg->label;
+    frame->rdx = msg->words[0];
+    frame->r10 = msg->words[1];
+    frame->r8 = msg->words[2];
+    frame->r9 = msg->words[3];
+}
+
+// Common body of the endpoint operations: the message is loaded from and
+// stored back to the saved registers around the blocking call.
+static int64_t endpoint_op(uint64_t handle, error_t (*op)(Endpoint*, IpcMessage*)) {
+    Endpoint* ep = get_endpoint(handle);
+    if (!ep) {
+        return E_INVAL;
+    }
+
+    IpcMessage msg;
+    load_message(&msg);
+    error_t err = op(ep, &msg);
+    endpoint_put(ep);
+
+    if (err == E_OK) {
+        store_message(&msg);
+    }
+    return err;
+}
+
+static error_t send_op(Endpoint* ep, IpcMessage* msg) {
+    return ipc_send(ep, msg);
+}
+
+static int64_t sys_ipc_send(uint64_t handle, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t) {
+    return endpoint_op(handle, send_op);
+}
+
+static int64_t sys_ipc_recv(uint64_t handle, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t) {
+    return endpoint_op(handle, ipc_receive);
+}
+
+static int64_t sys_ipc_call(uint64_t handle, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t) {
+    return endpoint_op(handle, ipc_call);
+}
+
+static int64_t sys_ipc_reply(uint64_t, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t) {
+    IpcMessage msg;
+    load_message(&msg);
+    return ipc_reply(&msg);
+}
+
+static int64_t sys_ipc_reply_recv(uint64_t handle, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t) {
+    return endpoint_op(handle, ipc_reply_wait);
+}
+
+static int64_t sys_channel_create(uint64_t slots, uint64_t arena_size, uint64_t, uint64_t, uint64_t, uint64_t) {
+    if (slots > 0xFFFFFFFF) {
+        return E_INVAL;
+    }
+
+    Channel* channel = channel_create((uint32_t)slots, arena_size);
+    if (!channel) {
+        return E_INVAL;
+    }
+
+    int handle = ProcessManager::get_current()->handles.install(&channel->obj);
+    channel_put(channel);
+    return handle;
+}
+
+static Channel* get_channel(uint64_t handle) {
+    KObject* obj = ProcessManager::get_current()->handles.get((int)handle, ObjectType::CHANNEL);
+    return obj ? (Channel*)((uint8_t*)obj - offsetof(Channel, obj)) : nullptr;
+}
+
+static int64_t sys_channel_map(uint64_t handle, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t) {
+    Channel* channel = get_channel(handle);
+    if (!channel) {
+        return E_INVAL;
+    }
+
+    int64_t addr = channel->region.user_addr;
+    channel_put(channel);
+    return addr;
+}
+
+static int64_t sys_channel_wait(uint64_t handle, uint64_t side, uint64_t token, uint64_t, uint64_t, uint64_t) {
+    if (side > (uint64_t)ChannelSide::WRITER) {
+        return E_INVAL;
+    }
+
+    Channel* channel = get_channel(handle);
+    if (!channel) {
+        return E_INVAL;
+    }
+
+    channel_wait(channel, (ChannelSide)side, (uint32_t)token);
+    channel_put(channel);
+    return E_OK;
+}
+
+static int64_t sys_channel_notify(uint64_t handle, uint64_t side, uint64_t, uint64_t, uint64_t, uint64_t) {
+    if (side > (uint64_t)ChannelSide::WRITER) {
+        return E_INVAL;
+    }
+
+    Channel* channel = get_channel(handle);
+    if (!channel) {
+        return E_INVAL;
+    }
+
+    channel_notify(channel, (ChannelSide)side);
+    channel_put(channel);
+    return E_OK;
+}
+
+static int64_t sys_io_ring_create(uint64_t entries, uint64_t flags, uint64_t, uint64_t, uint64_t, uint64_t) {
+    if (entries > IO_RING_MAX_ENTRIES || flags > 0xFFFFFFFF) {
+        return E_INVAL;
+    }
+
+    IoRing* ring = io_ring_create((uint32_t)entries, (uint32_t)flags);
+    if (!ring) {
+        return E_INVAL;
+    }
+
+    int handle = ProcessManager::get_current()->handles.install(&ring->obj);
+    io_ring_put(ring);
+    return handle;
+}
+
+static IoRing* get_io_ring(uint64_t handle) {
+    KObject* obj = ProcessManager::get_current()->handles.get((int)handle, ObjectType::IO_RING);
+    return obj ? (IoRing*)((uint8_t*)obj - offsetof(IoRing, obj)) : nullptr;
+}
+
+static int64_t sys_io_ring_map(uint64_t handle, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t) {
+    IoRing* ring = get_io_ring(handle);
+    if (!ring) {
+        return E_INVAL;
+    }
+
+    int64_t addr = ring->region.user_addr;
+    io_ring_put(ring);
+    return addr;
+}
+
+static int64_t sys_io_ring_enter(uint64_t handle, uint64_t to_submit, uint64_t min_complete, uint64_t flags,
+                                 uint64_t, uint64_t) {
+    IoRing* ring = get_io_ring(handle);
+    if (!ring) {
+        return E_INVAL;
+    }
+
+    int submitted = io_ring_enter(ring, (uint32_t)MIN(to_submit, IO_RING_MAX_ENTRIES),
+                                  (uint32_t)MIN(min_complete, 2 * IO_RING_MAX_ENTRIES), (uint32_t)flags);
+    io_ring_put(ring);
+    return submitted;
+}
+
+static int64_t sys_mem_create(uint64_t size, uint64_t, uint64_t, uint64_t, uint64_t, uint64_t) {
+    MemoryObject* mem = memory_object_create(size);
+    if (!mem) {
+        return size && size <= MEMORY_OBJECT_MAX_SIZE ? E_NOMEM : E_INVAL;
+    }
+
+    int handle = ProcessManager::get_current()->handles.install(&mem->obj);
+    memory_object_put(mem);
+    return handle;
+}
+
+static MemoryObject* get_memory_object(uint64_t handle, uint32_t rights) {
+    KObject* obj = ProcessManager::get_current()->handles.get((int)handle, ObjectType::MEMORY, rights);
+    return obj ? (MemoryObject*)((uint8_t*)obj - offsetof(MemoryObject, obj)) : nullptr;
+}
+
+static int64_t sys_mem_map(uint64_t handle, uint64_t addr, uint64_t writable, uint64_t, uint64_t, uint64_t) {
+    MemoryObject* mem = get_memory_object(handle, RIGHT_READ | (writable ? RIGHT_WRITE : 0));
+    if (!mem) {
+        return E_PERM;
+    }
+
+    error_t err = memory_object_map(mem, addr, writable != 0);
+    memory_object_put(mem);
+    return err;
+}
+
+// A writable handle may remove any mapping of the object; with a narrower
+// one a process can only remove what it mapped itself.
+static int64_t sys_mem_unmap(uint64_t handle, uint64_t addr, uint64_t, uint64_t, uint64_t, uint64_t) {
+    Process* current = ProcessManager::get_current();
+    uint32_t granted = 0;
+    KObject* obj = current->handles.get((int)handle, ObjectType::MEMORY, 0, &granted);
+    if (!obj) {
+        return E_INVAL;
+    }
+    MemoryObject* mem = (MemoryObject*)((uint8_t*)obj - offsetof(MemoryObject, obj));
+
+    error_t err = memory_object_unmap(mem, addr, (granted & RIGHT_WRITE) ? -1 : current->get_pid());
+    memory_object_put(mem);
+    return err;
+}
+
+// The caller's handle to the endpoint or channel that links it to the
+// target of a grant or transfer, or nullptr.
+static KObject* get_link(uint64_t handle) {
+    KObject* obj = ProcessManager::get_current()->handles.get((int)handle, ObjectType::NONE);
+    if (obj && obj->type != ObjectType::ENDPOINT && obj->type != ObjectType::CHANNEL) {
+        kobject_put(obj);
+        obj = nullptr;
+    }
+    return obj;
+}
+
+// Handles only go to a process the caller already talks to: one holding
+// the same endpoint or channel as `link`. A process may always install
+// into itself. Call inside rcu_read_lock().
+static error_t find_peer(uint64_t pid, KObject* link, Process** peer) {
+    Process* target = ProcessManager::find_process((int)pid);
+    if (!target) {
+        return E_NOENT;
+    }
+    if (target != ProcessManager::get_current() && !(link && target->handles.holds(link))) {
+        return E_PERM;
+    }
+    *peer = target;
+    return E_OK;
+}
+
+// Installs `obj` in the table of process `pid`; returns the handle there.
+static int install_in(uint64_t pid, KObject* link, KObject* obj, uint32_t rights) {
+    rcu_read_lock();
+    Process* target = nullptr;
+    error_t err = find_peer(pid, link, &target);
+    int handle = err == E_OK ? target->handles.install(obj, rights) : err;
+    rcu_read_unlock();
+    return handle;
+}
+
+static int64_t sys_mem_transfer(uint64_t handle, uint64_t pid, uint64_t dest, uint64_t link_handle, uint64_t, uint64_t) {
+    MemoryObject* mem = get_memory_object(handle, RIGHT_TRANSFER);
+    if (!mem) {
+        return E_PERM;
+    }
+
+    // A bad or unrelated target is caught before anything moves. The
+    // install can still fail, if the target exits meanwhile or its table
+    // is full, and then the pages go back to `mem`, mapped where they were.
+    KObject* link = get_link(link_handle);
+    rcu_read_lock();
+    Process* peer = nullptr;
+    error_t err = find_peer(pid, link, &peer);
+    rcu_read_unlock();
+    if (err != E_OK) {
+        if (link) kobject_put(link);
+        memory_object_put(mem);
+        return err;
+    }
+
+    MemoryObject* moved = nullptr;
+    err = memory_object_transfer(mem, dest, &moved);
+    if (err != E_OK) {
+        if (link) kobject_put(link);
+        memory_object_put(mem);
+        return err;
+    }
+
+    int target = install_in(pid, link, &moved->obj, RIGHTS_ALL);
+    if (link) kobject_put(link);
+    if (target >= 0) {
+        memory_object_finish_transfer(mem);
+        ProcessManager::get_current()->handles.close((int)handle);
+    } else {
+        memory_object_restore(mem, moved);
+    }
+    memory_object_put(moved);
+    memory_object_put(mem);
+    return target;
+}
+
+// Copies a handle of any type into another process. The new handle may
+// only carry rights the caller's handle already has.
+static int64_t sys_handle_grant(uint64_t handle, uint64_t pid, uint64_t rights, uint64_t link_handle, uint64_t, uint64_t) {
+    uint32_t granted = 0;
+    KObject* obj = ProcessManager::get_current()->handles.get((int)handle, ObjectType::NONE, 0, &granted);
+    if (!obj) {
+        return E_INVAL;
+    }
+
+    KObject* link = get_link(link_handle);
+    int target = (rights & ~(uint64_t)granted) ? E_PERM : install_in(pid, link, obj, (uint32_t)rights);
+    if (link) kobject_put(link);
+    kobject_put(obj);
+    return target;
+}
+
+// Indexed directly by the entry stub after a single bounds check.
+extern "C" const syscall_func_t syscall_table[NR_SYSCALLS] = {
+    [SYS_NULL] = sys_null,
+    [SYS_EXIT] = sys_exit,
+    [SYS_YIELD] = sys_yield,
+    [SYS_GETPID] = sys_getpid,
+    [SYS_GETTID] = sys_gettid,
+    [SYS_ENDPOINT_CREATE] = sys_endpoint_create,
+    [SYS_HANDLE_CLOSE] = sys_handle_close,
+    [SYS_IPC_SEND] = sys_ipc_send,
+    [SYS_IPC_RECV] = sys_ipc_recv,
+    [SYS_IPC_CALL] = sys_ipc_call,
+    [SYS_IPC_REPLY] = sys_ipc_reply,
+    [SYS_IPC_REPLY_RECV] = sys_ipc_reply_recv,
+    [SYS_CHANNEL_CREATE] = sys_channel_create,
+    [SYS_CHANNEL_MAP] = sys_channel_map,
+    [SYS_CHANNEL_WAIT] = sys_channel_wait,
+    [SYS_CHANNEL_NOTIFY] = sys_channel_notify,
+    [SYS_IO_RING_CREATE] = sys_io_ring_create,
+    [SYS_IO_RING_MAP] = sys_io_ring_map,
+    [SYS_IO_RING_ENTER] = sys_io_ring_enter,
+    [SYS_MEM_CREATE] = sys_mem_create,
+    [SYS_MEM_MAP] = sys_mem_map,
+    [SYS_MEM_UNMAP] = sys_mem_unmap,
+    [SYS_MEM_TRANSFER] = sys_mem_transfer,
+    [SYS_HANDLE_GRANT] = sys_handle_grant,
+};
+
+extern "C" void syscall_resched() {
+    Scheduler::schedule();
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,103 @@
+#include <kernel/lib/idr.h>
+#include <kernel/memory/pmm.h>
+
+namespace Core {
+
+void IDR::initialize(int first, int last) {
+    for (uint32_t i = 0; i < MAX_CHUNKS; i++) {
+        chunks[i] = nullptr;
+        chunk_free[i] = BITS_PER_CHUNK;
+    }
+
+    if (last >= (int)(MAX_CHUNKS * BITS_PER_CHUNK)) {
+        last = MAX_CHUNKS * BITS_PER_CHUNK - 1;
+    }
+
+    objects.initialize();
+    min_id = first;
+    max_id = last;
+    next_id = first;
+    count = 0;
+}
+
+int IDR::find_free_from(int start) {
+    int id = start;
+    int scanned = 0;
+    int range = max_id - min_id + 1;
+
+    while (scanned < range) {
+        uint32_t c = id / BITS_PER_CHUNK;
+        uint32_t bit = id % BITS_PER_CHUNK;
+
+        if (!chunks[c]) {
+            uint64_t phys = PMM::alloc_page();
+            if (!phys) return -1;
+            chunks[c] = (uint64_t*)(phys + KERNEL_VIRTUAL_BASE);
+            for (uint32_t i = 0; i < PAGE_SIZE / sizeof(uint64_t); i++) {
+                chunks[c][i] = 0;
+            }
+        }
+
+        if (chunk_free[c] > 0) {
+            for (uint32_t word = bit / 64; word < BITS_PER_CHUNK / 64; word++) {
+                uint64_t bits = chunks[c][word];
+                if (word == bit / 64) {
+                    bits |= (1ULL << (bit % 64)) - 1;
+                }
+                if (bits != ~0ULL) {
+                    int found = c * BITS_PER_CHUNK + word * 64 + __builtin_ctzll(~bits);
+                    if (found > max_id) break;
+                    return found;
+                }
+            }
+        }
+
+        int next_chunk = (c + 1) * BITS_PER_CHUNK;
+        scanned += next_chunk - id;
+        id = next_chunk > max_id ? min_id : next_chunk;
+    }
+
+    return -1;
+}
+
+int IDR::alloc(void* object) {
+    ScopedLock guard(lock);
+
+    int id = find_free_from(next_id);
+    if (id < 0) return -1;
+
+    if (object && objects.insert(id, object) != E_OK) return -1;
+
+    chunks[id / BITS_PER_CHUNK][(id % BITS_PER_CHUNK) / 64] |= 1ULL << (id % 64);
+    chunk_free[id / BITS_PER_CHUNK]--;
+    next_id = id + 1 > max_id ? min_id : id + 1;
+    count++;
+
+    return id;
+}
+
+void IDR::remove(int id) {
+    if (id < min_id || id > max_id) return;
+
+    ScopedLock guard(lock);
+
+    uint64_t* chunk = chunks[id / BITS_PER_CHUNK];
+    uint64_t mask = 1ULL << (id % 64);
+    if (!chunk || !(chunk[(id % BITS_PER_CHUNK) / 64] & mask)) return;
+
+    objects.remove(id);
+    chunk[(id % BITS_PER_CHUNK) / 64] &= ~mask;
+    chunk_free[id / BITS_PER_CHUNK]++;
+    count--;
+}
+
+void* IDR::find(int id) const {
+    if (id < min_id || id > max_id) return nullptr;
+
+    rcu_read_lock();
+    void* object = objects.lookup(id);
+    rcu_read_unlock();
+    return object;
+}
+
+}
\ No newline at end of file
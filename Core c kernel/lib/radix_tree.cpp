@@ -0,0 +1,136 @@
+#include <kernel/lib/radix_tree.h>
+
+namespace Core {
+
+ObjectCache RadixTree::node_cache("radix_node", sizeof(RadixTree::Node));
+
+void RadixTree::initialize() {
+    root = nullptr;
+    height = 0;
+}
+
+uint64_t RadixTree::max_index(uint32_t levels) {
+    if (levels == 0) return 0;
+    if (levels * MAP_SHIFT >= 64) return ~0ULL;
+    return (1ULL << (levels * MAP_SHIFT)) - 1;
+}
+
+void RadixTree::free_node(RcuHead* head) {
+    node_cache.free((uint8_t*)head - offsetof(Node, rcu));
+}
+
+error_t RadixTree::extend(uint64_t index) {
+    while (index > max_index(height) || !root) {
+        Node* node = (Node*)node_cache.zalloc();
+        if (!node) return E_NOMEM;
+
+        node->level = height + 1;
+        if (root) {
+            node->slots[0] = root;
+            node->count = 1;
+            root->parent = node;
+            root->offset = 0;
+        }
+
+        rcu_assign_pointer(root, node);
+        height++;
+    }
+
+    return E_OK;
+}
+
+error_t RadixTree::insert(uint64_t index, void* item) {
+    if (!item) return E_INVAL;
+
+    error_t err = extend(index);
+    if (err != E_OK) return err;
+
+    Node* node = root;
+    for (uint32_t level = height; level > 1; level--) {
+        uint32_t offset = (index >> ((level - 1) * MAP_SHIFT)) & MAP_MASK;
+        Node* child = (Node*)node->slots[offset];
+
+        if (!child) {
+            child = (Node*)node_cache.zalloc();
+            if (!child) return E_NOMEM;
+            child->parent = node;
+            child->offset = offset;
+            child->level = level - 1;
+            rcu_assign_pointer(node->slots[offset], child);
+            node->count++;
+        }
+
+        node = child;
+    }
+
+    uint32_t offset = index & MAP_MASK;
+    if (node->slots[offset]) return E_INVAL;
+
+    rcu_assign_pointer(node->slots[offset], item);
+    node->count++;
+
+    return E_OK;
+}
+
+// The height is taken from the root node itself so a concurrent extend() or
+// shrink() can't pair a new root with a stale height.
+void* RadixTree::lookup(uint64_t index) const {
+    Node* node = rcu_dereference(root);
+    if (!node) return nullptr;
+
+    uint32_t levels = node->level;
+    if (index > max_index(levels)) return nullptr;
+
+    for (uint32_t level = levels; level > 1; level--) {
+        uint32_t offset = (index >> ((level - 1) * MAP_SHIFT)) & MAP_MASK;
+        node = (Node*)rcu_dereference(node->slots[offset]);
+        if (!node) return nullptr;
+    }
+
+    return rcu_dereference(node->slots[index & MAP_MASK]);
+}
+
+void* RadixTree::remove(uint64_t index) {
+    if (!root || index > max_index(height)) return nullptr;
+
+    Node* node = root;
+    for (uint32_t level = height; level > 1; level--) {
+        node = (Node*)node->slots[(index >> ((level - 1) * MAP_SHIFT)) & MAP_MASK];
+        if (!node) return nullptr;
+    }
+
+    uint32_t offset = index & MAP_MASK;
+    void* item = node->slots[offset];
+    if (!item) return nullptr;
+
+    rcu_assign_pointer(node->slots[offset], nullptr);
+
+    while (node && --node->count == 0) {
+        Node* parent = node->parent;
+        if (parent) {
+            rcu_assign_pointer(parent->slots[node->offset], nullptr);
+        } else {
+            rcu_assign_pointer(root, nullptr);
+            height = 0;
+        }
+        call_rcu(&node->rcu, free_node);
+        node = parent;
+    }
+
+    shrink();
+    return item;
+}
+
+// Readers may still be walking the old root, so its slots are left intact.
+void RadixTree::shrink() {
+    while (height > 1 && root->count == 1 && root->slots[0]) {
+        Node* old = root;
+        Node* child = (Node*)old->slots[0];
+        child->parent = nullptr;
+        rcu_assign_pointer(root, child);
+        height--;
+        call_rcu(&old->rcu, free_node);
+    }
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,65 @@
+#include <kernel/memory/boot_modules.h>
+#include <kernel/memory/pmm.h>
+
+namespace Core {
+
+static BootModule modules[BootModules::MAX_MODULES];
+static uint32_t module_count;
+static size_t released_bytes;
+
+void BootModules::add(uint64_t start, uint64_t end, const char* cmdline) {
+    if (module_count == MAX_MODULES || end <= start) {
+        return;
+    }
+
+    BootModule& module = modules[module_count++];
+    module.start = start;
+    module.end = end;
+
+    uint32_t i = 0;
+    for (; cmdline && cmdline[i] && i < sizeof(module.cmdline) - 1; i++) {
+        module.cmdline[i] = cmdline[i];
+    }
+    module.cmdline[i] = '\0';
+
+    PMM::reserve_early(start, end);
+}
+
+uint32_t BootModules::count() {
+    return module_count;
+}
+
+BootModule* BootModules::get(uint32_t index) {
+    return index < module_count ? &modules[index] : nullptr;
+}
+
+// Only whole pages inside the range are freed, so a page it shares with
+// live data stays. The module owns the tail of its last page.
+void BootModules::release_range(BootModule* module, uint64_t start, uint64_t end) {
+    start = ALIGN_UP(MAX(start, module->start), PAGE_SIZE);
+    end = ALIGN_DOWN(MIN(end, ALIGN_UP(module->end, PAGE_SIZE)), PAGE_SIZE);
+    if (start >= end) {
+        return;
+    }
+
+    PMM::release_region(start, end);
+    released_bytes += end - start;
+}
+
+size_t BootModules::release_unclaimed() {
+    size_t before = released_bytes;
+
+    for (uint32_t i = 0; i < module_count; i++) {
+        if (!modules[i].claimed) {
+            release_range(&modules[i], modules[i].start, ALIGN_UP(modules[i].end, PAGE_SIZE));
+            modules[i].claimed = true;
+        }
+    }
+    return released_bytes - before;
+}
+
+size_t BootModules::get_released() {
+    return released_bytes;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,57 @@
+#include <kernel/memory/copy.h>
+#include <kernel/arch/x86_64/fpu.h>
+
+namespace Core {
+
+// Below this many pages the XSAVE/XRSTOR traffic of a kernel FPU section
+// costs more than the wider loads save.
+#define SIMD_COPY_MIN_PAGES 4
+
+extern void copy_pages_avx2(void* dst, const void* src, size_t count);
+extern void zero_pages_avx2(void* dst, size_t count);
+
+void copy_pages(void* dst, const void* src, size_t count) {
+    if (count >= SIMD_COPY_MIN_PAGES && FPU::has_avx2()) {
+        kernel_fpu_begin();
+        copy_pages_avx2(dst, src, count);
+        kernel_fpu_end();
+        return;
+    }
+
+    uint64_t words = count * PAGE_SIZE / sizeof(uint64_t);
+    __asm__ volatile("rep movsq"
+                     : "+D"(dst), "+S"(src), "+c"(words)
+                     :
+                     : "memory");
+}
+
+void zero_pages(void* dst, size_t count) {
+    if (count >= SIMD_COPY_MIN_PAGES && FPU::has_avx2()) {
+        kernel_fpu_begin();
+        zero_pages_avx2(dst, count);
+        kernel_fpu_end();
+        return;
+    }
+
+    uint64_t words = count * PAGE_SIZE / sizeof(uint64_t);
+    __asm__ volatile("rep stosq"
+                     : "+D"(dst), "+c"(words)
+                     : "a"(0ULL)
+                     : "memory");
+}
+
+void copy_bytes(void* dst, const void* src, size_t len) {
+    __asm__ volatile("rep movsb"
+                     : "+D"(dst), "+S"(src), "+c"(len)
+                     :
+                     : "memory");
+}
+
+void zero_bytes(void* dst, size_t len) {
+    __asm__ volatile("rep stosb"
+                     : "+D"(dst), "+c"(len)
+                     : "a"(0)
+                     : "memory");
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,40 @@
+#include <kernel/types.h>
+
+// Built with AVX2 enabled; callers must hold a kernel_fpu_begin() section.
+
+namespace Core {
+
+typedef long long v4di __attribute__((vector_size(32)));
+
+void copy_pages_avx2(void* dst, const void* src, size_t count) {
+    v4di* d = (v4di*)dst;
+    const v4di* s = (const v4di*)src;
+    size_t vectors = count * PAGE_SIZE / sizeof(v4di);
+
+    for (size_t i = 0; i < vectors; i += 4) {
+        v4di a = s[i];
+        v4di b = s[i + 1];
+        v4di c = s[i + 2];
+        v4di e = s[i + 3];
+        __builtin_ia32_movntdq256(&d[i], a);
+        __builtin_ia32_movntdq256(&d[i + 1], b);
+        __builtin_ia32_movntdq256(&d[i + 2], c);
+        __builtin_ia32_movntdq256(&d[i + 3], e);
+    }
+
+    __asm__ volatile("sfence" : : : "memory");
+}
+
+void zero_pages_avx2(void* dst, size_t count) {
+    v4di* d = (v4di*)dst;
+    v4di zero = {0, 0, 0, 0};
+    size_t vectors = count * PAGE_SIZE / sizeof(v4di);
+
+    for (size_t i = 0; i < vectors; i++) {
+        __builtin_ia32_movntdq256(&d[i], zero);
+    }
+
+    __asm__ volatile("sfence" : : : "memory");
+}
+
+}
\ No newline at end of file
@@ -2,6 +2,7 @@
 #include <kernel/memory/vmm.h>
 #include <kernel/memory/pmm.h>
 #include <kernel/sync/spinlock.h>
+#include <kernel/sync/seqlock.h>
 
 namespace Core {
 
@@ -15,8 +16,12 @@ struct HeapBlock {
 static uint64_t heap_start = 0;
 static uint64_t heap_end = 0;
 static HeapBlock* heap_head = nullptr;
-static Spinlock heap_lock;
+static Spinlock heap_lock("heap");
+
+// Usage totals are updated under heap_lock and read locklessly.
+static SeqCount stats_seq;
 static size_t used_memory = 0;
+static size_t free_memory = 0;
 
 void Heap::initialize(uint64_t start, uint64_t size) {
     heap_start = start;
@@ -34,6 +39,7 @@ void Heap::initialize(uint64_t start, uint64_t size) {
     heap_head->prev = nullptr;
     
     used_memory = 0;
+    free_memory = heap_head->size;
 }
 
 void* Heap::malloc(size_t size) {
@@ -46,6 +52,9 @@ void* Heap::malloc(size_t size) {
     HeapBlock* block = heap_head;
     while (block) {
         if (block->free && block->size >= size) {
+            stats_seq.write_begin();
+            free_memory -= block->size;
+
             if (block->size >= size + sizeof(HeapBlock) + 64) {
                 HeapBlock* new_block = (HeapBlock*)((uint64_t)block + sizeof(HeapBlock) + size);
                 new_block->size = block->size - size - sizeof(HeapBlock);
@@ -59,10 +68,12 @@ void* Heap::malloc(size_t size) {
                 
                 block->size = size;
                 block->next = new_block;
+                free_memory += new_block->size;
             }
             
             block->free = false;
             used_memory += block->size;
+            stats_seq.write_end();
             
             return (void*)((uint64_t)block + sizeof(HeapBlock));
         }
@@ -119,9 +130,13 @@ void Heap::free(void* ptr) {
     
     HeapBlock* block = (HeapBlock*)((uint64_t)ptr - sizeof(HeapBlock));
     block->free = true;
+
+    stats_seq.write_begin();
     used_memory -= block->size;
+    free_memory += block->size;
     
     if (block->next && block->next->free) {
+        free_memory += sizeof(HeapBlock);
         block->size += sizeof(HeapBlock) + block->next->size;
         block->next = block->next->next;
         if (block->next) {
@@ -130,31 +145,34 @@ void Heap::free(void* ptr) {
     }
     
     if (block->prev && block->prev->free) {
+        free_memory += sizeof(HeapBlock);
         block->prev->size += sizeof(HeapBlock) + block->size;
         block->prev->next = block->next;
         if (block->next) {
             block->next->prev = block->prev;
         }
     }
+    stats_seq.write_end();
 }
 
 size_t Heap::get_used() {
-    return used_memory;
+    size_t used;
+    uint32_t seq;
+    do {
+        seq = stats_seq.read_begin();
+        used = used_memory;
+    } while (stats_seq.read_retry(seq));
+    return used;
 }
 
 size_t Heap::get_free() {
-    ScopedLock guard(heap_lock);
-    
-    size_t free_memory = 0;
-    HeapBlock* block = heap_head;
-    while (block) {
-        if (block->free) {
-            free_memory += block->size;
-        }
-        block = block->next;
-    }
-    
-    return free_memory;
+    size_t free;
+    uint32_t seq;
+    do {
+        seq = stats_seq.read_begin();
+        free = free_memory;
+    } while (stats_seq.read_retry(seq));
+    return free;
 }
 
 }
\ No newline at end of file
@@ -0,0 +1,177 @@
+#include <kernel/memory/kstack.h>
+#include <kernel/memory/pmm.h>
+#include <kernel/memory/vmm.h>
+#include <kernel/memory/heap.h>
+#include <kernel/lib/idr.h>
+#include <kernel/irq/softirq.h>
+#include <kernel/arch/x86_64/cpu.h>
+#include <kernel/arch/x86_64/gdt.h>
+#include <kernel/arch/x86_64/idt.h>
+#include <kernel/console.h>
+
+extern "C" void isr14();
+
+namespace Core {
+
+#define FAULT_STACK_SIZE (16 * 1024)
+
+// Recently freed stacks keep their committed pages so the next spawn on the
+// same CPU skips the page-table work. The reserve lets the fault path grow a
+// stack without entering the PMM, which may already be locked by the
+// faulting code; the fault path only schedules the refill tasklet, which
+// tops the reserve up at the next interrupt exit.
+struct StackCache {
+    uint64_t stacks[KernelStack::CACHE_SIZE];
+    uint32_t count;
+    uint32_t reserve_count;
+    uint64_t reserve[KernelStack::FAULT_RESERVE];
+    Tasklet refill;
+} ALIGNED(64);
+
+static StackCache caches[CPU::MAX_CPUS];
+static IDR slots;
+static size_t committed_pages = 0;
+
+static uint64_t slot_to_base(int slot) {
+    return KERNEL_STACK_AREA_START + (uint64_t)slot * KernelStack::SLOT_SIZE + KernelStack::GUARD_SIZE;
+}
+
+static int base_to_slot(uint64_t base) {
+    return (base - KernelStack::GUARD_SIZE - KERNEL_STACK_AREA_START) / KernelStack::SLOT_SIZE;
+}
+
+static void refill_reserve() {
+    uint64_t flags = CPU::irq_save();
+    StackCache& cache = caches[CPU::id()];
+
+    while (cache.reserve_count < KernelStack::FAULT_RESERVE) {
+        uint64_t phys = PMM::alloc_page();
+        if (!phys) break;
+        cache.reserve[cache.reserve_count++] = phys;
+    }
+
+    CPU::irq_restore(flags);
+}
+
+static void refill_tasklet(void*) {
+    refill_reserve();
+}
+
+static void release(uint64_t base) {
+    for (uint64_t addr = base; addr < base + KernelStack::STACK_SIZE; addr += PAGE_SIZE) {
+        uint64_t phys = VMM::virt_to_phys(addr);
+        if (phys) {
+            VMM::unmap_page(addr);
+            PMM::free_page(phys);
+            __atomic_fetch_sub(&committed_pages, 1, __ATOMIC_RELAXED);
+        }
+    }
+
+    slots.remove(base_to_slot(base));
+}
+
+void KernelStack::initialize() {
+    slots.initialize(0, KERNEL_STACK_AREA_SIZE / SLOT_SIZE - 1);
+    IDT::set_gate(14, (uint64_t)isr14, FAULT_IST);
+    init_cpu();
+}
+
+// Page faults switch to a stack of the CPU's own, so faults on two CPUs
+// never share one.
+void KernelStack::init_cpu() {
+    uint64_t phys = PMM::alloc_pages(FAULT_STACK_SIZE / PAGE_SIZE);
+    if (!phys) {
+        Console::printf("[KSTACK] No memory for CPU %u's fault stack\n", CPU::id());
+        return;
+    }
+    GDT::set_ist(FAULT_IST, phys + KERNEL_VIRTUAL_BASE + FAULT_STACK_SIZE);
+
+    caches[CPU::id()].refill.func = refill_tasklet;
+    refill_reserve();
+}
+
+uint64_t KernelStack::alloc() {
+    uint64_t flags = CPU::irq_save();
+    StackCache& cache = caches[CPU::id()];
+
+    if (cache.count > 0) {
+        uint64_t base = cache.stacks[--cache.count];
+        CPU::irq_restore(flags);
+        return base;
+    }
+    CPU::irq_restore(flags);
+
+    int slot = slots.alloc(nullptr);
+    if (slot < 0) {
+        return 0;
+    }
+
+    // The fault path may run with the PMM locked, so it must find every
+    // page table of the slot already in place. Tables are never freed, so
+    // this only allocates the first time a slot is used.
+    uint64_t base = slot_to_base(slot);
+    uint64_t phys = VMM::populate_tables(base, STACK_SIZE) ? PMM::alloc_page() : 0;
+    if (!phys) {
+        slots.remove(slot);
+        return 0;
+    }
+
+    VMM::map_page(base + STACK_SIZE - PAGE_SIZE, phys, VMM::PRESENT | VMM::WRITABLE);
+    __atomic_fetch_add(&committed_pages, 1, __ATOMIC_RELAXED);
+
+    refill_reserve();
+    return base;
+}
+
+void KernelStack::free(uint64_t base) {
+    if (!base) return;
+
+    uint64_t flags = CPU::irq_save();
+    StackCache& cache = caches[CPU::id()];
+
+    if (cache.count < CACHE_SIZE) {
+        cache.stacks[cache.count++] = base;
+        CPU::irq_restore(flags);
+        return;
+    }
+    CPU::irq_restore(flags);
+
+    release(base);
+}
+
+bool KernelStack::handle_fault(uint64_t addr, uint64_t rsp) {
+    if (addr < KERNEL_STACK_AREA_START || addr >= KERNEL_STACK_AREA_START + KERNEL_STACK_AREA_SIZE) {
+        return false;
+    }
+
+    if ((addr - KERNEL_STACK_AREA_START) % SLOT_SIZE < GUARD_SIZE) {
+        Console::printf("[KSTACK] Guard page hit at 0x%llx: kernel stack overflow\n", addr);
+        return false;
+    }
+
+    // Only a stack growing into its own slot is backed. Nothing runs on a
+    // freed or cached slot, so a stray access to one still faults.
+    if (rsp < KERNEL_STACK_AREA_START ||
+        (rsp - KERNEL_STACK_AREA_START) / SLOT_SIZE != (addr - KERNEL_STACK_AREA_START) / SLOT_SIZE) {
+        return false;
+    }
+
+    StackCache& cache = caches[CPU::id()];
+    if (cache.reserve_count == 0) {
+        Console::printf("[KSTACK] Fault reserve exhausted at 0x%llx\n", addr);
+        return false;
+    }
+    uint64_t phys = cache.reserve[--cache.reserve_count];
+
+    VMM::map_page(ALIGN_DOWN(addr, PAGE_SIZE), phys, VMM::PRESENT | VMM::WRITABLE);
+    __atomic_fetch_add(&committed_pages, 1, __ATOMIC_RELAXED);
+
+    Tasklet::schedule(&cache.refill);
+    return true;
+}
+
+size_t KernelStack::get_committed_pages() {
+    return __atomic_load_n(&committed_pages, __ATOMIC_RELAXED);
+}
+
+}
\ No newline at end of file
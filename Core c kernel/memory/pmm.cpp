@@ -6,14 +6,63 @@ namespace Core {
 PMM::FreeBlock* PMM::free_lists[MAX_ORDER];
 uint64_t* PMM::bitmap = nullptr;
 size_t PMM::total_pages = 0;
-size_t PMM::free_pages = 0;
-Spinlock PMM::lock;
+size_t PMM::free_page_count = 0;
+Spinlock PMM::lock("pmm");
+
+PMM::Region PMM::reserved[MAX_RESERVED];
+size_t PMM::reserved_count = 0;
+
+void PMM::reserve_early(uint64_t start, uint64_t end) {
+    if (end > start && reserved_count < MAX_RESERVED) {
+        reserved[reserved_count++] = {ALIGN_DOWN(start, PAGE_SIZE), ALIGN_UP(end, PAGE_SIZE)};
+    }
+}
+
+// First page-aligned address at or above `start` where `size` bytes
+// overlap no reserved region.
+uint64_t PMM::place_bitmap(uint64_t start, uint64_t size) {
+    uint64_t addr = ALIGN_UP(start, PAGE_SIZE);
+    bool moved = true;
+
+    while (moved) {
+        moved = false;
+        for (size_t i = 0; i < reserved_count; i++) {
+            if (addr < reserved[i].end && addr + size > reserved[i].start) {
+                addr = reserved[i].end;
+                moved = true;
+            }
+        }
+    }
+    return addr;
+}
+
+void PMM::free_unreserved(uint64_t start, uint64_t end) {
+    while (start < end) {
+        const Region* next = nullptr;
+        for (size_t i = 0; i < reserved_count; i++) {
+            if (reserved[i].end > start && reserved[i].start < end &&
+                (!next || reserved[i].start < next->start)) {
+                next = &reserved[i];
+            }
+        }
+
+        if (!next) {
+            mark_region_free(start, end);
+            return;
+        }
+        if (next->start > start) {
+            mark_region_free(start, next->start);
+        }
+        start = next->end;
+    }
+}
 
 void PMM::initialize(uint64_t total_memory, uint64_t kernel_end) {
     total_pages = total_memory / PAGE_SIZE;
     
     uint64_t bitmap_size = (total_pages + 63) / 64 * sizeof(uint64_t);
-    bitmap = (uint64_t*)(kernel_end + KERNEL_VIRTUAL_BASE);
+    uint64_t bitmap_phys = place_bitmap(kernel_end, bitmap_size);
+    bitmap = (uint64_t*)(bitmap_phys + KERNEL_VIRTUAL_BASE);
     
     for (size_t i = 0; i < (total_pages + 63) / 64; i++) {
         bitmap[i] = 0xFFFFFFFFFFFFFFFF;
@@ -23,12 +72,12 @@ void PMM::initialize(uint64_t total_memory, uint64_t kernel_end) {
         free_lists[i] = nullptr;
     }
     
-    free_pages = 0;
-    
-    uint64_t available_start = ALIGN_UP(kernel_end + bitmap_size, PAGE_SIZE);
-    uint64_t available_end = total_memory;
+    free_page_count = 0;
     
-    mark_region_free(available_start, available_end);
+    // Boot modules and the multiboot information usually sit right after
+    // the kernel image, so everything from there on skips the reservations.
+    reserve_early(bitmap_phys, bitmap_phys + bitmap_size);
+    free_unreserved(ALIGN_UP(kernel_end, PAGE_SIZE), total_memory);
 }
 
 uint64_t PMM::alloc_page() {
@@ -66,7 +115,7 @@ uint64_t PMM::alloc_pages(size_t count) {
         set_page_used((addr / PAGE_SIZE) + i);
     }
     
-    free_pages -= pages;
+    __atomic_store_n(&free_page_count, free_page_count - pages, __ATOMIC_RELAXED);
     
     return addr;
 }
@@ -88,7 +137,7 @@ void PMM::free_pages(uint64_t addr, size_t count) {
         set_page_free((addr / PAGE_SIZE) + i);
     }
     
-    free_pages += pages;
+    __atomic_store_n(&free_page_count, free_page_count + pages, __ATOMIC_RELAXED);
     
     addr = try_merge_buddy(addr, order);
     
@@ -133,21 +182,32 @@ void PMM::mark_region_free(uint64_t start, uint64_t end) {
         block->next = free_lists[order];
         free_lists[order] = block;
         
-        free_pages += block_pages;
+        free_page_count += block_pages;
         addr += block_pages * PAGE_SIZE;
     }
 }
 
+void PMM::release_region(uint64_t start, uint64_t end) {
+    start = ALIGN_UP(start, PAGE_SIZE);
+    end = ALIGN_DOWN(end, PAGE_SIZE);
+    if (start >= end) return;
+
+    ScopedLock guard(lock);
+    mark_region_free(start, end);
+}
+
 uint64_t PMM::get_total_memory() {
     return total_pages * PAGE_SIZE;
 }
 
+// The counter is only written under the lock; readers need no more than an
+// untorn load.
 uint64_t PMM::get_used_memory() {
-    return (total_pages - free_pages) * PAGE_SIZE;
+    return (total_pages - __atomic_load_n(&free_page_count, __ATOMIC_RELAXED)) * PAGE_SIZE;
 }
 
 uint64_t PMM::get_free_memory() {
-    return free_pages * PAGE_SIZE;
+    return __atomic_load_n(&free_page_count, __ATOMIC_RELAXED) * PAGE_SIZE;
 }
 
 size_t PMM::get_order(size_t pages) {
@@ -0,0 +1,79 @@
+#include <kernel/memory/shared.h>
+#include <kernel/memory/pmm.h>
+#include <kernel/memory/vmm.h>
+#include <kernel/memory/copy.h>
+#include <kernel/sync/spinlock.h>
+#include <kernel/arch/x86_64/tlb.h>
+
+namespace Core {
+
+#define VA_SLOTS (USER_SHARED_SIZE / SharedMemory::MAX_SIZE)
+
+// Each region gets a fixed MAX_SIZE slot of the shared window.
+static uint64_t va_map[VA_SLOTS / 64];
+static Spinlock va_lock("shared_va");
+
+static uint64_t alloc_va() {
+    uint64_t addr = 0;
+
+    ScopedLock guard(va_lock);
+    for (uint64_t slot = 0; slot < VA_SLOTS; slot++) {
+        if (!(va_map[slot / 64] & BIT(slot % 64))) {
+            va_map[slot / 64] |= BIT(slot % 64);
+            addr = USER_SHARED_START + slot * SharedMemory::MAX_SIZE;
+            break;
+        }
+    }
+    return addr;
+}
+
+static void free_va(uint64_t addr) {
+    uint64_t slot = (addr - USER_SHARED_START) / SharedMemory::MAX_SIZE;
+
+    ScopedLock guard(va_lock);
+    va_map[slot / 64] &= ~BIT(slot % 64);
+}
+
+bool SharedMemory::alloc(SharedRegion* region, size_t size) {
+    if (!size || size > MAX_SIZE) {
+        return false;
+    }
+
+    region->pages = ALIGN_UP(size, PAGE_SIZE) / PAGE_SIZE;
+    region->phys = PMM::alloc_pages(region->pages);
+    if (!region->phys) {
+        return false;
+    }
+
+    region->user_addr = alloc_va();
+    if (!region->user_addr) {
+        PMM::free_pages(region->phys, region->pages);
+        return false;
+    }
+
+    // Handed to userspace, so it must not carry stale data.
+    region->kernel = (void*)(region->phys + KERNEL_VIRTUAL_BASE);
+    zero_pages(region->kernel, region->pages);
+
+    for (size_t i = 0; i < region->pages; i++) {
+        VMM::map_page(region->user_addr + i * PAGE_SIZE, region->phys + i * PAGE_SIZE,
+                      VMM::PRESENT | VMM::WRITABLE | VMM::USER);
+    }
+    return true;
+}
+
+// Every CPU shares the mapping, so all of them must drop it before the
+// frames can be reused.
+void SharedMemory::free(SharedRegion* region) {
+    TLB::Batch batch = {};
+    for (size_t i = 0; i < region->pages; i++) {
+        VMM::clear_pte(region->user_addr + i * PAGE_SIZE);
+        TLB::add(&batch, region->user_addr + i * PAGE_SIZE);
+    }
+    TLB::flush(&batch);
+
+    PMM::free_pages(region->phys, region->pages);
+    free_va(region->user_addr);
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,73 @@
+#include <kernel/memory/slab.h>
+#include <kernel/memory/pmm.h>
+
+namespace Core {
+
+ObjectCache::ObjectCache(const char* cache_name, size_t size)
+    : name(cache_name),
+      object_size(ALIGN_UP(MAX(size, sizeof(FreeObject)), 16)),
+      allocated(0),
+      pages(0),
+      free_list(nullptr),
+      lock(cache_name) {}
+
+void ObjectCache::set_object_size(size_t size) {
+    object_size = ALIGN_UP(MAX(size, sizeof(FreeObject)), 16);
+}
+
+bool ObjectCache::grow() {
+    uint64_t phys = PMM::alloc_page();
+    if (!phys) return false;
+
+    uint8_t* page = (uint8_t*)(phys + KERNEL_VIRTUAL_BASE);
+    size_t count = PAGE_SIZE / object_size;
+
+    for (size_t i = 0; i < count; i++) {
+        FreeObject* object = (FreeObject*)(page + i * object_size);
+        object->next = free_list;
+        free_list = object;
+    }
+
+    pages++;
+    return true;
+}
+
+void* ObjectCache::alloc() {
+    ScopedLock guard(lock);
+
+    if (!free_list && !grow()) {
+        return nullptr;
+    }
+
+    FreeObject* object = free_list;
+    free_list = object->next;
+    allocated++;
+
+    return object;
+}
+
+void* ObjectCache::zalloc() {
+    void* object = alloc();
+
+    if (object) {
+        uint64_t* words = (uint64_t*)object;
+        for (size_t i = 0; i < object_size / sizeof(uint64_t); i++) {
+            words[i] = 0;
+        }
+    }
+
+    return object;
+}
+
+void ObjectCache::free(void* ptr) {
+    if (!ptr) return;
+
+    ScopedLock guard(lock);
+
+    FreeObject* object = (FreeObject*)ptr;
+    object->next = free_list;
+    free_list = object;
+    allocated--;
+}
+
+}
\ No newline at end of file
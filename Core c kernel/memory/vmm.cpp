@@ -4,90 +4,126 @@
 namespace Core {
 
 static uint64_t* kernel_pml4 = nullptr;
+static uint64_t mmio_next = KERNEL_MMIO_START;
+
+Spinlock VMM::user_map_lock("user_map");
 
 void VMM::initialize() {
     __asm__ volatile("mov %%cr3, %0" : "=r"(kernel_pml4));
     kernel_pml4 = (uint64_t*)((uint64_t)kernel_pml4 + KERNEL_VIRTUAL_BASE);
 }
 
-void* VMM::map_page(uint64_t virt, uint64_t phys, uint32_t flags) {
-    uint64_t pml4_idx = (virt >> 39) & 0x1FF;
-    uint64_t pdpt_idx = (virt >> 30) & 0x1FF;
-    uint64_t pd_idx = (virt >> 21) & 0x1FF;
-    uint64_t pt_idx = (virt >> 12) & 0x1FF;
-    
-    uint64_t* pdpt;
-    if (!(kernel_pml4[pml4_idx] & PRESENT)) {
-        pdpt = (uint64_t*)(PMM::alloc_page() + KERNEL_VIRTUAL_BASE);
-        for (int i = 0; i < 512; i++) pdpt[i] = 0;
-        kernel_pml4[pml4_idx] = ((uint64_t)pdpt - KERNEL_VIRTUAL_BASE) | PRESENT | WRITABLE;
-    } else {
-        pdpt = (uint64_t*)((kernel_pml4[pml4_idx] & ~0xFFF) + KERNEL_VIRTUAL_BASE);
-    }
-    
-    uint64_t* pd;
-    if (!(pdpt[pdpt_idx] & PRESENT)) {
-        pd = (uint64_t*)(PMM::alloc_page() + KERNEL_VIRTUAL_BASE);
-        for (int i = 0; i < 512; i++) pd[i] = 0;
-        pdpt[pdpt_idx] = ((uint64_t)pd - KERNEL_VIRTUAL_BASE) | PRESENT | WRITABLE;
-    } else {
-        pd = (uint64_t*)((pdpt[pdpt_idx] & ~0xFFF) + KERNEL_VIRTUAL_BASE);
+// Returns the page-table entry for `virt`, or nullptr if a level is missing
+// and `create` is false. Intermediate tables created here get `flags & USER`
+// so user pages are reachable; existing ones are widened the same way.
+uint64_t* VMM::walk(uint64_t virt, uint32_t flags, bool create) {
+    uint64_t indices[3] = {(virt >> 39) & 0x1FF, (virt >> 30) & 0x1FF, (virt >> 21) & 0x1FF};
+    uint64_t table_flags = PRESENT | WRITABLE | (flags & USER);
+    uint64_t* table = kernel_pml4;
+
+    for (int level = 0; level < 3; level++) {
+        uint64_t& entry = table[indices[level]];
+
+        if (!(entry & PRESENT)) {
+            if (!create) {
+                return nullptr;
+            }
+            uint64_t phys = PMM::alloc_page();
+            if (!phys) {
+                return nullptr;
+            }
+            uint64_t* next = (uint64_t*)(phys + KERNEL_VIRTUAL_BASE);
+            for (int i = 0; i < 512; i++) next[i] = 0;
+            entry = phys | table_flags;
+        } else if (create) {
+            entry |= flags & USER;
+        }
+
+        table = (uint64_t*)((entry & ~0xFFF) + KERNEL_VIRTUAL_BASE);
     }
-    
-    uint64_t* pt;
-    if (!(pd[pd_idx] & PRESENT)) {
-        pt = (uint64_t*)(PMM::alloc_page() + KERNEL_VIRTUAL_BASE);
-        for (int i = 0; i < 512; i++) pt[i] = 0;
-        pd[pd_idx] = ((uint64_t)pt - KERNEL_VIRTUAL_BASE) | PRESENT | WRITABLE;
-    } else {
-        pt = (uint64_t*)((pd[pd_idx] & ~0xFFF) + KERNEL_VIRTUAL_BASE);
+
+    return &table[(virt >> 12) & 0x1FF];
+}
+
+void VMM::set_pte(uint64_t virt, uint64_t phys, uint32_t flags) {
+    *walk(virt, flags, true) = (phys & ~0xFFF) | flags;
+}
+
+uint64_t VMM::get_pte(uint64_t virt) {
+    uint64_t* pte = walk(virt, 0, false);
+    return pte && (*pte & PRESENT) ? *pte : 0;
+}
+
+uint64_t VMM::clear_pte(uint64_t virt) {
+    uint64_t* pte = walk(virt, 0, false);
+    if (!pte || !(*pte & PRESENT)) {
+        return 0;
     }
-    
-    pt[pt_idx] = (phys & ~0xFFF) | flags;
-    
+
+    uint64_t old = *pte;
+    *pte = 0;
+    return old;
+}
+
+void* VMM::map_page(uint64_t virt, uint64_t phys, uint32_t flags) {
+    set_pte(virt, phys, flags);
     __asm__ volatile("invlpg (%0)" : : "r"(virt) : "memory");
-    
     return (void*)virt;
 }
 
 void VMM::unmap_page(uint64_t virt) {
-    uint64_t pml4_idx = (virt >> 39) & 0x1FF;
-    uint64_t pdpt_idx = (virt >> 30) & 0x1FF;
-    uint64_t pd_idx = (virt >> 21) & 0x1FF;
-    uint64_t pt_idx = (virt >> 12) & 0x1FF;
-    
-    if (!(kernel_pml4[pml4_idx] & PRESENT)) return;
-    uint64_t* pdpt = (uint64_t*)((kernel_pml4[pml4_idx] & ~0xFFF) + KERNEL_VIRTUAL_BASE);
-    
-    if (!(pdpt[pdpt_idx] & PRESENT)) return;
-    uint64_t* pd = (uint64_t*)((pdpt[pdpt_idx] & ~0xFFF) + KERNEL_VIRTUAL_BASE);
-    
-    if (!(pd[pd_idx] & PRESENT)) return;
-    uint64_t* pt = (uint64_t*)((pd[pd_idx] & ~0xFFF) + KERNEL_VIRTUAL_BASE);
-    
-    pt[pt_idx] = 0;
+    clear_pte(virt);
     __asm__ volatile("invlpg (%0)" : : "r"(virt) : "memory");
 }
 
+bool VMM::populate_tables(uint64_t virt, size_t length) {
+    // One leaf table covers 2 MiB.
+    for (uint64_t addr = ALIGN_DOWN(virt, 0x200000ULL); addr < virt + length; addr += 0x200000) {
+        if (!walk(addr, 0, true)) {
+            return false;
+        }
+    }
+    return true;
+}
+
 uint64_t VMM::virt_to_phys(uint64_t virt) {
-    uint64_t pml4_idx = (virt >> 39) & 0x1FF;
-    uint64_t pdpt_idx = (virt >> 30) & 0x1FF;
-    uint64_t pd_idx = (virt >> 21) & 0x1FF;
-    uint64_t pt_idx = (virt >> 12) & 0x1FF;
-    uint64_t offset = virt & 0xFFF;
-    
-    if (!(kernel_pml4[pml4_idx] & PRESENT)) return 0;
-    uint64_t* pdpt = (uint64_t*)((kernel_pml4[pml4_idx] & ~0xFFF) + KERNEL_VIRTUAL_BASE);
-    
-    if (!(pdpt[pdpt_idx] & PRESENT)) return 0;
-    uint64_t* pd = (uint64_t*)((pdpt[pdpt_idx] & ~0xFFF) + KERNEL_VIRTUAL_BASE);
-    
-    if (!(pd[pd_idx] & PRESENT)) return 0;
-    uint64_t* pt = (uint64_t*)((pd[pd_idx] & ~0xFFF) + KERNEL_VIRTUAL_BASE);
-    
-    if (!(pt[pt_idx] & PRESENT)) return 0;
-    
-    return (pt[pt_idx] & ~0xFFF) | offset;
+    uint64_t* pte = walk(virt, 0, false);
+    if (!pte || !(*pte & PRESENT)) {
+        return 0;
+    }
+
+    return (*pte & ~0xFFF) | (virt & 0xFFF);
+}
+
+bool VMM::is_user_range(uint64_t virt, size_t length) {
+    return length && !(virt & (PAGE_SIZE - 1)) && !(length & (PAGE_SIZE - 1)) &&
+           virt >= USER_SPACE_START && virt < USER_SHARED_START &&
+           length <= USER_SHARED_START - virt;
+}
+
+bool VMM::is_range_free(uint64_t virt, size_t length) {
+    for (size_t offset = 0; offset < length; offset += PAGE_SIZE) {
+        if (virt_to_phys(virt + offset)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void* VMM::map_mmio(uint64_t phys, size_t size) {
+    uint64_t base = ALIGN_DOWN(phys, PAGE_SIZE);
+    size_t length = ALIGN_UP(phys + size, PAGE_SIZE) - base;
+
+    uint64_t virt = __atomic_fetch_add(&mmio_next, length, __ATOMIC_RELAXED);
+    if (virt + length > KERNEL_MMIO_START + KERNEL_MMIO_SIZE) {
+        return nullptr;
+    }
+
+    for (size_t offset = 0; offset < length; offset += PAGE_SIZE) {
+        map_page(virt + offset, base + offset, PRESENT | WRITABLE | WRITE_THROUGH | CACHE_DISABLE);
+    }
+
+    return (void*)(virt + (phys - base));
 }
 
 }
\ No newline at end of file
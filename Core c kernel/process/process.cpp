@@ -1,59 +1,222 @@
 #include <kernel/process/process.h>
-#include <kernel/memory/heap.h>
+#include <kernel/process/scheduler.h>
+#include <kernel/memory/kstack.h>
+#include <kernel/memory/slab.h>
+#include <kernel/lib/idr.h>
+#include <kernel/arch/x86_64/cpu.h>
+#include <kernel/arch/x86_64/fpu.h>
 #include <kernel/console.h>
 
 namespace Core {
 
-static int next_pid = 1;
+static ObjectCache process_cache("process", sizeof(Process));
+static ObjectCache thread_cache("thread", sizeof(Thread));
+static IDR pid_table;
+static IDR tid_table;
+static Process* kernel_process = nullptr;
 
-struct ProcessData {
-    int pid;
-    const char* name;
-    thread_func_t func;
-    void* arg;
-    uint64_t stack;
-    bool running;
-};
+static void thread_entry() {
+    Scheduler::finish_switch();
+    __asm__ volatile("sti");
 
-#define MAX_PROCESSES 256
-static ProcessData processes[MAX_PROCESSES];
-static int process_count = 0;
-static ProcessData* current_process = nullptr;
+    Thread* thread = CPU::local()->current_thread;
+    ProcessManager::exit_thread(thread->func(thread->arg));
+}
 
-void ProcessManager::initialize() {
-    for (int i = 0; i < MAX_PROCESSES; i++) {
-        processes[i].pid = 0;
-        processes[i].running = false;
+static void free_thread(RcuHead* head) {
+    thread_cache.free((uint8_t*)head - offsetof(Thread, rcu));
+}
+
+static void free_process(RcuHead* head) {
+    process_cache.free((uint8_t*)head - offsetof(Process, rcu));
+}
+
+static Process* alloc_process(const char* name) {
+    Process* proc = (Process*)process_cache.zalloc();
+    if (!proc) {
+        return nullptr;
     }
-    process_count = 0;
+
+    proc->name = name;
+    proc->refs = 1;
+    proc->pid = pid_table.alloc(proc);
+    if (proc->pid < 0) {
+        process_cache.free(proc);
+        return nullptr;
+    }
+
+    return proc;
+}
+
+void ProcessManager::initialize() {
+    pid_table.initialize(1, PID_MAX - 1);
+    tid_table.initialize(1, PID_MAX - 1);
+
+    // Holds kernel worker threads; it never runs out of threads, so it is
+    // never reaped.
+    kernel_process = alloc_process("kernel");
+    kernel_process->thread_count = 1;
 }
 
 Process* ProcessManager::create_kernel_process(const char* name, thread_func_t func, void* arg) {
-    if (process_count >= MAX_PROCESSES) {
+    Process* proc = alloc_process(name);
+    if (!proc) {
         return nullptr;
     }
-    
-    ProcessData* proc = &processes[process_count++];
-    proc->pid = next_pid++;
-    proc->name = name;
-    proc->func = func;
-    proc->arg = arg;
-    proc->stack = (uint64_t)Heap::malloc(64 * 1024);
-    proc->running = true;
-    
-    return (Process*)proc;
+
+    if (!create_thread(proc, name, func, arg)) {
+        pid_table.remove(proc->pid);
+        process_cache.free(proc);
+        return nullptr;
+    }
+
+    return proc;
+}
+
+Thread* ProcessManager::create_kernel_thread(const char* name, thread_func_t func, void* arg, int cpu) {
+    return create_thread(kernel_process, name, func, arg, cpu);
+}
+
+Thread* ProcessManager::create_thread(Process* proc, const char* name, thread_func_t func, void* arg, int cpu) {
+    Thread* thread = (Thread*)thread_cache.zalloc();
+    if (!thread) {
+        return nullptr;
+    }
+
+    thread->tid = tid_table.alloc(thread);
+    if (thread->tid < 0) {
+        thread_cache.free(thread);
+        return nullptr;
+    }
+
+    thread->stack_base = KernelStack::alloc();
+    if (!thread->stack_base) {
+        tid_table.remove(thread->tid);
+        thread_cache.free(thread);
+        return nullptr;
+    }
+    thread->stack_top = thread->stack_base + KernelStack::STACK_SIZE;
+
+    thread->name = name;
+    thread->func = func;
+    thread->arg = arg;
+    thread->process = proc;
+    thread->state = Thread::State::READY;
+
+    // Initial frame consumed by context_switch: six callee-saved registers
+    // followed by the return address.
+    uint64_t* sp = (uint64_t*)thread->stack_top;
+    *--sp = 0;
+    *--sp = (uint64_t)thread_entry;
+    for (int i = 0; i < 6; i++) {
+        *--sp = 0;
+    }
+    thread->saved_rsp = (uint64_t)sp;
+
+    {
+        ScopedLock guard(proc->lock);
+        thread->process_next = proc->threads;
+        if (proc->threads) {
+            proc->threads->process_prev = thread;
+        }
+        proc->threads = thread;
+        proc->thread_count++;
+    }
+
+    if (cpu >= 0) {
+        Scheduler::enqueue_on(thread, cpu);
+    } else {
+        Scheduler::enqueue(thread);
+    }
+    return thread;
+}
+
+Process* ProcessManager::find_process(int pid) {
+    return (Process*)pid_table.find(pid);
+}
+
+void ProcessManager::get(Process* proc) {
+    __atomic_fetch_add(&proc->refs, 1, __ATOMIC_RELAXED);
+}
+
+void ProcessManager::put(Process* proc) {
+    if (__atomic_sub_fetch(&proc->refs, 1, __ATOMIC_ACQ_REL) == 0) {
+        call_rcu(&proc->rcu, free_process);
+    }
+}
+
+Thread* ProcessManager::find_thread(int tid) {
+    return (Thread*)tid_table.find(tid);
 }
 
 Process* ProcessManager::get_current() {
-    return (Process*)current_process;
+    Thread* thread = CPU::local()->current_thread;
+    return thread ? thread->process : nullptr;
+}
+
+Thread* ProcessManager::get_current_thread() {
+    return CPU::local()->current_thread;
 }
 
 void ProcessManager::exit(int code) {
-    if (current_process) {
-        Console::printf("[PROC] Process %d exited with code %d\n", 
-                       current_process->pid, code);
-        current_process->running = false;
+    Process* proc = get_current();
+    if (proc) {
+        Console::printf("[PROC] Process %d exited with code %d\n", proc->pid, code);
+        proc->exit_code = code;
     }
+    exit_thread(nullptr);
+}
+
+void ProcessManager::exit_thread(void* value) {
+    Thread* thread = CPU::local()->current_thread;
+
+    __asm__ volatile("cli");
+    thread->exit_value = value;
+    thread->state = Thread::State::DEAD;
+    Scheduler::schedule();
+
+    while (true) {
+        __asm__ volatile("cli; hlt");
+    }
+}
+
+void ProcessManager::reap(Thread* thread) {
+    Process* proc = thread->process;
+    bool last;
+
+    tid_table.remove(thread->tid);
+    KernelStack::free(thread->stack_base);
+    FPU::release(thread);
+
+    {
+        ScopedLock guard(proc->lock);
+        if (thread->process_prev) {
+            thread->process_prev->process_next = thread->process_next;
+        } else {
+            proc->threads = thread->process_next;
+        }
+        if (thread->process_next) {
+            thread->process_next->process_prev = thread->process_prev;
+        }
+        last = --proc->thread_count == 0;
+    }
+
+    // find_thread()/find_process() callers may still hold a reference.
+    call_rcu(&thread->rcu, free_thread);
+
+    if (last) {
+        proc->handles.close_all();
+        pid_table.remove(proc->pid);
+        put(proc);
+    }
+}
+
+size_t ProcessManager::get_process_count() {
+    return pid_table.get_count();
+}
+
+size_t ProcessManager::get_thread_count() {
+    return tid_table.get_count();
 }
 
 }
\ No newline at end of file
@@ -1,23 +1,256 @@
 #include <kernel/process/scheduler.h>
+#include <kernel/process/process.h>
+#include <kernel/sync/spinlock.h>
+#include <kernel/sync/rcu.h>
+#include <kernel/arch/x86_64/cpu.h>
+#include <kernel/arch/x86_64/gdt.h>
+#include <kernel/arch/x86_64/fpu.h>
+#include <kernel/arch/x86_64/pit.h>
 #include <kernel/console.h>
 
+extern "C" void context_switch(uint64_t* old_rsp, uint64_t new_rsp);
+
 namespace Core {
 
+struct RunQueue {
+    Spinlock lock;
+    Thread* head;
+    Thread* tail;
+    Thread* prev;
+    Thread* sleepers;
+    uint32_t nr_running;
+    uint32_t slice_ticks;
+    uint64_t switches;
+} ALIGNED(64);
+
+static RunQueue run_queues[CPU::MAX_CPUS];
+static Thread idle_threads[CPU::MAX_CPUS];
 static bool scheduler_running = false;
 
+static void push_tail(RunQueue& rq, Thread* thread) {
+    if (thread->on_rq) return;
+
+    thread->run_next = nullptr;
+    thread->on_rq = true;
+    if (rq.tail) {
+        rq.tail->run_next = thread;
+    } else {
+        rq.head = thread;
+    }
+    rq.tail = thread;
+    rq.nr_running++;
+}
+
+static Thread* pop_head(RunQueue& rq) {
+    Thread* thread = rq.head;
+    if (thread) {
+        rq.head = thread->run_next;
+        if (!rq.head) {
+            rq.tail = nullptr;
+        }
+        thread->on_rq = false;
+        rq.nr_running--;
+    }
+    return thread;
+}
+
+static void switch_context(CPU::Local* local, RunQueue& rq, Thread* prev, Thread* next) {
+    local->current_thread = next;
+    rq.prev = prev;
+    rq.switches++;
+
+    if (next->stack_top) {
+        GDT::install_tss(next->stack_top);
+        local->kernel_rsp = next->stack_top;
+    }
+    FPU::switch_to(next);
+
+    context_switch(&prev->saved_rsp, next->saved_rsp);
+    Scheduler::finish_switch();
+}
+
 void Scheduler::initialize() {
+    for (uint32_t cpu = 0; cpu < CPU::MAX_CPUS; cpu++) {
+        run_queues[cpu].lock.set_name("runqueue");
+    }
     scheduler_running = false;
 }
 
 void Scheduler::start() {
+    CPU::Local* local = CPU::local();
+    Thread* idle = &idle_threads[local->id];
+
+    idle->name = "idle";
+    idle->state = Thread::State::RUNNING;
+    idle->cpu = local->id;
+    local->idle_thread = idle;
+    local->current_thread = idle;
     scheduler_running = true;
-    
+
     while (true) {
+        schedule();
         __asm__ volatile("hlt");
     }
 }
 
+void Scheduler::enqueue(Thread* thread) {
+    enqueue_on(thread, scheduler_running ? CPU::id() : 0);
+}
+
+void Scheduler::enqueue_on(Thread* thread, uint32_t cpu) {
+    RunQueue& rq = run_queues[cpu];
+
+    uint64_t flags = rq.lock.lock_irqsave();
+    thread->cpu = cpu;
+    thread->state = Thread::State::READY;
+    push_tail(rq, thread);
+    rq.lock.unlock_irqrestore(flags);
+}
+
+bool Scheduler::wake(Thread* thread) {
+    RunQueue& rq = run_queues[thread->cpu];
+    bool woken = false;
+
+    uint64_t flags = rq.lock.lock_irqsave();
+    if (thread->state == Thread::State::BLOCKED) {
+        thread->state = Thread::State::READY;
+        push_tail(rq, thread);
+        woken = true;
+    }
+    rq.lock.unlock_irqrestore(flags);
+
+    if (woken && thread->cpu == CPU::id() &&
+        CPU::local()->current_thread == CPU::local()->idle_thread) {
+        CPU::local()->need_resched = true;
+    }
+
+    return woken;
+}
+
+void Scheduler::schedule() {
+    if (!scheduler_running) return;
+
+    uint64_t flags = CPU::irq_save();
+    CPU::Local* local = CPU::local();
+    RunQueue& rq = run_queues[local->id];
+    Thread* prev = local->current_thread;
+
+    RCU::note_context_switch();
+    rq.lock.lock();
+    local->need_resched = false;
+    rq.slice_ticks = 0;
+
+    Thread* next = pop_head(rq);
+    if (prev->state == Thread::State::RUNNING && prev != local->idle_thread) {
+        if (next) {
+            prev->state = Thread::State::READY;
+            push_tail(rq, prev);
+        } else {
+            next = prev;
+        }
+    }
+    if (!next) {
+        next = local->idle_thread;
+    }
+    next->state = Thread::State::RUNNING;
+    rq.lock.unlock();
+
+    if (next != prev) {
+        switch_context(local, rq, prev, next);
+    }
+
+    CPU::irq_restore(flags);
+}
+
+// Direct handoff for IPC: the caller has already blocked itself and owns
+// `next`, a blocked thread of this CPU that is on no run queue, so neither
+// side touches the run queue or its lock. The rest of the current time
+// slice passes to `next`.
+void Scheduler::switch_to(Thread* next) {
+    uint64_t flags = CPU::irq_save();
+    CPU::Local* local = CPU::local();
+    Thread* prev = local->current_thread;
+
+    RCU::note_context_switch();
+    next->state = Thread::State::RUNNING;
+    switch_context(local, run_queues[local->id], prev, next);
+
+    CPU::irq_restore(flags);
+}
+
+void Scheduler::finish_switch() {
+    RunQueue& rq = run_queues[CPU::id()];
+    Thread* prev = rq.prev;
+
+    rq.prev = nullptr;
+    if (prev && prev->state == Thread::State::DEAD) {
+        ProcessManager::reap(prev);
+    }
+}
+
 void Scheduler::yield() {
+    schedule();
+}
+
+bool Scheduler::can_block() {
+    CPU::Local* local = CPU::local();
+    return scheduler_running && local->preempt_count == 0 &&
+           local->current_thread != local->idle_thread;
+}
+
+void Scheduler::sleep_until(uint64_t tick) {
+    CPU::Local* local = CPU::local();
+    RunQueue& rq = run_queues[local->id];
+    Thread* current = local->current_thread;
+
+    uint64_t flags = rq.lock.lock_irqsave();
+
+    current->wake_tick = tick;
+    Thread** link = &rq.sleepers;
+    while (*link && (*link)->wake_tick <= tick) {
+        link = &(*link)->sleep_next;
+    }
+    current->sleep_next = *link;
+    *link = current;
+    current->state = Thread::State::BLOCKED;
+
+    rq.lock.unlock();
+    schedule();
+    CPU::irq_restore(flags);
+}
+
+void Scheduler::tick() {
+    if (!scheduler_running) return;
+
+    CPU::Local* local = CPU::local();
+    RunQueue& rq = run_queues[local->id];
+    uint64_t now = PIT::get_ticks();
+
+    RCU::tick();
+
+    uint64_t flags = rq.lock.lock_irqsave();
+    while (rq.sleepers && rq.sleepers->wake_tick <= now) {
+        Thread* thread = rq.sleepers;
+        rq.sleepers = thread->sleep_next;
+        if (thread->state == Thread::State::BLOCKED) {
+            thread->state = Thread::State::READY;
+            push_tail(rq, thread);
+        }
+    }
+    rq.lock.unlock_irqrestore(flags);
+
+    if (++rq.slice_ticks >= TIME_SLICE_TICKS ||
+        (local->current_thread == local->idle_thread && rq.nr_running > 0)) {
+        local->need_resched = true;
+    }
+}
+
+uint64_t Scheduler::get_switch_count() {
+    uint64_t total = 0;
+    for (uint32_t cpu = 0; cpu < CPU::online_count(); cpu++) {
+        total += run_queues[cpu].switches;
+    }
+    return total;
 }
 
 }
\ No newline at end of file
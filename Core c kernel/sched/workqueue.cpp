@@ -0,0 +1,112 @@
+#include <kernel/process/workqueue.h>
+#include <kernel/process/process.h>
+#include <kernel/sync/completion.h>
+#include <kernel/memory/heap.h>
+
+namespace Core {
+
+static WorkQueue* system_queue = nullptr;
+
+void* WorkQueue::worker_main(void* arg) {
+    Worker* worker = (Worker*)arg;
+
+    while (true) {
+        worker->wait.wait_event([worker] {
+            return __atomic_load_n(&worker->pending, __ATOMIC_ACQUIRE) != nullptr;
+        });
+
+        // Producers push LIFO; reverse the detached batch to run it in order.
+        Work* batch = __atomic_exchange_n(&worker->pending, nullptr, __ATOMIC_ACQUIRE);
+        Work* ordered = nullptr;
+        while (batch) {
+            Work* next = batch->next;
+            batch->next = ordered;
+            ordered = batch;
+            batch = next;
+        }
+
+        uint32_t ran = 0;
+        while (ordered) {
+            Work* work = ordered;
+            ordered = ordered->next;
+            __atomic_store_n(&work->pending, 0, __ATOMIC_RELEASE);
+            work->func(work);
+            worker->executed++;
+
+            if (++ran % BATCH_SIZE == 0) {
+                Scheduler::yield();
+            }
+        }
+    }
+
+    return nullptr;
+}
+
+void WorkQueue::initialize() {
+    system_queue = create("kworker");
+}
+
+WorkQueue* WorkQueue::create(const char* name) {
+    WorkQueue* wq = (WorkQueue*)Heap::calloc(1, sizeof(WorkQueue));
+    if (!wq) {
+        return nullptr;
+    }
+
+    wq->name = name;
+    for (uint32_t cpu = 0; cpu < CPU::online_count(); cpu++) {
+        Worker* worker = &wq->workers[cpu];
+        worker->queue = wq;
+        worker->cpu = cpu;
+        ProcessManager::create_kernel_thread(name, worker_main, worker, cpu);
+    }
+
+    return wq;
+}
+
+WorkQueue* WorkQueue::system() {
+    return system_queue;
+}
+
+bool WorkQueue::queue(Work* work) {
+    return queue_on(CPU::id(), work);
+}
+
+bool WorkQueue::queue_on(uint32_t cpu, Work* work) {
+    if (__atomic_exchange_n(&work->pending, 1, __ATOMIC_ACQ_REL)) {
+        return false;
+    }
+
+    Worker* worker = &workers[cpu];
+    Work* head = __atomic_load_n(&worker->pending, __ATOMIC_RELAXED);
+    do {
+        work->next = head;
+    } while (!__atomic_compare_exchange_n(&worker->pending, &head, work, true,
+                                          __ATOMIC_RELEASE, __ATOMIC_RELAXED));
+
+    if (!head) {
+        worker->wait.wake_one();
+    }
+
+    return true;
+}
+
+struct FlushWork {
+    Work work;
+    Completion done;
+};
+
+static void flush_func(Work* work) {
+    ((FlushWork*)work)->done.complete();
+}
+
+void WorkQueue::flush() {
+    for (uint32_t cpu = 0; cpu < CPU::online_count(); cpu++) {
+        FlushWork barrier;
+        barrier.work.func = flush_func;
+        barrier.work.pending = 0;
+        queue_on(cpu, &barrier.work);
+        barrier.done.wait();
+    }
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,39 @@
+#include <kernel/sync/completion.h>
+
+namespace Core {
+
+bool Completion::try_wait() {
+    uint32_t value = __atomic_load_n(&done, __ATOMIC_ACQUIRE);
+
+    while (value != 0) {
+        if (value == DONE_ALL) return true;
+        if (__atomic_compare_exchange_n(&done, &value, value - 1, false,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_ACQUIRE)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void Completion::wait() {
+    waiters.wait_event([this] { return try_wait(); });
+}
+
+void Completion::complete() {
+    uint32_t value = __atomic_load_n(&done, __ATOMIC_RELAXED);
+
+    while (value != DONE_ALL &&
+           !__atomic_compare_exchange_n(&done, &value, value + 1, false,
+                                        __ATOMIC_RELEASE, __ATOMIC_RELAXED)) {
+    }
+
+    waiters.wake_one();
+}
+
+void Completion::complete_all() {
+    __atomic_store_n(&done, DONE_ALL, __ATOMIC_RELEASE);
+    waiters.wake_all();
+}
+
+}
\ No newline at end of file
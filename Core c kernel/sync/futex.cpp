@@ -0,0 +1,87 @@
+#include <kernel/sync/futex.h>
+#include <kernel/sync/spinlock.h>
+#include <kernel/process/process.h>
+#include <kernel/process/scheduler.h>
+#include <kernel/arch/x86_64/cpu.h>
+
+namespace Core {
+
+struct FutexWaiter {
+    Process* process;
+    uint32_t* addr;
+    Thread* thread;
+    FutexWaiter* next;
+    bool woken;
+};
+
+struct FutexBucket {
+    Spinlock lock;
+    FutexWaiter* head;
+} ALIGNED(64);
+
+static FutexBucket buckets[Futex::BUCKETS];
+
+static FutexBucket& bucket_for(Process* process, uint32_t* addr) {
+    uint64_t key = ((uint64_t)addr >> 2) ^ ((uint64_t)process >> 6);
+    key *= 0x9E3779B97F4A7C15ULL;
+    return buckets[key >> 56];
+}
+
+error_t Futex::wait(uint32_t* addr, uint32_t expected) {
+    Thread* current = ProcessManager::get_current_thread();
+    FutexBucket& bucket = bucket_for(current->process, addr);
+
+    FutexWaiter waiter;
+    waiter.process = current->process;
+    waiter.addr = addr;
+    waiter.thread = current;
+    waiter.woken = false;
+
+    uint64_t flags = bucket.lock.lock_irqsave();
+
+    if (__atomic_load_n(addr, __ATOMIC_SEQ_CST) != expected) {
+        bucket.lock.unlock_irqrestore(flags);
+        return E_AGAIN;
+    }
+
+    waiter.next = bucket.head;
+    bucket.head = &waiter;
+
+    while (!waiter.woken) {
+        current->state = Thread::State::BLOCKED;
+        bucket.lock.unlock();
+        Scheduler::schedule();
+        bucket.lock.lock();
+    }
+
+    bucket.lock.unlock_irqrestore(flags);
+
+    return E_OK;
+}
+
+uint32_t Futex::wake(uint32_t* addr, uint32_t count) {
+    Process* process = ProcessManager::get_current();
+    FutexBucket& bucket = bucket_for(process, addr);
+    uint32_t woken = 0;
+
+    uint64_t flags = bucket.lock.lock_irqsave();
+
+    FutexWaiter** link = &bucket.head;
+    while (*link && woken < count) {
+        FutexWaiter* waiter = *link;
+        if (waiter->process == process && waiter->addr == addr) {
+            *link = waiter->next;
+            waiter->woken = true;
+            Scheduler::wake(waiter->thread);
+            woken++;
+        } else {
+            link = &waiter->next;
+        }
+    }
+
+    bucket.lock.unlock_irqrestore(flags);
+
+    return woken;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,257 @@
+#ifdef CONFIG_LOCKSTAT
+
+#include <kernel/sync/lockstat.h>
+#include <kernel/sync/spinlock.h>
+#include <kernel/drivers/serial.h>
+#include <kernel/process/process.h>
+#include <kernel/arch/x86_64/cpu.h>
+#include <kernel/arch/x86_64/pit.h>
+
+namespace Core {
+
+#define MONITOR_POLL_MS 100
+
+// The registry can't use Spinlock without recursing into itself.
+static LockClass classes[Lockstat::MAX_CLASSES];
+static uint32_t class_count = 0;
+static uint32_t registry_busy = 0;
+static LockClass overflow_class = { "(other)", 0, 0, 0, 0, 0, 0, 0, 0, {} };
+
+static uint64_t raw_acquire(uint32_t* flag) {
+    uint64_t flags = CPU::irq_save();
+    while (__atomic_exchange_n(flag, 1, __ATOMIC_ACQUIRE)) {
+        CPU::relax();
+    }
+    return flags;
+}
+
+static void raw_release(uint32_t* flag, uint64_t flags) {
+    __atomic_store_n(flag, 0, __ATOMIC_RELEASE);
+    CPU::irq_restore(flags);
+}
+
+static bool same_name(const char* a, const char* b) {
+    if (a == b) return true;
+    while (*a && *a == *b) {
+        a++;
+        b++;
+    }
+    return *a == *b;
+}
+
+static void update_max(uint64_t* max, uint64_t value) {
+    uint64_t current = __atomic_load_n(max, __ATOMIC_RELAXED);
+    while (value > current &&
+           !__atomic_compare_exchange_n(max, &current, value, false,
+                                        __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+    }
+}
+
+static LockClass* find_class(const char* name, uint64_t ip) {
+    uint64_t flags = raw_acquire(&registry_busy);
+
+    LockClass* found = nullptr;
+    for (uint32_t i = 0; i < class_count && !found; i++) {
+        LockClass* cls = &classes[i];
+        if (name ? (cls->name && same_name(cls->name, name)) : (!cls->name && cls->key == ip)) {
+            found = cls;
+        }
+    }
+
+    if (!found) {
+        if (class_count < Lockstat::MAX_CLASSES) {
+            found = &classes[class_count++];
+            found->name = name;
+            found->key = ip;
+        } else {
+            found = &overflow_class;
+        }
+    }
+
+    raw_release(&registry_busy, flags);
+    return found;
+}
+
+// Keeps the call sites with the most contention using the space-saving
+// scheme: a new site evicts the weakest entry and inherits its count.
+static void record_site(LockClass* cls, uint64_t ip, uint64_t wait_cycles) {
+    uint64_t flags = raw_acquire(&cls->sites_busy);
+
+    LockSite* slot = nullptr;
+    LockSite* weakest = &cls->sites[0];
+    for (uint32_t i = 0; i < LockClass::TOP_SITES; i++) {
+        LockSite* site = &cls->sites[i];
+        if (site->ip == ip || site->ip == 0) {
+            slot = site;
+            break;
+        }
+        if (site->contended < weakest->contended) {
+            weakest = site;
+        }
+    }
+    if (!slot) {
+        slot = weakest;
+        slot->wait_cycles = 0;
+    }
+
+    slot->ip = ip;
+    slot->contended++;
+    slot->wait_cycles += wait_cycles;
+
+    raw_release(&cls->sites_busy, flags);
+}
+
+void Lockstat::acquired(Spinlock* lock, uint64_t ip, uint64_t wait_cycles, bool contended) {
+    LockClass* cls = lock->lock_class;
+    if (!cls) {
+        cls = find_class(lock->name, ip);
+        lock->lock_class = cls;
+    }
+
+    __atomic_fetch_add(&cls->acquisitions, 1, __ATOMIC_RELAXED);
+    if (contended) {
+        __atomic_fetch_add(&cls->contended, 1, __ATOMIC_RELAXED);
+        __atomic_fetch_add(&cls->wait_total, wait_cycles, __ATOMIC_RELAXED);
+        update_max(&cls->wait_max, wait_cycles);
+        record_site(cls, ip, wait_cycles);
+    }
+
+    lock->acquired_at = CPU::rdtsc();
+}
+
+void Lockstat::released(Spinlock* lock) {
+    LockClass* cls = lock->lock_class;
+    if (!cls) return;
+
+    uint64_t held = CPU::rdtsc() - lock->acquired_at;
+    __atomic_fetch_add(&cls->hold_total, held, __ATOMIC_RELAXED);
+    update_max(&cls->hold_max, held);
+}
+
+static void dump_class(const LockClass* cls) {
+    if (cls->name) {
+        Serial::printf("%s\n", cls->name);
+    } else {
+        Serial::printf("lock@0x%llx\n", cls->key);
+    }
+
+    Serial::printf("  acquisitions %llu  contended %llu\n", cls->acquisitions, cls->contended);
+    Serial::printf("  wait total %llu  max %llu  avg %llu\n", cls->wait_total, cls->wait_max,
+                   cls->contended ? cls->wait_total / cls->contended : 0);
+    Serial::printf("  hold total %llu  max %llu  avg %llu\n", cls->hold_total, cls->hold_max,
+                   cls->acquisitions ? cls->hold_total / cls->acquisitions : 0);
+
+    for (uint32_t i = 0; i < LockClass::TOP_SITES; i++) {
+        const LockSite* site = &cls->sites[i];
+        if (site->ip) {
+            Serial::printf("  site 0x%llx  contended %llu  wait %llu\n",
+                           site->ip, site->contended, site->wait_cycles);
+        }
+    }
+}
+
+void Lockstat::dump() {
+    uint32_t count = __atomic_load_n(&class_count, __ATOMIC_ACQUIRE);
+    uint32_t order[MAX_CLASSES];
+
+    for (uint32_t i = 0; i < count; i++) {
+        order[i] = i;
+    }
+    for (uint32_t i = 1; i < count; i++) {
+        uint32_t idx = order[i];
+        uint32_t j = i;
+        while (j > 0 && classes[order[j - 1]].wait_total < classes[idx].wait_total) {
+            order[j] = order[j - 1];
+            j--;
+        }
+        order[j] = idx;
+    }
+
+    Serial::printf("\n[LOCKSTAT] %u lock classes (cycles)\n", count);
+    for (uint32_t i = 0; i < count; i++) {
+        dump_class(&classes[order[i]]);
+    }
+    if (overflow_class.acquisitions) {
+        dump_class(&overflow_class);
+    }
+}
+
+static void clear_counters(LockClass* cls) {
+    cls->acquisitions = 0;
+    cls->contended = 0;
+    cls->wait_total = 0;
+    cls->wait_max = 0;
+    cls->hold_total = 0;
+    cls->hold_max = 0;
+
+    uint64_t flags = raw_acquire(&cls->sites_busy);
+    for (uint32_t i = 0; i < LockClass::TOP_SITES; i++) {
+        cls->sites[i].ip = 0;
+        cls->sites[i].contended = 0;
+        cls->sites[i].wait_cycles = 0;
+    }
+    raw_release(&cls->sites_busy, flags);
+}
+
+void Lockstat::reset() {
+    uint32_t count = __atomic_load_n(&class_count, __ATOMIC_ACQUIRE);
+    for (uint32_t i = 0; i < count; i++) {
+        clear_counters(&classes[i]);
+    }
+    clear_counters(&overflow_class);
+}
+
+static void* monitor_main(void*) {
+    while (true) {
+        int c;
+        while ((c = Serial::read_char()) >= 0) {
+            if (c == 'l') {
+                Lockstat::dump();
+            } else if (c == 'r') {
+                Lockstat::reset();
+                Serial::printf("[LOCKSTAT] Counters reset\n");
+            }
+        }
+        PIT::sleep(MONITOR_POLL_MS);
+    }
+    return nullptr;
+}
+
+void Lockstat::start_monitor() {
+    if (Serial::is_present()) {
+        ProcessManager::create_kernel_thread("lockstat", monitor_main, nullptr);
+    }
+}
+
+// Out-of-line Spinlock entry points, so the return address is the caller.
+
+__attribute__((noinline)) void Spinlock::lock() {
+    uint64_t ip = (uint64_t)__builtin_return_address(0);
+
+    CPU::preempt_disable();
+    if (fast_try_lock()) {
+        Lockstat::acquired(this, ip, 0, false);
+        return;
+    }
+
+    uint64_t start = CPU::rdtsc();
+    lock_slowpath();
+    Lockstat::acquired(this, ip, CPU::rdtsc() - start, true);
+}
+
+__attribute__((noinline)) void Spinlock::unlock() {
+    Lockstat::released(this);
+    raw_unlock();
+}
+
+__attribute__((noinline)) bool Spinlock::try_lock() {
+    if (!raw_try_lock()) {
+        return false;
+    }
+    Lockstat::acquired(this, (uint64_t)__builtin_return_address(0), 0, false);
+    return true;
+}
+
+}
+
+#endif
\ No newline at end of file
@@ -0,0 +1,44 @@
+#include <kernel/sync/mutex.h>
+#include <kernel/process/process.h>
+#include <kernel/arch/x86_64/cpu.h>
+
+namespace Core {
+
+bool Mutex::try_lock() {
+    Thread* expected = nullptr;
+    return __atomic_compare_exchange_n(&owner, &expected, ProcessManager::get_current_thread(),
+                                       false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+bool Mutex::spin_on_owner() {
+    Thread* holder = __atomic_load_n(&owner, __ATOMIC_RELAXED);
+
+    for (uint32_t i = 0; i < SPIN_LIMIT; i++) {
+        if (!holder) {
+            if (try_lock()) return true;
+        } else if (holder->state != Thread::State::RUNNING || holder->cpu == CPU::id()) {
+            return false;
+        }
+        CPU::relax();
+        holder = __atomic_load_n(&owner, __ATOMIC_RELAXED);
+    }
+
+    return false;
+}
+
+void Mutex::lock() {
+    if (try_lock()) return;
+    if (spin_on_owner()) return;
+
+    waiters.wait_event([this] { return try_lock(); });
+}
+
+void Mutex::unlock() {
+    __atomic_store_n(&owner, nullptr, __ATOMIC_SEQ_CST);
+
+    if (!waiters.is_empty()) {
+        waiters.wake_one();
+    }
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,243 @@
+#include <kernel/sync/rcu.h>
+#include <kernel/sync/spinlock.h>
+#include <kernel/sync/completion.h>
+#include <kernel/irq/softirq.h>
+#include <kernel/arch/x86_64/cpu.h>
+
+namespace Core {
+
+struct CallbackList {
+    RcuHead* head;
+    RcuHead** tail;
+    uint32_t count;
+};
+
+// Callbacks move next -> wait -> done: `next` has not been assigned a grace
+// period yet, `wait` is waiting for grace period `wait_gp` to complete, and
+// `done` is ready to be invoked.
+struct RcuData {
+    CallbackList next;
+    CallbackList wait;
+    CallbackList done;
+    uint64_t wait_gp;
+    uint64_t gp_seen;
+    bool qs_pending;
+    bool passed_qs;
+} ALIGNED(64);
+
+// Grace period `started` is in progress while it differs from `completed`;
+// it ends once every CPU in qs_mask has reported a quiescent state.
+struct RcuState {
+    Spinlock lock;
+    uint64_t started;
+    uint64_t completed;
+    uint64_t qs_mask;
+    bool need_gp;
+} ALIGNED(64);
+
+static RcuData rcu_data[CPU::MAX_CPUS];
+static RcuState state;
+
+static void list_init(CallbackList& list) {
+    list.head = nullptr;
+    list.tail = &list.head;
+    list.count = 0;
+}
+
+static void list_push(CallbackList& list, RcuHead* head) {
+    head->next = nullptr;
+    *list.tail = head;
+    list.tail = &head->next;
+    list.count++;
+}
+
+static void list_splice(CallbackList& dst, CallbackList& src) {
+    if (!src.head) return;
+
+    *dst.tail = src.head;
+    dst.tail = src.tail;
+    dst.count += src.count;
+    list_init(src);
+}
+
+static void start_gp_locked() {
+    uint32_t cpus = CPU::online_count();
+
+    state.qs_mask = cpus >= 64 ? ~0ULL : BIT(cpus) - 1;
+    __atomic_store_n(&state.started, state.started + 1, __ATOMIC_RELEASE);
+}
+
+// Notices a grace period this CPU hasn't seen yet. Only quiescent states
+// observed after this point count towards it.
+static void check_new_gp(RcuData& rdp) {
+    uint64_t started = __atomic_load_n(&state.started, __ATOMIC_ACQUIRE);
+    if (rdp.gp_seen != started) {
+        rdp.gp_seen = started;
+        rdp.passed_qs = false;
+        rdp.qs_pending = true;
+    }
+}
+
+static void report_qs(RcuData& rdp, uint32_t cpu) {
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    uint64_t flags = state.lock.lock_irqsave();
+    if (rdp.gp_seen == state.started && state.started != state.completed &&
+        (state.qs_mask & BIT(cpu))) {
+        state.qs_mask &= ~BIT(cpu);
+        if (!state.qs_mask) {
+            __atomic_store_n(&state.completed, state.started, __ATOMIC_RELEASE);
+            if (state.need_gp) {
+                state.need_gp = false;
+                start_gp_locked();
+            }
+        }
+    }
+    state.lock.unlock_irqrestore(flags);
+
+    rdp.qs_pending = false;
+}
+
+static void advance_callbacks(RcuData& rdp) {
+    uint64_t flags = CPU::irq_save();
+
+    if (rdp.wait.head && __atomic_load_n(&state.completed, __ATOMIC_ACQUIRE) >= rdp.wait_gp) {
+        list_splice(rdp.done, rdp.wait);
+    }
+
+    // Everything queued since the last batch shares the next grace period.
+    if (!rdp.wait.head && rdp.next.head) {
+        list_splice(rdp.wait, rdp.next);
+
+        state.lock.lock();
+        rdp.wait_gp = state.started + 1;
+        if (state.started == state.completed) {
+            start_gp_locked();
+        } else {
+            state.need_gp = true;
+        }
+        state.lock.unlock();
+    }
+
+    CPU::irq_restore(flags);
+}
+
+static void invoke_callbacks(RcuData& rdp) {
+    uint64_t flags = CPU::irq_save();
+    RcuHead* head = rdp.done.head;
+    uint32_t count = 0;
+
+    RcuHead* last = nullptr;
+    for (RcuHead* cb = head; cb && count < RCU::BATCH_LIMIT; cb = cb->next) {
+        last = cb;
+        count++;
+    }
+
+    if (last) {
+        rdp.done.head = last->next;
+        rdp.done.count -= count;
+        if (!rdp.done.head) {
+            rdp.done.tail = &rdp.done.head;
+        }
+        last->next = nullptr;
+    }
+    bool more = rdp.done.head != nullptr;
+    CPU::irq_restore(flags);
+
+    while (head) {
+        RcuHead* next = head->next;
+        head->func(head);
+        head = next;
+    }
+
+    if (more) {
+        Softirq::raise(SOFTIRQ_RCU);
+    }
+}
+
+static void rcu_softirq() {
+    uint32_t cpu = CPU::id();
+    RcuData& rdp = rcu_data[cpu];
+
+    check_new_gp(rdp);
+    if (rdp.qs_pending && rdp.passed_qs) {
+        report_qs(rdp, cpu);
+    }
+
+    advance_callbacks(rdp);
+    invoke_callbacks(rdp);
+}
+
+static bool has_work(RcuData& rdp) {
+    return rdp.qs_pending || rdp.next.head || rdp.wait.head || rdp.done.head ||
+           rdp.gp_seen != __atomic_load_n(&state.started, __ATOMIC_RELAXED);
+}
+
+void RCU::initialize() {
+    for (uint32_t cpu = 0; cpu < CPU::MAX_CPUS; cpu++) {
+        RcuData& rdp = rcu_data[cpu];
+        list_init(rdp.next);
+        list_init(rdp.wait);
+        list_init(rdp.done);
+        rdp.gp_seen = 0;
+        rdp.qs_pending = false;
+        rdp.passed_qs = false;
+    }
+
+    state.started = 0;
+    state.completed = 0;
+    state.qs_mask = 0;
+    state.need_gp = false;
+
+    Softirq::register_handler(SOFTIRQ_RCU, rcu_softirq);
+}
+
+// Called from the timer softirq. Softirqs only run when the interrupted code
+// had preemption enabled, so it cannot have been inside a read-side section.
+void RCU::tick() {
+    RcuData& rdp = rcu_data[CPU::id()];
+
+    rdp.passed_qs = true;
+    if (has_work(rdp)) {
+        Softirq::raise(SOFTIRQ_RCU);
+    }
+}
+
+void RCU::note_context_switch() {
+    rcu_data[CPU::id()].passed_qs = true;
+}
+
+uint64_t RCU::get_completed() {
+    return __atomic_load_n(&state.completed, __ATOMIC_ACQUIRE);
+}
+
+void call_rcu(RcuHead* head, rcu_callback_t func) {
+    head->func = func;
+
+    uint64_t flags = CPU::irq_save();
+    list_push(rcu_data[CPU::id()].next, head);
+    CPU::irq_restore(flags);
+}
+
+struct RcuSync {
+    RcuHead head;
+    Completion done;
+};
+
+static void wake_synchronize(RcuHead* head) {
+    ((RcuSync*)head)->done.complete();
+}
+
+void synchronize_rcu() {
+    // Blocking is itself a quiescent state; with a single CPU there is no
+    // other reader left to wait for.
+    if (CPU::online_count() == 1) {
+        return;
+    }
+
+    RcuSync sync;
+    call_rcu(&sync.head, wake_synchronize);
+    sync.done.wait();
+}
+
+}
\ No newline at end of file
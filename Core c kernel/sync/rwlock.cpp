@@ -0,0 +1,49 @@
+#include <kernel/sync/rwlock.h>
+#include <kernel/arch/x86_64/cpu.h>
+
+namespace Core {
+
+void RWLock::read_lock() {
+    CPU::preempt_disable();
+    uint32_t* count = &readers[CPU::id()].count;
+
+    while (true) {
+        // The locked xadd orders our count before the writer check; the
+        // writer does the mirror image, so one of us always sees the other.
+        uint32_t nested = __atomic_fetch_add(count, 1, __ATOMIC_SEQ_CST);
+
+        // A nested reader (e.g. an interrupt on a CPU that already holds the
+        // read side) must not back off: the writer is waiting for us anyway.
+        if (nested > 0 || !__atomic_load_n(&writer, __ATOMIC_SEQ_CST)) {
+            return;
+        }
+
+        __atomic_fetch_sub(count, 1, __ATOMIC_RELEASE);
+        while (__atomic_load_n(&writer, __ATOMIC_RELAXED)) {
+            CPU::relax();
+        }
+    }
+}
+
+void RWLock::read_unlock() {
+    __atomic_fetch_sub(&readers[CPU::id()].count, 1, __ATOMIC_RELEASE);
+    CPU::preempt_enable();
+}
+
+void RWLock::write_lock() {
+    writer_lock.lock();
+    __atomic_store_n(&writer, 1, __ATOMIC_SEQ_CST);
+
+    for (uint32_t cpu = 0; cpu < CPU::online_count(); cpu++) {
+        while (__atomic_load_n(&readers[cpu].count, __ATOMIC_SEQ_CST)) {
+            CPU::relax();
+        }
+    }
+}
+
+void RWLock::write_unlock() {
+    __atomic_store_n(&writer, 0, __ATOMIC_RELEASE);
+    writer_lock.unlock();
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,27 @@
+#include <kernel/sync/semaphore.h>
+
+namespace Core {
+
+bool Semaphore::try_down() {
+    int32_t value = __atomic_load_n(&count, __ATOMIC_RELAXED);
+
+    while (value > 0) {
+        if (__atomic_compare_exchange_n(&count, &value, value - 1, false,
+                                        __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void Semaphore::down() {
+    waiters.wait_event([this] { return try_down(); });
+}
+
+void Semaphore::up() {
+    __atomic_fetch_add(&count, 1, __ATOMIC_RELEASE);
+    waiters.wake_one();
+}
+
+}
\ No newline at end of file
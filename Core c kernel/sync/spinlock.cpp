@@ -0,0 +1,85 @@
+#include <kernel/sync/spinlock.h>
+#include <kernel/arch/x86_64/cpu.h>
+
+namespace Core {
+
+// One node per nesting level: thread, softirq, hardirq and exception
+// context can each be queued on a different lock at the same time.
+#define MCS_NODES_PER_CPU 4
+
+struct McsNode {
+    McsNode* next;
+    uint32_t locked;
+    uint32_t count;
+} ALIGNED(64);
+
+static McsNode mcs_nodes[CPU::MAX_CPUS][MCS_NODES_PER_CPU];
+
+static inline uint16_t encode_tail(uint32_t cpu, uint32_t idx) {
+    return (uint16_t)(((cpu + 1) << 2) | idx);
+}
+
+static inline McsNode* decode_tail(uint16_t tail) {
+    return &mcs_nodes[(tail >> 2) - 1][tail & 3];
+}
+
+// Entered with preemption disabled after the fast-path cmpxchg failed.
+void Spinlock::lock_slowpath() {
+    uint32_t cpu = CPU::id();
+    McsNode* base = &mcs_nodes[cpu][0];
+    uint32_t idx = base->count++;
+
+    if (idx >= MCS_NODES_PER_CPU) {
+        // Nested deeper than we have nodes for; fall back to spinning.
+        while (true) {
+            if (fast_try_lock()) {
+                break;
+            }
+            CPU::relax();
+        }
+        base->count--;
+        return;
+    }
+
+    McsNode* node = &mcs_nodes[cpu][idx];
+    node->next = nullptr;
+    node->locked = 0;
+
+    uint16_t my_tail = encode_tail(cpu, idx);
+    uint16_t old_tail = __atomic_exchange_n(&tail, my_tail, __ATOMIC_ACQ_REL);
+
+    if (old_tail) {
+        McsNode* prev = decode_tail(old_tail);
+        __atomic_store_n(&prev->next, node, __ATOMIC_RELEASE);
+        while (!__atomic_load_n(&node->locked, __ATOMIC_ACQUIRE)) {
+            CPU::relax();
+        }
+    }
+
+    // Head of the queue: wait for the owner to drop the lock.
+    uint32_t value;
+    while ((value = __atomic_load_n(&val, __ATOMIC_ACQUIRE)) & 0xFF) {
+        CPU::relax();
+    }
+
+    // If nobody queued behind us, take the lock and clear the tail at once.
+    if ((value >> TAIL_SHIFT) == my_tail &&
+        __atomic_compare_exchange_n(&val, &value, LOCKED_VAL, false,
+                                    __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        base->count--;
+        return;
+    }
+
+    // Only the queue head may set the owner byte while the tail is non-zero.
+    __atomic_store_n(&locked, 1, __ATOMIC_RELAXED);
+
+    McsNode* next;
+    while (!(next = __atomic_load_n(&node->next, __ATOMIC_ACQUIRE))) {
+        CPU::relax();
+    }
+    __atomic_store_n(&next->locked, 1, __ATOMIC_RELEASE);
+
+    base->count--;
+}
+
+}
\ No newline at end of file
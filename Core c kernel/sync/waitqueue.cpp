@@ -0,0 +1,78 @@
+#include <kernel/sync/waitqueue.h>
+#include <kernel/process/process.h>
+#include <kernel/arch/x86_64/cpu.h>
+
+namespace Core {
+
+void WaitQueue::unlink(WaitQueueEntry& entry) {
+    if (entry.prev) {
+        entry.prev->next = entry.next;
+    } else {
+        head = entry.next;
+    }
+    if (entry.next) {
+        entry.next->prev = entry.prev;
+    } else {
+        tail = entry.prev;
+    }
+    entry.next = nullptr;
+    entry.prev = nullptr;
+    entry.queued = false;
+}
+
+void WaitQueue::prepare_to_wait(WaitQueueEntry& entry) {
+    Thread* current = ProcessManager::get_current_thread();
+
+    uint64_t flags = lock.lock_irqsave();
+
+    if (!entry.queued) {
+        entry.thread = current;
+        entry.next = nullptr;
+        entry.prev = tail;
+        if (tail) {
+            tail->next = &entry;
+        } else {
+            head = &entry;
+        }
+        tail = &entry;
+        entry.queued = true;
+    }
+    current->state = Thread::State::BLOCKED;
+
+    lock.unlock_irqrestore(flags);
+
+    // Pairs with the waker's fence: either it sees us queued, or our
+    // re-check of the condition sees its update. The unlock alone is a
+    // plain store that the re-check's load may pass.
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+}
+
+void WaitQueue::finish_wait(WaitQueueEntry& entry) {
+    uint64_t flags = lock.lock_irqsave();
+
+    entry.thread->state = Thread::State::RUNNING;
+    if (entry.queued) {
+        unlink(entry);
+    }
+
+    lock.unlock_irqrestore(flags);
+}
+
+uint32_t WaitQueue::wake(uint32_t count) {
+    uint32_t woken = 0;
+
+    uint64_t flags = lock.lock_irqsave();
+
+    while (head && woken < count) {
+        WaitQueueEntry* entry = head;
+        unlink(*entry);
+        Scheduler::wake(entry->thread);
+        woken++;
+    }
+
+    lock.unlock_irqrestore(flags);
+
+    return woken;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,158 @@
+#include <kernel/time/clock.h>
+#include <kernel/time/vdso.h>
+#include <kernel/drivers/rtc.h>
+#include <kernel/memory/pmm.h>
+#include <kernel/memory/vmm.h>
+#include <kernel/memory/copy.h>
+#include <kernel/arch/x86_64/cpu.h>
+#include <kernel/arch/x86_64/io.h>
+#include <kernel/arch/x86_64/pit.h>
+#include <kernel/console.h>
+
+extern "C" const uint8_t vdso_start[];
+extern "C" const uint8_t vdso_end[];
+
+namespace Core {
+
+#define PIT_FREQUENCY     1193182
+#define PIT_CHANNEL2      0x42
+#define PIT_COMMAND       0x43
+#define PIT_GATE_PORT     0x61
+#define PIT_GATE          BIT(0)
+#define PIT_SPEAKER       BIT(1)
+#define PIT_CH2_OUT       BIT(5)
+
+#define NSEC_PER_SEC      1000000000ULL
+#define FIRST_REFINE_MS   4000
+#define LAST_REFINE_MS    (64 * 1000)
+
+// Kernel alias of the page mapped read-only at VDSO_DATA_ADDR.
+static VdsoTimeData* data = nullptr;
+static uint64_t tsc_hz = 0;
+
+// Refinement baseline: the TSC at the first timer tick.
+static uint64_t boot_tsc = 0;
+static uint64_t boot_tick = 0;
+static uint64_t next_refine = FIRST_REFINE_MS;
+
+// Counts a one-shot on PIT channel 2 by polling its output, so this works
+// before interrupts are enabled.
+static uint64_t calibrate_tsc() {
+    uint16_t count = PIT_FREQUENCY * Clock::CALIBRATE_MS / 1000;
+
+    IO::outb(PIT_GATE_PORT, IO::inb(PIT_GATE_PORT) & ~(PIT_GATE | PIT_SPEAKER));
+    IO::outb(PIT_COMMAND, 0xB0);    // channel 2, lobyte/hibyte, mode 0
+    IO::outb(PIT_CHANNEL2, count & 0xFF);
+    IO::outb(PIT_CHANNEL2, count >> 8);
+
+    IO::outb(PIT_GATE_PORT, IO::inb(PIT_GATE_PORT) | PIT_GATE);
+    uint64_t start = CPU::rdtsc();
+    while (!(IO::inb(PIT_GATE_PORT) & PIT_CH2_OUT)) {
+    }
+    uint64_t end = CPU::rdtsc();
+
+    IO::outb(PIT_GATE_PORT, IO::inb(PIT_GATE_PORT) & ~PIT_GATE);
+    return (end - start) * 1000 / Clock::CALIBRATE_MS;
+}
+
+static uint64_t scale(const VdsoTimeData* time, uint64_t tsc) {
+    uint64_t delta = tsc > time->tsc_base ? tsc - time->tsc_base : 0;
+    return time->mono_base + (uint64_t)(((unsigned __int128)delta * time->mult) >> time->shift);
+}
+
+// Rebases at the current TSC so time stays continuous across a change of
+// rate.
+static void set_frequency(uint64_t hz) {
+    uint64_t now = CPU::rdtsc();
+
+    data->seq.write_begin();
+    data->mono_base = scale(data, now);
+    data->tsc_base = now;
+    data->mult = (NSEC_PER_SEC << Clock::SHIFT) / hz;
+    data->seq.write_end();
+
+    tsc_hz = hz;
+}
+
+void Clock::initialize() {
+    uint32_t eax, ebx, ecx, edx;
+    CPU::cpuid(0x80000007, 0, &eax, &ebx, &ecx, &edx);
+    if (!(edx & BIT(8))) {
+        Console::printf("[CLOCK] TSC is not invariant, time may drift\n");
+    }
+
+    uint64_t data_page = PMM::alloc_page();
+    uint64_t text_page = PMM::alloc_page();
+    data = (VdsoTimeData*)(data_page + KERNEL_VIRTUAL_BASE);
+    zero_pages(data, 1);
+
+    uint8_t* text = (uint8_t*)(text_page + KERNEL_VIRTUAL_BASE);
+    for (size_t i = 0; i < PAGE_SIZE; i++) {
+        text[i] = i < (size_t)(vdso_end - vdso_start) ? vdso_start[i] : 0xCC;
+    }
+
+    data->shift = SHIFT;
+    data->tsc_base = CPU::rdtsc();
+    set_frequency(calibrate_tsc());
+
+    uint64_t wall = RTC::read_unix_time() * NSEC_PER_SEC;
+    data->seq.write_begin();
+    data->realtime_offset = wall - scale(data, CPU::rdtsc());
+    data->seq.write_end();
+
+    // Every process shares the kernel page tables, so one mapping covers
+    // all of user space.
+    VMM::map_page(VDSO_DATA_ADDR, data_page, VMM::PRESENT | VMM::USER);
+    VMM::map_page(VDSO_TEXT_ADDR, text_page, VMM::PRESENT | VMM::USER);
+}
+
+void Clock::tick() {
+    uint64_t ticks = PIT::get_ticks();
+
+    if (!boot_tsc) {
+        boot_tsc = CPU::rdtsc();
+        boot_tick = ticks;
+        return;
+    }
+
+    uint64_t elapsed_ms = ticks - boot_tick;
+    if (next_refine > LAST_REFINE_MS || elapsed_ms < next_refine) {
+        return;
+    }
+    next_refine *= 2;
+
+    // At most LAST_REFINE_MS of cycles, so the product stays far below
+    // 2^64 and no 128-bit division (a libgcc call) is needed.
+    uint64_t cycles = CPU::rdtsc() - boot_tsc;
+    set_frequency(cycles * 1000 / elapsed_ms);
+}
+
+uint64_t Clock::monotonic_ns() {
+    uint32_t seq;
+    uint64_t ns;
+
+    do {
+        seq = data->seq.read_begin();
+        ns = scale(data, CPU::rdtsc());
+    } while (data->seq.read_retry(seq));
+
+    return ns;
+}
+
+uint64_t Clock::realtime_ns() {
+    uint32_t seq;
+    uint64_t ns;
+
+    do {
+        seq = data->seq.read_begin();
+        ns = scale(data, CPU::rdtsc()) + data->realtime_offset;
+    } while (data->seq.read_retry(seq));
+
+    return ns;
+}
+
+uint64_t Clock::get_tsc_hz() {
+    return tsc_hz;
+}
+
+}
\ No newline at end of file
@@ -0,0 +1,80 @@
+#include <kernel/time/timer.h>
+#include <kernel/sync/spinlock.h>
+#include <kernel/sync/percpu.h>
+#include <kernel/arch/x86_64/pit.h>
+
+namespace Core {
+
+struct TimerBase {
+    Spinlock lock;
+    Timer* head;
+};
+
+static PerCpu<TimerBase> bases;
+
+void Timer::add(Timer* timer, uint64_t expires) {
+    TimerBase& base = bases.get_cpu();
+    uint64_t flags = base.lock.lock_irqsave();
+
+    timer->expires = expires;
+    timer->cpu = CPU::id();
+
+    Timer** link = &base.head;
+    while (*link && (*link)->expires <= expires) {
+        link = &(*link)->next;
+    }
+    timer->next = *link;
+    *link = timer;
+    timer->pending = true;
+
+    base.lock.unlock_irqrestore(flags);
+    bases.put_cpu();
+}
+
+bool Timer::cancel(Timer* timer) {
+    TimerBase& base = bases.get(__atomic_load_n(&timer->cpu, __ATOMIC_RELAXED));
+    bool removed = false;
+
+    uint64_t flags = base.lock.lock_irqsave();
+    if (timer->pending) {
+        Timer** link = &base.head;
+        while (*link && *link != timer) {
+            link = &(*link)->next;
+        }
+        if (*link) {
+            *link = timer->next;
+            timer->pending = false;
+            removed = true;
+        }
+    }
+    base.lock.unlock_irqrestore(flags);
+
+    return removed;
+}
+
+void Timer::run_expired() {
+    TimerBase& base = bases.local();
+    uint64_t now = PIT::get_ticks();
+    Timer* expired = nullptr;
+    Timer** tail = &expired;
+
+    uint64_t flags = base.lock.lock_irqsave();
+    while (base.head && base.head->expires <= now) {
+        Timer* timer = base.head;
+        base.head = timer->next;
+        timer->pending = false;
+        *tail = timer;
+        tail = &timer->next;
+    }
+    *tail = nullptr;
+    base.lock.unlock_irqrestore(flags);
+
+    // The owner may reuse a timer as soon as its callback starts.
+    while (expired) {
+        Timer* timer = expired;
+        expired = timer->next;
+        timer->func(timer);
+    }
+}
+
+}
\ No newline at end of file
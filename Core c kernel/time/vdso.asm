@@ -0,0 +1,64 @@
+section .rodata
+bits 64
+
+; Reader routines copied into the user-mapped vDSO text page. They must stay
+; position independent and may only reference the data page by its fixed
+; address. Entry points sit at the offsets published in vdso.h.
+
+%define VDSO_DATA_ADDR  0x00007FFFFFFF1000
+
+%define SEQ             0
+%define SHIFT           4
+%define MULT            8
+%define TSC_BASE        16
+%define MONO_BASE       24
+%define REALTIME_OFFSET 32
+
+; Leaves nanoseconds since boot in RAX; %1 is a label prefix.
+%macro READ_CLOCK 2
+    mov r8, VDSO_DATA_ADDR
+%1_retry:
+    mov r9d, [r8 + SEQ]
+    test r9d, 1
+    jnz %1_busy
+
+    lfence
+    rdtsc
+    shl rdx, 32
+    or rax, rdx
+    sub rax, [r8 + TSC_BASE]
+    jae %1_forward
+    xor eax, eax                ; TSC slightly behind the writer's CPU
+%1_forward:
+    mul qword [r8 + MULT]
+    mov ecx, [r8 + SHIFT]
+    shrd rax, rdx, cl
+    add rax, [r8 + MONO_BASE]
+%if %2
+    add rax, [r8 + REALTIME_OFFSET]
+%endif
+
+    cmp r9d, [r8 + SEQ]
+    jne %1_retry
+    ret
+
+%1_busy:
+    pause
+    jmp %1_retry
+%endmacro
+
+global vdso_start
+global vdso_end
+
+align 16
+vdso_start:
+
+vdso_clock_monotonic:
+    READ_CLOCK .monotonic, 0
+
+    times 0x40 - ($ - vdso_start) int3
+
+vdso_clock_realtime:
+    READ_CLOCK .realtime, 1
+
+vdso_end:
\ No newline at end of file